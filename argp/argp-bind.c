@@ -0,0 +1,703 @@
+/* Converters for options that argp stores itself.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+#include <errno.h>
+#include <locale.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <argp.h>
+#include <cpu-features.h>
+#include "argp-namefrob.h"
+
+/* Values of ARGP_BIND_DOUBLE longer than this that need strtod, in a
+   locale whose decimal point isn't `.' or in a list, are copied to the
+   heap.  */
+#define BIND_BUF_SIZE 64
+
+/* ASCII only, whatever the locale.  */
+#define bind_isdigit(c) ((unsigned) (c) - '0' < 10)
+#define bind_tolower(c) ((c) >= 'A' && (c) <= 'Z' ? (c) - 'A' + 'a' : (c))
+
+/* The value of the digit C in base 16, or 16 if it isn't one.  */
+static unsigned
+bind_digit(char c)
+{
+    if (bind_isdigit(c))
+        return c - '0';
+    c = bind_tolower(c);
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return 16;
+}
+
+/* Read the unsigned number at *S, before E, in decimal, hex after `0x' or
+   octal after `0', into *VALUE, and advance *S past it.  Returns 0, EINVAL if
+   there's no number, or ERANGE if it doesn't fit in 64 bits.  */
+static error_t
+bind_number(const char **s, const char *e, uint64_t *value)
+{
+    const char *p = *s;
+    unsigned base = 10, digit;
+    uint64_t v = 0;
+    int overflow = 0;
+
+    if (e - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')
+        && bind_digit(p[2]) < 16) {
+        base = 16;
+        p += 2;
+    } else if (p < e && p[0] == '0')
+        base = 8;
+    else if (p == e || !bind_isdigit(*p))
+        return EINVAL;
+
+    for (; p < e && (digit = bind_digit(*p)) < base; p++) {
+        if (v > (UINT64_MAX - digit) / base)
+            overflow = 1;
+        v = v * base + digit;
+    }
+
+    *s = p;
+    *value = v;
+    return overflow ? ERANGE : 0;
+}
+
+/* Read a signed number from S to E, which must be all of it, into *VALUE,
+   if it's between MIN and MAX.  */
+static error_t
+bind_signed(const char *s, const char *e, int64_t min, int64_t max,
+            int64_t *value)
+{
+    int negative = s < e && *s == '-';
+    uint64_t v;
+    error_t err;
+
+    if (s < e && (*s == '-' || *s == '+'))
+        s++;
+    err = bind_number(&s, e, &v);
+    if (!err && s != e)
+        err = EINVAL;
+    if (err)
+        return err;
+
+    if (negative ? v > (uint64_t) -(min + 1) + 1 : v > (uint64_t) max)
+        return ERANGE;
+
+    *value = negative ? (int64_t) (0 - v) : (int64_t) v;
+    return 0;
+}
+
+/* Read an unsigned number from S to E, which must be all of it, into
+   *VALUE.  */
+static error_t
+bind_unsigned(const char *s, const char *e, uint64_t *value)
+{
+    uint64_t v;
+    error_t err;
+
+    if (s < e && *s == '+')
+        s++;
+    err = bind_number(&s, e, &v);
+    if (!err && s != e)
+        err = EINVAL;
+    if (err)
+        return err;
+
+    *value = v;
+    return 0;
+}
+
+/* Read a size, with an optional suffix, from S to E into *VALUE.  */
+static error_t
+bind_size(const char *s, const char *e, size_t *value)
+{
+    static const char suffixes[] = "kmgtpe";
+    const char *suffix;
+    unsigned shift = 0;
+    uint64_t v;
+    error_t err;
+
+    if (s < e && *s == '+')
+        s++;
+    err = bind_number(&s, e, &v);
+    if (err)
+        return err;
+
+    if (s != e) {
+        suffix = *s ? strchr(suffixes, bind_tolower(*s)) : NULL;
+        if (!suffix)
+            return EINVAL;
+        shift = 10 * (unsigned) (suffix - suffixes + 1);
+        s++;
+        if (e - s >= 2 && s[0] == 'i' && s[1] == 'B')
+            s += 2;
+        else if (s < e && *s == 'B')
+            s++;
+        if (s != e)
+            return EINVAL;
+    }
+
+    if (v > (SIZE_MAX >> shift))
+        return ERANGE;
+
+    *value = (size_t) (v << shift);
+    return 0;
+}
+
+/* Powers of 10 that are exact in a double.  */
+static const double bind_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Read the decimal number from S to E into *VALUE, if it has no more than
+   19 significant digits and a small enough exponent that the result can be
+   computed exactly (Clinger's fast path); return 0 if it hasn't, or isn't a
+   plain decimal number, and 1 if *VALUE is set.  */
+static int
+bind_double_fast(const char *s, const char *e, double *value)
+{
+    int negative = 0, exp = 0, digits = 0, exp_sign = 1, n = 0;
+    uint64_t m = 0;
+    const char *p = s;
+    double v;
+
+    if (p < e && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    for (; p < e && bind_isdigit(*p); p++, digits++)
+        m = m * 10 + (*p - '0');
+    if (p < e && *p == '.')
+        for (p++; p < e && bind_isdigit(*p); p++, digits++, exp--)
+            m = m * 10 + (*p - '0');
+
+    if (!digits || digits > 19)
+        return 0;
+
+    if (p < e && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < e && (*p == '-' || *p == '+'))
+            exp_sign = *p++ == '-' ? -1 : 1;
+        if (p == e || !bind_isdigit(*p))
+            return 0;
+        for (; p < e && bind_isdigit(*p) && n < 10000; p++)
+            n = n * 10 + (*p - '0');
+        exp += exp_sign * n;
+    }
+
+    if (p != e || m > ((uint64_t) 1 << 53) || exp < -22 || exp > 22)
+        return 0;
+
+    v = (double) m;
+    v = exp < 0 ? v / bind_pow10[-exp] : v * bind_pow10[exp];
+    *value = negative ? -v : v;
+    return 1;
+}
+
+/* Return true if the LEN bytes at STR are somewhere from S to E.  */
+static int
+bind_contains(const char *s, const char *e, const char *str, size_t len)
+{
+    for (; (size_t) (e - s) >= len; s++)
+        if (memcmp(s, str, len) == 0)
+            return 1;
+    return 0;
+}
+
+/* Read the number from S to E, which must be all of it, into *VALUE, with
+   `.' as the decimal point.  */
+static error_t
+bind_double(const char *s, const char *e, double *value)
+{
+    const char *point = localeconv()->decimal_point;
+    size_t len = e - s, plen = 0, size;
+    char buf[BIND_BUF_SIZE], *copy = NULL, *end;
+    const char *dot = NULL;
+    double v;
+    int saved_errno = errno;
+    error_t err = 0;
+
+    if (bind_double_fast(s, e, value))
+        return 0;
+
+    /* Leading blanks aren't allowed, and strtod would skip them.  */
+    if (s == e || *s == ' ' || (*s >= '\t' && *s <= '\r'))
+        return EINVAL;
+
+    if (strcmp(point, ".") != 0 && *point) {
+        plen = strlen(point);
+        if (bind_contains(s, e, point, plen))
+            return EINVAL;      /* Only `.' is a decimal point here.  */
+        dot = memchr(s, '.', len);
+    }
+    if (dot || *e) {
+        /* Give strtod a string that ends at E, with the locale's decimal
+           point instead of the `.'.  */
+        size = len + (dot ? plen : 0) + 1;
+        copy = size <= sizeof buf ? buf : malloc(size);
+        if (!copy)
+            return ENOMEM;
+        if (dot) {
+            memcpy(copy, s, dot - s);
+            memcpy(copy + (dot - s), point, plen);
+            memcpy(copy + (dot - s) + plen, dot + 1, e - dot - 1);
+        } else
+            memcpy(copy, s, len);
+        copy[size - 1] = '\0';
+        s = copy;
+    }
+
+    errno = 0;
+    v = strtod(s, &end);
+    if (end == s || *end)
+        err = EINVAL;
+    else if (errno == ERANGE)
+        err = ERANGE;
+    else
+        *value = v;
+    errno = saved_errno;
+
+    if (copy != buf)
+        free(copy);
+
+    return err;
+}
+
+/* Read a duration from S to E, which must be all of it, into *VALUE in
+   nanoseconds.  */
+static error_t
+bind_duration(const char *s, const char *e, int64_t *value)
+{
+    static const struct
+    {
+        const char *name;
+        int64_t ns;
+    } units[] = {
+        /* Longer names first, so "ms" isn't taken for "m".  */
+        { "ns", 1 },
+        { "us", 1000 },
+        { "ms", 1000000 },
+        { "s", 1000000000 },
+        { "m", INT64_C(60000000000) },
+        { "h", INT64_C(3600000000000) },
+        { "d", INT64_C(86400000000000) },
+    };
+    int negative = 0;
+    uint64_t total = 0, part;
+    const char *p = s, *first;
+
+    if (p < e && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    first = p;
+
+    do {
+        uint64_t whole = 0, frac = 0, scale = 1;
+        const char *start = p;
+        int64_t unit = 0;
+        size_t i, len;
+
+        for (; p < e && bind_isdigit(*p); p++)
+            whole = whole < UINT64_MAX / 10 ? whole * 10 + (*p - '0') : UINT64_MAX;
+        if (p < e && *p == '.')
+            for (p++; p < e && bind_isdigit(*p); p++)
+                if (scale < UINT64_C(1000000000000000000)) {
+                    frac = frac * 10 + (*p - '0');
+                    scale *= 10;
+                }
+        if (p == start || (p == start + 1 && *start == '.'))
+            return EINVAL;
+
+        for (i = 0; i < sizeof units / sizeof units[0]; i++) {
+            len = strlen(units[i].name);
+            if ((size_t) (e - p) >= len && memcmp(p, units[i].name, len) == 0) {
+                unit = units[i].ns;
+                p += len;
+                break;
+            }
+        }
+        if (!unit) {
+            /* A plain number of seconds, only on its own.  */
+            if (p != e || start != first)
+                return EINVAL;
+            unit = 1000000000;
+        }
+
+        /* The fraction is less than one UNIT, so a double is exact enough
+            for it.  */
+        if (whole > (uint64_t) INT64_MAX / unit)
+            return ERANGE;
+        part = whole * unit
+               + (uint64_t) ((double) frac * (double) unit / (double) scale + 0.5);
+        if (part > (uint64_t) INT64_MAX - total)
+            return ERANGE;
+        total += part;
+    } while (p != e);
+
+    *value = negative ? -(int64_t) total : (int64_t) total;
+    return 0;
+}
+
+/* Return 0 if S to E is the same as the lowercase NAME, in any case.  */
+static int
+bind_strcasecmp(const char *s, const char *e, const char *name)
+{
+    for (; *name; s++, name++)
+        if (s == e || bind_tolower(*s) != *name)
+            return 1;
+    return s != e;
+}
+
+/* Read a boolean from S to E into *VALUE.  */
+static error_t
+bind_bool(const char *s, const char *e, int *value)
+{
+    static const char *const names[] = {
+        "no", "yes", "false", "true", "off", "on", "0", "1"
+    };
+    unsigned i;
+
+    for (i = 0; i < sizeof names / sizeof names[0]; i++)
+        if (bind_strcasecmp(s, e, names[i]) == 0) {
+            *value = i & 1;
+            return 0;
+        }
+
+    return EINVAL;
+}
+
+/* Convert S to E, which needn't be NUL-terminated though *E must be
+   readable, to TYPE, which isn't ARGP_BIND_STRING or ARGP_BIND_SLICE, and
+   store it in VALUE.  */
+static error_t
+bind_convert(int type, const char *s, const char *e, void *value)
+{
+    int64_t v;
+    error_t err;
+
+    switch (type) {
+    case ARGP_BIND_INT:
+        err = bind_signed(s, e, INT_MIN, INT_MAX, &v);
+        if (!err)
+            *(int *) value = (int) v;
+        return err;
+
+    case ARGP_BIND_INT64:
+        return bind_signed(s, e, INT64_MIN, INT64_MAX, (int64_t *) value);
+
+    case ARGP_BIND_UINT64:
+        return bind_unsigned(s, e, (uint64_t *) value);
+
+    case ARGP_BIND_SIZE:
+        return bind_size(s, e, (size_t *) value);
+
+    case ARGP_BIND_DOUBLE:
+        return bind_double(s, e, (double *) value);
+
+    case ARGP_BIND_DURATION:
+        return bind_duration(s, e, (int64_t *) value);
+
+    case ARGP_BIND_BOOL:
+        return bind_bool(s, e, (int *) value);
+
+    default:
+        return EINVAL;
+    }
+}
+
+/* Convert ARG as an argp_binding of type TYPE would, and store the result
+   in VALUE.  See argp.h for details.  */
+error_t
+__argp_convert(int type, const char *arg, void *value)
+{
+    if (type == ARGP_BIND_STRING) {
+        *(const char **) value = arg;
+        return 0;
+    }
+    if (!arg) {
+        if (type != ARGP_BIND_BOOL)
+            return EINVAL;
+        *(int *) value = 1;
+        return 0;
+    }
+
+    return bind_convert(type, arg, arg + strlen(arg), value);
+}
+#ifdef weak_alias
+weak_alias(__argp_convert, argp_convert)
+#endif
+
+/* Counting the values in a list, so that its array is allocated once at the
+   right size.  The list may be megabytes long, so this reads it 8, 16 or 32
+   bytes at a time, whichever the CPU can.  */
+
+typedef size_t bind_counter_t(const char *s, size_t n, char c);
+
+/* Return the number of bytes that are C in the N bytes at S.  */
+static size_t
+bind_count_generic(const char *s, size_t n, char c)
+{
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    const uint64_t low7 = UINT64_C(0x7f7f7f7f7f7f7f7f);
+    size_t count = 0, i = 0;
+
+    for (; n - i >= 8; i += 8) {
+        uint64_t word, zero;
+
+        memcpy(&word, s + i, 8);
+        word ^= ones * (unsigned char) c;
+        /* The high bit of each byte of ZERO is set if that byte of WORD is
+           zero, with no carries between bytes.  */
+        zero = ~(((word & low7) + low7) | word | low7);
+        count += (size_t) (((zero >> 7) * ones) >> 56);
+    }
+    for (; i < n; i++)
+        count += s[i] == c;
+
+    return count;
+}
+
+#ifdef CPU_SSE2
+static size_t
+bind_count_sse2(const char *s, size_t n, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c), zero = _mm_setzero_si128();
+    size_t count = 0, i = 0;
+
+    while (n - i >= 16) {
+        /* Each byte of SUMS counts its hits, up to 255 blocks' worth.  */
+        __m128i sums = zero;
+        unsigned blocks = 0;
+
+        for (; n - i >= 16 && blocks < 255; i += 16, blocks++)
+            sums = _mm_sub_epi8(sums, _mm_cmpeq_epi8(
+                       _mm_loadu_si128((const __m128i *) (s + i)), needle));
+        sums = _mm_sad_epu8(sums, zero);
+        count += (size_t) _mm_cvtsi128_si32(sums)
+                 + (size_t) _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+
+    return count + bind_count_generic(s + i, n - i, c);
+}
+#endif /* CPU_SSE2 */
+
+#ifdef CPU_AVX2
+static CPU_TARGET_AVX2 size_t
+bind_count_avx2(const char *s, size_t n, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c), zero = _mm256_setzero_si256();
+    size_t count = 0, i = 0;
+
+    while (n - i >= 32) {
+        __m256i sums = zero;
+        __m128i half;
+        unsigned blocks = 0;
+
+        for (; n - i >= 32 && blocks < 255; i += 32, blocks++)
+            sums = _mm256_sub_epi8(sums, _mm256_cmpeq_epi8(
+                       _mm256_loadu_si256((const __m256i *) (s + i)), needle));
+        sums = _mm256_sad_epu8(sums, zero);
+        half = _mm_add_epi64(_mm256_castsi256_si128(sums),
+                             _mm256_extracti128_si256(sums, 1));
+        count += (size_t) _mm_cvtsi128_si32(half)
+                 + (size_t) _mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+    }
+
+    return count + bind_count_generic(s + i, n - i, c);
+}
+#endif /* CPU_AVX2 */
+
+/* Return the best counter the CPU can run, deciding the first time.  */
+static bind_counter_t *
+bind_counter(void)
+{
+    static bind_counter_t *volatile chosen;
+    bind_counter_t *counter = chosen;
+
+    if (!counter) {
+#ifdef CPU_AVX2
+        if (cpu_has_avx2())
+            counter = bind_count_avx2;
+        else
+#endif
+#ifdef CPU_SSE2
+            counter = bind_count_sse2;
+#else
+            counter = bind_count_generic;
+#endif
+        chosen = counter;
+    }
+
+    return counter;
+}
+
+/* Return the size of an item of a list of TYPE, or 0 if there's no such
+   list.  */
+static size_t
+bind_item_size(int type)
+{
+    switch (type) {
+    case ARGP_BIND_INT:
+    case ARGP_BIND_BOOL:
+        return sizeof(int);
+    case ARGP_BIND_INT64:
+    case ARGP_BIND_DURATION:
+        return sizeof(int64_t);
+    case ARGP_BIND_UINT64:
+        return sizeof(uint64_t);
+    case ARGP_BIND_SIZE:
+        return sizeof(size_t);
+    case ARGP_BIND_DOUBLE:
+        return sizeof(double);
+    case ARGP_BIND_STRING:
+        return sizeof(char *);
+    case ARGP_BIND_SLICE:
+        return sizeof(struct argp_slice);
+    default:
+        return 0;
+    }
+}
+
+/* Convert the list of integers of TYPE from P to E, separated by DELIM,
+   into ITEMS.  */
+static error_t
+bind_list_numbers(int type, const char *p, const char *e, char delim,
+                  void *items)
+{
+    int64_t min = type == ARGP_BIND_INT ? INT_MIN : INT64_MIN;
+    int64_t max = type == ARGP_BIND_INT ? INT_MAX : INT64_MAX;
+    size_t i;
+
+    for (i = 0;; i++) {
+        const char *start = p;
+        int negative = type != ARGP_BIND_SIZE && p < e && *p == '-';
+        unsigned digits = 0;
+        uint64_t u = 0;
+        int64_t v = 0;
+        size_t size = 0;
+        error_t err;
+
+        /* Most values are short decimal numbers, which can't overflow in 18
+           digits, so those are read here and anything else by the
+           converters.  */
+        p += negative;
+        if (p < e && *p != '0')
+            for (; p < e && bind_isdigit(*p) && digits < 18; p++, digits++)
+                u = u * 10 + (unsigned) (*p - '0');
+
+        if (!digits || (p != e && *p != delim)) {
+            p = memchr(start, delim, e - start);
+            if (!p)
+                p = e;
+            if (type == ARGP_BIND_SIZE)
+                err = bind_size(start, p, &size);
+            else
+                err = bind_signed(start, p, min, max, &v);
+            if (err)
+                return err;
+        } else if (type == ARGP_BIND_SIZE) {
+            if (u > SIZE_MAX)
+                return ERANGE;
+            size = (size_t) u;
+        } else {
+            if (negative ? u > (uint64_t) -(min + 1) + 1 : u > (uint64_t) max)
+                return ERANGE;
+            v = negative ? -(int64_t) u : (int64_t) u;
+        }
+
+        if (type == ARGP_BIND_INT)
+            ((int *) items)[i] = (int) v;
+        else if (type == ARGP_BIND_INT64)
+            ((int64_t *) items)[i] = v;
+        else
+            ((size_t *) items)[i] = size;
+
+        if (p == e)
+            return 0;
+        p++;
+    }
+}
+
+/* Convert the values in ARG, separated by DELIM, to TYPE and add them to
+   LIST.  See argp.h for details.  */
+error_t
+__argp_convert_list(int type, int delim, char *arg, struct argp_list *list)
+{
+    size_t size = bind_item_size(type), len, n, i;
+    char *p, *e, *end;
+    char *items;
+    error_t err = 0;
+
+    if (!size || !arg)
+        return EINVAL;
+    if (!delim)
+        delim = ',';
+
+    len = strlen(arg);
+    if (len == 0)
+        return 0;
+    n = bind_counter()(arg, len, (char) delim) + 1;
+
+    if (n > SIZE_MAX / size - list->count)
+        return ENOMEM;
+    items = realloc(list->items, (list->count + n) * size);
+    if (!items)
+        return ENOMEM;
+    list->items = items;
+    items += list->count * size;
+
+    e = arg + len;
+    switch (type) {
+    case ARGP_BIND_INT:
+    case ARGP_BIND_INT64:
+    case ARGP_BIND_SIZE:
+        err = bind_list_numbers(type, arg, e, (char) delim, items);
+        break;
+
+    default:
+        for (p = arg, i = 0;; p = end + 1, i++) {
+            end = memchr(p, delim, e - p);
+            if (!end)
+                end = e;
+            if (type == ARGP_BIND_STRING) {
+                *end = '\0';
+                ((char **) items)[i] = p;
+            } else if (type == ARGP_BIND_SLICE) {
+                ((struct argp_slice *) items)[i].str = p;
+                ((struct argp_slice *) items)[i].len = end - p;
+            } else {
+                err = bind_convert(type, p, end, items + i * size);
+                if (err)
+                    break;
+            }
+            if (end == e)
+                break;
+        }
+    }
+
+    if (!err)
+        list->count += n;
+
+    return err;
+}
+#ifdef weak_alias
+weak_alias(__argp_convert_list, argp_convert_list)
+#endif
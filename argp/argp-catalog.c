@@ -0,0 +1,240 @@
+/* A flat catalog of the options of an argp tree.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <argp.h>
+#include "argp-namefrob.h"
+#include "argp-dag.h"
+#include "argp-catalog.h"
+
+/* What a catalog needs room for.  */
+struct catalog_sizes
+{
+    size_t num_argps;
+    size_t count;
+    size_t pool_len;
+};
+
+/* Add what ARGP and its children, unless they're in SEEN, need to SZS.  */
+static void
+catalog_count(const struct argp *argp, struct argp_seen *seen,
+              struct catalog_sizes *szs)
+{
+    const struct argp_option *opt = argp->options;
+    const struct argp_child *child;
+
+    if (argp_seen_add(seen, argp))
+        return;
+
+    szs->num_argps++;
+    if (opt)
+        for (; !__option_is_end(opt); opt++) {
+            szs->count++;
+            if (opt->name)
+                szs->pool_len += strlen(opt->name) + 1;
+        }
+
+    for (child = argp->children; child && child->argp; child++)
+        catalog_count(child->argp, seen, szs);
+}
+
+static size_t
+catalog_hash(const char *name, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+    return hash;
+}
+
+/* Add ENTRY to CATALOG's names, unless an earlier entry has its name.
+   Returns true if it was added.  */
+static int
+catalog_add_name(struct argp_catalog *catalog, uint32_t entry)
+{
+    const char *name = catalog->pool + catalog->name[entry];
+    size_t len = catalog->name_len[entry], i;
+    uint32_t other;
+
+    for (i = catalog_hash(name, len) & catalog->names_mask
+        ; (other = catalog->names[i]) != ARGP_CATALOG_NONE
+        ; i = (i + 1) & catalog->names_mask)
+        if (catalog->name_len[other] == len
+            && memcmp(catalog->pool + catalog->name[other], name, len) == 0)
+            return 0;
+
+    catalog->names[i] = entry;
+    return 1;
+}
+
+/* Add entries for the options of ARGP and its children, unless they're in
+   SEEN, to CATALOG.  *POOL_LEN is how much of its pool is used.  */
+static void
+catalog_fill(struct argp_catalog *catalog, const struct argp *argp,
+             struct argp_seen *seen, size_t *pool_len)
+{
+    const struct argp_option *opt = argp->options;
+    const struct argp_child *child;
+    uint32_t group, first, real = 0;
+
+    if (argp_seen_add(seen, argp))
+        return;
+
+    group = (uint32_t) catalog->num_argps++;
+    first = (uint32_t) catalog->count;
+    catalog->argps[group] = argp;
+    catalog->first[group] = first;
+
+    if (opt)
+        for (; !__option_is_end(opt); opt++) {
+            uint32_t entry = (uint32_t) catalog->count++;
+            const struct argp_option *ropt;
+            int flags = opt->flags;
+
+            /* As in convert_options, a first option that's an alias is
+                taken as real.  */
+            if (!(opt->flags & OPTION_ALIAS) || entry == first)
+                real = entry;
+            ropt = argp->options + (real - first);
+
+            catalog->key[entry] = opt->key;
+            catalog->real[entry] = real;
+            catalog->group[entry] = group;
+            catalog->arity[entry] = !ropt->arg ? ARGP_CATALOG_NO_ARG
+                : ropt->flags & OPTION_ARG_OPTIONAL ? ARGP_CATALOG_OPTIONAL_ARG
+                : ARGP_CATALOG_REQUIRED_ARG;
+
+            if (opt->name) {
+                size_t len = strlen(opt->name);
+
+                memcpy(catalog->pool + *pool_len, opt->name, len + 1);
+                catalog->name[entry] = (uint32_t) *pool_len;
+                catalog->name_len[entry] = (uint32_t) len;
+                *pool_len += len + 1;
+                if (!(ropt->flags & OPTION_DOC)
+                    && catalog_add_name(catalog, entry))
+                    flags |= ARGP_CATALOG_LONG;
+            } else {
+                catalog->name[entry] = ARGP_CATALOG_NONE;
+                catalog->name_len[entry] = 0;
+            }
+
+            if (!(ropt->flags & OPTION_DOC) && __option_is_short(opt)
+                && catalog->shorts[opt->key] == ARGP_CATALOG_NONE) {
+                catalog->shorts[opt->key] = entry;
+                flags |= ARGP_CATALOG_SHORT;
+            }
+
+            catalog->flags[entry] = flags;
+        }
+
+    for (child = argp->children; child && child->argp; child++)
+        catalog_fill(catalog, child->argp, seen, pool_len);
+}
+
+/* Build CATALOG for the tree of ARGP, which may be NULL.  Returns ENOMEM
+   if there isn't enough memory.  */
+error_t
+__argp_catalog_init(struct argp_catalog *catalog, const struct argp *argp)
+{
+    struct catalog_sizes szs = { 0, 0, 0 };
+    struct argp_seen seen;
+    size_t names = 16, i;
+    char *at;
+
+    argp_seen_init(&seen, argp);
+    if (argp)
+        catalog_count(argp, &seen, &szs);
+    while (names < 2 * szs.count)
+        names <<= 1;
+
+    /* Carve the storage up, in order of alignment.  */
+    catalog->storage = malloc(szs.num_argps * sizeof(*catalog->argps)
+                              + (szs.num_argps + 1) * sizeof(uint32_t)
+                              + 5 * szs.count * sizeof(uint32_t)
+                              + szs.count * sizeof(int)
+                              + names * sizeof(uint32_t)
+                              + szs.count + szs.pool_len + 1);
+    if (!catalog->storage) {
+        argp_seen_free(&seen);
+        return ENOMEM;
+    }
+    at = catalog->storage;
+    catalog->argps = (const struct argp **) at;
+    catalog->first = (uint32_t *) (at += szs.num_argps * sizeof(*catalog->argps));
+    catalog->name = (uint32_t *) (at += (szs.num_argps + 1) * sizeof(uint32_t));
+    catalog->name_len = (uint32_t *) (at += szs.count * sizeof(uint32_t));
+    catalog->real = (uint32_t *) (at += szs.count * sizeof(uint32_t));
+    catalog->group = (uint32_t *) (at += szs.count * sizeof(uint32_t));
+    catalog->flags = (int *) (at += szs.count * sizeof(uint32_t));
+    catalog->key = (int *) (at += szs.count * sizeof(int));
+    catalog->names = (uint32_t *) (at += szs.count * sizeof(int));
+    catalog->arity = (unsigned char *) (at += names * sizeof(uint32_t));
+    catalog->pool = (char *) (at += szs.count);
+    catalog->pool[0] = '\0';
+
+    catalog->names_mask = names - 1;
+    memset(catalog->names, 0xff, names * sizeof(uint32_t));
+    for (i = 0; i <= UCHAR_MAX; i++)
+        catalog->shorts[i] = ARGP_CATALOG_NONE;
+
+    catalog->num_argps = 0;
+    catalog->count = 0;
+    szs.pool_len = 0;
+    argp_seen_clear(&seen);
+    if (argp)
+        catalog_fill(catalog, argp, &seen, &szs.pool_len);
+    catalog->first[catalog->num_argps] = (uint32_t) catalog->count;
+    argp_seen_free(&seen);
+
+    return 0;
+}
+
+/* Free the memory CATALOG uses.  */
+void
+__argp_catalog_free(struct argp_catalog *catalog)
+{
+    free(catalog->storage);
+}
+
+/* Return CATALOG's ARGP_CATALOG_LONG entry called the LEN bytes at NAME,
+   or ARGP_CATALOG_NONE.  */
+uint32_t
+__argp_catalog_find(const struct argp_catalog *catalog, const char *name,
+                    size_t len)
+{
+    size_t i;
+    uint32_t entry;
+
+    for (i = catalog_hash(name, len) & catalog->names_mask
+        ; (entry = catalog->names[i]) != ARGP_CATALOG_NONE
+        ; i = (i + 1) & catalog->names_mask)
+        if (catalog->name_len[entry] == len
+            && memcmp(catalog->pool + catalog->name[entry], name, len) == 0)
+            return entry;
+
+    return ARGP_CATALOG_NONE;
+}
@@ -0,0 +1,174 @@
+/* A flat catalog of the options of an argp tree.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* Parsing, help and completion all need to go over every option of a tree
+   and look options up by name or key.  Rather than each chasing pointers
+   through the argps and their children, they read a catalog built in one
+   walk of the tree: what they need to know of each option is kept in
+   parallel arrays, with the long names together in one pool, and indexes
+   to find them by.  Each argp is only walked the first time it's used, as
+   with argp-dag.h.  A catalog isn't changed once it's built, so threads
+   may share one.  This header file is only used internally while compiling
+   argp, and shouldn't be installed.  */
+
+#ifndef _ARGP_CATALOG_H
+#define _ARGP_CATALOG_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <argp.h>
+
+/* An entry that isn't one.  */
+#define ARGP_CATALOG_NONE ((uint32_t) -1)
+
+/* The arguments an entry's option takes, as in getopt's struct option.  */
+#define ARGP_CATALOG_NO_ARG         0
+#define ARGP_CATALOG_REQUIRED_ARG   1
+#define ARGP_CATALOG_OPTIONAL_ARG   2
+
+/* Flags of an entry besides those of its option.  */
+/* Its long name is one getopt knows it by: the option isn't for
+   documentation, and no earlier entry has the name.  */
+#define ARGP_CATALOG_LONG   0x10000
+/* Its key is a short option that getopt gives to it, and no earlier
+   entry.  */
+#define ARGP_CATALOG_SHORT  0x20000
+
+struct argp_catalog
+{
+    /* The argps of the tree, each once, in the order argp_parse first meets
+        them, and the entry each one's options start at.  FIRST[NUM_ARGPS] is
+        COUNT.  */
+    const struct argp **argps;
+    uint32_t *first;
+    size_t num_argps;
+
+    /* An entry for every option of ARGPS, in the same order.  */
+    size_t count;
+    uint32_t *name;             /* Offset of its long name in POOL, or
+                                   ARGP_CATALOG_NONE, and...  */
+    uint32_t *name_len;         /* ...its length.  */
+    int *key;                   /* Its own key.  */
+    int *flags;                 /* Its own flags, and ARGP_CATALOG_ ones.  */
+    uint32_t *real;             /* Its real option; itself if not an alias.  */
+    uint32_t *group;            /* Index in ARGPS of its argp.  */
+    unsigned char *arity;       /* ARGP_CATALOG_*_ARG, from its real option.  */
+
+    /* The long names, each followed by a NUL.  */
+    char *pool;
+
+    /* The ARGP_CATALOG_LONG entries, hashed by name, and the
+        ARGP_CATALOG_SHORT ones, by key.  */
+    uint32_t *names;
+    size_t names_mask;
+    uint32_t shorts[UCHAR_MAX + 1];
+
+    void *storage;
+};
+
+/* Build CATALOG for the tree of ARGP, which may be NULL.  Returns ENOMEM
+   if there isn't enough memory.  */
+extern error_t __argp_catalog_init(struct argp_catalog *__catalog,
+                    const struct argp *__argp);
+
+/* Free the memory CATALOG uses.  */
+extern void __argp_catalog_free(struct argp_catalog *__catalog);
+
+/* Return CATALOG's ARGP_CATALOG_LONG entry called the LEN bytes at NAME,
+   or ARGP_CATALOG_NONE.  */
+extern uint32_t __argp_catalog_find(const struct argp_catalog *__catalog,
+                    const char *__name, size_t __len);
+
+/* Return the option of CATALOG's ENTRY.  */
+static inline const struct argp_option *
+argp_catalog_option(const struct argp_catalog *catalog, uint32_t entry)
+{
+    uint32_t group = catalog->group[entry];
+
+    return catalog->argps[group]->options + (entry - catalog->first[group]);
+}
+
+/* Return the long name of CATALOG's ENTRY, or NULL.  */
+static inline const char *
+argp_catalog_name(const struct argp_catalog *catalog, uint32_t entry)
+{
+    return catalog->name[entry] == ARGP_CATALOG_NONE ? NULL
+        : catalog->pool + catalog->name[entry];
+}
+
+/* Return true if CATALOG's ENTRY, or its real option, is hidden.  */
+static inline int
+argp_catalog_hidden(const struct argp_catalog *catalog, uint32_t entry)
+{
+    return ((catalog->flags[entry] | catalog->flags[catalog->real[entry]])
+            & OPTION_HIDDEN) != 0;
+}
+
+/* Return the struct argp_extension that ends ARGP's options, or NULL.  */
+static inline const struct argp_extension *
+argp_extension(const struct argp *argp)
+{
+    const struct argp_option *opt = argp->options;
+
+    if (! opt)
+        return NULL;
+    while (! __option_is_end(opt))
+        opt++;
+    return opt->flags & OPTION_EXTENSION
+        ? (const struct argp_extension *) opt->arg : NULL;
+}
+
+/* True if EXT was built with its FIELD.  */
+#define ARGP_EXTENSION_HAS(ext, field) \
+    ((ext)->size >= offsetof(struct argp_extension, field) \
+                    + sizeof((ext)->field))
+
+/* Return the bindings of ARGP's extension, or NULL.  */
+static inline const struct argp_binding *
+argp_bindings(const struct argp *argp)
+{
+    const struct argp_extension *ext = argp_extension(argp);
+
+    return ext && ARGP_EXTENSION_HAS(ext, bindings) ? ext->bindings : NULL;
+}
+
+/* Return the constraints of ARGP's extension, or NULL.  */
+static inline const struct argp_constraint *
+argp_constraints(const struct argp *argp)
+{
+    const struct argp_extension *ext = argp_extension(argp);
+
+    return ext && ARGP_EXTENSION_HAS(ext, constraints)
+        ? ext->constraints : NULL;
+}
+
+/* Return the commands of ARGP's extension, or NULL.  */
+static inline const struct argp_command *
+argp_commands(const struct argp *argp)
+{
+    const struct argp_extension *ext = argp_extension(argp);
+
+    return ext && ARGP_EXTENSION_HAS(ext, commands) ? ext->commands : NULL;
+}
+
+#endif /* argp-catalog.h */
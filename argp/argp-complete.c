@@ -0,0 +1,282 @@
+/* Completing command lines for shells.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <argp.h>
+#include "argp-namefrob.h"
+#include "argp-catalog.h"
+
+/* The options of a tree, in the order argp_parse would look at them.  */
+struct complete_index
+{
+    struct argp_catalog catalog;
+
+    /* The commands of the first argp that has any, or NULL.  */
+    const struct argp_command *commands;
+};
+
+/* Return the values the ARGP_BIND_ENUM binding of KEY in BINDINGS takes,
+   or NULL.  */
+static const struct argp_enum *
+complete_values(const struct argp_binding *bindings, int key)
+{
+    const struct argp_binding *binding;
+
+    for (binding = bindings; binding && binding->key; binding++)
+        if (binding->key == key && binding->type == ARGP_BIND_ENUM)
+            return binding->values;
+
+    return NULL;
+}
+
+/* Return the entry of INDEX whose long name is the LEN bytes at NAME, or
+   that they uniquely abbreviate, or ARGP_CATALOG_NONE.  */
+static uint32_t
+complete_find_long(const struct complete_index *index, const char *name,
+                   size_t len)
+{
+    const struct argp_catalog *catalog = &index->catalog;
+    uint32_t entry, found = ARGP_CATALOG_NONE;
+    int ambiguous = 0;
+
+    entry = __argp_catalog_find(catalog, name, len);
+    if (entry != ARGP_CATALOG_NONE)
+        return entry;
+
+    for (entry = 0; entry < catalog->count; entry++)
+        if ((catalog->flags[entry] & ARGP_CATALOG_LONG)
+            && catalog->name_len[entry] > len
+            && memcmp(catalog->pool + catalog->name[entry], name, len) == 0) {
+            ambiguous |= found != ARGP_CATALOG_NONE;
+            found = entry;
+        }
+
+    return ambiguous ? ARGP_CATALOG_NONE : found;
+}
+
+/* Return the entry of INDEX whose short option is KEY, or
+   ARGP_CATALOG_NONE.  */
+static uint32_t
+complete_find_short(const struct complete_index *index, unsigned char key)
+{
+    return index->catalog.shorts[key];
+}
+
+/* Write to STREAM the long option of INDEX's ENTRY, as a completion.  */
+static void
+complete_put_long(const struct complete_index *index, uint32_t entry,
+                  FILE *stream)
+{
+    fputs("--", stream);
+    fputs(argp_catalog_name(&index->catalog, entry), stream);
+    if (index->catalog.arity[entry] == ARGP_CATALOG_REQUIRED_ARG)
+        putc('=', stream);
+    putc('\n', stream);
+}
+
+/* Write to STREAM the values of INDEX's ENTRY that start with PREFIX, each
+   after the LEN bytes at WORD.  */
+static void
+complete_enum(const struct complete_index *index, uint32_t entry,
+              const char *word, size_t len, const char *prefix, FILE *stream)
+{
+    const struct argp_catalog *catalog = &index->catalog;
+    const struct argp_binding *bindings =
+        argp_bindings(catalog->argps[catalog->group[entry]]);
+    const struct argp_enum *value;
+    size_t prefix_len = strlen(prefix);
+
+    if (!bindings)
+        return;
+
+    value = complete_values(bindings, catalog->key[catalog->real[entry]]);
+    for (; value && value->name; value++)
+        if (strncmp(value->name, prefix, prefix_len) == 0) {
+            fwrite(word, 1, len, stream);
+            fputs(value->name, stream);
+            putc('\n', stream);
+        }
+}
+
+/* Write to STREAM the options of INDEX that complete WORD, which starts
+   with a `-'.  */
+static void
+complete_option_word(const struct complete_index *index, const char *word,
+                     FILE *stream)
+{
+    const struct argp_catalog *catalog = &index->catalog;
+    uint32_t entry;
+
+    if (word[1] == '-' || word[1] == '\0') {
+        const char *eq = strchr(word, '=');
+        size_t len;
+
+        if (eq) {
+            /* `--NAME=VALUE': complete the value.  */
+            entry = complete_find_long(index, word + 2, eq - word - 2);
+            if (entry != ARGP_CATALOG_NONE
+                && catalog->arity[entry] != ARGP_CATALOG_NO_ARG)
+                complete_enum(index, entry, word, eq + 1 - word, eq + 1,
+                              stream);
+            return;
+        }
+
+        if (word[1] == '\0')
+            /* Just `-': all the short options come first.  */
+            for (entry = 0; entry < catalog->count; entry++)
+                if ((catalog->flags[entry] & ARGP_CATALOG_SHORT)
+                    && !argp_catalog_hidden(catalog, entry)) {
+                    putc('-', stream);
+                    putc(catalog->key[entry], stream);
+                    putc('\n', stream);
+                }
+
+        len = word[1] ? strlen(word + 2) : 0;
+        for (entry = 0; entry < catalog->count; entry++)
+            if ((catalog->flags[entry] & ARGP_CATALOG_LONG)
+                && !argp_catalog_hidden(catalog, entry)
+                && catalog->name_len[entry] >= len
+                && memcmp(catalog->pool + catalog->name[entry], word + 2,
+                          len) == 0)
+                complete_put_long(index, entry, stream);
+    } else {
+        /* Short options, one of which may take the rest as its argument.  */
+        const char *p;
+
+        for (p = word + 1; *p; p++) {
+            entry = complete_find_short(index, (unsigned char) *p);
+            if (entry == ARGP_CATALOG_NONE)
+                return;
+            if (catalog->arity[entry] != ARGP_CATALOG_NO_ARG) {
+                complete_enum(index, entry, word, p + 1 - word, p + 1,
+                              stream);
+                return;
+            }
+        }
+        fprintf(stream, "%s\n", word);
+    }
+}
+
+/* Write to STREAM the commands from COMMAND on that start with WORD.  */
+static void
+complete_command(const struct argp_command *command, const char *word,
+                 FILE *stream)
+{
+    size_t len = strlen(word);
+
+    for (; command->name; command++)
+        if (strncmp(command->name, word, len) == 0) {
+            fputs(command->name, stream);
+            putc('\n', stream);
+        }
+}
+
+/* Write to STREAM the ways the last of the ARGC words in ARGV can be
+   completed.  See argp.h for details.  */
+error_t
+__argp_complete(const struct argp *argp, int argc, char **argv, FILE *stream)
+{
+    struct complete_index index;
+    const struct argp_catalog *catalog = &index.catalog;
+    uint32_t pending = ARGP_CATALOG_NONE;
+    const char *word;
+    size_t g;
+    int i, options = 1;
+
+    if (__argp_catalog_init(&index.catalog, argp))
+        return ENOMEM;
+    index.commands = NULL;
+    for (g = 0; g < catalog->num_argps && !index.commands; g++)
+        index.commands = argp_commands(catalog->argps[g]);
+
+    /* Find out what the last word is: an option, an option's argument, or
+        neither, by going over the ones before it as getopt would.  */
+    for (i = 0; i < argc - 1; i++) {
+        const char *arg = argv[i];
+
+        if (pending != ARGP_CATALOG_NONE)
+            pending = ARGP_CATALOG_NONE;
+        else if (index.commands
+                 && (!options || arg[0] != '-' || arg[1] == '\0')) {
+            /* The command: the rest are its words, if it's one.  */
+            const struct argp_command *command = index.commands;
+
+            __argp_catalog_free(&index.catalog);
+            for (; command->name; command++)
+                if (strcmp(command->name, arg) == 0)
+                    break;
+            argp = command->argp;
+            if (!argp && command->loader)
+                argp = (*command->loader)(command);
+            return argp ? __argp_complete(argp, argc - i - 1, argv + i + 1,
+                                          stream)
+                : 0;
+        } else if (!options || arg[0] != '-' || arg[1] == '\0')
+            continue;
+        else if (arg[1] == '-') {
+            if (arg[2] == '\0')
+                options = 0;
+            else if (!strchr(arg, '=')) {
+                uint32_t entry
+                    = complete_find_long(&index, arg + 2, strlen(arg + 2));
+
+                if (entry != ARGP_CATALOG_NONE
+                    && catalog->arity[entry] == ARGP_CATALOG_REQUIRED_ARG)
+                    pending = entry;
+            }
+        } else {
+            const char *p;
+
+            for (p = arg + 1; *p; p++) {
+                uint32_t entry
+                    = complete_find_short(&index, (unsigned char) *p);
+
+                if (entry == ARGP_CATALOG_NONE
+                    || catalog->arity[entry] != ARGP_CATALOG_NO_ARG) {
+                    if (entry != ARGP_CATALOG_NONE
+                        && catalog->arity[entry] == ARGP_CATALOG_REQUIRED_ARG
+                        && p[1] == '\0')
+                        pending = entry;
+                    break;
+                }
+            }
+        }
+    }
+
+    word = argc > 0 ? argv[argc - 1] : "";
+    if (pending != ARGP_CATALOG_NONE)
+        complete_enum(&index, pending, "", 0, word, stream);
+    else if (options && word[0] == '-')
+        complete_option_word(&index, word, stream);
+    else if (index.commands)
+        complete_command(index.commands, word, stream);
+
+    __argp_catalog_free(&index.catalog);
+    return 0;
+}
+#ifdef weak_alias
+weak_alias(__argp_complete, argp_complete)
+#endif
@@ -0,0 +1,110 @@
+/* Walking argp trees that share children.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* The same argp may be the child of more than one parent, such as a block
+   of logging options shared by many parts of a program, so a tree of argps
+   is really a DAG.  Each place an argp is used still gets its own parser
+   state, but its options are only worth looking at once: an option can
+   only be given to the first place its argp is used, whose names and keys
+   shadow those of any later ones.  An argp_seen set records the argps
+   already looked at.  This header file is only used internally while
+   compiling argp, and shouldn't be installed.  */
+
+#ifndef _ARGP_DAG_H
+#define _ARGP_DAG_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <argp.h>
+
+/* The argps seen so far in a walk of a tree, in an open-addressed table
+   with room for every argp in it.  */
+struct argp_seen
+{
+    const struct argp **slots;
+    size_t mask;
+};
+
+/* Return the number of places argps are used in ARGP's tree.  */
+static inline size_t
+argp_tree_size(const struct argp *argp)
+{
+    const struct argp_child *child = argp->children;
+    size_t size = 1;
+
+    if (child)
+        for (; child->argp; child++)
+            size += argp_tree_size(child->argp);
+
+    return size;
+}
+
+/* Make SEEN an empty set for walking ARGP's tree.  If there isn't enough
+   memory, every argp seems new, and the tree is walked as a tree.  */
+static inline void
+argp_seen_init(struct argp_seen *seen, const struct argp *argp)
+{
+    size_t size = 16, count = argp ? argp_tree_size(argp) : 0;
+
+    while (size < 2 * count)
+        size <<= 1;
+
+    seen->slots = calloc(size, sizeof(*seen->slots));
+    seen->mask = size - 1;
+}
+
+/* Forget every argp SEEN has seen.  */
+static inline void
+argp_seen_clear(struct argp_seen *seen)
+{
+    if (seen->slots)
+        memset(seen->slots, 0, (seen->mask + 1) * sizeof(*seen->slots));
+}
+
+/* Add ARGP to SEEN, and return true if it was already there.  */
+static inline int
+argp_seen_add(struct argp_seen *seen, const struct argp *argp)
+{
+    size_t i;
+
+    if (! seen->slots)
+        return 0;
+
+    /* Argps are at least pointer aligned, so the low bits say nothing.  */
+    i = (size_t) (((uintptr_t) argp >> 3) * 0x9E3779B97F4A7C15ull
+                  >> 16) & seen->mask;
+    for (; seen->slots[i]; i = (i + 1) & seen->mask)
+        if (seen->slots[i] == argp)
+            return 1;
+    seen->slots[i] = argp;
+
+    return 0;
+}
+
+static inline void
+argp_seen_free(struct argp_seen *seen)
+{
+    free(seen->slots);
+}
+
+#endif /* argp-dag.h */
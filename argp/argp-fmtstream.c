@@ -24,33 +24,90 @@
 #include <string.h>
 #include <errno.h>
 #include <stdarg.h>
-#include <ctype.h>
+#include <limits.h>
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <sys/uio.h>
+#endif
+#include <cpu-features.h>
 
 #include <argp-fmtstream.h>
 #include "argp-namefrob.h"
 
-#ifndef isblank
-# define isblank(ch) ((ch)==' ' || (ch)=='\t')
-#endif
-
 #define INIT_BUF_SIZE 200
 #define PRINTF_SIZE_GUESS 150
+#define MIN_BOUNDED_BUF_SIZE 256
 
-/* Return an argp_fmtstream that outputs to STREAM, and which prefixes lines
-   written on it with LMARGIN spaces and limits them to RMARGIN columns
-   total.  If WMARGIN >= 0, words that extend past RMARGIN are wrapped by
-   replacing the whitespace before them with a newline and WMARGIN spaces.
-   Otherwise, chars beyond RMARGIN are simply dropped until a newline.
-   Returns NULL if there was an error.  */
-argp_fmtstream_t
-__argp_make_fmtstream(FILE *stream,
-        size_t lmargin, size_t rmargin, ssize_t wmargin)
+/* How much text an FD sink gathers before writing, and in how many pieces
+   at most.  */
+#define FD_SINK_BUF_SIZE 16384
+#if defined IOV_MAX && IOV_MAX < 64
+# define FD_SINK_IOV IOV_MAX
+#else
+# define FD_SINK_IOV 64
+#endif
+
+/* Margins are written from here, rather than by the byte.  */
+static const char fmtstream_blanks[64] =
+    "                                                                ";
+
+#ifdef _WIN32
+/* There's no writev, so the pieces are written one at a time.  */
+struct iovec
+{
+    void *iov_base;
+    size_t iov_len;
+};
+
+static ssize_t
+writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    ssize_t total = 0;
+    int i;
+
+    for (i = 0; i < iovcnt; i++) {
+        int wrote = _write(fd, iov[i].iov_base, (unsigned) iov[i].iov_len);
+
+        if (wrote < 0)
+            return total ? total : -1;
+        total += wrote;
+        if ((size_t) wrote < iov[i].iov_len)
+            break;
+    }
+
+    return total;
+}
+#endif /* _WIN32 */
+
+struct argp_fmtstream_pending
+{
+    /* Text waiting to be written (FD), or all the output (MEMORY).  */
+    char *data;
+    size_t len, size;
+
+    /* For FD, the pieces to write next: runs of DATA, and margins pointing
+        at FMTSTREAM_BLANKS, which aren't copied.  */
+    struct iovec iov[FD_SINK_IOV];
+    int iovcnt;
+};
+
+/* Return a new argp_fmtstream, with no sink yet.  BUF_SIZE and LIMIT are as
+   for __argp_make_bounded_fmtstream.  */
+static argp_fmtstream_t
+fmtstream_new(size_t lmargin, size_t rmargin, ssize_t wmargin,
+        size_t buf_size, size_t limit)
 {
     argp_fmtstream_t fs;
 
     fs = (struct argp_fmtstream *) malloc(sizeof (struct argp_fmtstream));
     if (fs != NULL) {
-        fs->stream = stream;
+        fs->sink = ARGP_FMTSTREAM_SINK_FILE;
+        fs->stream = NULL;
+        fs->fd = -1;
+        fs->write_fn = NULL;
+        fs->cookie = NULL;
+        fs->pending = NULL;
 
         fs->lmargin = lmargin;
         fs->rmargin = rmargin;
@@ -58,71 +115,1003 @@ __argp_make_fmtstream(FILE *stream,
         fs->point_col = 0;
         fs->point_offs = 0;
 
-        fs->buf = (char *) malloc(INIT_BUF_SIZE);
+        fs->bounded = buf_size != 0;
+        fs->stopped = 0;
+        fs->limit = limit;
+        fs->written = 0;
+
+        if (! fs->bounded)
+            buf_size = INIT_BUF_SIZE;
+        else if (buf_size < MIN_BOUNDED_BUF_SIZE)
+            /* Leave room for a PRINTF_SIZE_GUESS and the margins.  */
+            buf_size = MIN_BOUNDED_BUF_SIZE;
+
+        fs->buf = (char *) malloc(buf_size);
         if (! fs->buf) {
             free (fs);
             fs = 0;
         } else {
             fs->p = fs->buf;
-            fs->end = fs->buf + INIT_BUF_SIZE;
+            fs->end = fs->buf + buf_size;
         }
     }
 
     return fs;
 }
 
+/* Give FS, just made, a pending buffer of SIZE bytes.  If that fails, FS is
+   freed and NULL returned.  */
+static argp_fmtstream_t
+fmtstream_add_pending(argp_fmtstream_t fs, size_t size)
+{
+    struct argp_fmtstream_pending *pending;
+
+    pending = malloc(sizeof (struct argp_fmtstream_pending));
+    if (pending)
+        pending->data = malloc(size);
+    if (! pending || ! pending->data) {
+        free(pending);
+        free(fs->buf);
+        free(fs);
+        return NULL;
+    }
+
+    pending->len = 0;
+    pending->size = size;
+    pending->iovcnt = 0;
+    fs->pending = pending;
+
+    return fs;
+}
+
+/* Return an argp_fmtstream that outputs to STREAM, and which prefixes lines
+   written on it with LMARGIN spaces and limits them to RMARGIN columns
+   total.  If WMARGIN >= 0, words that extend past RMARGIN are wrapped by
+   replacing the whitespace before them with a newline and WMARGIN spaces.
+   Otherwise, chars beyond RMARGIN are simply dropped until a newline.
+   Returns NULL if there was an error.  */
+argp_fmtstream_t
+__argp_make_fmtstream(FILE *stream,
+        size_t lmargin, size_t rmargin, ssize_t wmargin)
+{
+    return __argp_make_bounded_fmtstream(stream, lmargin, rmargin, wmargin,
+                                         0, 0);
+}
+
+/* Like __argp_make_fmtstream, but the returned stream uses a buffer of
+   exactly BUF_SIZE bytes that never grows, and stops writing for good as soon
+   as LIMIT bytes have been output (if LIMIT is non-zero) or STREAM reports an
+   error.  A BUF_SIZE of 0 gives the usual growable buffer.  Returns NULL if
+   there was an error.  */
+argp_fmtstream_t
+__argp_make_bounded_fmtstream(FILE *stream,
+        size_t lmargin, size_t rmargin, ssize_t wmargin,
+        size_t buf_size, size_t limit)
+{
+    argp_fmtstream_t fs;
+
+    fs = fmtstream_new(lmargin, rmargin, wmargin, buf_size, limit);
+    if (fs != NULL)
+        fs->stream = stream;
+
+    return fs;
+}
+
+/* Like __argp_make_fmtstream, but output goes to WRITE_FN, called with
+   COOKIE, instead of to a stream.  The buffer behaves exactly as for a
+   stream, so the text comes out the same.  Returns NULL if there was an
+   error.  */
+argp_fmtstream_t
+__argp_make_fmtstream_fn(argp_fmtstream_write_fn write_fn, void *cookie,
+        size_t lmargin, size_t rmargin, ssize_t wmargin)
+{
+    argp_fmtstream_t fs;
+
+    fs = fmtstream_new(lmargin, rmargin, wmargin, 0, 0);
+    if (fs != NULL) {
+        fs->sink = ARGP_FMTSTREAM_SINK_CALLBACK;
+        fs->write_fn = write_fn;
+        fs->cookie = cookie;
+    }
+
+    return fs;
+}
+
+/* Like __argp_make_fmtstream, but output goes to the file descriptor FD.
+   The wrapping buffer is the same as for a stream, so the text comes out
+   the same; what it passes on is gathered up, margins by reference, and
+   written FD_SINK_BUF_SIZE bytes or so at a time with writev.  Returns NULL
+   if there was an error.  */
+argp_fmtstream_t
+__argp_make_fmtstream_fd(int fd, size_t lmargin, size_t rmargin,
+        ssize_t wmargin)
+{
+    argp_fmtstream_t fs;
+
+    fs = fmtstream_new(lmargin, rmargin, wmargin, 0, 0);
+    if (fs != NULL) {
+        fs->sink = ARGP_FMTSTREAM_SINK_FD;
+        fs->fd = fd;
+        fs = fmtstream_add_pending(fs, FD_SINK_BUF_SIZE);
+    }
+
+    return fs;
+}
+
+/* Like __argp_make_fmtstream, but output is kept in memory, to be had from
+   __argp_fmtstream_take_memory.  Returns NULL if there was an error.  */
+argp_fmtstream_t
+__argp_make_fmtstream_mem(size_t lmargin, size_t rmargin, ssize_t wmargin)
+{
+    argp_fmtstream_t fs;
+
+    fs = fmtstream_new(lmargin, rmargin, wmargin, 0, 0);
+    if (fs != NULL) {
+        fs->sink = ARGP_FMTSTREAM_SINK_MEMORY;
+        fs = fmtstream_add_pending(fs, INIT_BUF_SIZE);
+    }
+
+    return fs;
+}
+
+/* Write out the pieces FS's FD sink has gathered.  A write error stops FS,
+   and what wasn't written is taken off FS's count.  */
+static void
+fmtstream_fd_drain(argp_fmtstream_t fs)
+{
+    struct argp_fmtstream_pending *pending = fs->pending;
+    struct iovec *iov = pending->iov;
+    int iovcnt = pending->iovcnt;
+
+    while (iovcnt > 0) {
+        ssize_t wrote = writev(fs->fd, iov, iovcnt);
+
+        if (wrote < 0 && errno == EINTR)
+            continue;
+        if (wrote <= 0) {
+            fs->stopped = 1;
+            break;
+        }
+
+        /* Skip what was written, which may end in the middle of a piece.  */
+        while (iovcnt > 0 && (size_t) wrote >= iov->iov_len) {
+            wrote -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *) iov->iov_base + wrote;
+            iov->iov_len -= wrote;
+        }
+    }
+
+    while (iovcnt-- > 0)
+        fs->written -= iov++->iov_len;
+    pending->len = 0;
+    pending->iovcnt = 0;
+}
+
+/* Add LEN bytes at DATA to what FS's FD sink is to write.  If SHARED, DATA
+   is part of FMTSTREAM_BLANKS, and needn't be copied.  */
+static void
+fmtstream_fd_add(argp_fmtstream_t fs, const char *data, size_t len,
+        int shared)
+{
+    struct argp_fmtstream_pending *pending = fs->pending;
+    struct iovec *last;
+
+    if (pending->iovcnt == FD_SINK_IOV
+        || (! shared && len > pending->size - pending->len))
+        fmtstream_fd_drain(fs);
+
+    if (! shared && len > pending->size) {
+        /* Too big to gather; write it on its own.  */
+        pending->iov[0].iov_base = (char *) data;
+        pending->iov[0].iov_len = len;
+        pending->iovcnt = 1;
+        fmtstream_fd_drain(fs);
+        return;
+    }
+
+    if (! shared) {
+        memcpy(pending->data + pending->len, data, len);
+        data = pending->data + pending->len;
+        pending->len += len;
+    }
+
+    /* Text that follows text in DATA just extends the last piece.  */
+    last = pending->iovcnt ? &pending->iov[pending->iovcnt - 1] : NULL;
+    if (last && ! shared && (char *) last->iov_base + last->iov_len == data)
+        last->iov_len += len;
+    else {
+        pending->iov[pending->iovcnt].iov_base = (char *) data;
+        pending->iov[pending->iovcnt].iov_len = len;
+        pending->iovcnt++;
+    }
+}
+
+/* Append LEN bytes at DATA to FS's MEMORY sink.  Returns false if there
+   wasn't enough memory.  */
+static int
+fmtstream_mem_add(argp_fmtstream_t fs, const char *data, size_t len)
+{
+    struct argp_fmtstream_pending *pending = fs->pending;
+
+    if (len > pending->size - pending->len) {
+        size_t new_size = 2 * pending->size + len;
+        char *new_data;
+
+        if (new_size < pending->size
+            || ! (new_data = realloc(pending->data, new_size))) {
+            errno = ENOMEM;
+            return 0;
+        }
+        pending->data = new_data;
+        pending->size = new_size;
+    }
+
+    memcpy(pending->data + pending->len, data, len);
+    pending->len += len;
+
+    return 1;
+}
+
+/* Write LEN bytes at DATA to FS's sink, unless FS has stopped.  If SHARED,
+   DATA is part of FMTSTREAM_BLANKS, and stays put.  Output is cut short at
+   FS's byte limit; hitting it or a write error stops FS.  Returns the number
+   of bytes actually written (or taken by the sink to write later).  */
+static size_t
+fmtstream_output_shared(argp_fmtstream_t fs, const char *data, size_t len,
+        int shared)
+{
+    size_t wrote;
+
+    if (fs->stopped)
+        return 0;
+
+    if (fs->limit && len >= fs->limit - fs->written) {
+        len = fs->limit - fs->written;
+        fs->stopped = 1;
+    }
+
+    if (! len)
+        wrote = 0;
+    else switch (fs->sink) {
+    case ARGP_FMTSTREAM_SINK_FD:
+        fmtstream_fd_add(fs, data, len, shared);
+        wrote = fs->stopped ? 0 : len;
+        break;
+    case ARGP_FMTSTREAM_SINK_MEMORY:
+        wrote = fmtstream_mem_add(fs, data, len) ? len : 0;
+        break;
+    case ARGP_FMTSTREAM_SINK_CALLBACK:
+        wrote = (*fs->write_fn)(fs->cookie, data, len);
+        break;
+    default:
+        wrote = fwrite(data, 1, len, fs->stream);
+        break;
+    }
+    fs->written += wrote;
+    if (wrote < len)
+        fs->stopped = 1;
+
+    return wrote;
+}
+
+/* Write LEN bytes at DATA to FS's sink, as fmtstream_output_shared does.  */
+static size_t
+fmtstream_output(argp_fmtstream_t fs, const char *data, size_t len)
+{
+    return fmtstream_output_shared(fs, data, len, 0);
+}
+
+/* Write N spaces to FS's sink, bypassing the buffer.  */
+static void
+fmtstream_output_blanks(argp_fmtstream_t fs, size_t n)
+{
+    while (n > 0 && !fs->stopped) {
+        size_t chunk = n < sizeof (fmtstream_blanks)
+            ? n : sizeof (fmtstream_blanks);
+        fmtstream_output_shared(fs, fmtstream_blanks, chunk, 1);
+        n -= chunk;
+    }
+}
+
 /* Flush FS to its stream, and free it (but don't close the stream).  */
 void
 __argp_fmtstream_free(argp_fmtstream_t fs)
 {
-    __argp_fmtstream_update(fs);
-    if (fs->p > fs->buf) {
-        fwrite(fs->buf, 1, fs->p - fs->buf, fs->stream);
-    }
+    __argp_fmtstream_flush(fs);
 
+    if (fs->pending) {
+        free(fs->pending->data);
+        free(fs->pending);
+    }
     free(fs->buf);
     free(fs);
 }
 
+/* Do any pending line wrapping in FS and write out its whole buffer.  The
+   output column is kept, so this may be done in the middle of a line.  */
+void
+__argp_fmtstream_flush(argp_fmtstream_t fs)
+{
+    __argp_fmtstream_update(fs);
+    if (fs->p > fs->buf)
+        fmtstream_output(fs, fs->buf, fs->p - fs->buf);
+
+    fs->p = fs->buf;
+    fs->point_offs = 0;
+
+    if (fs->sink == ARGP_FMTSTREAM_SINK_FD)
+        fmtstream_fd_drain(fs);
+
+    /* A bounded stream is meant to get its output to the reader early, and
+        to notice a reader that has gone away (EPIPE) before doing more work.  */
+    if (fs->bounded && !fs->stopped && fs->stream && fflush(fs->stream) != 0)
+        fs->stopped = 1;
+}
+
+/* Flush FS, which must have been made by __argp_make_fmtstream_mem, and
+   return everything written to it so far as a '\0'-terminated string for
+   the caller to free, storing its length in *LEN if LEN isn't NULL.  FS
+   starts over empty.  Returns NULL if there wasn't enough memory.  */
+char *
+__argp_fmtstream_take_memory(argp_fmtstream_t fs, size_t *len)
+{
+    struct argp_fmtstream_pending *pending = fs->pending;
+    char *data;
+
+    __argp_fmtstream_flush(fs);
+    if (fs->stopped || ! fmtstream_mem_add(fs, "", 1))
+        return NULL;
+
+    data = pending->data;
+    if (len)
+        *len = pending->len - 1;
+
+    pending->data = malloc(INIT_BUF_SIZE);
+    pending->len = 0;
+    pending->size = pending->data ? INIT_BUF_SIZE : 0;
+
+    return data;
+}
+
+/* Columns are counted in display width, so that text translated into
+   languages written with multibyte or double-width characters lines up and
+   wraps as it should.  Help text is mostly ASCII, one column a byte, and
+   runs of that are skipped over a block at a time.  Other UTF-8 characters
+   take 0, 1 or 2 columns, as wcwidth would say; bytes that aren't valid
+   UTF-8 take one column each, as they always have.  */
+
+
+/* Return how many of the N bytes at S are ASCII before the first that
+   isn't.  */
+static inline size_t
+fmtstream_ascii_span(const char *s, size_t n)
+{
+    const size_t high_bits = (size_t) -1 / 0xff * 0x80;
+    size_t i = 0, word;
+
+#ifdef CPU_SSE2
+    if (n >= 16) {
+        int high;
+
+        for (; i + 16 <= n; i += 16) {
+            high = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (s + i)));
+            if (high)
+                return i + cpu_ctz(high);
+        }
+        /* The last block overlaps what's been checked already.  */
+        if (i < n
+            && (high = _mm_movemask_epi8(
+                    _mm_loadu_si128((const __m128i *) (s + n - 16)))))
+            return n - 16 + cpu_ctz(high);
+        return n;
+    }
+#endif
+    for (; i + sizeof (word) <= n; i += sizeof (word)) {
+        memcpy(&word, s + i, sizeof (word));
+        if (word & high_bits)
+            break;
+    }
+    if (i + sizeof (word) > n && n >= sizeof (word)) {
+        memcpy(&word, s + n - sizeof (word), sizeof (word));
+        if (!(word & high_bits))
+            return n;
+    }
+    while (i < n && !(s[i] & 0x80))
+        i++;
+
+    return i;
+}
+
+/* Return the first newline in the text from S to E, or NULL if there's
+   none, and set *WIDE to the first byte before it that isn't ASCII, or to
+   the end of the line if they all are.  For ASCII text the two are found in
+   the same pass.  */
+static const char *
+fmtstream_scan(const char *s, const char *e, const char **wide)
+{
+    const char *nl;
+
+#ifdef CPU_SSE2
+    if (e - s >= 16) {
+        const __m128i newline = _mm_set1_epi8('\n');
+        const char *p = s;
+        unsigned skip = 0;
+
+        /* Newlines compare to all ones, so a block has either kind of byte
+           if its bytes or'ed with the comparison have a high bit set.  */
+        for (; e - p >= 32; p += 32) {
+            __m128i a = _mm_loadu_si128((const __m128i *) p);
+            __m128i b = _mm_loadu_si128((const __m128i *) (p + 16));
+
+            if (_mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(a, b),
+                    _mm_or_si128(_mm_cmpeq_epi8(a, newline),
+                                 _mm_cmpeq_epi8(b, newline)))))
+                break;
+        }
+
+        for (;;) {
+            __m128i block;
+            unsigned hits;
+
+            if (e - p < 16) {
+                if (p == e)
+                    break;
+                /* The last block overlaps what's been checked already.  */
+                skip = 16 - (e - p);
+                p = e - 16;
+            }
+            block = _mm_loadu_si128((const __m128i *) p);
+            hits = _mm_movemask_epi8(
+                _mm_or_si128(block, _mm_cmpeq_epi8(block, newline)));
+            hits = hits >> skip << skip;
+
+            if (hits) {
+                p += cpu_ctz(hits);
+                *wide = p;
+                return *p == '\n' ? p : memchr(p, '\n', e - p);
+            }
+            if (skip)
+                break;
+            p += 16;
+        }
+
+        *wide = e;
+        return NULL;
+    }
+#endif
+    nl = memchr(s, '\n', e - s);
+    *wide = s + fmtstream_ascii_span(s, (nl ? nl : e) - s);
+
+    return nl;
+}
+
+/* A range of code points, in a sorted table.  */
+struct fmtstream_range
+{
+    unsigned first, last;
+};
+
+/* Combining and other zero-width characters of the common scripts.  */
+static const struct fmtstream_range fmtstream_zero_width[] = {
+    { 0x0300, 0x036f }, { 0x0483, 0x0489 }, { 0x0591, 0x05bd },
+    { 0x05bf, 0x05bf }, { 0x05c1, 0x05c2 }, { 0x05c4, 0x05c5 },
+    { 0x05c7, 0x05c7 }, { 0x0610, 0x061a }, { 0x064b, 0x065f },
+    { 0x0670, 0x0670 }, { 0x06d6, 0x06dc }, { 0x06df, 0x06e4 },
+    { 0x06e7, 0x06e8 }, { 0x06ea, 0x06ed }, { 0x0900, 0x0902 },
+    { 0x093a, 0x093a }, { 0x093c, 0x093c }, { 0x0941, 0x0948 },
+    { 0x094d, 0x094d }, { 0x0951, 0x0957 }, { 0x0962, 0x0963 },
+    { 0x0e31, 0x0e31 }, { 0x0e34, 0x0e3a }, { 0x0e47, 0x0e4e },
+    { 0x1ab0, 0x1aff }, { 0x1dc0, 0x1dff }, { 0x200b, 0x200f },
+    { 0x202a, 0x202e }, { 0x2060, 0x2064 }, { 0x20d0, 0x20ff },
+    { 0x302a, 0x302d }, { 0x3099, 0x309a }, { 0xfe00, 0xfe0f },
+    { 0xfe20, 0xfe2f }, { 0xfeff, 0xfeff }, { 0xe0100, 0xe01ef },
+};
+
+/* East Asian wide and fullwidth characters.  */
+static const struct fmtstream_range fmtstream_double_width[] = {
+    { 0x1100, 0x115f }, { 0x231a, 0x231b }, { 0x2329, 0x232a },
+    { 0x23e9, 0x23ec }, { 0x23f0, 0x23f0 }, { 0x23f3, 0x23f3 },
+    { 0x25fd, 0x25fe }, { 0x2614, 0x2615 }, { 0x2648, 0x2653 },
+    { 0x267f, 0x267f }, { 0x2693, 0x2693 }, { 0x26a1, 0x26a1 },
+    { 0x26aa, 0x26ab }, { 0x26bd, 0x26be }, { 0x26c4, 0x26c5 },
+    { 0x26ce, 0x26ce }, { 0x26d4, 0x26d4 }, { 0x26ea, 0x26ea },
+    { 0x26f2, 0x26f3 }, { 0x26f5, 0x26f5 }, { 0x26fa, 0x26fa },
+    { 0x26fd, 0x26fd }, { 0x2705, 0x2705 }, { 0x270a, 0x270b },
+    { 0x2728, 0x2728 }, { 0x274c, 0x274c }, { 0x274e, 0x274e },
+    { 0x2753, 0x2755 }, { 0x2757, 0x2757 }, { 0x2795, 0x2797 },
+    { 0x27b0, 0x27b0 }, { 0x27bf, 0x27bf }, { 0x2b1b, 0x2b1c },
+    { 0x2b50, 0x2b50 }, { 0x2b55, 0x2b55 }, { 0x2e80, 0x303e },
+    { 0x3041, 0x33ff }, { 0x3400, 0x4dbf }, { 0x4e00, 0xa4cf },
+    { 0xa960, 0xa97f }, { 0xac00, 0xd7a3 }, { 0xf900, 0xfaff },
+    { 0xfe10, 0xfe19 }, { 0xfe30, 0xfe6f }, { 0xff00, 0xff60 },
+    { 0xffe0, 0xffe6 }, { 0x16fe0, 0x16fe4 }, { 0x17000, 0x18aff },
+    { 0x1b000, 0x1b2ff }, { 0x1f004, 0x1f004 }, { 0x1f0cf, 0x1f0cf },
+    { 0x1f18e, 0x1f18e }, { 0x1f191, 0x1f19a }, { 0x1f200, 0x1f251 },
+    { 0x1f300, 0x1f64f }, { 0x1f680, 0x1f6ff }, { 0x1f900, 0x1f9ff },
+    { 0x20000, 0x2fffd }, { 0x30000, 0x3fffd },
+};
+
+/* Return true if C is in the sorted table of N RANGES.  */
+static int
+fmtstream_in_ranges(unsigned c, const struct fmtstream_range *ranges,
+        size_t n)
+{
+    size_t lo = 0, hi = n;
+
+    if (c < ranges[0].first || c > ranges[n - 1].last)
+        return 0;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+
+        if (c > ranges[mid].last)
+            lo = mid + 1;
+        else if (c < ranges[mid].first)
+            hi = mid;
+        else
+            return 1;
+    }
+
+    return 0;
+}
+
+/* Decode the non-ASCII character at S, which has bytes up to E, storing
+   its width in *WIDTH.  Returns its length in bytes; a byte that doesn't
+   start a valid UTF-8 sequence is taken on its own, with a width of 1.  */
+static size_t
+fmtstream_char_width(const char *s, const char *e, int *width)
+{
+    const unsigned char *u = (const unsigned char *) s;
+    size_t len, i;
+    unsigned c;
+
+    *width = 1;
+    if (u[0] >= 0xc2 && u[0] <= 0xdf) {
+        len = 2;
+        c = u[0] & 0x1f;
+    } else if (u[0] >= 0xe0 && u[0] <= 0xef) {
+        len = 3;
+        c = u[0] & 0x0f;
+    } else if (u[0] >= 0xf0 && u[0] <= 0xf4) {
+        len = 4;
+        c = u[0] & 0x07;
+    } else
+        return 1;
+
+    if ((size_t) (e - s) < len)
+        return 1;
+    for (i = 1; i < len; i++) {
+        if ((u[i] & 0xc0) != 0x80)
+            return 1;
+        c = (c << 6) | (u[i] & 0x3f);
+    }
+    /* Overlong forms, surrogates and what's past U+10FFFF aren't valid.  */
+    if ((len == 3 && (c < 0x800 || (c >= 0xd800 && c <= 0xdfff)))
+        || (len == 4 && (c < 0x10000 || c > 0x10ffff)))
+        return 1;
+
+    if (fmtstream_in_ranges(c, fmtstream_zero_width,
+            sizeof (fmtstream_zero_width) / sizeof (fmtstream_zero_width[0])))
+        *width = 0;
+    else if (fmtstream_in_ranges(c, fmtstream_double_width,
+            sizeof (fmtstream_double_width)
+            / sizeof (fmtstream_double_width[0])))
+        *width = 2;
+
+    return len;
+}
+
+/* Return how many bytes of the text from S up to E fit before column
+   LIMIT, starting at column *COL, which is advanced past them.  A character
+   fits if it ends no further right than LIMIT.  */
+static size_t
+fmtstream_fit(const char *s, const char *e, ssize_t limit, ssize_t *col)
+{
+    const char *p = s;
+
+    while (p < e && *col < limit) {
+        size_t room = limit - *col;
+        size_t ascii = fmtstream_ascii_span(p, (size_t) (e - p) < room
+                                                ? (size_t) (e - p) : room);
+        int width;
+        size_t len;
+
+        p += ascii;
+        *col += ascii;
+        if (p == e || *col >= limit || !(*p & 0x80))
+            break;
+
+        len = fmtstream_char_width(p, e, &width);
+        if (*col + width > limit)
+            break;
+        p += len;
+        *col += width;
+    }
+
+    /* Zero-width characters at the limit still belong before it.  */
+    while (p < e && (*p & 0x80)) {
+        int width;
+        size_t len = fmtstream_char_width(p, e, &width);
+
+        if (width)
+            break;
+        p += len;
+    }
+
+    return p - s;
+}
+
+/* Return the number of columns the LEN bytes at STR take up.  */
+size_t
+__argp_fmtstream_width(const char *str, size_t len)
+{
+    const char *e = str + len;
+    size_t width = 0;
+
+    while (str < e) {
+        size_t ascii = fmtstream_ascii_span(str, e - str);
+        int w;
+
+        str += ascii;
+        width += ascii;
+        if (str < e) {
+            str += fmtstream_char_width(str, e, &w);
+            width += w;
+        }
+    }
+
+    return width;
+}
+
+/* Blanks, where lines may be broken, are spaces and tabs: what isblank
+   says in the C locale and in UTF-8 ones, where no other single byte is a
+   character, let alone a blank.  Deciding it here rather than per byte
+   through the locale lets the searches below look at many bytes at once,
+   and they and the byte-at-a-time loops always agree.  */
+#define fmtstream_isblank(c) ((c) == ' ' || (c) == '\t')
+
+/* Searches for where words begin and end, in versions for what the CPU can
+   do; see fmtstream_scanners for the one that's used.  */
+struct fmtstream_scanners
+{
+    /* Return the index of the last blank in the N bytes at S, or -1.  */
+    ssize_t (*last_blank)(const char *s, size_t n);
+    /* Return the first blank or newline from S up to E, or E.  */
+    const char *(*word_end)(const char *s, const char *e);
+};
+
+/* Each byte of X with the same value as the corresponding one of Y has just
+   its high bit set in the result, and others are clear.  */
+#define fmtstream_bytes_eq(x, y) \
+    (~(((((x) ^ (y)) & ~high_bits) + ~high_bits) | ((x) ^ (y))) & high_bits)
+
+static ssize_t
+fmtstream_last_blank_generic(const char *s, size_t n)
+{
+    const size_t high_bits = (size_t) -1 / 0xff * 0x80;
+    const size_t spaces = (size_t) -1 / 0xff * ' ';
+    const size_t tabs = (size_t) -1 / 0xff * '\t';
+    size_t word;
+
+    for (; n >= sizeof (word); n -= sizeof (word)) {
+        memcpy(&word, s + n - sizeof (word), sizeof (word));
+        if (fmtstream_bytes_eq(word, spaces) | fmtstream_bytes_eq(word, tabs))
+            break;
+    }
+    while (n > 0 && !fmtstream_isblank(s[n - 1]))
+        n--;
+
+    return (ssize_t) n - 1;
+}
+
+static const char *
+fmtstream_word_end_generic(const char *s, const char *e)
+{
+    const size_t high_bits = (size_t) -1 / 0xff * 0x80;
+    const size_t spaces = (size_t) -1 / 0xff * ' ';
+    const size_t tabs = (size_t) -1 / 0xff * '\t';
+    const size_t newlines = (size_t) -1 / 0xff * '\n';
+    size_t word;
+
+    for (; (size_t) (e - s) >= sizeof (word); s += sizeof (word)) {
+        memcpy(&word, s, sizeof (word));
+        if (fmtstream_bytes_eq(word, spaces) | fmtstream_bytes_eq(word, tabs)
+            | fmtstream_bytes_eq(word, newlines))
+            break;
+    }
+    while (s < e && !fmtstream_isblank(*s) && *s != '\n')
+        s++;
+
+    return s;
+}
+
+#ifndef CPU_SSE2
+static const struct fmtstream_scanners fmtstream_generic_scanners = {
+    fmtstream_last_blank_generic, fmtstream_word_end_generic
+};
+#endif
+
+#ifdef CPU_SSE2
+/* Return a mask of the bytes in BLOCK that are blanks.  */
+# define fmtstream_blanks_sse2(block) \
+    _mm_movemask_epi8(_mm_or_si128(                                    \
+        _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),                     \
+        _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'))))
+
+static ssize_t
+fmtstream_last_blank_sse2(const char *s, size_t n)
+{
+    size_t left = n;
+    unsigned blanks;
+
+    if (n < 16)
+        return fmtstream_last_blank_generic(s, n);
+
+    for (; left >= 16; left -= 16) {
+        blanks = fmtstream_blanks_sse2(
+            _mm_loadu_si128((const __m128i *) (s + left - 16)));
+        if (blanks)
+            return left - 16 + cpu_msb(blanks);
+    }
+    if (left == 0)
+        return -1;
+
+    /* The first block overlaps what's been checked already.  */
+    blanks = fmtstream_blanks_sse2(_mm_loadu_si128((const __m128i *) s));
+    blanks &= (1u << left) - 1;
+
+    return blanks ? cpu_msb(blanks) : -1;
+}
+
+static const char *
+fmtstream_word_end_sse2(const char *s, const char *e)
+{
+    const char *p = s;
+    unsigned ends, skip = 0;
+
+    if (e - s < 16)
+        return fmtstream_word_end_generic(s, e);
+
+    for (;;) {
+        __m128i block;
+
+        if (e - p < 16) {
+            if (p == e)
+                return e;
+            /* The last block overlaps what's been checked already.  */
+            skip = 16 - (e - p);
+            p = e - 16;
+        }
+        block = _mm_loadu_si128((const __m128i *) p);
+        ends = fmtstream_blanks_sse2(block)
+               | _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+        ends = ends >> skip << skip;
+        if (ends)
+            return p + cpu_ctz(ends);
+        if (skip)
+            return e;
+        p += 16;
+    }
+}
+
+static const struct fmtstream_scanners fmtstream_sse2_scanners = {
+    fmtstream_last_blank_sse2, fmtstream_word_end_sse2
+};
+#endif /* CPU_SSE2 */
+
+#ifdef CPU_AVX2
+/* Return a mask of the bytes in BLOCK that are blanks.  */
+# define fmtstream_blanks_avx2(block) \
+    (unsigned) _mm256_movemask_epi8(_mm256_or_si256(                   \
+        _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),               \
+        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'))))
+
+static CPU_TARGET_AVX2 ssize_t
+fmtstream_last_blank_avx2(const char *s, size_t n)
+{
+    size_t left = n;
+    unsigned blanks;
+
+    if (n < 32)
+        return fmtstream_last_blank_generic(s, n);
+
+    for (; left >= 32; left -= 32) {
+        blanks = fmtstream_blanks_avx2(
+            _mm256_loadu_si256((const __m256i *) (s + left - 32)));
+        if (blanks)
+            return left - 32 + cpu_msb(blanks);
+    }
+    if (left == 0)
+        return -1;
+
+    /* The first block overlaps what's been checked already.  */
+    blanks = fmtstream_blanks_avx2(_mm256_loadu_si256((const __m256i *) s));
+    blanks &= (1u << left) - 1;
+
+    return blanks ? cpu_msb(blanks) : -1;
+}
+
+static CPU_TARGET_AVX2 const char *
+fmtstream_word_end_avx2(const char *s, const char *e)
+{
+    const char *p = s;
+    unsigned ends, skip = 0;
+
+    if (e - s < 32)
+        return fmtstream_word_end_generic(s, e);
+
+    for (;;) {
+        __m256i block;
+
+        if (e - p < 32) {
+            if (p == e)
+                return e;
+            /* The last block overlaps what's been checked already.  */
+            skip = 32 - (e - p);
+            p = e - 32;
+        }
+        block = _mm256_loadu_si256((const __m256i *) p);
+        ends = fmtstream_blanks_avx2(block)
+               | (unsigned) _mm256_movemask_epi8(
+                     _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+        /* SKIP is less than 32 here, so these shifts are defined.  */
+        ends = ends >> skip << skip;
+        if (ends)
+            return p + cpu_ctz(ends);
+        if (skip)
+            return e;
+        p += 32;
+    }
+}
+
+static const struct fmtstream_scanners fmtstream_avx2_scanners = {
+    fmtstream_last_blank_avx2, fmtstream_word_end_avx2
+};
+#endif /* CPU_AVX2 */
+
+/* Return the best searches the CPU can run, deciding the first time.
+   Threads racing to decide all come to the same answer.  */
+static const struct fmtstream_scanners *
+fmtstream_scanners(void)
+{
+    static const struct fmtstream_scanners *volatile chosen;
+    const struct fmtstream_scanners *scanners = chosen;
+
+    if (!scanners) {
+#ifdef CPU_AVX2
+        if (cpu_has_avx2())
+            scanners = &fmtstream_avx2_scanners;
+        else
+#endif
+#ifdef CPU_SSE2
+            scanners = &fmtstream_sse2_scanners;
+#else
+            scanners = &fmtstream_generic_scanners;
+#endif
+        chosen = scanners;
+    }
+
+    return scanners;
+}
+
+/* Helpers for __argp_fmtstream_update.  The text still to be wrapped runs
+   from *S to *E; the wrapped result is written at *O, which never gets
+   ahead of *S unless the text has been moved out of the way.  */
+
+/* Append LEN bytes at SRC to the wrapped text at *O.  */
+static inline void
+fmtstream_emit(char **o, const char *src, size_t len)
+{
+    if (*o != src)
+        memmove(*o, src, len);
+    *o += len;
+}
+
+/* Make sure that writing AMOUNT more bytes at O won't overwrite any text
+   from *S to *E that is still to be wrapped, by moving that text to the end
+   of FS's buffer.  This happens at most once per update, so each byte is
+   copied a bounded number of times.  Since room is only used when the old
+   in-place algorithm had it, the text at the end is never caught up with.  */
+static inline void
+fmtstream_reserve(argp_fmtstream_t fs, const char *o, size_t amount,
+                  const char **s, const char **e)
+{
+    if (o + amount > *s) {
+        size_t left = *e - *s;
+        char *dst = fs->end - left;
+
+        memmove(dst, *s, left);
+        *s = dst;
+        *e = fs->end;
+    }
+}
+
+/* Write the wrapped text from FS's buffer up to *O to its stream, so the
+   buffer can be reused from the start.  */
+static inline void
+fmtstream_output_done(argp_fmtstream_t fs, char **o)
+{
+    if (*o > fs->buf)
+        fmtstream_output(fs, fs->buf, *o - fs->buf);
+    *o = fs->buf;
+}
+
+/* Return true if the text at P, which is still to be wrapped and ends at E,
+   is a blank.  There is nothing blank at or after E.  */
+#define fmtstream_blank_at(p, e) ((p) < (e) && fmtstream_isblank(*(p)))
+
 /* Process FS's buffer so that line wrapping is done from POINT_OFFS to the
-   end of its buffer.  This code is mostly from glibc stdio/linewrap.c.  */
+   end of its buffer.  The algorithm is that of glibc stdio/linewrap.c, and
+   makes the same decisions in the same places, but instead of inserting
+   margins by moving the rest of the buffer up (which takes time quadratic in
+   the number of lines), each byte is copied forward once into its final
+   place.  Where the old code ran out of buffer space it could write margin
+   blanks to the stream ahead of text that was still buffered; here any such
+   text is written first.  Nothing past the end of the text is ever read.  */
 void
 __argp_fmtstream_update(argp_fmtstream_t fs)
 {
-    char *buf, *nl;
-    size_t len;
+    char *o = fs->buf + fs->point_offs;     /* Wrapped text goes here.  */
+    const char *s = o, *e = fs->p;          /* Text still to be wrapped.  */
+    /* How far before E the next newline is, or 0 if there's none, so that
+        long paragraphs aren't searched over again for each line.  It's a
+        distance since the text may be moved.  */
+    size_t nl_before_end = 0;
+    int nl_known = 0;
+    /* Likewise for the next byte before that which isn't ASCII, or the end
+        of the line.  Up to it, a column is a byte and lines are measured by
+        their lengths alone.  */
+    size_t wide_before_end = 0;
+    const struct fmtstream_scanners *scan = fmtstream_scanners();
 
-    /* Scan the buffer for newlines.  */
-    buf = fs->buf + fs->point_offs;
-    while (buf < fs->p) {
-        size_t r;
+    while (s < e) {
+        const char *nl, *ascii_end;
+        size_t len, r, fitted = 0;
+        ssize_t col = 0;
+        int ascii;
 
         if (fs->point_col == 0 && fs->lmargin != 0) {
-        /* We are starting a new line.  Print spaces to the left margin.  */
+            /* We are starting a new line.  Print spaces to the left margin.  */
             const size_t pad = fs->lmargin;
-            if (fs->p + pad < fs->end) {
-                /* We can fit in them in the buffer by moving the
-                buffer text up and filling in the beginning.  */
-                memmove(buf + pad, buf, fs->p - buf);
-                fs->p += pad; /* Compensate for bigger buffer. */
-                memset(buf, ' ', pad); /* Fill in the spaces.  */
-                buf += pad; /* Don't bother searching them.  */
-            } else {
+
+            if (o + (e - s) + pad >= fs->end)
+                /* Make space by writing out what's done.  */
+                fmtstream_output_done(fs, &o);
+
+            if (o + (e - s) + pad < fs->end) {
+                fmtstream_reserve(fs, o, pad, &s, &e);
+                memset(o, ' ', pad);
+                o += pad;
+            } else
                 /* No buffer space for spaces.  Must flush.  */
-                size_t i;
-                for (i = 0; i < pad; i++) {
-                    putc(' ', fs->stream);
-                }
-            }
+                fmtstream_output_blanks(fs, pad);
             fs->point_col = pad;
         }
 
-        len = fs->p - buf;
-        nl = memchr(buf, '\n', len);
+        len = e - s;
+        if (!nl_known || (nl_before_end && e - nl_before_end < s)) {
+            nl = fmtstream_scan(s, e, &ascii_end);
+            nl_before_end = nl ? (size_t) (e - nl) : 0;
+            nl_known = 1;
+        } else {
+            nl = nl_before_end ? e - nl_before_end : NULL;
+            ascii_end = e - wide_before_end;
+            if (ascii_end < s)
+                /* We've wrapped past it; look for the next in the line.  */
+                ascii_end = s + fmtstream_ascii_span(s, (nl ? nl : e) - s);
+        }
+        wide_before_end = e - ascii_end;
 
         if (fs->point_col < 0)
             fs->point_col = 0;
 
+        /* No text takes up more columns than it has bytes, so text that fits
+            by its length fits.  */
         if (!nl) {
             /* The buffer ends in a partial line.  */
 
@@ -130,38 +1119,75 @@ __argp_fmtstream_update(argp_fmtstream_t fs)
                 /* The remaining buffer text is a partial line and fits
                 within the maximum line width.  Advance point for the
                 characters to be written and stop scanning.  */
-                fs->point_col += len;
+                fs->point_col += ascii_end == e
+                                 ? len : __argp_fmtstream_width(s, len);
+                fmtstream_emit(&o, s, len);
+                s = e;
                 break;
             } else
                 /* Set the end-of-line pointer for the code below to
                 the end of the buffer.  */
-                nl = fs->p;
-        } else if (fs->point_col + (nl - buf) < (ssize_t) fs->rmargin) {
+                nl = e;
+        } else if (fs->point_col + (nl - s) < (ssize_t) fs->rmargin) {
             /* The buffer contains a full line that fits within the maximum
                 line width.  Reset point and scan the next line.  */
             fs->point_col = 0;
-            buf = nl + 1;
+            fmtstream_emit(&o, s, nl + 1 - s);
+            s = nl + 1;
             continue;
         }
 
-        /* This line is too long.  */
+        /* The line has too many bytes.  If those up to and including the one
+            just past the right margin are ASCII, it's too long; otherwise
+            see how much of it fits in the columns left.  */
         r = fs->rmargin - 1;
+        ascii = fs->point_col >= (ssize_t) fs->rmargin
+                || s + (fs->rmargin - fs->point_col + 1 < (size_t) (nl - s)
+                        ? fs->rmargin - fs->point_col + 1
+                        : (size_t) (nl - s)) <= ascii_end;
+        if (!ascii) {
+            col = fs->point_col;
+            fitted = fmtstream_fit(s, nl, r, &col);
+            if (fitted == (size_t) (nl - s)) {
+                /* It fits after all.  */
+                fmtstream_emit(&o, s, fitted);
+                if (nl == e) {
+                    fs->point_col = col;
+                    s = e;
+                    break;
+                }
+                fmtstream_emit(&o, nl, 1);
+                fs->point_col = 0;
+                s = nl + 1;
+                continue;
+            }
+        }
+
+        /* This line is too long.  */
 
         if (fs->wmargin < 0) {
-            /* Truncate the line by overwriting the excess with the
-                newline and anything after it in the buffer.  */
-            if (nl < fs->p) {
-                memmove(buf + (r - fs->point_col), nl, fs->p - nl);
-                fs->p -= buf + (r - fs->point_col) - nl;
-                /* Reset point for the next line and start scanning it.  */
+            /* Truncate the line by dropping the excess up to the newline.  */
+            size_t keep;
+
+            if (ascii)
+                keep = fs->point_col < (ssize_t) r ? r - fs->point_col : 0;
+            else
+                keep = fitted;
+
+            fmtstream_emit(&o, s, keep);
+            if (nl < e) {
+                /* Keep the newline; reset point for the next line and start
+                scanning it.  */
+                fmtstream_emit(&o, nl, 1);
                 fs->point_col = 0;
-                buf += r + 1; /* Skip full line plus \n. */
+                s = nl + 1;
             } else {
                 /* The buffer ends with a partial line that is beyond the
                 maximum line width.  Advance point for the characters
-                written, and discard those past the max from the buffer.  */
-                fs->point_col += len;
-                fs->p -= fs->point_col - r;
+                written, and drop those past the max.  */
+                fs->point_col += ascii_end == e
+                                 ? len : __argp_fmtstream_width(s, len);
+                s = e;
                 break;
             }
         } else {
@@ -169,98 +1195,110 @@ __argp_fmtstream_update(argp_fmtstream_t fs)
                 width and scan back for the beginning of the word there.
                 Then insert a line break.  */
 
-            char *p, *nextline;
-            int i;
+            const size_t wmargin = fs->wmargin;
+            const char *lineend, *nextline;
+            ssize_t start, i;
+
+            /* START is the first character that doesn't end by the right
+                margin; it's before the text if point is already past it.  */
+            if (ascii)
+                start = (ssize_t) r + 1 - fs->point_col;
+            else
+                start = fitted + fmtstream_fit(s + fitted, nl, fs->rmargin,
+                                               &col);
 
-            p = buf + (r + 1 - fs->point_col);
-            while (p >= buf && !isblank(*p))
-                --p;
-            nextline = p + 1; /* This will begin the next line.  */
+            if (start < 0)
+                i = -1;
+            else
+                i = scan->last_blank(s, start < e - s ? start + 1 : e - s);
+            nextline = s + i + 1; /* This will begin the next line.  */
 
-            if (nextline > buf) {
+            if (i >= 0) {
                 /* Swallow separating blanks.  */
-                if (p >= buf)
-                    do
-                        --p;
-                    while (p >= buf && isblank(*p));
-                nl = p + 1;   /* The newline will replace the first blank. */
+                do
+                    --i;
+                while (i >= 0 && fmtstream_isblank(s[i]));
+                lineend = s + i + 1;  /* The newline replaces the first blank. */
             } else {
                 /* A single word that is greater than the maximum line width.
                 Oh well.  Put it on an overlong line by itself.  */
-                p = buf + (r + 1 - fs->point_col);
-                /* Find the end of the long word.  */
-                do
-                    ++p;
-                while (p < nl && !isblank(*p));
+                i = start < 0 ? -1 : start;
+                /* Find the end of the long word, which is at the newline
+                    if not before.  */
+                if (s + i + 1 < nl)
+                    i = scan->word_end(s + i + 1, e) - s;
+                else
+                    i++;
 
-                if (p == nl) {
-                    /* It already ends a line.  No fussing required.  */
+                if (s + i >= nl) {
+                    /* It already ends a line.  No fussing required.  (It may
+                        run right up to the newline, and the search start just
+                        past it.)  */
                     fs->point_col = 0;
-                    buf = nl + 1;
+                    if (nl < e)
+                        nl++;
+                    fmtstream_emit(&o, s, nl - s);
+                    s = nl;
                     continue;
                 }
-                /* We will move the newline to replace the first blank.  */
-                nl = p;
+                /* The newline will replace the first blank.  */
+                lineend = s + i;
                 /* Swallow separating blanks.  */
                 do
-                    ++p;
-                while (isblank(*p));
+                    ++i;
+                while (fmtstream_blank_at(s + i, e));
 
                 /* The next line will start here.  */
-                nextline = p;
+                nextline = s + i;
             }
 
-            /* Note: There are a bunch of tests below for
-                NEXTLINE == BUF + LEN + 1; this case is where NL happens to fall
-                at the end of the buffer, and NEXTLINE is in fact empty (and so
-                we need not be careful to maintain its contents).  */
-
-            if ((nextline == buf + len + 1
-                ? fs->end - nl < fs->wmargin + 1
-                : nextline - (nl + 1) < fs->wmargin)
-                && fs->p > nextline) {
+            /* Where the old in-place code had the room, the newline and the
+                margin go into the buffer; otherwise it wrote out the line
+                first, or sent the margin straight to the stream.  The same
+                choices are made here, so the buffer fills up the same way.  */
+            if ((size_t) (nextline - lineend) < wmargin + 1 && e > nextline) {
                 /* The margin needs more blanks than we removed.  */
-                if (fs->end - fs->p > fs->wmargin + 1) {
-                    /* Make some space for them.  */
-                    size_t mv = fs->p - nextline;
-                    memmove(nl + 1 + fs->wmargin, nextline, mv);
-                    nextline = nl + 1 + fs->wmargin;
-                    len = nextline + mv - buf;
-                    *nl++ = '\n';
+                if ((size_t) (fs->end - (o + (e - s))) > wmargin + 1) {
+                    /* There's room to make space for them.  */
+                    fmtstream_emit(&o, s, lineend - s);
+                    s = nextline;
+                    fmtstream_reserve(fs, o, wmargin + 1, &s, &e);
+                    *o++ = '\n';
+                    memset(o, ' ', wmargin);
+                    o += wmargin;
                 } else {
                     /* Output the first line so we can use the space.  */
-                    if (nl > fs->buf)
-                        fwrite(fs->buf, 1, nl - fs->buf, fs->stream);
-                    putc('\n', fs->stream);
+                    size_t nextline_offs = (o - fs->buf) + (nextline - s);
 
-                    len += buf - fs->buf;
-                    nl = buf = fs->buf;
-                }
-            } else
-                /* We can fit the newline and blanks in before
-                the next word.  */
-                *nl++ = '\n';
-
-            if (nextline - nl >= fs->wmargin
-                || (nextline == buf + len + 1 && fs->end - nextline >= fs->wmargin))
-                /* Add blanks up to the wrap margin column.  */
-                for (i = 0; i < fs->wmargin; ++i)
-                    *nl++ = ' ';
-            else
-                for (i = 0; i < fs->wmargin; ++i)
-                    putc(' ', fs->stream);
-
-            /* Copy the tail of the original buffer into the current buffer
-                position.  */
-            if (nl < nextline)
-                memmove(nl, nextline, buf + len - nextline);
-            len -= nextline - buf;
+                    fmtstream_emit(&o, s, lineend - s);
+                    fmtstream_output_done(fs, &o);
+                    fmtstream_output(fs, "\n", 1);
+                    s = nextline;
 
-            /* Continue the scan on the remaining lines in the buffer.  */
-            buf = nl;
+                    if (nextline_offs >= wmargin) {
+                        fmtstream_reserve(fs, o, wmargin, &s, &e);
+                        memset(o, ' ', wmargin);
+                        o += wmargin;
+                    } else
+                        fmtstream_output_blanks(fs, wmargin);
+                }
+            } else {
+                /* We can fit the newline in before the next word.  */
+                fmtstream_emit(&o, s, lineend - s);
+                *o++ = '\n';
 
-            /* Restore bufp to include all the remaining text.  */
-            fs->p = nl + len;
+                if ((size_t) (nextline - lineend) >= wmargin + 1) {
+                    /* And the blanks up to the wrap margin.  */
+                    memset(o, ' ', wmargin);
+                    o += wmargin;
+                } else {
+                    /* The line ends with blanks that run to the end of the
+                        buffer; get the line out before the margin.  */
+                    fmtstream_output_done(fs, &o);
+                    fmtstream_output_blanks(fs, wmargin);
+                }
+                s = nextline;
+            }
 
             /* Reset the counter of what has been output this line.  If wmargin
                 is 0, we want to avoid the lmargin getting added, so we set
@@ -270,11 +1308,14 @@ __argp_fmtstream_update(argp_fmtstream_t fs)
     }
 
     /* Remember that we've scanned as far as the end of the buffer.  */
+    fs->p = o;
     fs->point_offs = fs->p - fs->buf;
 }
 
 /* Ensure that FS has space for AMOUNT more bytes in its buffer, either by
-   growing the buffer, or by flushing it.  True is returned iff we succeed. */
+   growing the buffer, or by flushing it.  True is returned iff we succeed.
+   A bounded FS is never grown, so this fails for AMOUNTs larger than its
+   buffer.  */
 int
 __argp_fmtstream_ensure(struct argp_fmtstream *fs, size_t amount)
 {
@@ -284,8 +1325,9 @@ __argp_fmtstream_ensure(struct argp_fmtstream *fs, size_t amount)
         /* Flush FS's buffer.  */
         __argp_fmtstream_update(fs);
 
-        wrote = fwrite(fs->buf, 1, fs->p - fs->buf, fs->stream);
-        if (wrote == fs->p - fs->buf) {
+        wrote = fmtstream_output(fs, fs->buf, fs->p - fs->buf);
+        if (wrote == fs->p - fs->buf || fs->stopped) {
+            /* Anything left over after stopping is just thrown away.  */
             fs->p = fs->buf;
             fs->point_offs = 0;
         } else {
@@ -301,6 +1343,9 @@ __argp_fmtstream_ensure(struct argp_fmtstream *fs, size_t amount)
             size_t new_size = old_size + amount;
             char *new_buf;
 
+            if (fs->bounded)
+                return 0;
+
             if (new_size < old_size || ! (new_buf = realloc(fs->buf, new_size))) {
                 errno = ENOMEM;
                 return 0;
@@ -315,23 +1360,91 @@ __argp_fmtstream_ensure(struct argp_fmtstream *fs, size_t amount)
     return 1;
 }
 
-ssize_t
-__argp_fmtstream_printf(struct argp_fmtstream *fs, const char *fmt, ...)
+/* Write LEN bytes at STR to the bounded stream FS, which doesn't have room
+   for them all at once.  The text is fed through the buffer a piece at a
+   time; pieces are cut just after a newline whenever possible, since line
+   wrapping then comes out exactly as if the whole text had been buffered.
+   Returns LEN.  */
+size_t
+__argp_fmtstream_write_bounded(argp_fmtstream_t fs, const char *str, size_t len)
+{
+    const size_t size = fs->end - fs->buf;
+    size_t left = len;
+
+    while (left > 0 && !fs->stopped) {
+        size_t chunk = left;
+
+        if (chunk > (size_t) (fs->end - fs->p)) {
+            const char *nl;
+
+            __argp_fmtstream_flush(fs);
+
+            if (chunk > size) {
+                chunk = size;
+                for (nl = str + chunk; nl > str && nl[-1] != '\n'; nl--)
+                    ;
+                if (nl > str)
+                    chunk = nl - str;
+                else {
+                    /* Don't split a character, so it's measured whole.  */
+                    size_t lead = chunk;
+
+                    while (lead > 0 && chunk - lead < 3
+                           && (str[lead] & 0xc0) == 0x80)
+                        lead--;
+                    if (lead > 0)
+                        chunk = lead;
+                }
+            }
+        }
+
+        memcpy(fs->p, str, chunk);
+        fs->p += chunk;
+        str += chunk;
+        left -= chunk;
+    }
+
+    return len;
+}
+
+/* Format FMT with ARGS at the end of FS's buffer with vsnprintf, first
+   reserving PRINTF_SIZE_GUESS bytes, and then as many as it turns out to
+   need if that wasn't enough.  */
+static ssize_t
+fmtstream_vprintf(argp_fmtstream_t fs, const char *fmt, va_list args)
 {
     int out;
     size_t avail;
     size_t size_guess = PRINTF_SIZE_GUESS; /* How much space to reserve. */
 
     do {
-        va_list args;
+        va_list try_args;
 
-        if (!__argp_fmtstream_ensure(fs, size_guess))
-            return -1;
+        if (!__argp_fmtstream_ensure(fs, size_guess)) {
+            char *tmp;
+
+            if (! fs->bounded || size_guess <= PRINTF_SIZE_GUESS)
+                return -1;
+
+            /* Too big for a bounded buffer; format it on the side.  */
+            tmp = malloc(size_guess);
+            if (! tmp)
+                return -1;
+
+            va_copy (try_args, args);
+            out = vsnprintf(tmp, size_guess, fmt, try_args);
+            va_end (try_args);
 
-        va_start (args, fmt);
+            __argp_fmtstream_write_bounded(fs, tmp, out);
+            free(tmp);
+
+            return out;
+        }
+
+        va_copy (try_args, args);
         avail = fs->end - fs->p;
-        out = vsnprintf(fs->p, avail, fmt, args);
-        va_end (args);
+        out = vsnprintf(fs->p, avail, fmt, try_args);
+        va_end (try_args);
         if ((size_t) out >= avail)
             size_guess = out + 1;
     } while ((size_t) out >= avail);
@@ -341,3 +1454,207 @@ __argp_fmtstream_printf(struct argp_fmtstream *fs, const char *fmt, ...)
     return out;
 }
 
+#ifndef ARGP_FMTSTREAM_NO_FAST_PRINTF
+/* Help text is formatted with little more than %s and %c, so those, along
+   with %.*s, %d and %%, are done here, straight into the buffer.  A format
+   is gone through once to find out exactly how long the result is, and once
+   more to put it in place; anything else goes to vsnprintf.  Define
+   ARGP_FMTSTREAM_NO_FAST_PRINTF to send everything there.  */
+
+/* Return the number of characters %d gives for N.  */
+static size_t
+fmt_int_length(int n)
+{
+    unsigned u = n < 0 ? 0U - (unsigned) n : (unsigned) n;
+    size_t len = n < 0 ? 2 : 1;
+
+    while (u >= 10) {
+        u /= 10;
+        len++;
+    }
+
+    return len;
+}
+
+/* Return the length of STR, but no more than MAX if MAX isn't negative.  */
+static size_t
+fmt_str_length(const char *str, int max)
+{
+    const char *end;
+
+    if (max < 0)
+        return strlen(str);
+    end = memchr(str, '\0', max);
+    return end ? (size_t) (end - str) : (size_t) max;
+}
+
+/* Return how long formatting FMT with ARGS makes, or -1 if FMT has
+   conversions other than those done here (or a null string for one).  */
+static ssize_t
+fmt_simple_length(const char *fmt, va_list args)
+{
+    size_t len = 0;
+
+    for (;;) {
+        const char *pct = strchr(fmt, '%');
+        const char *str;
+        int max;
+
+        if (! pct)
+            return len + strlen(fmt);
+        len += pct - fmt;
+        fmt = pct + 1;
+
+        switch (*fmt++) {
+        case '%':
+            len++;
+            break;
+        case 'c':
+            (void) va_arg(args, int);
+            len++;
+            break;
+        case 'd':
+            len += fmt_int_length(va_arg(args, int));
+            break;
+        case 's':
+            max = -1;
+            goto string;
+        case '.':
+            if (fmt[0] != '*' || fmt[1] != 's')
+                return -1;
+            fmt += 2;
+            max = va_arg(args, int);
+        string:
+            str = va_arg(args, const char *);
+            if (! str)
+                return -1;
+            len += fmt_str_length(str, max);
+            break;
+        default:
+            return -1;
+        }
+
+        if (len > INT_MAX)
+            return -1;
+    }
+}
+
+/* Put the result of formatting FMT with ARGS, which fmt_simple_length has
+   found to be all right, at DST.  */
+static void
+fmt_simple_emit(char *dst, const char *fmt, va_list args)
+{
+    for (;;) {
+        const char *pct = strchr(fmt, '%');
+        const char *str;
+        size_t len;
+        int max;
+
+        if (! pct) {
+            memcpy(dst, fmt, strlen(fmt));
+            return;
+        }
+        memcpy(dst, fmt, pct - fmt);
+        dst += pct - fmt;
+        fmt = pct + 1;
+
+        switch (*fmt++) {
+        case '%':
+            *dst++ = '%';
+            break;
+        case 'c':
+            *dst++ = (char) va_arg(args, int);
+            break;
+        case 'd': {
+            int n = va_arg(args, int);
+            unsigned u = n < 0 ? 0U - (unsigned) n : (unsigned) n;
+            char *p;
+
+            len = fmt_int_length(n);
+            p = dst + len;
+            do
+                *--p = '0' + u % 10;
+            while ((u /= 10) != 0);
+            if (n < 0)
+                *--p = '-';
+            dst += len;
+            break;
+        }
+        case 's':
+            max = -1;
+            goto string;
+        default:
+            /* It's `.*s'.  */
+            fmt += 2;
+            max = va_arg(args, int);
+        string:
+            str = va_arg(args, const char *);
+            len = fmt_str_length(str, max);
+            memcpy(dst, str, len);
+            dst += len;
+            break;
+        }
+    }
+}
+
+/* Put the LEN characters that formatting FMT with ARGS gives at the end of
+   FS's buffer.  Room is made just as fmtstream_vprintf would, so that the
+   buffer is flushed at the same points whichever way a call is done.  */
+static ssize_t
+fmtstream_printf_simple(argp_fmtstream_t fs, size_t len, const char *fmt,
+        va_list args)
+{
+    if (!__argp_fmtstream_ensure(fs, PRINTF_SIZE_GUESS))
+        return -1;
+
+    if (len >= (size_t) (fs->end - fs->p)
+        && !__argp_fmtstream_ensure(fs, len + 1)) {
+        char *tmp;
+
+        if (! fs->bounded)
+            return -1;
+
+        /* Too big for a bounded buffer; format it on the side.  */
+        tmp = malloc(len + 1);
+        if (! tmp)
+            return -1;
+
+        fmt_simple_emit(tmp, fmt, args);
+        __argp_fmtstream_write_bounded(fs, tmp, len);
+        free(tmp);
+
+        return len;
+    }
+
+    fmt_simple_emit(fs->p, fmt, args);
+    fs->p += len;
+
+    return len;
+}
+#endif /* ARGP_FMTSTREAM_NO_FAST_PRINTF */
+
+ssize_t
+__argp_fmtstream_printf(struct argp_fmtstream *fs, const char *fmt, ...)
+{
+    va_list args;
+    ssize_t out;
+#ifndef ARGP_FMTSTREAM_NO_FAST_PRINTF
+    va_list measure;
+
+    va_start (args, fmt);
+    va_copy (measure, args);
+    out = fmt_simple_length(fmt, measure);
+    va_end (measure);
+
+    if (out >= 0)
+        out = fmtstream_printf_simple(fs, out, fmt, args);
+    else
+        out = fmtstream_vprintf(fs, fmt, args);
+#else
+    va_start (args, fmt);
+    out = fmtstream_vprintf(fs, fmt, args);
+#endif
+    va_end (args);
+
+    return out;
+}
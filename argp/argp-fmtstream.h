@@ -35,9 +35,32 @@ typedef intmax_t ssize_t;
 # include <unistd.h>
 #endif /* _WIN32 */
 
+/* A function that takes output away from an argp_fmtstream in place of a
+   FILE.  It should consume LEN bytes at DATA and return how many it did; a
+   short count makes the fmtstream stop, as a write error would.  */
+typedef size_t (*argp_fmtstream_write_fn)(void *__cookie, const char *__data,
+                        size_t __len);
+
+/* Where an argp_fmtstream's output goes.  */
+enum argp_fmtstream_sink
+{
+    ARGP_FMTSTREAM_SINK_FILE,   /* A stdio stream.  */
+    ARGP_FMTSTREAM_SINK_FD,     /* A file descriptor, written with writev.  */
+    ARGP_FMTSTREAM_SINK_MEMORY, /* A buffer in memory that grows as needed.  */
+    ARGP_FMTSTREAM_SINK_CALLBACK /* A function.  */
+};
+
+/* Output taken by an FD or MEMORY sink that hasn't been passed on.  */
+struct argp_fmtstream_pending;
+
 struct argp_fmtstream
 {
+    enum argp_fmtstream_sink sink; /* Which of the following is used.  */
     FILE *stream;               /* The stream we're outputting to.  */
+    int fd;                     /* Or the file descriptor.  */
+    argp_fmtstream_write_fn write_fn; /* Or the function.  */
+    void *cookie;               /* Passed to WRITE_FN.  */
+    struct argp_fmtstream_pending *pending;
 
     size_t lmargin, rmargin;    /* Left and right margins.  */
     ssize_t wmargin;            /* Margin to wrap to, or -1 to truncate.  */
@@ -50,6 +73,14 @@ struct argp_fmtstream
     char *buf;                  /* Output buffer.  */
     char *p;                    /* Current end of text in BUF. */
     char *end;                  /* Absolute end of BUF.  */
+
+    /* If true, BUF is never grown; long writes are flushed in pieces.  */
+    int bounded;
+    /* True once LIMIT bytes have been written or STREAM reported an error
+        (such as EPIPE); any further output is discarded.  */
+    int stopped;
+    size_t limit;               /* Maximum bytes to write, or 0 for no limit.  */
+    size_t written;             /* Bytes written to STREAM so far.  */
 };
 
 typedef struct argp_fmtstream *argp_fmtstream_t;
@@ -69,6 +100,69 @@ extern argp_fmtstream_t argp_make_fmtstream(FILE *__stream,
                         size_t __rmargin,
                         ssize_t __wmargin);
 
+/* Like __argp_make_fmtstream, but the returned stream uses a buffer of
+   exactly BUF_SIZE bytes that never grows, and stops writing for good as soon
+   as LIMIT bytes have been output (if LIMIT is non-zero) or STREAM reports an
+   error.  Returns NULL if there was an error.  */
+extern argp_fmtstream_t __argp_make_bounded_fmtstream(FILE *__stream,
+                        size_t __lmargin,
+                        size_t __rmargin,
+                        ssize_t __wmargin,
+                        size_t __buf_size,
+                        size_t __limit);
+extern argp_fmtstream_t argp_make_bounded_fmtstream(FILE *__stream,
+                        size_t __lmargin,
+                        size_t __rmargin,
+                        ssize_t __wmargin,
+                        size_t __buf_size,
+                        size_t __limit);
+
+/* Like __argp_make_fmtstream, but output goes to WRITE_FN, called with
+   COOKIE, instead of to a stream.  Returns NULL if there was an error.  */
+extern argp_fmtstream_t __argp_make_fmtstream_fn(
+                        argp_fmtstream_write_fn __write_fn,
+                        void *__cookie,
+                        size_t __lmargin,
+                        size_t __rmargin,
+                        ssize_t __wmargin);
+extern argp_fmtstream_t argp_make_fmtstream_fn(
+                        argp_fmtstream_write_fn __write_fn,
+                        void *__cookie,
+                        size_t __lmargin,
+                        size_t __rmargin,
+                        ssize_t __wmargin);
+
+/* Like __argp_make_fmtstream, but output goes to the file descriptor FD.
+   Text and margins are gathered up and written with as few writev calls
+   as possible; __argp_fmtstream_flush writes out whatever has been
+   gathered.  Returns NULL if there was an error.  */
+extern argp_fmtstream_t __argp_make_fmtstream_fd(int __fd,
+                        size_t __lmargin,
+                        size_t __rmargin,
+                        ssize_t __wmargin);
+extern argp_fmtstream_t argp_make_fmtstream_fd(int __fd,
+                        size_t __lmargin,
+                        size_t __rmargin,
+                        ssize_t __wmargin);
+
+/* Like __argp_make_fmtstream, but output is kept in memory, to be had from
+   __argp_fmtstream_take_memory.  Returns NULL if there was an error.  */
+extern argp_fmtstream_t __argp_make_fmtstream_mem(size_t __lmargin,
+                        size_t __rmargin,
+                        ssize_t __wmargin);
+extern argp_fmtstream_t argp_make_fmtstream_mem(size_t __lmargin,
+                        size_t __rmargin,
+                        ssize_t __wmargin);
+
+/* Flush __FS, which must have been made by __argp_make_fmtstream_mem, and
+   return everything written to it so far as a '\0'-terminated string for
+   the caller to free, storing its length in *__LEN if __LEN isn't NULL.
+   __FS starts over empty.  Returns NULL if there wasn't enough memory.  */
+extern char *__argp_fmtstream_take_memory(argp_fmtstream_t __fs,
+                        size_t *__len);
+extern char *argp_fmtstream_take_memory(argp_fmtstream_t __fs,
+                        size_t *__len);
+
 /* Flush __FS to its stream, and free it (but don't close the stream).  */
 extern void __argp_fmtstream_free(argp_fmtstream_t __fs);
 extern void argp_fmtstream_free(argp_fmtstream_t __fs);
@@ -83,15 +177,31 @@ extern ssize_t argp_fmtstream_printf(argp_fmtstream_t __fs,
 #define argp_fmtstream_lmargin(__fs) ((__fs)->lmargin)
 #define argp_fmtstream_rmargin(__fs) ((__fs)->rmargin)
 #define argp_fmtstream_wmargin(__fs) ((__fs)->wmargin)
+#define argp_fmtstream_stopped(__fs) ((__fs)->stopped)
+#define argp_fmtstream_written(__fs) ((__fs)->written)
+#define argp_fmtstream_bounded(__fs) ((__fs)->bounded)
 #define __argp_fmtstream_lmargin argp_fmtstream_lmargin
 #define __argp_fmtstream_rmargin argp_fmtstream_rmargin
 #define __argp_fmtstream_wmargin argp_fmtstream_wmargin
+#define __argp_fmtstream_stopped argp_fmtstream_stopped
+#define __argp_fmtstream_written argp_fmtstream_written
+#define __argp_fmtstream_bounded argp_fmtstream_bounded
 
 /* Internal routines.  */
 extern void _argp_fmtstream_update(argp_fmtstream_t __fs);
 extern void __argp_fmtstream_update(argp_fmtstream_t __fs);
 extern int _argp_fmtstream_ensure(argp_fmtstream_t __fs, size_t __amount);
 extern int __argp_fmtstream_ensure(argp_fmtstream_t __fs, size_t __amount);
+extern void _argp_fmtstream_flush(argp_fmtstream_t __fs);
+extern void __argp_fmtstream_flush(argp_fmtstream_t __fs);
+extern size_t _argp_fmtstream_write_bounded(argp_fmtstream_t __fs,
+                        const char *__str, size_t __len);
+extern size_t __argp_fmtstream_write_bounded(argp_fmtstream_t __fs,
+                        const char *__str, size_t __len);
+/* Return the number of columns taken up by the LEN bytes of UTF-8 at STR,
+   counted the way the stream counts them when wrapping.  */
+extern size_t _argp_fmtstream_width(const char *__str, size_t __len);
+extern size_t __argp_fmtstream_width(const char *__str, size_t __len);
 
 #define __argp_fmtstream_putc argp_fmtstream_putc
 #define __argp_fmtstream_puts argp_fmtstream_puts
@@ -102,6 +212,8 @@ extern int __argp_fmtstream_ensure(argp_fmtstream_t __fs, size_t __amount);
 #define __argp_fmtstream_point argp_fmtstream_point
 #define __argp_fmtstream_update _argp_fmtstream_update
 #define __argp_fmtstream_ensure _argp_fmtstream_ensure
+#define __argp_fmtstream_write_bounded _argp_fmtstream_write_bounded
+#define __argp_fmtstream_width _argp_fmtstream_width
 
 #ifndef ARGP_FS_EI
 #define ARGP_FS_EI static inline
@@ -114,7 +226,10 @@ __argp_fmtstream_write(argp_fmtstream_t __fs, const char *__str, size_t __len)
         memcpy (__fs->p, __str, __len);
         __fs->p += __len;
         return __len;
-    } else
+    } else if (__fs->bounded)
+        /* Too big for the fixed buffer; feed it through in pieces.  */
+        return __argp_fmtstream_write_bounded(__fs, __str, __len);
+    else
         return 0;
 }
 
@@ -196,6 +311,8 @@ __argp_fmtstream_point(argp_fmtstream_t __fs)
 #undef __argp_fmtstream_point
 #undef __argp_fmtstream_update
 #undef __argp_fmtstream_ensure
+#undef __argp_fmtstream_write_bounded
+#undef __argp_fmtstream_width
 
 #endif /* argp-fmtstream.h */
 
@@ -32,6 +32,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -52,6 +53,7 @@ const char *dgettext_safe(const char *d, const char *m)
 #include <argp.h>
 #include <argp-fmtstream.h>
 #include "argp-namefrob.h"
+#include "argp-catalog.h"
 
 #ifndef SIZE_MAX
 # define SIZE_MAX ((size_t) -1)
@@ -75,6 +77,9 @@ const char *dgettext_safe(const char *d, const char *m)
 #define USAGE_INDENT 12     /* indentation of wrapped usage lines */
 #define RMARGIN      79     /* right margin used for wrapping */
 
+/* Size of the fixed output buffer used by argp_help_stream.  */
+#define HELP_STREAM_BUF_SIZE 4096
+
 /* User-selectable (using an environment variable) formatting parameters.
    They must all be of type `int' for the parsing code to work.  */
 struct uparams
@@ -100,8 +105,8 @@ struct uparams
     int rmargin;
 };
 
-/* This is a global variable, as user options are only ever read once.  */
-static struct uparams uparams = {
+/* The parameters used unless ARGP_HELP_FMT says otherwise.  */
+static const struct uparams default_uparams = {
     DUP_ARGS, DUP_ARGS_NOTE,
     SHORT_OPT_COL, LONG_OPT_COL, DOC_OPT_COL, OPT_DOC_COL, HEADER_COL,
     USAGE_INDENT, RMARGIN
@@ -130,12 +135,16 @@ static const struct uparam_name uparam_names[] =
 };
 #define nuparam_names (sizeof(uparam_names) / sizeof(uparam_names[0]))
 
-/* Read user options from the environment, and fill in UPARAMS appropriately.  */
+/* Read user options from the environment, and fill in UPARAMS
+   appropriately.  UPARAMS starts out with the default parameters; only the
+   caller's copy is written, so concurrent help output doesn't interfere.  */
 static void
-fill_in_uparams(const struct argp_state *state)
+fill_in_uparams(struct uparams *uparams, const struct argp_state *state)
 {
     const char *var = getenv("ARGP_HELP_FMT");
 
+    *uparams = default_uparams;
+
 #define SKIPWS(p) do { while (isspace(*p)) p++; } while (0);
 
     if (var)
@@ -188,7 +197,7 @@ fill_in_uparams(const struct argp_state *state)
                                 "%.*s: ARGP_HELP_FMT parameter requires a value"),
                                 (int) var_len, var);
                         else
-                            *(int *)((char *)&uparams + un->uparams_offs) = val;
+                            *(int *)((char *)uparams + un->uparams_offs) = val;
                         break;
                     }
                 if (u == nuparam_names)
@@ -213,6 +222,101 @@ fill_in_uparams(const struct argp_state *state)
         }
 }
 
+/* Fixed messages that help output may contain.  They live in one table so
+   that a help context can translate them ahead of time.  */
+enum help_message
+{
+    HELP_MSG_USAGE,
+    HELP_MSG_OR,
+    HELP_MSG_OPTIONS,
+    HELP_MSG_SEE,
+    HELP_MSG_BUGS,
+    HELP_MSG_DUP_ARGS,
+    HELP_MSG_COMMANDS,
+    HELP_MSG_COUNT
+};
+
+static const char *const help_messages[HELP_MSG_COUNT] = {
+    "Usage:",
+    "  or: ",
+    " [OPTION...]",
+    "\
+                    Try `%s --help' or `%s --usage' for more information.\n",
+    "Report bugs to %s.\n",
+    "Mandatory or optional arguments to long options"
+    " are also mandatory or optional for any "
+    "corresponding short options.",
+    "Commands:"
+};
+
+/* A cached translation of MSGID in DOMAIN.  */
+struct help_string
+{
+    const char *domain;
+    const char *msgid;          /* 0 if the slot is empty.  */
+    const char *str;
+};
+
+/* What help output is rendered with that only needs working out once: the
+   formatting parameters and, if messages are translated, the translations of
+   every string that ARGP's help can show.  A context is never changed after
+   it's made, so it may be shared by threads rendering help at once.  */
+struct argp_help_context
+{
+    struct uparams uparams;
+    const struct argp *argp;    /* The argp this was made for, or 0.  */
+
+    /* Open-addressed hash table of translations, or 0 if there is none.  */
+    struct help_string *strings;
+    size_t strings_mask;        /* Size of STRINGS minus 1.  */
+};
+
+/* Fill in CTX for a single help message about ARGP, with no translation
+   cache.  If called from argp_state_help, STATE is the relevant parsing
+   state.  */
+static void
+help_context_init(struct argp_help_context *ctx, const struct argp *argp,
+    const struct argp_state *state)
+{
+    fill_in_uparams(&ctx->uparams, state);
+    ctx->argp = argp;
+    ctx->strings = 0;
+    ctx->strings_mask = 0;
+}
+
+#if defined ENABLE_NLS && ENABLE_NLS
+/* Hash the pair DOMAIN, MSGID.  Message ids are looked up by address, as
+   help strings come from static tables that outlive the context.  */
+static inline size_t
+help_string_hash(const char *domain, const char *msgid)
+{
+    size_t h = (size_t) (uintptr_t) msgid ^ ((size_t) (uintptr_t) domain >> 4);
+    return h ^ (h >> 7) ^ (h >> 17);
+}
+#endif
+
+/* Return the translation of MSGID in DOMAIN, or 0 if MSGID is 0.  CTX's cache
+   is used if it has one.  */
+static const char *
+help_gettext(const struct argp_help_context *ctx, const char *domain,
+    const char *msgid)
+{
+#if defined ENABLE_NLS && ENABLE_NLS
+    if (msgid && ctx->strings) {
+        size_t i = help_string_hash(domain, msgid) & ctx->strings_mask;
+        const struct help_string *hs;
+
+        for (; (hs = &ctx->strings[i])->msgid; i = (i + 1) & ctx->strings_mask)
+            if (hs->msgid == msgid && hs->domain == domain)
+                return hs->str;
+    }
+#else
+    (void) ctx;
+#endif
+
+    return dgettext_safe(domain, msgid);
+}
+
 /* Returns true if OPT hasn't been marked invisible.  Visibility only affects
    whether OPT is displayed or used in sorting, not option shadowing.  */
 #define ovisible(opt) (! ((opt)->flags & OPTION_HIDDEN))
@@ -289,18 +393,6 @@ fill_in_uparams(const struct argp_state *state)
     unless you tell it not to with ARGP_NO_HELP.
 */
 
-/* Returns true if CH occurs between BEG and END.  */
-static int
-find_char(char ch, char *beg, char *end)
-{
-    while (beg < end)
-        if (*beg == ch)
-            return 1;
-        else
-            beg++;
-    return 0;
-}
-
 struct hol_cluster;     /* fwd decl */
 
 struct hol_entry
@@ -326,8 +418,9 @@ struct hol_entry
     /* The cluster of options this entry belongs to, or 0 if none.  */
     struct hol_cluster *cluster;
 
-    /* The argp from which this option came.  */
+    /* The argp from which this option came, and its bindings.  */
     const struct argp *argp;
+    const struct argp_binding *bindings;
 };
 
 /* A cluster of entries to reflect the argp tree structure.  */
@@ -377,74 +470,6 @@ struct hol
     struct hol_cluster *clusters;
 };
 
-/* Create a struct hol from the options in ARGP.  CLUSTER is the
-   hol_cluster in which these entries occur, or 0, if at the root.  */
-static struct hol *
-make_hol(const struct argp *argp, struct hol_cluster *cluster)
-{
-    char *so;
-    const struct argp_option *o;
-    const struct argp_option *opts = argp->options;
-    struct hol_entry *entry;
-    unsigned num_short_options = 0;
-    struct hol *hol = malloc(sizeof(struct hol));
-
-    assert(hol);
-
-    hol->num_entries = 0;
-    hol->clusters = 0;
-
-    if (opts) {
-        int cur_group = 0;
-
-        /* The first option must not be an alias.  */
-        assert(!oalias(opts));
-
-        /* Calculate the space needed.  */
-        for (o = opts; !oend(o); o++) {
-            if (!oalias(o))
-                hol->num_entries++;
-            if (oshort(o))
-                num_short_options++;    /* This is an upper bound.  */
-        }
-
-        hol->entries = malloc(sizeof(struct hol_entry) * hol->num_entries);
-        hol->short_options = malloc(num_short_options + 1);
-
-        assert(hol->entries && hol->short_options);
-#if SIZE_MAX <= UINT_MAX
-        assert(hol->num_entries <= SIZE_MAX / sizeof(struct hol_entry));
-#endif
-
-        /* Fill in the entries.  */
-        so = hol->short_options;
-        for (o = opts, entry = hol->entries; !oend(o); entry++) {
-            entry->opt = o;
-            entry->num = 0;
-            entry->short_options = so;
-            entry->group = cur_group =
-                o->group
-                ? o->group
-                : ((!o->name && !o->key)
-                ? cur_group + 1
-                : cur_group);
-            entry->cluster = cluster;
-            entry->argp = argp;
-
-            do {
-                entry->num++;
-                if (oshort(o) && !find_char(o->key, hol->short_options, so))
-                /* O has a valid short option which hasn't already been used.*/
-                *so++ = o->key;
-                o++;
-            } while (!oend(o) && oalias(o));
-        }
-        *so = '\0';       /* null terminated so we can find the length */
-    }
-
-    return hol;
-}
-
 /* Add a new cluster to HOL, with the given GROUP and HEADER (taken from the
    associated argp child list entry), INDEX, and PARENT, and return a pointer
    to it.  ARGP is the argp that this cluster results from.  */
@@ -755,95 +780,6 @@ hol_sort(struct hol *hol)
             hol_entry_qcmp);
 }
 
-/* Append MORE to HOL, destroying MORE in the process.  Options in HOL shadow
-   any in MORE with the same name.  */
-static void
-hol_append(struct hol *hol, struct hol *more)
-{
-    struct hol_cluster **cl_end = &hol->clusters;
-
-    /* Steal MORE's cluster list, and add it to the end of HOL's.  */
-    while (*cl_end)
-        cl_end = &(*cl_end)->next;
-    *cl_end = more->clusters;
-    more->clusters = 0;
-
-    /* Merge entries.  */
-    if (more->num_entries > 0) {
-        if (hol->num_entries == 0) {
-            hol->num_entries = more->num_entries;
-            hol->entries = more->entries;
-            hol->short_options = more->short_options;
-            more->num_entries = 0;    /* Mark MORE's fields as invalid.  */
-        } else {
-            /* Append the entries in MORE to those in HOL, taking care to only add
-            non-shadowed SHORT_OPTIONS values.  */
-
-            unsigned left;
-            char *so, *more_so;
-            struct hol_entry *e;
-            unsigned num_entries = hol->num_entries + more->num_entries;
-            struct hol_entry *entries =
-                malloc(num_entries * sizeof(struct hol_entry));
-            unsigned hol_so_len = strlen(hol->short_options);
-            char *short_options =
-                malloc(hol_so_len + strlen(more->short_options) + 1);
-
-            assert(entries && short_options);
-#if SIZE_MAX <= UINT_MAX
-            assert(num_entries <= SIZE_MAX / sizeof(struct hol_entry));
-#endif
-
-            mempcpy(mempcpy(entries, hol->entries,
-                            hol->num_entries * sizeof(struct hol_entry)),
-                    more->entries,
-                    more->num_entries * sizeof(struct hol_entry));
-
-            mempcpy(short_options, hol->short_options, hol_so_len);
-
-            /* Fix up the short options pointers from HOL.  */
-            for (e = entries, left = hol->num_entries; left > 0; e++, left--)
-                e->short_options += (short_options - hol->short_options);
-
-            /* Now add the short options from MORE, fixing up its entries
-                too.  */
-            so = short_options + hol_so_len;
-            more_so = more->short_options;
-            for (left = more->num_entries; left > 0; e++, left--) {
-                int opts_left;
-                const struct argp_option *opt;
-
-                e->short_options = so;
-
-                for (opts_left = e->num, opt = e->opt; opts_left; opt++, opts_left--) {
-                    int ch = *more_so;
-                    if (oshort(opt) && ch == opt->key)
-                        /* The next short option in MORE_SO, CH, is from OPT.  */
-                        {
-                        if (!find_char(ch, short_options,
-                                short_options + hol_so_len))
-                        /* The short option CH isn't shadowed by HOL's options,
-                        so add it to the sum.  */
-                        *so++ = ch;
-                        more_so++;
-                        }
-                }
-            }
-
-            *so = '\0';
-
-            free(hol->entries);
-            free(hol->short_options);
-
-            hol->entries = entries;
-            hol->num_entries = num_entries;
-            hol->short_options = short_options;
-        }
-    }
-
-    hol_free(more);
-}
-
 /* Inserts enough spaces to make sure STREAM is at column COL.  */
 static void
 indent_to(argp_fmtstream_t stream, unsigned col)
@@ -870,15 +806,16 @@ space(argp_fmtstream_t stream, size_t ensure)
    optional argument.  */
 static void
 arg(const struct argp_option *real, const char *req_fmt, const char *opt_fmt,
-    const char *domain, argp_fmtstream_t stream)
+    const struct argp_help_context *ctx, const char *domain,
+    argp_fmtstream_t stream)
 {
     if (real->arg) {
         if (real->flags & OPTION_ARG_OPTIONAL)
             __argp_fmtstream_printf(stream, opt_fmt,
-                dgettext(domain, real->arg));
+                help_gettext(ctx, domain, real->arg));
         else
             __argp_fmtstream_printf(stream, req_fmt,
-                dgettext(domain, real->arg));
+                help_gettext(ctx, domain, real->arg));
     }
 }
 
@@ -887,6 +824,9 @@ arg(const struct argp_option *real, const char *req_fmt, const char *opt_fmt,
 /* State used during the execution of hol_help.  */
 struct hol_help_state
 {
+    /* The context help is being rendered with.  */
+    const struct argp_help_context *ctx;
+
     /* PREV_ENTRY should contain the previous entry printed, or 0.  */
     struct hol_entry *prev_entry;
 
@@ -939,17 +879,18 @@ static void
 print_header(const char *str, const struct argp *argp,
         struct pentry_state *pest)
 {
-    const char *tstr = dgettext_safe(argp->argp_domain, str);
+    const char *tstr = help_gettext(pest->hhstate->ctx, argp->argp_domain, str);
     const char *fstr = filter_doc(tstr, ARGP_KEY_HELP_HEADER, argp, pest->state);
+    int header_col = pest->hhstate->ctx->uparams.header_col;
 
     if (fstr) {
         if (*fstr) {
             if (pest->hhstate->prev_entry)
                 /* Precede with a blank line.  */
                 __argp_fmtstream_putc(pest->stream, '\n');
-            indent_to(pest->stream, uparams.header_col);
-            __argp_fmtstream_set_lmargin(pest->stream, uparams.header_col);
-            __argp_fmtstream_set_wmargin(pest->stream, uparams.header_col);
+            indent_to(pest->stream, header_col);
+            __argp_fmtstream_set_lmargin(pest->stream, header_col);
+            __argp_fmtstream_set_wmargin(pest->stream, header_col);
             __argp_fmtstream_puts(pest->stream, fstr);
             __argp_fmtstream_set_lmargin(pest->stream, 0);
             __argp_fmtstream_putc(pest->stream, '\n');
@@ -999,6 +940,38 @@ comma(unsigned col, struct pentry_state *pest)
     indent_to(pest->stream, col);
 }
 
+/* Return the arguments ENTRY takes if it has an ARGP_BIND_ENUM binding, or
+   NULL.  */
+static const struct argp_enum *
+entry_enum_values(const struct hol_entry *entry)
+{
+    const struct argp_binding *binding = entry->bindings;
+
+    if (binding)
+        for (; binding->key; binding++)
+            if (binding->key == entry->opt->key
+                && binding->type == ARGP_BIND_ENUM)
+                return binding->values;
+    return NULL;
+}
+
+/* Print the names in VALUES as the arguments an option takes, after its
+   doc if there is one.  */
+static void
+print_enum_values(const struct argp_enum *values, int after_doc,
+        const struct argp_help_context *ctx, const struct argp_state *state,
+        argp_fmtstream_t stream)
+{
+    if (after_doc)
+        __argp_fmtstream_putc(stream, ' ');
+    __argp_fmtstream_printf(stream, "(%s ",
+            help_gettext(ctx, state == NULL ? NULL
+                    : state->root_argp->argp_domain, "one of:"));
+    for (; values->name; values++)
+        __argp_fmtstream_printf(stream, values[1].name ? "%s, " : "%s)",
+                                values->name);
+}
+
 /* Print help for ENTRY to STREAM.  */
 static void
 hol_entry_help(struct hol_entry *entry, const struct argp_state *state,
@@ -1014,6 +987,8 @@ hol_entry_help(struct hol_entry *entry, const struct argp_state *state,
     /* PEST is a state block holding some of our variables that we'd like to
         share with helper functions.  */
     struct pentry_state pest = { entry, stream, hhstate, 1, state };
+    const struct argp_help_context *ctx = hhstate->ctx;
+    const struct uparams *uparams = &ctx->uparams;
 
     if (! odoc(real))
         for (opt = real, num = entry->num; num > 0; opt++, num--)
@@ -1023,16 +998,16 @@ hol_entry_help(struct hol_entry *entry, const struct argp_state *state,
             }
 
     /* First emit short options.  */
-    __argp_fmtstream_set_wmargin(stream, uparams.short_opt_col); /* For truly bizarre cases. */
+    __argp_fmtstream_set_wmargin(stream, uparams->short_opt_col); /* For truly bizarre cases. */
     for (opt = real, num = entry->num; num > 0; opt++, num--)
         if (oshort(opt) && opt->key == *so) {
             /* OPT has a valid (non shadowed) short option.  */
             if (ovisible(opt)) {
-                comma(uparams.short_opt_col, &pest);
+                comma(uparams->short_opt_col, &pest);
                 __argp_fmtstream_putc(stream, '-');
                 __argp_fmtstream_putc(stream, *so);
-                if (!have_long_opt || uparams.dup_args)
-                    arg(real, " %s", "[%s]",
+                if (!have_long_opt || uparams->dup_args)
+                    arg(real, " %s", "[%s]", ctx,
                         state == NULL ? NULL : state->root_argp->argp_domain,
                         stream);
                 else if (real->arg)
@@ -1044,26 +1019,26 @@ hol_entry_help(struct hol_entry *entry, const struct argp_state *state,
     /* Now, long options.  */
     if (odoc(real)) {
         /* A `documentation' option.  */
-        __argp_fmtstream_set_wmargin(stream, uparams.doc_opt_col);
+        __argp_fmtstream_set_wmargin(stream, uparams->doc_opt_col);
         for (opt = real, num = entry->num; num > 0; opt++, num--)
             if (opt->name && ovisible(opt)) {
-                comma(uparams.doc_opt_col, &pest);
+                comma(uparams->doc_opt_col, &pest);
                 /* Calling gettext here isn't quite right, since sorting will
                 have been done on the original; but documentation options
                 should be pretty rare anyway...  */
                 __argp_fmtstream_puts(stream,
-                        dgettext(state == NULL ? NULL
+                        help_gettext(ctx, state == NULL ? NULL
                                 : state->root_argp->argp_domain,
                                 opt->name));
             }
     } else {
         /* A real long option.  */
-        __argp_fmtstream_set_wmargin(stream, uparams.long_opt_col);
+        __argp_fmtstream_set_wmargin(stream, uparams->long_opt_col);
         for (opt = real, num = entry->num; num > 0; opt++, num--)
             if (opt->name && ovisible(opt)) {
-                comma(uparams.long_opt_col, &pest);
+                comma(uparams->long_opt_col, &pest);
                 __argp_fmtstream_printf(stream, "--%s", opt->name);
-                arg(real, "=%s", "[=%s]",
+                arg(real, "=%s", "[=%s]", ctx,
                 state == NULL ? NULL : state->root_argp->argp_domain, stream);
             }
     }
@@ -1080,25 +1055,32 @@ hol_entry_help(struct hol_entry *entry, const struct argp_state *state,
             /* Just a totally shadowed option or null header; print nothing.  */
             goto cleanup;       /* Just return, after cleaning up.  */
     } else {
-        const char *tstr = real->doc ? dgettext_safe(state == NULL ? NULL
+        const char *tstr = real->doc ? help_gettext(ctx, state == NULL ? NULL
                                             : state->root_argp->argp_domain,
                                             real->doc)
                                     : 0;
         const char *fstr = filter_doc(tstr, real->key, entry->argp, state);
-        if (fstr && *fstr) {
+        const struct argp_enum *values = entry_enum_values(entry);
+
+        if (values && !values->name)
+            values = NULL;
+        if ((fstr && *fstr) || values) {
             unsigned int col = __argp_fmtstream_point(stream);
 
-            __argp_fmtstream_set_lmargin(stream, uparams.opt_doc_col);
-            __argp_fmtstream_set_wmargin(stream, uparams.opt_doc_col);
+            __argp_fmtstream_set_lmargin(stream, uparams->opt_doc_col);
+            __argp_fmtstream_set_wmargin(stream, uparams->opt_doc_col);
 
-            if (col > (unsigned int) (uparams.opt_doc_col + 3))
+            if (col > (unsigned int) (uparams->opt_doc_col + 3))
                 __argp_fmtstream_putc(stream, '\n');
-            else if (col >= (unsigned int) uparams.opt_doc_col)
+            else if (col >= (unsigned int) uparams->opt_doc_col)
                 __argp_fmtstream_puts(stream, "   ");
             else
-                indent_to(stream, uparams.opt_doc_col);
+                indent_to(stream, uparams->opt_doc_col);
 
-            __argp_fmtstream_puts(stream, fstr);
+            if (fstr && *fstr)
+                __argp_fmtstream_puts(stream, fstr);
+            if (values)
+                print_enum_values(values, fstr && *fstr, ctx, state, stream);
         }
             if (fstr && fstr != tstr)
             free((char *) fstr);
@@ -1117,22 +1099,27 @@ cleanup:
 
 /* Output a long help message about the options in HOL to STREAM.  */
 static void
-hol_help(struct hol *hol, const struct argp_state *state,
-        argp_fmtstream_t stream)
+hol_help(struct hol *hol, const struct argp_help_context *ctx,
+        const struct argp_state *state, argp_fmtstream_t stream)
 {
     unsigned num;
     struct hol_entry *entry;
-    struct hol_help_state hhstate = { 0, 0, 0 };
-
-    for (entry = hol->entries, num = hol->num_entries; num > 0; entry++, num--)
+    struct hol_help_state hhstate = { ctx, 0, 0, 0 };
+
+    for (entry = hol->entries, num = hol->num_entries
+        ; num > 0 && !__argp_fmtstream_stopped(stream)
+        ; entry++, num--) {
+        if (__argp_fmtstream_bounded(stream) && hhstate.prev_entry
+            && hhstate.prev_entry->cluster != entry->cluster)
+            /* Send each finished cluster on its way.  */
+            __argp_fmtstream_flush(stream);
         hol_entry_help(entry, state, stream, &hhstate);
+    }
 
-    if (hhstate.suppressed_dup_arg && uparams.dup_args_note) {
-        const char *tstr = dgettext(state == NULL ? NULL
+    if (hhstate.suppressed_dup_arg && ctx->uparams.dup_args_note) {
+        const char *tstr = help_gettext(ctx, state == NULL ? NULL
                             : state->root_argp->argp_domain,
-                            "Mandatory or optional arguments to long options"
-                            " are also mandatory or optional for any "
-                            "corresponding short options.");
+                            help_messages[HELP_MSG_DUP_ARGS]);
         const char *fstr = filter_doc(tstr, ARGP_KEY_HELP_DUP_ARGS_NOTE,
                         state ? state->root_argp : 0, state);
         if (fstr && *fstr) {
@@ -1145,127 +1132,272 @@ hol_help(struct hol *hol, const struct argp_state *state,
     }
 }
 
-/* Helper functions for hol_usage.  */
+/* Return the first argp in ARGP's tree that has commands, in the order
+   argp_parse looks for them, or 0 if none has.  */
+static const struct argp *
+argp_command_argp(const struct argp *argp)
+{
+    const struct argp_child *child = argp->children;
+    const struct argp *found = argp_commands(argp) ? argp : 0;
+
+    if (child)
+        for (; !found && child->argp; child++)
+            found = argp_command_argp(child->argp);
+
+    return found;
+}
 
-/* If OPT is a short option without an arg, append its key to the string
-   pointer pointer to by COOKIE, and advance the pointer.  */
+/* Output a list of the commands in ARGP's tree, and what they do, to
+   STREAM.  The commands themselves aren't loaded.  Returns true if there
+   were any.  */
 static int
-add_argless_short_opt(const struct argp_option *opt,
-        const struct argp_option *real,
-        const char *domain, void *cookie)
+commands_help(const struct argp *argp, const struct argp_help_context *ctx,
+        argp_fmtstream_t stream)
 {
-    char **snao_end = cookie;
-    if (!(opt->arg || real->arg)
-        && !((opt->flags | real->flags) & OPTION_NO_USAGE))
-        *(*snao_end)++ = opt->key;
+    const struct argp *cargp = argp_command_argp(argp);
+    const struct uparams *uparams = &ctx->uparams;
+    const struct argp_command *command;
+    int old_lm, old_wm;
 
-    return 0;
+    if (! cargp || ! argp_commands(cargp)->name)
+        return 0;
+
+    old_lm = __argp_fmtstream_set_lmargin(stream, 0);
+    old_wm = __argp_fmtstream_set_wmargin(stream, 0);
+
+    indent_to(stream, uparams->header_col);
+    __argp_fmtstream_puts(stream, help_gettext(ctx, cargp->argp_domain,
+                                    help_messages[HELP_MSG_COMMANDS]));
+    __argp_fmtstream_putc(stream, '\n');
+
+    for (command = argp_commands(cargp)
+        ; command->name && !__argp_fmtstream_stopped(stream)
+        ; command++) {
+        indent_to(stream, uparams->short_opt_col);
+        __argp_fmtstream_puts(stream, command->name);
+
+        if (command->doc && *command->doc) {
+            unsigned int col = __argp_fmtstream_point(stream);
+
+            __argp_fmtstream_set_lmargin(stream, uparams->opt_doc_col);
+            __argp_fmtstream_set_wmargin(stream, uparams->opt_doc_col);
+
+            if (col > (unsigned int) (uparams->opt_doc_col + 3))
+                __argp_fmtstream_putc(stream, '\n');
+            else if (col >= (unsigned int) uparams->opt_doc_col)
+                __argp_fmtstream_puts(stream, "   ");
+            else
+                indent_to(stream, uparams->opt_doc_col);
+
+            __argp_fmtstream_puts(stream, help_gettext(ctx, cargp->argp_domain,
+                                            command->doc));
+            __argp_fmtstream_set_lmargin(stream, 0);
+            __argp_fmtstream_set_wmargin(stream, 0);
+        }
+        __argp_fmtstream_putc(stream, '\n');
+    }
+
+    __argp_fmtstream_set_lmargin(stream, old_lm);
+    __argp_fmtstream_set_wmargin(stream, old_wm);
+
+    return 1;
 }
 
-/* If OPT is a short option with an arg, output a usage entry for it to the
-   stream pointed at by COOKIE.  */
-static int
-usage_argful_short_opt(const struct argp_option *opt,
-            const struct argp_option *real,
-            const char *domain, void *cookie)
+/* Helper functions for hol_usage.  */
+
+/* A usage entry for one short or long option that hol_usage will print.  */
+struct usage_opt
 {
-    argp_fmtstream_t stream = cookie;
-    const char *arg = opt->arg;
-    int flags = opt->flags | real->flags;
+    const struct argp_option *opt;
+    const char *arg;            /* Translated argument name, or 0.  */
+    int flags;                  /* OPT's flags, plus those of its real option.  */
+};
+
+/* The three segments of a usage line, gathered in one pass over a HOL.  */
+struct usage_segments
+{
+    char *argless;              /* Keys of short options without args.  */
+    size_t num_argless;
+    struct usage_opt *argful;   /* Short options with args.  */
+    size_t num_argful;
+    struct usage_opt *longs;    /* Long options.  */
+    size_t num_longs;
+};
+
+/* Add the visible options of ENTRY that belong in a usage line to SEGS.  */
+static void
+usage_segments_add(struct usage_segments *segs,
+    const struct argp_help_context *ctx, const struct hol_entry *entry)
+{
+    unsigned nopts;
+    const char *domain = entry->argp->argp_domain;
+    const char *so = entry->short_options;
+    /* Only the first option of an entry isn't an alias.  */
+    const struct argp_option *opt, *real = entry->opt;
+
+    for (opt = real, nopts = entry->num; nopts > 0; opt++, nopts--) {
+        int flags = opt->flags | real->flags;
+        const char *arg = opt->arg ? opt->arg : real->arg;
+        int is_short = oshort(opt) && *so == opt->key;
+
+        if (is_short)
+            so++;
+
+        if (!ovisible(opt) || (flags & OPTION_NO_USAGE))
+            continue;
+
+        if (arg)
+            arg = help_gettext(ctx, domain, arg);
+
+        if (is_short) {
+            if (!arg)
+                segs->argless[segs->num_argless++] = opt->key;
+            else {
+                struct usage_opt *uo = &segs->argful[segs->num_argful++];
+                uo->opt = opt;
+                uo->arg = arg;
+                uo->flags = flags;
+            }
+        }
+
+        if (opt->name) {
+            struct usage_opt *uo = &segs->longs[segs->num_longs++];
+            uo->opt = opt;
+            uo->arg = arg;
+            uo->flags = flags;
+        }
+    }
+}
+
+/* Print a short usage description for the arguments in HOL to STREAM.  All
+   entries are gathered into segments in a single pass, which are then output
+   in order: short options without args, short options with args, and
+   finally long options.  */
+static void
+hol_usage(struct hol *hol, const struct argp_help_context *ctx,
+    argp_fmtstream_t stream)
+{
+    unsigned nentries;
+    struct hol_entry *entry;
+    struct usage_segments segs;
+    size_t num_shorts, num_opts = 0;
+    void *mem;
+    size_t i;
+
+    if (hol->num_entries == 0)
+        return;
+
+    for (entry = hol->entries, nentries = hol->num_entries
+        ; nentries > 0
+        ; entry++, nentries--)
+        num_opts += entry->num;
+    num_shorts = strlen(hol->short_options);
 
-    if (!arg)
-        arg = real->arg;
+    mem = malloc((num_shorts + num_opts) * sizeof(struct usage_opt)
+                 + num_shorts + 1);
+    if (! mem)
+        return;
+
+    segs.argful = mem;
+    segs.longs = segs.argful + num_shorts;
+    segs.argless = (char *) (segs.longs + num_opts);
+    segs.num_argless = segs.num_argful = segs.num_longs = 0;
 
-    if (arg && !(flags & OPTION_NO_USAGE)) {
-        arg = dgettext(domain, arg);
+    for (entry = hol->entries, nentries = hol->num_entries
+        ; nentries > 0
+        ; entry++, nentries--)
+        usage_segments_add(&segs, ctx, entry);
+
+    /* First we put a list of short options without arguments.  */
+    if (segs.num_argless > 0) {
+        segs.argless[segs.num_argless] = '\0';
+        __argp_fmtstream_printf(stream, " [-%s]", segs.argless);
+    }
 
-        if (flags & OPTION_ARG_OPTIONAL)
-            __argp_fmtstream_printf(stream, " [-%c[%s]]", opt->key, arg);
+    /* Now a list of short options *with* arguments.  */
+    for (i = 0; i < segs.num_argful; i++) {
+        const struct usage_opt *uo = &segs.argful[i];
+
+        if (uo->flags & OPTION_ARG_OPTIONAL)
+            __argp_fmtstream_printf(stream, " [-%c[%s]]",
+                                    uo->opt->key, uo->arg);
         else {
             /* Manually do line wrapping so that it (probably) won't
                 get wrapped at the embedded space.  */
-            space(stream, 6 + strlen(arg));
-            __argp_fmtstream_printf(stream, "[-%c %s]", opt->key, arg);
+            space(stream,
+                  6 + __argp_fmtstream_width(uo->arg, strlen(uo->arg)));
+            __argp_fmtstream_printf(stream, "[-%c %s]", uo->opt->key, uo->arg);
         }
     }
 
-    return 0;
-}
+    /* Finally, a list of long options (whew!).  */
+    for (i = 0; i < segs.num_longs; i++) {
+        const struct usage_opt *uo = &segs.longs[i];
 
-/* Output a usage entry for the long option opt to the stream pointed at by
-   COOKIE.  */
-static int
-usage_long_opt(const struct argp_option *opt,
-        const struct argp_option *real,
-        const char *domain, void *cookie)
-{
-    argp_fmtstream_t stream = cookie;
-    const char *arg = opt->arg;
-    int flags = opt->flags | real->flags;
-
-    if (!arg)
-        arg = real->arg;
-
-    if (! (flags & OPTION_NO_USAGE)) {
-        if (arg) {
-            arg = dgettext(domain, arg);
-            if (flags & OPTION_ARG_OPTIONAL)
-                __argp_fmtstream_printf(stream, " [--%s[=%s]]", opt->name, arg);
-            else
-                __argp_fmtstream_printf(stream, " [--%s=%s]", opt->name, arg);
-        }
+        if (! uo->arg)
+            __argp_fmtstream_printf(stream, " [--%s]", uo->opt->name);
+        else if (uo->flags & OPTION_ARG_OPTIONAL)
+            __argp_fmtstream_printf(stream, " [--%s[=%s]]",
+                                    uo->opt->name, uo->arg);
         else
-            __argp_fmtstream_printf(stream, " [--%s]", opt->name);
+            __argp_fmtstream_printf(stream, " [--%s=%s]",
+                                    uo->opt->name, uo->arg);
     }
 
-    return 0;
+    free(mem);
 }
 
-/* Print a short usage description for the arguments in HOL to STREAM.  */
+/* Add the entries for ARGP and its children to HOL, which has room for
+   all those of CATALOG, in CLUSTER.  *GROUP is the index in CATALOG of the
+   next argp to add, *SO is where the next short option goes, and USED tells
+   which ones are already there.  An argp whose options were added before,
+   one used in more than one place, adds nothing: its options are listed
+   where it's first used, the only place they can be given.  */
 static void
-hol_usage(struct hol *hol, argp_fmtstream_t stream)
+hol_fill(struct hol *hol, const struct argp_catalog *catalog,
+         const struct argp *argp, struct hol_cluster *cluster,
+         size_t *group, char **so, char *used)
 {
-    if (hol->num_entries > 0) {
-        unsigned nentries;
-        struct hol_entry *entry;
-        char *short_no_arg_opts = alloca(strlen(hol->short_options) + 1);
-        char *snao_end = short_no_arg_opts;
-
-        /* First we put a list of short options without arguments.  */
-        for (entry = hol->entries, nentries = hol->num_entries
-            ; nentries > 0
-            ; entry++, nentries--)
-            hol_entry_short_iterate(entry, add_argless_short_opt,
-                    entry->argp->argp_domain, &snao_end);
-
-        if (snao_end > short_no_arg_opts) {
-            *snao_end++ = 0;
-            __argp_fmtstream_printf(stream, " [-%s]", short_no_arg_opts);
+    const struct argp_child *child = argp->children;
+    const struct argp_binding *bindings;
+    struct hol_entry *entry = NULL;
+    uint32_t e, first, end;
+    int cur_group = 0;
+
+    if (*group == catalog->num_argps || catalog->argps[*group] != argp)
+        return;
+    bindings = argp_bindings(argp);
+    first = catalog->first[*group];
+    end = catalog->first[*group + 1];
+    (*group)++;
+
+    for (e = first; e < end; e++) {
+        const struct argp_option *o = argp->options + (e - first);
+
+        if (catalog->real[e] == e) {
+            entry = &hol->entries[hol->num_entries++];
+            entry->opt = o;
+            entry->num = 0;
+            entry->short_options = *so;
+            entry->group = cur_group =
+                o->group
+                ? o->group
+                : ((!o->name && !o->key)
+                ? cur_group + 1
+                : cur_group);
+            entry->cluster = cluster;
+            entry->argp = argp;
+            entry->bindings = bindings;
         }
 
-        /* Now a list of short options *with* arguments.  */
-        for (entry = hol->entries, nentries = hol->num_entries
-            ; nentries > 0
-            ; entry++, nentries--)
-            hol_entry_short_iterate(entry, usage_argful_short_opt,
-                entry->argp->argp_domain, stream);
-
-        /* Finally, a list of long options (whew!).  */
-        for (entry = hol->entries, nentries = hol->num_entries
-            ; nentries > 0
-            ; entry++, nentries--)
-            hol_entry_long_iterate(entry, usage_long_opt,
-                entry->argp->argp_domain, stream);
+        entry->num++;
+        if (oshort(o) && !used[o->key]) {
+            /* O has a valid short option which hasn't already been used.  */
+            used[o->key] = 1;
+            *(*so)++ = o->key;
+        }
     }
-}
 
-/* Make a HOL containing all levels of options in ARGP.  CLUSTER is the
-   cluster in which ARGP's entries should be clustered, or 0.  */
-static struct hol *
-argp_hol(const struct argp *argp, struct hol_cluster *cluster)
-{
-    const struct argp_child *child = argp->children;
-    struct hol *hol = make_hol(argp, cluster);
     if (child)
         while (child->argp) {
             struct hol_cluster *child_cluster =
@@ -1275,12 +1407,103 @@ argp_hol(const struct argp *argp, struct hol_cluster *cluster)
                                     child - argp->children, cluster, argp)
                         /* Just merge it into the parent's cluster.  */
                         : cluster);
-            hol_append(hol, argp_hol(child->argp, child_cluster)) ;
+            hol_fill(hol, catalog, child->argp, child_cluster, group, so,
+                     used);
             child++;
         }
+}
+
+/* Make a HOL containing all levels of options in ARGP, in the order
+   argp_parse looks at them.  The entries and short options for the whole
+   tree are allocated at once, from the sizes its catalog gives.  Returns 0
+   and sets errno to ENOMEM if there isn't room for the catalog.  */
+static struct hol *
+argp_hol(const struct argp *argp)
+{
+    struct argp_catalog catalog;
+    struct hol *hol = malloc(sizeof(struct hol));
+    char used[UCHAR_MAX + 1];
+    size_t group = 0;
+    unsigned num_entries = 0;
+    uint32_t e;
+    char *so;
+
+    assert(hol);
+    hol->num_entries = 0;
+    hol->clusters = 0;
+
+    if (__argp_catalog_init(&catalog, argp)) {
+        free(hol);
+        errno = ENOMEM;
+        return 0;
+    }
+
+    for (e = 0; e < catalog.count; e++)
+        if (catalog.real[e] == e)
+            num_entries++;
+
+    if (num_entries > 0) {
+        /* There can't be more short options than options.  */
+        hol->entries = malloc(sizeof(struct hol_entry) * num_entries);
+        hol->short_options = malloc(catalog.count + 1);
+
+        assert(hol->entries && hol->short_options);
+#if SIZE_MAX <= UINT_MAX
+        assert(num_entries <= SIZE_MAX / sizeof(struct hol_entry));
+#endif
+    } else {
+        /* Only clusters.  */
+        hol->entries = NULL;
+        hol->short_options = NULL;
+    }
+
+    memset(used, 0, sizeof used);
+    so = hol->short_options;
+    hol_fill(hol, &catalog, argp, 0, &group, &so, used);
+    if (so)
+        *so = '\0';      /* null terminated so we can find the length */
+
+    __argp_catalog_free(&catalog);
     return hol;
 }
 
+/* Make the sorted HOL used to print help for ARGP, or return 0 if there
+   isn't enough memory.  */
+static struct hol *
+argp_help_hol(const struct argp *argp)
+{
+    struct hol *hol = argp_hol(argp);
+
+    if (! hol)
+        return 0;
+
+    /* If present, these options always come last.  */
+    hol_set_group(hol, "help", -1);
+    hol_set_group(hol, "version", -1);
+
+    hol_sort(hol);
+
+    return hol;
+}
+
+/* Returns true if the HOL for ARGP would have any entries, without going to
+   the trouble of building it.  */
+static int
+argp_has_options(const struct argp *argp)
+{
+    const struct argp_child *child = argp->children;
+
+    if (argp->options && !oend(argp->options))
+        return 1;
+
+    if (child)
+        while (child->argp)
+            if (argp_has_options((child++)->argp))
+                return 1;
+
+    return 0;
+}
+
 /* Calculate how many different levels with alternative args strings exist in
    ARGP.  */
 static size_t
@@ -1305,13 +1528,15 @@ argp_args_levels(const struct argp *argp)
    updated by this routine for the next call if ADVANCE is true.  True is
    returned as long as there are more patterns to output.  */
 static int
-argp_args_usage(const struct argp *argp, const struct argp_state *state,
-        char **levels, int advance, argp_fmtstream_t stream)
+argp_args_usage(const struct argp_help_context *ctx, const struct argp *argp,
+        const struct argp_state *state, char **levels, int advance,
+        argp_fmtstream_t stream)
 {
     char *our_level = *levels;
     int multiple = 0;
     const struct argp_child *child = argp->children;
-    const char *tdoc = dgettext_safe(argp->argp_domain, argp->args_doc), *nl = 0;
+    const char *tdoc = help_gettext(ctx, argp->argp_domain,
+                                    argp->args_doc), *nl = 0;
     const char *fdoc = filter_doc(tdoc, ARGP_KEY_HELP_ARGS_DOC, argp, state);
 
     if (fdoc) {
@@ -1330,7 +1555,7 @@ argp_args_usage(const struct argp *argp, const struct argp_state *state,
 
         /* Manually do line wrapping so that it (probably) won't get wrapped at
         any embedded spaces.  */
-        space(stream, 1 + nl - cp);
+        space(stream, 1 + __argp_fmtstream_width(cp, nl - cp));
 
         __argp_fmtstream_write(stream, cp, nl - cp);
     }
@@ -1340,7 +1565,8 @@ argp_args_usage(const struct argp *argp, const struct argp_state *state,
 
     if (child)
         while (child->argp)
-            advance = !argp_args_usage((child++)->argp, state, levels, advance, stream);
+            advance = !argp_args_usage(ctx, (child++)->argp, state, levels,
+                                    advance, stream);
 
     if (advance && multiple) {
         /* Need to increment our level.  */
@@ -1364,16 +1590,16 @@ argp_args_usage(const struct argp *argp, const struct argp_state *state,
    then the first is as well.  If FIRST_ONLY is true, only the first
    occurrence is output.  Returns true if anything was output.  */
 static int
-argp_doc(const struct argp *argp, const struct argp_state *state,
-        int post, int pre_blank, int first_only,
-        argp_fmtstream_t stream)
+argp_doc(const struct argp_help_context *ctx, const struct argp *argp,
+        const struct argp_state *state, int post, int pre_blank,
+        int first_only, argp_fmtstream_t stream)
 {
     const char *text;
     const char *inp_text;
     void *input = 0;
     int anything = 0;
     size_t inp_text_limit = 0;
-    const char *doc = dgettext_safe(argp->argp_domain, argp->doc);
+    const char *doc = help_gettext(ctx, argp->argp_domain, argp->doc);
     const struct argp_child *child = argp->children;
 
     if (doc) {
@@ -1436,42 +1662,32 @@ argp_doc(const struct argp *argp, const struct argp_state *state,
 
     if (child)
         while (child->argp && !(first_only && anything))
-            anything |= argp_doc((child++)->argp, state,
+            anything |= argp_doc(ctx, (child++)->argp, state,
                             post, anything || pre_blank, first_only,
                             stream);
 
     return anything;
 }
 
-/* Output a usage message for ARGP to STREAM.  If called from
-   argp_state_help, STATE is the relevant parsing state.  FLAGS are from the
-   set ARGP_HELP_*.  NAME is what to use wherever a `program name' is
-   needed. */
+/* Output a usage message for ARGP to FS, formatted as CTX says.  If called
+   from argp_state_help, STATE is the relevant parsing state.  FLAGS are from
+   the set ARGP_HELP_*.  NAME is what to use wherever a `program name' is
+   needed.  Output stops early if FS stops accepting it.  */
 static void
-_help(const struct argp *argp, const struct argp_state *state, FILE *stream,
-    unsigned flags, const char *name)
+_help_fmtstream(const struct argp_help_context *ctx, const struct argp *argp,
+    const struct argp_state *state, argp_fmtstream_t fs, unsigned flags,
+    const char *name)
 {
     int anything = 0;     /* Whether we've output anything.  */
     struct hol *hol = 0;
-    argp_fmtstream_t fs;
-
-    if (! stream)
-        return;
-
-    fill_in_uparams(state);
 
-    fs = __argp_make_fmtstream(stream, 0, uparams.rmargin, 0);
-    if (! fs)
-        return;
-
-    if (flags & (ARGP_HELP_USAGE | ARGP_HELP_SHORT_USAGE | ARGP_HELP_LONG)) {
-        hol = argp_hol(argp, 0);
-
-        /* If present, these options always come last.  */
-        hol_set_group(hol, "help", -1);
-        hol_set_group(hol, "version", -1);
-
-        hol_sort(hol);
+    if (flags & (ARGP_HELP_USAGE | ARGP_HELP_LONG)) {
+        /* Help that leaves out the options would look complete when it
+            isn't, so if there's no memory to list them, write nothing, just
+            as when there's no memory for FS.  */
+        hol = argp_help_hol(argp);
+        if (! hol)
+            return;
     }
 
     if (flags & (ARGP_HELP_USAGE | ARGP_HELP_SHORT_USAGE)) {
@@ -1479,41 +1695,53 @@ _help(const struct argp *argp, const struct argp_state *state, FILE *stream,
         int first_pattern = 1, more_patterns;
         size_t num_pattern_levels = argp_args_levels(argp);
         char *pattern_levels = alloca(num_pattern_levels);
+        int has_options;
+
+        /* A short usage message only needs to know whether there are any
+            options at all, which is much cheaper than building the HOL if
+            nothing else needs it.  */
+        if (hol)
+            has_options = hol->num_entries > 0;
+        else
+            has_options = argp_has_options(argp);
 
         memset (pattern_levels, 0, num_pattern_levels);
 
         do
         {
             int old_lm;
-            int old_wm = __argp_fmtstream_set_wmargin(fs, uparams.usage_indent);
+            int old_wm = __argp_fmtstream_set_wmargin(fs,
+                                            ctx->uparams.usage_indent);
             char *levels = pattern_levels;
 
             if (first_pattern)
                 __argp_fmtstream_printf(fs, "%s %s",
-                            dgettext(argp->argp_domain, "Usage:"),
+                            help_gettext(ctx, argp->argp_domain,
+                                    help_messages[HELP_MSG_USAGE]),
                             name);
             else
                 __argp_fmtstream_printf(fs, "%s %s",
-                            dgettext(argp->argp_domain, "  or: "),
+                            help_gettext(ctx, argp->argp_domain,
+                                    help_messages[HELP_MSG_OR]),
                             name);
 
             /* We set the lmargin as well as the wmargin, because hol_usage
                 manually wraps options with newline to avoid annoying breaks.  */
-            old_lm = __argp_fmtstream_set_lmargin(fs, uparams.usage_indent);
+            old_lm = __argp_fmtstream_set_lmargin(fs, ctx->uparams.usage_indent);
 
             if (flags & ARGP_HELP_SHORT_USAGE) {
                 /* Just show where the options go.  */
 
-                if (hol->num_entries > 0)
-                __argp_fmtstream_puts(fs, dgettext(argp->argp_domain,
-                                    " [OPTION...]"));
+                if (has_options)
+                __argp_fmtstream_puts(fs, help_gettext(ctx, argp->argp_domain,
+                                    help_messages[HELP_MSG_OPTIONS]));
             } else {
                 /* Actually print the options.  */
-                hol_usage(hol, fs);
+                hol_usage(hol, ctx, fs);
                 flags |= ARGP_HELP_SHORT_USAGE; /* But only do so once.  */
             }
 
-            more_patterns = argp_args_usage(argp, state, &levels, 1, fs);
+            more_patterns = argp_args_usage(ctx, argp, state, &levels, 1, fs);
 
             __argp_fmtstream_set_wmargin(fs, old_wm);
             __argp_fmtstream_set_lmargin(fs, old_lm);
@@ -1523,50 +1751,102 @@ _help(const struct argp *argp, const struct argp_state *state, FILE *stream,
 
             first_pattern = 0;
         } while (more_patterns);
+
+        if (__argp_fmtstream_bounded(fs))
+            /* Get the usage line out before the rest.  */
+            __argp_fmtstream_flush(fs);
     }
 
+    if (__argp_fmtstream_stopped(fs))
+        goto done;
+
     if (flags & ARGP_HELP_PRE_DOC)
-        anything |= argp_doc(argp, state, 0, 0, 1, fs);
+        anything |= argp_doc(ctx, argp, state, 0, 0, 1, fs);
 
     if (flags & ARGP_HELP_SEE) {
-        __argp_fmtstream_printf(fs, dgettext(argp->argp_domain, "\
-                    Try `%s --help' or `%s --usage' for more information.\n"),
+        __argp_fmtstream_printf(fs, help_gettext(ctx, argp->argp_domain,
+                                    help_messages[HELP_MSG_SEE]),
                     name, name);
         anything = 1;
     }
 
     if (flags & ARGP_HELP_LONG) {
         /* Print a long, detailed help message.  */
-
         /* Print info about all the options.  */
         if (hol->num_entries > 0) {
             if (anything)
                 __argp_fmtstream_putc(fs, '\n');
-            hol_help(hol, state, fs);
+            hol_help(hol, ctx, state, fs);
             anything = 1;
         }
+
+        /* And the commands, if there are any.  */
+        if (argp_command_argp(argp)) {
+            if (anything)
+                __argp_fmtstream_putc(fs, '\n');
+            anything |= commands_help(argp, ctx, fs);
+        }
     }
 
+    if (__argp_fmtstream_stopped(fs))
+        goto done;
+
     if (flags & ARGP_HELP_POST_DOC)
         /* Print any documentation strings at the end.  */
-        anything |= argp_doc(argp, state, 1, anything, 0, fs);
+        anything |= argp_doc(ctx, argp, state, 1, anything, 0, fs);
 
     if ((flags & ARGP_HELP_BUG_ADDR) && argp_program_bug_address) {
         if (anything)
             __argp_fmtstream_putc(fs, '\n');
 
-        __argp_fmtstream_printf(fs, dgettext(argp->argp_domain,
-                            "Report bugs to %s.\n"),
+        __argp_fmtstream_printf(fs, help_gettext(ctx, argp->argp_domain,
+                                    help_messages[HELP_MSG_BUGS]),
                             argp_program_bug_address);
         anything = 1;
     }
 
+done:
     if (hol)
         hol_free(hol);
+}
+
+/* Output a usage message for ARGP to STREAM, formatted as CTX says.  If
+   called from argp_state_help, STATE is the relevant parsing state.  FLAGS
+   are from the set ARGP_HELP_*.  NAME is what to use wherever a `program
+   name' is needed. */
+static void
+_help_with_context(const struct argp_help_context *ctx,
+    const struct argp *argp, const struct argp_state *state, FILE *stream,
+    unsigned flags, const char *name)
+{
+    argp_fmtstream_t fs;
+
+    if (! stream)
+        return;
+
+    fs = __argp_make_fmtstream(stream, 0, ctx->uparams.rmargin, 0);
+    if (! fs)
+        return;
+
+    _help_fmtstream(ctx, argp, state, fs, flags, name);
 
     __argp_fmtstream_free(fs);
 }
 
+/* Like _help_with_context, but reading ARGP_HELP_FMT afresh.  */
+static void
+_help(const struct argp *argp, const struct argp_state *state, FILE *stream,
+    unsigned flags, const char *name)
+{
+    struct argp_help_context ctx;
+
+    if (! stream)
+        return;
+
+    help_context_init(&ctx, argp, state);
+    _help_with_context(&ctx, argp, state, stream, flags, name);
+}
+
 /* Output a usage message for ARGP to STREAM.  FLAGS are from the set
    ARGP_HELP_*.  NAME is what to use wherever a `program name' is needed. */
 void __argp_help(const struct argp *argp, FILE *stream,
@@ -1578,6 +1858,345 @@ void __argp_help(const struct argp *argp, FILE *stream,
 weak_alias(__argp_help, argp_help)
 #endif
 
+/* Like argp_help, but streams the output section by section through a
+   fixed-size buffer: the `Usage:' line is written first, and each cluster
+   of options as soon as it's done.  The option list has to be sorted, so
+   it's still built whole, one entry for every option of ARGP, before any
+   help that needs it is written.  Output stops as soon as MAX_BYTES bytes
+   have been written (if MAX_BYTES is non-zero) or STREAM reports an error
+   such as EPIPE, skipping the work for the rest.  Returns the number of
+   bytes written to STREAM.  */
+size_t __argp_help_stream(const struct argp *argp, FILE *stream,
+          unsigned flags, char *name, size_t max_bytes)
+{
+    struct argp_help_context ctx;
+    argp_fmtstream_t fs;
+    size_t written;
+
+    if (! stream)
+        return 0;
+
+    help_context_init(&ctx, argp, 0);
+
+    fs = __argp_make_bounded_fmtstream(stream, 0, ctx.uparams.rmargin, 0,
+                        HELP_STREAM_BUF_SIZE, max_bytes);
+    if (! fs)
+        return 0;
+
+    _help_fmtstream(&ctx, argp, 0, fs, flags, name);
+
+    __argp_fmtstream_flush(fs);
+    written = __argp_fmtstream_written(fs);
+    __argp_fmtstream_free(fs);
+
+    return written;
+}
+#ifdef weak_alias
+weak_alias(__argp_help_stream, argp_help_stream)
+#endif
+
+/* Output a usage message for ARGP to WRITE_FN, called with COOKIE.  Like
+   _help_with_context, but without a stream.  Returns the number of bytes
+   WRITE_FN took.  */
+static size_t
+_help_to_callback(const struct argp_help_context *ctx,
+    const struct argp *argp, const struct argp_state *state,
+    argp_help_write_fn write_fn, void *cookie, unsigned flags,
+    const char *name)
+{
+    argp_fmtstream_t fs;
+    size_t written;
+
+    if (! write_fn)
+        return 0;
+
+    fs = __argp_make_fmtstream_fn(write_fn, cookie, 0, ctx->uparams.rmargin, 0);
+    if (! fs)
+        return 0;
+
+    _help_fmtstream(ctx, argp, state, fs, flags, name);
+
+    __argp_fmtstream_flush(fs);
+    written = __argp_fmtstream_written(fs);
+    __argp_fmtstream_free(fs);
+
+    return written;
+}
+
+/* Where argp_help_to_buffer puts its output.  */
+struct help_buffer
+{
+    char *buf;                  /* Caller's buffer, or NULL.  */
+    size_t size;                /* Size of BUF.  */
+    size_t len;                 /* Length of the whole message so far.  */
+};
+
+/* An argp_help_write_fn that copies into a help_buffer as much as fits,
+   leaving room for the terminating '\0', but counts everything.  */
+static size_t
+help_buffer_write(void *cookie, const char *data, size_t len)
+{
+    struct help_buffer *hb = cookie;
+
+    if (hb->len + 1 < hb->size) {
+        size_t room = hb->size - 1 - hb->len;
+        memcpy(hb->buf + hb->len, data, len < room ? len : room);
+    }
+    hb->len += len;
+
+    return len;
+}
+
+/* Output a usage message for ARGP into BUF, and return its length.  */
+static size_t
+_help_to_buffer(const struct argp_help_context *ctx, const struct argp *argp,
+    const struct argp_state *state, char *buf, size_t size, unsigned flags,
+    const char *name)
+{
+    struct help_buffer hb;
+
+    hb.buf = buf;
+    hb.size = buf ? size : 0;
+    hb.len = 0;
+
+    _help_to_callback(ctx, argp, state, help_buffer_write, &hb, flags, name);
+
+    if (hb.size)
+        buf[hb.len < hb.size ? hb.len : hb.size - 1] = '\0';
+
+    return hb.len;
+}
+
+/* Like argp_help, but render the message into BUF, which is SIZE bytes
+   long, the way snprintf does: at most SIZE - 1 bytes are stored, followed
+   by a '\0'.  Returns the length of the whole message, so calling this
+   first with a SIZE of 0 tells how big BUF has to be.  */
+size_t __argp_help_to_buffer(const struct argp *argp, char *buf, size_t size,
+          unsigned flags, char *name)
+{
+    struct argp_help_context ctx;
+
+    help_context_init(&ctx, argp, 0);
+    return _help_to_buffer(&ctx, argp, 0, buf, size, flags, name);
+}
+#ifdef weak_alias
+weak_alias(__argp_help_to_buffer, argp_help_to_buffer)
+#endif
+
+/* Like argp_help, but pass the message to WRITE_FN, called with COOKIE, in
+   as many pieces as it takes.  Returns the number of bytes WRITE_FN took.  */
+size_t __argp_help_to_callback(const struct argp *argp,
+          argp_help_write_fn write_fn, void *cookie,
+          unsigned flags, char *name)
+{
+    struct argp_help_context ctx;
+
+    help_context_init(&ctx, argp, 0);
+    return _help_to_callback(&ctx, argp, 0, write_fn, cookie, flags, name);
+}
+#ifdef weak_alias
+weak_alias(__argp_help_to_callback, argp_help_to_callback)
+#endif
+
+/* Like argp_help, but write the message to the file descriptor FD, in a
+   few large writes rather than through stdio.  Returns the number of bytes
+   written; it is short if FD reported an error.  */
+size_t __argp_help_to_fd(const struct argp *argp, int fd,
+          unsigned flags, char *name)
+{
+    struct argp_help_context ctx;
+    argp_fmtstream_t fs;
+    size_t written;
+
+    if (fd < 0)
+        return 0;
+
+    help_context_init(&ctx, argp, 0);
+
+    fs = __argp_make_fmtstream_fd(fd, 0, ctx.uparams.rmargin, 0);
+    if (! fs)
+        return 0;
+
+    _help_fmtstream(&ctx, argp, 0, fs, flags, name);
+
+    __argp_fmtstream_flush(fs);
+    written = __argp_fmtstream_written(fs);
+    __argp_fmtstream_free(fs);
+
+    return written;
+}
+#ifdef weak_alias
+weak_alias(__argp_help_to_fd, argp_help_to_fd)
+#endif
+
+#if defined ENABLE_NLS && ENABLE_NLS
+/* Add the translation of MSGID in DOMAIN to CTX's cache, unless it's 0 or
+   already there.  */
+static void
+help_context_add(struct argp_help_context *ctx, const char *domain,
+    const char *msgid)
+{
+    size_t i;
+    struct help_string *hs;
+
+    if (! msgid)
+        return;
+
+    for (i = help_string_hash(domain, msgid) & ctx->strings_mask
+        ; (hs = &ctx->strings[i])->msgid
+        ; i = (i + 1) & ctx->strings_mask)
+        if (hs->msgid == msgid && hs->domain == domain)
+            return;
+
+    hs->domain = domain;
+    hs->msgid = msgid;
+    hs->str = dgettext(domain, msgid);
+}
+
+/* Returns an upper bound on the number of strings help_context_add_argp
+   adds for ARGP.  */
+static size_t
+help_context_count(const struct argp *argp)
+{
+    size_t n = 2;
+    const struct argp_option *opt;
+    const struct argp_command *command;
+    const struct argp_child *child = argp->children;
+
+    if (argp->options)
+        for (opt = argp->options; !oend(opt); opt++)
+            n += 5;
+
+    for (command = argp_commands(argp); command && command->name; command++)
+        n++;
+
+    if (child)
+        for (; child->argp; child++)
+            n += 1 + help_context_count(child->argp);
+
+    return n;
+}
+
+/* Add every string of ARGP and its children that help output translates to
+   CTX's cache.  Option docs, args and documentation option names are looked
+   up in no particular domain when there's no parsing state, which is always
+   the case when a context is used.  */
+static void
+help_context_add_argp(struct argp_help_context *ctx, const struct argp *argp)
+{
+    const char *domain = argp->argp_domain;
+    const struct argp_option *opt;
+    const struct argp_command *command;
+    const struct argp_child *child = argp->children;
+
+    help_context_add(ctx, domain, argp->doc);
+    help_context_add(ctx, domain, argp->args_doc);
+
+    if (argp->options)
+        for (opt = argp->options; !oend(opt); opt++) {
+            /* Group headers and usage use the option's own domain.  */
+            help_context_add(ctx, domain, opt->doc);
+            help_context_add(ctx, domain, opt->arg);
+            help_context_add(ctx, NULL, opt->doc);
+            help_context_add(ctx, NULL, opt->arg);
+            if (odoc(opt))
+                help_context_add(ctx, NULL, opt->name);
+        }
+
+    for (command = argp_commands(argp); command && command->name; command++)
+        help_context_add(ctx, domain, command->doc);
+
+    if (child)
+        for (; child->argp; child++) {
+            /* Child headers are printed for the parent.  */
+            help_context_add(ctx, domain, child->header);
+            help_context_add_argp(ctx, child->argp);
+        }
+}
+#endif
+
+/* Make a help context for ARGP: ARGP_HELP_FMT is read and parsed once, and
+   if messages are translated, every string that ARGP's help can show is
+   translated up front.  The context may then be used for any number of
+   help messages, by any number of threads at once.  Returns 0 if there
+   isn't enough memory.  */
+struct argp_help_context *
+__argp_help_context_new(const struct argp *argp)
+{
+    struct argp_help_context *ctx = malloc(sizeof(struct argp_help_context));
+
+    if (! ctx)
+        return 0;
+
+    help_context_init(ctx, argp, 0);
+
+#if defined ENABLE_NLS && ENABLE_NLS
+    if (argp) {
+        size_t num = help_context_count(argp) + HELP_MSG_COUNT;
+        size_t size = 16;
+        int i;
+
+        while (size < 2 * num)
+            size <<= 1;
+
+        /* Without a cache, strings are just translated when needed.  */
+        ctx->strings = calloc(size, sizeof(struct help_string));
+        if (ctx->strings) {
+            ctx->strings_mask = size - 1;
+
+            for (i = 0; i < HELP_MSG_COUNT; i++)
+                help_context_add(ctx, i == HELP_MSG_DUP_ARGS
+                                    ? NULL : argp->argp_domain,
+                                 help_messages[i]);
+            help_context_add_argp(ctx, argp);
+        }
+    }
+#endif
+
+    return ctx;
+}
+#ifdef weak_alias
+weak_alias(__argp_help_context_new, argp_help_context_new)
+#endif
+
+/* Free CTX, which must no longer be in use.  */
+void
+__argp_help_context_free(struct argp_help_context *ctx)
+{
+    if (ctx) {
+        free(ctx->strings);
+        free(ctx);
+    }
+}
+#ifdef weak_alias
+weak_alias(__argp_help_context_free, argp_help_context_free)
+#endif
+
+/* Like argp_help, for the argp CTX was made for, but formatted and
+   translated as CTX says.  */
+void
+__argp_help_with_context(const struct argp_help_context *ctx, FILE *stream,
+    unsigned flags, char *name)
+{
+    _help_with_context(ctx, ctx->argp, 0, stream, flags, name);
+}
+#ifdef weak_alias
+weak_alias(__argp_help_with_context, argp_help_with_context)
+#endif
+
+/* Like argp_help_to_buffer, for the argp CTX was made for, but formatted
+   and translated as CTX says.  */
+size_t
+__argp_help_to_buffer_with_context(const struct argp_help_context *ctx,
+    char *buf, size_t size, unsigned flags, char *name)
+{
+    return _help_to_buffer(ctx, ctx->argp, 0, buf, size, flags, name);
+}
+#ifdef weak_alias
+weak_alias(__argp_help_to_buffer_with_context,
+           argp_help_to_buffer_with_context)
+#endif
+
 char *__argp_basename(char *name)
 {
     char *short_name = strrchr(name, '/');
@@ -1613,6 +2232,46 @@ __argp_state_help(const struct argp_state *state, FILE *stream, unsigned flags)
 weak_alias(__argp_state_help, argp_state_help)
 #endif
 
+/* Like argp_state_help, but render the message for STATE into BUF the way
+   argp_help_to_buffer does.  This never exits, whatever FLAGS say.  */
+size_t
+__argp_state_help_to_buffer(const struct argp_state *state, char *buf,
+    size_t size, unsigned flags)
+{
+    struct argp_help_context ctx;
+    const struct argp *argp = state ? state->root_argp : 0;
+
+    if (state && (state->flags & ARGP_LONG_ONLY))
+        flags |= ARGP_HELP_LONG_ONLY;
+
+    help_context_init(&ctx, argp, state);
+    return _help_to_buffer(&ctx, argp, state, buf, size, flags,
+                state ? state->name : __argp_short_program_name());
+}
+#ifdef weak_alias
+weak_alias(__argp_state_help_to_buffer, argp_state_help_to_buffer)
+#endif
+
+/* Like argp_state_help, but pass the message for STATE to WRITE_FN the way
+   argp_help_to_callback does.  This never exits, whatever FLAGS say.  */
+size_t
+__argp_state_help_to_callback(const struct argp_state *state,
+    argp_help_write_fn write_fn, void *cookie, unsigned flags)
+{
+    struct argp_help_context ctx;
+    const struct argp *argp = state ? state->root_argp : 0;
+
+    if (state && (state->flags & ARGP_LONG_ONLY))
+        flags |= ARGP_HELP_LONG_ONLY;
+
+    help_context_init(&ctx, argp, state);
+    return _help_to_callback(&ctx, argp, state, write_fn, cookie, flags,
+                state ? state->name : __argp_short_program_name());
+}
+#ifdef weak_alias
+weak_alias(__argp_state_help_to_callback, argp_state_help_to_callback)
+#endif
+
 /* If appropriate, print the printf string FMT and following args, preceded
    by the program name and `:', to stderr, and followed by a `Try ... --help'
    message, then exit(1).  */
@@ -0,0 +1,171 @@
+/* C++ range over the events of an argp parse.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* argp_iter_begin and friends as a C++17 range, for a range-based for loop:
+
+     for (const win_argp::event &e : win_argp::events(&argp, argc, argv,
+                                                      ARGP_IN_ORDER))
+         if (e.key == ARGP_KEY_ARG)
+             return run_subcommand(e.arg, e.index);
+
+   Leaving the loop stops the parse where it is.  Arguments are views of
+   the strings in ARGV, and nothing is allocated beyond what argp_iter_begin
+   allocates.  */
+
+#ifndef ARGP_ITER_HPP
+#define ARGP_ITER_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#include <argp.h>
+
+namespace win_argp {
+
+/* An argp_event, with its argument as a string_view.  */
+struct event
+{
+    /* Whose option this is, or nullptr for a non-option argument or error.  */
+    const struct ::argp *argp;
+
+    /* The option's key, ARGP_KEY_ARG, or ARGP_KEY_ERROR.  */
+    int key;
+
+    /* The option's argument, the non-option argument, or the argument the
+        error is in; empty, with HAS_ARG false, for an option without one.  */
+    std::string_view arg;
+    bool has_arg;
+
+    /* The index in ARGV of the argument the event comes from.  */
+    int index;
+};
+
+/* The events of a parse, as an input range: each can be seen only once,
+   and a second begin carries on from where the first left off.  */
+class events
+{
+public:
+    struct sentinel {};
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = event;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const event *;
+        using reference = const event &;
+
+        iterator() noexcept = default;
+
+        explicit iterator(struct ::argp_iter *iter) noexcept : iter_(iter)
+        {
+            next();
+        }
+
+        reference operator*() const noexcept { return event_; }
+        pointer operator->() const noexcept { return &event_; }
+
+        iterator &operator++() noexcept
+        {
+            next();
+            return *this;
+        }
+
+        void operator++(int) noexcept { next(); }
+
+        friend bool operator==(const iterator &i, sentinel) noexcept
+        {
+            return !i.iter_;
+        }
+        friend bool operator!=(const iterator &i, sentinel s) noexcept
+        {
+            return !(i == s);
+        }
+        friend bool operator==(sentinel s, const iterator &i) noexcept
+        {
+            return i == s;
+        }
+        friend bool operator!=(sentinel s, const iterator &i) noexcept
+        {
+            return !(i == s);
+        }
+
+    private:
+        /* Fetch the next event, or become equal to the sentinel.  */
+        void next() noexcept
+        {
+            struct ::argp_event e;
+
+            if (iter_ && argp_iter_next(iter_, &e)) {
+                event_.argp = e.argp;
+                event_.key = e.key;
+                event_.has_arg = e.arg != nullptr;
+                event_.arg = e.arg ? std::string_view(e.arg)
+                                   : std::string_view();
+                event_.index = e.index;
+            } else
+                iter_ = nullptr;
+        }
+
+        struct ::argp_iter *iter_ = nullptr;
+        event event_ {};
+    };
+
+    /* Start parsing ARGC & ARGV by ARGP, as argp_iter_begin does.  */
+    events(const struct ::argp *argp, int argc, char **argv,
+           unsigned flags = 0) noexcept
+        : iter_(argp_iter_begin(argp, argc, argv, flags))
+    {
+    }
+
+    events(const events &) = delete;
+    events &operator=(const events &) = delete;
+
+    events(events &&other) noexcept
+        : iter_(std::exchange(other.iter_, nullptr))
+    {
+    }
+
+    events &operator=(events &&other) noexcept
+    {
+        std::swap(iter_, other.iter_);
+        return *this;
+    }
+
+    ~events() { argp_iter_end(iter_); }
+
+    /* False if argp_iter_begin ran out of memory, in which case the range
+        is empty.  */
+    explicit operator bool() const noexcept { return iter_ != nullptr; }
+
+    iterator begin() noexcept { return iterator(iter_); }
+    sentinel end() const noexcept { return {}; }
+
+private:
+    struct ::argp_iter *iter_;
+};
+
+} /* namespace win_argp */
+
+#endif /* ARGP_ITER_HPP */
@@ -25,6 +25,26 @@
 /* argp-parse functions */
 #undef __argp_parse
 #define __argp_parse argp_parse
+#undef __argp_parse_forward
+#define __argp_parse_forward argp_parse_forward
+#undef __argp_unparse
+#define __argp_unparse argp_unparse
+#undef __argp_complete
+#define __argp_complete argp_complete
+#undef __argp_iter_begin
+#define __argp_iter_begin argp_iter_begin
+#undef __argp_iter_next
+#define __argp_iter_next argp_iter_next
+#undef __argp_iter_suggest
+#define __argp_iter_suggest argp_iter_suggest
+#undef __argp_iter_end
+#define __argp_iter_end argp_iter_end
+#undef __argp_convert
+#define __argp_convert argp_convert
+#undef __argp_convert_list
+#define __argp_convert_list argp_convert_list
+#undef __argp_accumulated
+#define __argp_accumulated argp_accumulated
 #undef __option_is_end
 #define __option_is_end _option_is_end
 #undef __option_is_short
@@ -35,18 +55,48 @@
 /* argp-help functions */
 #undef __argp_help
 #define __argp_help argp_help
+#undef __argp_help_stream
+#define __argp_help_stream argp_help_stream
+#undef __argp_help_to_buffer
+#define __argp_help_to_buffer argp_help_to_buffer
+#undef __argp_help_to_callback
+#define __argp_help_to_callback argp_help_to_callback
+#undef __argp_help_to_fd
+#define __argp_help_to_fd argp_help_to_fd
+#undef __argp_help_context_new
+#define __argp_help_context_new argp_help_context_new
+#undef __argp_help_context_free
+#define __argp_help_context_free argp_help_context_free
+#undef __argp_help_with_context
+#define __argp_help_with_context argp_help_with_context
+#undef __argp_help_to_buffer_with_context
+#define __argp_help_to_buffer_with_context argp_help_to_buffer_with_context
 #undef __argp_error
 #define __argp_error argp_error
 #undef __argp_failure
 #define __argp_failure argp_failure
 #undef __argp_state_help
 #define __argp_state_help argp_state_help
+#undef __argp_state_help_to_buffer
+#define __argp_state_help_to_buffer argp_state_help_to_buffer
+#undef __argp_state_help_to_callback
+#define __argp_state_help_to_callback argp_state_help_to_callback
 #undef __argp_usage
 #define __argp_usage argp_usage
 
 /* argp-fmtstream functions */
 #undef __argp_make_fmtstream
 #define __argp_make_fmtstream argp_make_fmtstream
+#undef __argp_make_fmtstream_fn
+#define __argp_make_fmtstream_fn argp_make_fmtstream_fn
+#undef __argp_make_bounded_fmtstream
+#define __argp_make_bounded_fmtstream argp_make_bounded_fmtstream
+#undef __argp_make_fmtstream_fd
+#define __argp_make_fmtstream_fd argp_make_fmtstream_fd
+#undef __argp_make_fmtstream_mem
+#define __argp_make_fmtstream_mem argp_make_fmtstream_mem
+#undef __argp_fmtstream_take_memory
+#define __argp_fmtstream_take_memory argp_fmtstream_take_memory
 #undef __argp_fmtstream_free
 #define __argp_fmtstream_free argp_fmtstream_free
 #undef __argp_fmtstream_putc
@@ -69,12 +119,24 @@
 #define __argp_fmtstream_update _argp_fmtstream_update
 #undef __argp_fmtstream_ensure
 #define __argp_fmtstream_ensure _argp_fmtstream_ensure
+#undef __argp_fmtstream_flush
+#define __argp_fmtstream_flush _argp_fmtstream_flush
+#undef __argp_fmtstream_write_bounded
+#define __argp_fmtstream_write_bounded _argp_fmtstream_write_bounded
+#undef __argp_fmtstream_width
+#define __argp_fmtstream_width _argp_fmtstream_width
 #undef __argp_fmtstream_lmargin
 #define __argp_fmtstream_lmargin argp_fmtstream_lmargin
 #undef __argp_fmtstream_rmargin
 #define __argp_fmtstream_rmargin argp_fmtstream_rmargin
 #undef __argp_fmtstream_wmargin
 #define __argp_fmtstream_wmargin argp_fmtstream_wmargin
+#undef __argp_fmtstream_stopped
+#define __argp_fmtstream_stopped argp_fmtstream_stopped
+#undef __argp_fmtstream_written
+#define __argp_fmtstream_written argp_fmtstream_written
+#undef __argp_fmtstream_bounded
+#define __argp_fmtstream_bounded argp_fmtstream_bounded
 
 /* normal libc functions we call */
 #undef __flockfile
@@ -27,6 +27,7 @@
 # include <gettext.h>
 #endif /* _WIN32 */
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
@@ -38,12 +39,18 @@
 
 #include <argp.h>
 #include "argp-namefrob.h"
+#include "argp-dag.h"
+#include "argp-catalog.h"
 
 /* Getopt return values.  */
 #define KEY_END (-1)    /* The end of the options.  */
 #define KEY_ARG 1       /* A non-option argument.  */
 #define KEY_ERR '?'     /* An error parsing the options.  */
 
+/* Not a getopt value: what a real KEY_ERR becomes, since KEY_ERR is also a
+   valid short option.  */
+#define KEY_BAD (-2)
+
 /* The meta-argument used to prevent any further arguments being interpreted
    as options.  */
 #define QUOTE "--"
@@ -69,6 +76,7 @@ static volatile int _argp_hang;
 #define OPT_PROGNAME    -2
 #define OPT_USAGE       -3
 #define OPT_HANG        -4
+#define OPT_COMPLETE    -5
 
 static const struct argp_option argp_default_options[] =
 {
@@ -76,6 +84,8 @@ static const struct argp_option argp_default_options[] =
         N_("Give this help list"), -1},
     {"usage",          OPT_USAGE,          0,             0,
         N_("Give a short usage message")},
+    {"complete",    OPT_COMPLETE,          0, OPTION_HIDDEN,
+        N_("List the completions of the last argument, for shells")},
     {"program-name",OPT_PROGNAME, N_("NAME"), OPTION_HIDDEN,
         N_("Set the program name")},
     {"HANG",            OPT_HANG, N_("SECS"), OPTION_ARG_OPTIONAL | OPTION_HIDDEN,
@@ -95,6 +105,16 @@ argp_default_parser(int key, char *arg, struct argp_state *state)
                     ARGP_HELP_USAGE | ARGP_HELP_EXIT_OK);
         break;
 
+    case OPT_COMPLETE:
+        /* Not first, so not caught by argp_parse before parsing: complete
+            what's left.  */
+        __argp_complete(state->root_argp, state->argc - state->next,
+                    state->argv + state->next, state->out_stream);
+        if (! (state->flags & ARGP_NO_EXIT))
+            exit(0);
+        state->next = state->argc;
+        break;
+
     case OPT_PROGNAME:      /* Set the program name.  */
 #if 0 || HAVE_DECL_PROGRAM_INVOCATION_NAMEF
         program_invocation_name = arg;
@@ -168,24 +188,321 @@ argp_version_parser(int key, char *arg, struct argp_state *state)
 static const struct argp argp_version_argp =
     {argp_version_options, &argp_version_parser, NULL, NULL, NULL, NULL, "libc"};
 
-/* Returns the offset into the getopt long options array LONG_OPTIONS of a
-   long option with called NAME, or -1 if none is found.  Passing NULL as
-   NAME will return the number of options.  */
+
+/* Perfect hashes for ARGP_BIND_ENUM bindings.  Each holds every name and
+   every prefix of one, so that an abbreviated argument is found with one
+   probe, like a whole one.  They're built by hash and displace: the keys
+   are put in buckets, and the buckets, biggest first, each get the first
+   displacement that moves all their keys to free slots.  */
+
+/* Where an enum's key is.  */
+struct enum_slot
+{
+    /* The index in the binding's VALUES of a name that starts with the key,
+        or -1 if the slot is free.  */
+    int index;
+
+    /* The length of the key.  */
+    unsigned len;
+
+    /* True if names with different values start with the key.  */
+    int ambiguous;
+};
+
+/* The hash of an ARGP_BIND_ENUM binding's names.  */
+struct group_enum
+{
+    const struct argp_binding *binding;
+
+    /* The numbers of DISPLACE and SLOTS, powers of 2.  SLOT_COUNT is 0 if
+        no hash was found, and the names are searched instead.  */
+    size_t bucket_count, slot_count;
+    uint32_t *displace;
+    struct enum_slot *slots;
+};
+
+/* A key while the hash is built.  */
+struct enum_key
+{
+    uint64_t hash;
+    struct enum_slot slot;
+};
+
+/* Tries with more displacements than this give up on the hash.  */
+#define ENUM_MAX_DISPLACE (1u << 20)
+
+static size_t
+enum_pow2_at_least(size_t n)
+{
+    size_t p = 1;
+
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+/* The number of keys of BINDING, at most: one per byte of its names.  */
+static size_t
+enum_key_count(const struct argp_binding *binding)
+{
+    const struct argp_enum *value;
+    size_t count = 0;
+
+    for (value = binding->values; value && value->name; value++)
+        count += strlen(value->name);
+    return count;
+}
+
+#define enum_slot_count(keys) enum_pow2_at_least(2 * (keys))
+#define enum_bucket_count(keys) enum_pow2_at_least(((keys) + 3) / 4)
+
+/* FNV-1a, as argp-static.hpp hashes option names.  */
+#define ENUM_FNV_BASIS UINT64_C(0xcbf29ce484222325)
+#define enum_fnv(h, c) \
+    (((h) ^ (unsigned char) (c)) * UINT64_C(0x100000001b3))
+
+static size_t
+enum_bucket(uint64_t h, size_t count)
+{
+    return (size_t) (h >> 40) & (count - 1);
+}
+
+static size_t
+enum_slot(uint64_t h, uint32_t d, size_t count)
+{
+    h ^= (d + UINT64_C(1)) * UINT64_C(0x9e3779b97f4a7c15);
+    h ^= h >> 29;
+    h *= UINT64_C(0xbf58476d1ce4e5b9);
+    h ^= h >> 32;
+    return (size_t) h & (count - 1);
+}
+
 static int
-find_long_option(struct option *long_options, const char *name)
+enum_compare(const void *a, const void *b)
 {
-    struct option *l = long_options;
-    while (l->name != NULL)
-        if (name != NULL && strcmp(l->name, name) == 0)
-            return l - long_options;
-        else
-            l++;
-    if (name == NULL)
-        return l - long_options;
-    else
+    return strcmp((*(const struct argp_enum *const *) a)->name,
+                  (*(const struct argp_enum *const *) b)->name);
+}
+
+/* Find the keys of GE's names, the ones that differ, in KEYS, and return
+   how many there are.  SORTED and LCP have room for one entry per name.  */
+static size_t
+enum_keys(const struct group_enum *ge, const struct argp_enum **sorted,
+          size_t *lcp, struct enum_key *keys)
+{
+    const struct argp_enum *values = ge->binding->values;
+    size_t n = 0, count = 0, i, k;
+
+    for (; values[n].name; n++)
+        sorted[n] = &values[n];
+    qsort(sorted, n, sizeof *sorted, enum_compare);
+
+    /* LCP[I] is the length of the common prefix of names I and I + 1.  The
+        names starting with a prefix are next to each other.  */
+    for (i = 0; i < n; i++) {
+        const char *a = sorted[i]->name, *b = i + 1 < n ? sorted[i + 1]->name : "";
+
+        for (k = 0; a[k] && a[k] == b[k]; k++)
+            ;
+        lcp[i] = k;
+    }
+
+    /* Name I adds the prefixes that name I - 1 doesn't start with.  Going
+        from the longest, the names starting with each are I up to R.  */
+    for (i = 0; i < n; i++) {
+        const char *name = sorted[i]->name;
+        size_t len = strlen(name), prev = i ? lcp[i - 1] : 0, r = i;
+        int mixed = 0;
+        uint64_t h = ENUM_FNV_BASIS;
+
+        for (k = len; k > prev; k--) {
+            struct enum_slot *slot = &keys[count + k - prev - 1].slot;
+
+            for (; r + 1 < n && lcp[r] >= k; r++)
+                mixed |= sorted[r + 1]->value != sorted[i]->value;
+            slot->index = (int) (sorted[i] - values);
+            slot->len = (unsigned) k;
+            /* A whole name is never ambiguous.  */
+            slot->ambiguous = k < len && mixed;
+        }
+
+        for (k = 0; k < len; k++) {
+            h = enum_fnv(h, name[k]);
+            if (k >= prev)
+                keys[count + k - prev].hash = h;
+        }
+        if (len > prev)
+            count += len - prev;
+    }
+
+    return count;
+}
+
+/* Build the hash GE, whose tables are allocated and sized already.  */
+static error_t
+enum_build(struct group_enum *ge)
+{
+    size_t names = 0, total = enum_key_count(ge->binding), count, i, j, b;
+    size_t largest = 0, *lcp, *bucket_start;
+    const struct argp_enum **sorted;
+    struct enum_key *keys, *by_bucket;
+    char *scratch;
+
+    while (ge->binding->values[names].name)
+        names++;
+
+    scratch = malloc(names * (sizeof *sorted + sizeof *lcp)
+                     + 2 * total * sizeof *keys
+                     + (ge->bucket_count + 1) * sizeof *bucket_start);
+    if (!scratch)
+        return ENOMEM;
+    keys = (struct enum_key *) scratch;
+    by_bucket = keys + total;
+    bucket_start = (size_t *) (by_bucket + total);
+    lcp = bucket_start + ge->bucket_count + 1;
+    sorted = (const struct argp_enum **) (lcp + names);
+
+    count = enum_keys(ge, sorted, lcp, keys);
+
+    /* Sort the keys by bucket.  */
+    memset(bucket_start, 0, (ge->bucket_count + 1) * sizeof *bucket_start);
+    for (i = 0; i < count; i++)
+        bucket_start[enum_bucket(keys[i].hash, ge->bucket_count) + 1]++;
+    for (b = 0; b < ge->bucket_count; b++) {
+        if (bucket_start[b + 1] > largest)
+            largest = bucket_start[b + 1];
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    for (i = 0; i < count; i++) {
+        b = enum_bucket(keys[i].hash, ge->bucket_count);
+        by_bucket[bucket_start[b]++] = keys[i];
+    }
+    /* Each start is now the next bucket's; shift them back.  */
+    memmove(bucket_start + 1, bucket_start,
+            ge->bucket_count * sizeof *bucket_start);
+    bucket_start[0] = 0;
+
+    for (i = 0; i < ge->slot_count; i++)
+        ge->slots[i].index = -1;
+    memset(ge->displace, 0, ge->bucket_count * sizeof *ge->displace);
+
+    for (; largest && ge->slot_count; largest--)
+        for (b = 0; b < ge->bucket_count; b++) {
+            struct enum_key *members = by_bucket + bucket_start[b];
+            size_t n = bucket_start[b + 1] - bucket_start[b];
+            uint32_t d;
+
+            if (n != largest)
+                continue;
+
+            for (d = 0; d < ENUM_MAX_DISPLACE; d++) {
+                int fits = 1;
+
+                for (i = 0; i < n && fits; i++) {
+                    size_t s = enum_slot(members[i].hash, d, ge->slot_count);
+
+                    fits = ge->slots[s].index < 0;
+                    for (j = 0; j < i && fits; j++)
+                        fits = s != enum_slot(members[j].hash, d,
+                                              ge->slot_count);
+                }
+                if (fits)
+                    break;
+            }
+
+            if (d == ENUM_MAX_DISPLACE) {
+                ge->slot_count = 0;
+                break;
+            }
+            ge->displace[b] = d;
+            for (i = 0; i < n; i++)
+                ge->slots[enum_slot(members[i].hash, d, ge->slot_count)] =
+                    members[i].slot;
+        }
+
+    free(scratch);
+    return 0;
+}
+
+/* Return the index in GE's binding's VALUES of the one ARG means, or -1 if
+   none does, setting *AMBIGUOUS if that's because several might.  */
+static int
+enum_find(const struct group_enum *ge, const char *arg, int *ambiguous)
+{
+    const struct argp_enum *values = ge->binding->values;
+    const struct enum_slot *slot;
+    size_t len = strlen(arg), i;
+    uint64_t h = ENUM_FNV_BASIS;
+    int found = -1;
+
+    *ambiguous = 0;
+
+    if (!ge->slot_count) {
+        /* No hash: look at every name.  */
+        for (i = 0; values[i].name; i++)
+            if (strncmp(values[i].name, arg, len) == 0) {
+                if (!values[i].name[len])
+                    return (int) i;
+                if (found < 0)
+                    found = (int) i;
+                else if (values[found].value != values[i].value)
+                    *ambiguous = 1;
+            }
+        return *ambiguous || !len ? -1 : found;
+    }
+
+    for (i = 0; i < len; i++)
+        h = enum_fnv(h, arg[i]);
+    slot = &ge->slots[enum_slot(h, ge->displace[enum_bucket(h, ge->bucket_count)],
+                                ge->slot_count)];
+    if (slot->index < 0 || slot->len != len
+        || strncmp(values[slot->index].name, arg, len) != 0)
+        return -1;
+    if (slot->ambiguous) {
+        *ambiguous = 1;
         return -1;
+    }
+    return slot->index;
 }
 
+/* The arguments of an OPTION_ACCUMULATE option so far.  */
+struct group_accum
+{
+    int key;
+    char **args;
+    size_t count, alloced;
+};
+
+/* What parsing one of the getopt options does besides calling its group's
+   parser: collect its argument, if it's an OPTION_ACCUMULATE option, or
+   else store it as its binding says, if it has one.  */
+struct parser_slot
+{
+    struct group_accum *accum;
+    const struct argp_binding *binding;
+};
+
+/* The bits of some of a constraint's options that are in one word of the
+   bitset of options seen.  */
+struct constraint_term
+{
+    size_t word;
+    uint64_t mask;
+};
+
+/* An argp_constraint, as masks of the bits of its options.  */
+struct parser_constraint
+{
+    const struct argp_constraint *constraint;
+    const struct group *group;
+
+    /* For ARGP_REQUIRES, the bit of the first option.  */
+    size_t trigger;
+
+    /* The bits of the other options.  */
+    struct constraint_term *terms;
+    unsigned num_terms;
+};
 
 /* The state of a `group' during parsing.  Each group corresponds to a
    particular argp structure from the tree of such descending from the top
@@ -214,27 +531,22 @@ struct group
         calling this group's parser.  */
     void *input, **child_inputs;
     void *hook;
-};
 
-/* Call GROUP's parser with KEY and ARG, swapping any group-specific info
-   from STATE before calling, and back into state afterwards.  If GROUP has
-   no parser, EBADKEY is returned.  */
-static error_t
-group_parse(struct group *group, struct argp_state *state, int key, char *arg)
-{
-    if (group->parser) {
-        error_t err;
-        state->hook = group->hook;
-        state->input = group->input;
-        state->child_inputs = group->child_inputs;
-        state->arg_num = group->args_processed;
-        err = (*group->parser)(key, arg, state);
-        group->hook = state->hook;
-        return err;
-    }
-    else
-        return EBADKEY;
-}
+    /* The hashes of this group's ARGP_BIND_ENUM bindings.  */
+    struct group_enum *enums;
+    unsigned num_enums;
+
+    /* The arguments of this group's OPTION_ACCUMULATE options.  */
+    struct group_accum *accums;
+    unsigned num_accums;
+
+    /* The keys of the options this group's constraints name, sorted; the
+        option with CKEYS[I] has bit BIT_BASE + I in the bitset of options
+        seen.  */
+    int *ckeys;
+    unsigned num_ckeys;
+    size_t bit_base;
+};
 
 struct parser
 {
@@ -247,6 +559,12 @@ struct parser
         all the groups of options.  */
     struct option *long_opts;
 
+    /* The slots of the options in SHORT_OPTS and LONG_OPTS, at the same
+        places, and the place in LONG_OPTS of the option getopt returned
+        last, or -1 if it wasn't a long one.  */
+    struct parser_slot *short_slots, *long_slots;
+    int long_index;
+
     /* States of the various parsing groups.  */
     struct group *groups;
     /* The end of the GROUPS array.  */
@@ -254,19 +572,69 @@ struct parser
     /* An vector containing storage for the CHILD_INPUTS field in all groups.  */
     void **child_inputs;
 
+    /* The hashes of all the groups' ARGP_BIND_ENUM bindings, and their end.  */
+    struct group_enum *enums, *eenum;
+
+    /* All the groups' OPTION_ACCUMULATE options, and their end.  */
+    struct group_accum *accums, *eaccum;
+
+    /* All the groups' constraints, and their end, and a bitset of which of
+        the options they name have been seen.  */
+    struct parser_constraint *constraints, *econstraint;
+    uint64_t *seen;
+
+    /* The group whose parser was called last.  */
+    struct group *current;
+
+    /* The first group whose argp has commands, or NULL, its commands, and
+        whether the command has been given yet.  */
+    struct group *command_group;
+    const struct argp_command *commands;
+    int command_done;
+
     /* True if we think using getopt is still useful; if false, then
         remaining arguments are just passed verbatim with ARGP_KEY_ARG.  This is
         cleared whenever getopt returns KEY_END, but may be set again if the user
         moves the next argument pointer backwards.  */
     int try_getopt;
 
+    /* If non-NULL, options that no parser knows are stored here instead of
+        being errors, as argp_parse_forward describes; FORWARD_LEN is how many
+        have been so far.  */
+    char **forward;
+    size_t forward_len;
+
     /* State block supplied to parsing routines.  */
     struct argp_state state;
 
+    /* Every option of the tree.  */
+    struct argp_catalog catalog;
+
     /* Memory used by this parser.  */
     void *storage;
 };
 
+/* Call GROUP's parser with KEY and ARG, swapping any group-specific info
+   from STATE before calling, and back into state afterwards.  If GROUP has
+   no parser, EBADKEY is returned.  */
+static error_t
+group_parse(struct group *group, struct argp_state *state, int key, char *arg)
+{
+    if (group->parser) {
+        error_t err;
+        ((struct parser *) state->pstate)->current = group;
+        state->hook = group->hook;
+        state->input = group->input;
+        state->child_inputs = group->child_inputs;
+        state->arg_num = group->args_processed;
+        err = (*group->parser)(key, arg, state);
+        group->hook = state->hook;
+        return err;
+    }
+    else
+        return EBADKEY;
+}
+
 /* The next usable entries in the various parser tables being filled in by
    convert_options.  */
 struct parser_convert_state
@@ -275,12 +643,137 @@ struct parser_convert_state
     char *short_end;
     struct option *long_end;
     void **child_inputs_end;
+    struct group_enum *enums_end;
+    struct group_accum *accums_end;
+    struct parser_constraint *constraints_end;
+    struct constraint_term *terms_end;
+    int *ckeys_end;
+    size_t bits_end;
+    struct enum_slot *slots_end;
+    uint32_t *displace_end;
+    /* The argps whose options have been converted.  */
+    struct argp_seen *seen;
+    /* The catalog entry of the next option converted.  */
+    uint32_t entry;
 };
 
+static int
+constraint_key_compare(const void *a, const void *b)
+{
+    int x = *(const int *) a, y = *(const int *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* Return the bit of GROUP's option KEY in the bitset of options seen, or
+   -1 if none of GROUP's constraints name it.  */
+static size_t
+group_constraint_bit(const struct group *group, int key)
+{
+    unsigned lo = 0, hi = group->num_ckeys;
+
+    while (lo < hi) {
+        unsigned mid = lo + (hi - lo) / 2;
+
+        if (group->ckeys[mid] < key)
+            lo = mid + 1;
+        else if (group->ckeys[mid] > key)
+            hi = mid;
+        else
+            return group->bit_base + mid;
+    }
+    return (size_t) -1;
+}
+
+/* Number the options CONSTRAINTS name, for GROUP, whose argp has them,
+   and turn the constraints into masks.  */
+static void
+convert_constraints(const struct argp_constraint *constraints,
+        struct group *group, struct parser_convert_state *cvt)
+{
+    const struct argp_constraint *c;
+    const int *key;
+    unsigned n = 0, i;
+
+    group->ckeys = cvt->ckeys_end;
+    group->bit_base = cvt->bits_end;
+
+    for (c = constraints; c->type; c++)
+        for (key = c->keys; *key; key++)
+            group->ckeys[n++] = *key;
+    qsort(group->ckeys, n, sizeof(int), constraint_key_compare);
+    for (group->num_ckeys = 0, i = 0; i < n; i++)
+        if (!group->num_ckeys || group->ckeys[group->num_ckeys - 1] != group->ckeys[i])
+            group->ckeys[group->num_ckeys++] = group->ckeys[i];
+    cvt->ckeys_end += group->num_ckeys;
+    cvt->bits_end += group->num_ckeys;
+
+    for (c = constraints; c->type; c++) {
+        struct parser_constraint *pc = cvt->constraints_end++;
+
+        pc->constraint = c;
+        pc->group = group;
+        pc->trigger = 0;
+        pc->terms = cvt->terms_end;
+        pc->num_terms = 0;
+
+        for (key = c->keys; *key; key++) {
+            size_t bit = group_constraint_bit(group, *key);
+
+            if (c->type == ARGP_REQUIRES && key == c->keys) {
+                pc->trigger = bit;
+                continue;
+            }
+
+            /* Options close together share a word.  */
+            for (i = pc->num_terms; i > 0 && pc->terms[i - 1].word != bit / 64; i--)
+                ;
+            if (i == 0) {
+                i = ++pc->num_terms;
+                pc->terms[i - 1].word = bit / 64;
+                pc->terms[i - 1].mask = 0;
+            }
+            pc->terms[i - 1].mask |= (uint64_t) 1 << bit % 64;
+        }
+        cvt->terms_end += pc->num_terms;
+    }
+}
+
+/* Return GROUP's OPTION_ACCUMULATE option KEY, or NULL if KEY isn't one.  */
+static struct group_accum *
+group_accum(const struct group *group, int key)
+{
+    unsigned i;
+
+    for (i = 0; i < group->num_accums; i++)
+        if (group->accums[i].key == key)
+            return &group->accums[i];
+    return NULL;
+}
+
+/* Fill in SLOT for the option KEY of GROUP, whose argp has BINDINGS.  */
+static void
+convert_slot(const struct argp_binding *bindings, struct group *group,
+        int key, struct parser_slot *slot)
+{
+    const struct argp_binding *binding = bindings;
+
+    slot->accum = group_accum(group, key);
+    slot->binding = NULL;
+    if (binding)
+        for (; binding->key; binding++)
+            if (binding->key == key) {
+                slot->binding = binding;
+                break;
+            }
+}
+
 /* Converts all options in ARGP (which is put in GROUP) and ancestors
    into getopt options stored in SHORT_OPTS and LONG_OPTS; SHORT_END and
    CVT->LONG_END are the points at which new options are added.  Returns the
-   next unused group entry.  CVT holds state used during the conversion.  */
+   next unused group entry.  CVT holds state used during the conversion.
+   An argp already converted elsewhere in the tree gets a group for its
+   parser, but none of its options, which the first one shadows.  */
 static struct group *
 convert_options(const struct argp *argp,
         struct group *parent, unsigned parent_index,
@@ -289,15 +782,40 @@ convert_options(const struct argp *argp,
     /* REAL is the most recent non-alias value of OPT.  */
     const struct argp_option *real = argp->options;
     const struct argp_child *children = argp->children;
+    const struct argp_binding *bindings = argp_bindings(argp);
+    const struct argp_constraint *constraints = argp_constraints(argp);
+    const struct argp_command *commands = argp_commands(argp);
+    int shared = argp_seen_add(cvt->seen, argp);
 
-    if (real || argp->parser) {
+    if (real || argp->parser || commands) {
         const struct argp_option *opt;
+        char *short_start = cvt->short_end;
+        struct option *long_start = cvt->long_end;
+
+        group->accums = cvt->accums_end;
+        group->num_accums = 0;
+
+        if (shared)
+            real = NULL;
 
         if (real)
             for (opt = real; !__option_is_end(opt); opt++) {
-                if (! (opt->flags & OPTION_ALIAS))
-                /* OPT isn't an alias, so we can use values from it.  */
-                real = opt;
+                uint32_t entry = cvt->entry++;
+
+                if (! (opt->flags & OPTION_ALIAS)) {
+                    /* OPT isn't an alias, so we can use values from it.  */
+                    real = opt;
+
+                    if ((opt->flags & (OPTION_ACCUMULATE | OPTION_DOC))
+                        == OPTION_ACCUMULATE) {
+                        struct group_accum *accum = cvt->accums_end++;
+
+                        accum->key = opt->key;
+                        accum->args = NULL;
+                        accum->count = accum->alloced = 0;
+                        group->num_accums++;
+                    }
+                }
 
                 if (! (real->flags & OPTION_DOC)) {
                     /* A real option (not just documentation).  */
@@ -312,9 +830,9 @@ convert_options(const struct argp *argp,
                         *cvt->short_end = '\0'; /* keep 0 terminated */
                     }
 
-                    if (opt->name
-                        && find_long_option(cvt->parser->long_opts, opt->name) < 0) {
-                        /* OPT can be used as a long option.  */
+                    if (cvt->parser->catalog.flags[entry] & ARGP_CATALOG_LONG) {
+                        /* OPT can be used as a long option: no earlier one
+                        has its name.  */
                         cvt->long_end->name = opt->name;
                         cvt->long_end->has_arg =
                                 (real->arg ? (real->flags & OPTION_ARG_OPTIONAL
@@ -338,6 +856,22 @@ convert_options(const struct argp *argp,
                 }
             }
 
+        if (real) {
+            /* Find what each of GROUP's options does, now that all its
+            accumulated options are known.  */
+            char *so;
+            struct option *lo;
+
+            for (so = short_start; so < cvt->short_end; so++)
+                if (*so != ':')
+                    convert_slot(bindings, group, *so,
+                        &cvt->parser->short_slots[so - cvt->parser->short_opts]);
+            for (lo = long_start; lo < cvt->long_end; lo++)
+                convert_slot(bindings, group,
+                    (int) ((unsigned) lo->val << GROUP_BITS) >> GROUP_BITS,
+                    &cvt->parser->long_slots[lo - cvt->parser->long_opts]);
+        }
+
         group->parser = argp->parser;
         group->argp = argp;
         group->short_end = cvt->short_end;
@@ -347,6 +881,33 @@ convert_options(const struct argp *argp,
         group->input = 0;
         group->hook = 0;
         group->child_inputs = 0;
+        group->enums = cvt->enums_end;
+        group->num_enums = 0;
+        group->num_ckeys = 0;
+
+        if (constraints && !shared)
+            convert_constraints(constraints, group, cvt);
+
+        if (bindings && !shared) {
+            /* Give each ARGP_BIND_ENUM binding its tables; they're filled
+            in once all the groups are converted.  */
+            const struct argp_binding *binding;
+
+            for (binding = bindings; binding->key; binding++)
+                if (binding->type == ARGP_BIND_ENUM) {
+                    struct group_enum *ge = cvt->enums_end++;
+                    size_t keys = enum_key_count(binding);
+
+                    ge->binding = binding;
+                    ge->bucket_count = enum_bucket_count(keys);
+                    ge->slot_count = enum_slot_count(keys);
+                    ge->displace = cvt->displace_end;
+                    ge->slots = cvt->slots_end;
+                    cvt->displace_end += ge->bucket_count;
+                    cvt->slots_end += ge->slot_count;
+                    group->num_enums++;
+                }
+        }
 
         if (children) {
             /* Assign GROUP's CHILD_INPUTS field some space from
@@ -360,6 +921,11 @@ convert_options(const struct argp *argp,
             cvt->child_inputs_end += num_children;
         }
 
+        if (commands && !cvt->parser->command_group) {
+            cvt->parser->command_group = group;
+            cvt->parser->commands = commands;
+        }
+
         parent = group++;
     } else
         parent = 0;
@@ -374,9 +940,14 @@ convert_options(const struct argp *argp,
     return group;
 }
 
-/* Find the merged set of getopt options, with keys appropriately prefixed. */
+/* Find the merged set of getopt options, with keys appropriately prefixed.
+   The tables of the enum hashes are taken from SLOTS and DISPLACE, and
+   those of the constraints from TERMS and CKEYS.  SEEN is an empty set for
+   ARGP's tree.  */
 static void
-parser_convert(struct parser *parser, const struct argp *argp, int flags)
+parser_convert(struct parser *parser, const struct argp *argp, int flags,
+        struct enum_slot *slots, uint32_t *displace,
+        struct constraint_term *terms, int *ckeys, struct argp_seen *seen)
 {
     struct parser_convert_state cvt;
 
@@ -384,6 +955,16 @@ parser_convert(struct parser *parser, const struct argp *argp, int flags)
     cvt.short_end = parser->short_opts;
     cvt.long_end = parser->long_opts;
     cvt.child_inputs_end = parser->child_inputs;
+    cvt.enums_end = parser->enums;
+    cvt.accums_end = parser->accums;
+    cvt.constraints_end = parser->constraints;
+    cvt.terms_end = terms;
+    cvt.ckeys_end = ckeys;
+    cvt.bits_end = 0;
+    cvt.slots_end = slots;
+    cvt.displace_end = displace;
+    cvt.seen = seen;
+    cvt.entry = 0;
 
     if (flags & ARGP_IN_ORDER)
         *cvt.short_end++ = '-';
@@ -394,11 +975,16 @@ parser_convert(struct parser *parser, const struct argp *argp, int flags)
     cvt.long_end->name = NULL;
 
     parser->argp = argp;
+    parser->command_group = NULL;
+    parser->commands = NULL;
 
     if (argp)
         parser->egroup = convert_options(argp, 0, 0, parser->groups, &cvt);
     else
         parser->egroup = parser->groups; /* No parsers at all! */
+    parser->eenum = cvt.enums_end;
+    parser->eaccum = cvt.accums_end;
+    parser->econstraint = cvt.constraints_end;
 }
 
 /* Lengths of various parser fields which we will allocated.  */
@@ -408,70 +994,177 @@ struct parser_sizes
     size_t long_len;      /* Getopt long options vector.  */
     size_t num_groups;        /* Group structures we allocate.  */
     size_t num_child_inputs;  /* Child input slots.  */
+    size_t num_accums;        /* OPTION_ACCUMULATE options.  */
+    size_t num_constraints;   /* Constraints...  */
+    size_t constraint_keys;   /* ...and the keys they name.  */
+    size_t num_enums;         /* ARGP_BIND_ENUM hashes.  */
+    size_t enum_slots;        /* Their slots...  */
+    size_t enum_buckets;      /* ...and buckets.  */
+    int commands;             /* Whether any argp has commands.  */
 };
 
 /* For ARGP, increments the NUM_GROUPS field in SZS by the total number of
  argp structures descended from it, and the SHORT_LEN & LONG_LEN fields by
  the maximum lengths of the resulting merged getopt short options string and
- long-options array, respectively.  */
+ long-options array, respectively.  The options of argps in SEEN, which
+ convert_options won't convert again, aren't counted.  */
 static void
-calc_sizes(const struct argp *argp,  struct parser_sizes *szs)
+calc_sizes(const struct argp *argp,  struct parser_sizes *szs,
+        struct argp_seen *seen)
 {
     const struct argp_child *child = argp->children;
     const struct argp_option *opt = argp->options;
+    const struct argp_binding *bindings = argp_bindings(argp);
+    const struct argp_constraint *constraints = argp_constraints(argp);
+    const struct argp_command *commands = argp_commands(argp);
+    int shared = argp_seen_add(seen, argp);
 
-    if (opt || argp->parser) {
+    if (opt || argp->parser || commands) {
         szs->num_groups++;
+        if (commands)
+            szs->commands = 1;
+        if (shared)
+            opt = NULL;
         if (opt) {
             int num_opts = 0;
-            while (!__option_is_end(opt++))
+            for (; !__option_is_end(opt); opt++) {
                 num_opts++;
+                if ((opt->flags & (OPTION_ACCUMULATE | OPTION_ALIAS
+                                   | OPTION_DOC)) == OPTION_ACCUMULATE)
+                    szs->num_accums++;
+            }
             szs->short_len += num_opts * 3; /* opt + up to 2 `:'s */
             szs->long_len += num_opts;
         }
+
+        if (bindings && !shared) {
+            const struct argp_binding *binding;
+
+            for (binding = bindings; binding->key; binding++)
+                if (binding->type == ARGP_BIND_ENUM) {
+                    size_t keys = enum_key_count(binding);
+
+                    szs->num_enums++;
+                    szs->enum_slots += enum_slot_count(keys);
+                    szs->enum_buckets += enum_bucket_count(keys);
+                }
+        }
+
+        if (constraints && !shared) {
+            const struct argp_constraint *c;
+            const int *key;
+
+            for (c = constraints; c->type; c++) {
+                szs->num_constraints++;
+                for (key = c->keys; *key; key++)
+                    szs->constraint_keys++;
+            }
+        }
     }
 
     if (child)
         while (child->argp) {
-            calc_sizes((child++)->argp, szs);
+            calc_sizes((child++)->argp, szs, seen);
             szs->num_child_inputs++;
         }
 }
 
-/* Initializes PARSER to parse ARGP in a manner described by FLAGS.  */
+/* Sets up PARSER to parse ARGP in a manner described by FLAGS, without
+   calling any parsers yet.  */
 static error_t
-parser_init(struct parser *parser, const struct argp *argp,
-        int argc, char **argv, int flags, void *input)
+parser_setup(struct parser *parser, const struct argp *argp,
+        int argc, char **argv, int flags)
 {
-    error_t err = 0;
-    struct group *group;
     struct parser_sizes szs;
+    struct argp_seen seen;
+    struct group_enum *ge;
+    struct enum_slot *slots;
+    uint32_t *displace;
+    struct constraint_term *terms;
+    int *ckeys;
+    char *at;
+    error_t err = 0;
 
     szs.short_len = (flags & ARGP_NO_ARGS) ? 0 : 1;
     szs.long_len = 0;
     szs.num_groups = 0;
     szs.num_child_inputs = 0;
-
+    szs.num_accums = 0;
+    szs.num_constraints = 0;
+    szs.constraint_keys = 0;
+    szs.num_enums = 0;
+    szs.enum_slots = 0;
+    szs.enum_buckets = 0;
+    szs.commands = 0;
+
+    argp_seen_init(&seen, argp);
     if (argp)
-        calc_sizes(argp, &szs);
+        calc_sizes(argp, &szs, &seen);
+
+    err = __argp_catalog_init(&parser->catalog, argp);
+    if (err) {
+        argp_seen_free(&seen);
+        return err;
+    }
 
     /* Lengths of the various bits of storage used by PARSER.  */
 #define GLEN (szs.num_groups + 1) * sizeof(struct group)
+#define ELEN (szs.num_enums * sizeof(struct group_enum))
+#define ALEN (szs.num_accums * sizeof(struct group_accum))
+#define KLEN (szs.num_constraints * sizeof(struct parser_constraint))
+#define MLEN (szs.constraint_keys * sizeof(struct constraint_term))
+#define BLEN ((szs.constraint_keys + 63) / 64 * sizeof(uint64_t))
 #define CLEN (szs.num_child_inputs * sizeof(void *))
 #define LLEN ((szs.long_len + 1) * sizeof(struct option))
+#define TLEN (szs.enum_slots * sizeof(struct enum_slot))
+#define YLEN (szs.constraint_keys * sizeof(int))
+#define DLEN (szs.enum_buckets * sizeof(uint32_t))
+#define PLEN ((szs.short_len + szs.long_len + 1) * sizeof(struct parser_slot))
 #define SLEN (szs.short_len + 1)
 
-    parser->storage = malloc (GLEN + CLEN + LLEN + SLEN);
-    if (! parser->storage)
+    parser->storage = malloc (GLEN + ELEN + ALEN + KLEN + MLEN + BLEN + CLEN
+                              + LLEN + PLEN + TLEN + YLEN + DLEN + SLEN);
+    if (! parser->storage) {
+        argp_seen_free(&seen);
+        __argp_catalog_free(&parser->catalog);
         return ENOMEM;
+    }
 
-    parser->groups = parser->storage;
-    parser->child_inputs = (void*)((size_t)(parser->storage) + GLEN);
-    parser->long_opts = (struct option*)((size_t)(parser->storage) + GLEN + CLEN);
-    parser->short_opts = (char*)((size_t)(parser->storage) + GLEN + CLEN + LLEN);
-
+    /* Carve the storage up, in order of alignment.  */
+    at = parser->storage;
+    parser->groups = (struct group*)at;
+    parser->enums = (struct group_enum*)(at += GLEN);
+    parser->accums = (struct group_accum*)(at += ELEN);
+    parser->constraints = (struct parser_constraint*)(at += ALEN);
+    terms = (struct constraint_term*)(at += KLEN);
+    parser->seen = (uint64_t*)(at += MLEN);
+    parser->child_inputs = (void**)(at += BLEN);
+    parser->long_opts = (struct option*)(at += CLEN);
+    parser->short_slots = (struct parser_slot*)(at += LLEN);
+    parser->long_slots = parser->short_slots + szs.short_len + 1;
+    slots = (struct enum_slot*)(at += PLEN);
+    ckeys = (int*)(at += TLEN);
+    displace = (uint32_t*)(at += YLEN);
+    parser->short_opts = (char*)(at += DLEN);
+
+    memset(parser->seen, 0, BLEN);
     memset(parser->child_inputs, 0, szs.num_child_inputs * sizeof(void *));
-    parser_convert(parser, argp, flags);
+    /* Options after a command are its own, so getopt mustn't move them in
+        front of it.  */
+    argp_seen_clear(&seen);
+    parser_convert(parser, argp,
+                   szs.commands && !(flags & ARGP_NO_ARGS)
+                   ? flags | ARGP_IN_ORDER : flags,
+                   slots, displace, terms, ckeys, &seen);
+    argp_seen_free(&seen);
+
+    for (ge = parser->enums; ge < parser->eenum && !err; ge++)
+        err = enum_build(ge);
+    if (err) {
+        free(parser->storage);
+        __argp_catalog_free(&parser->catalog);
+        return err;
+    }
 
     memset(&parser->state, 0, sizeof(struct argp_state));
     parser->state.root_argp = parser->argp;
@@ -484,6 +1177,26 @@ parser_init(struct parser *parser, const struct argp *argp,
     parser->state.pstate = parser;
 
     parser->try_getopt = 1;
+    parser->current = NULL;
+    parser->command_done = 0;
+    parser->forward = NULL;
+    parser->forward_len = 0;
+
+    return 0;
+}
+
+/* Initializes PARSER to parse ARGP in a manner described by FLAGS.  If
+   NAME isn't NULL, it's what the program is called in messages.  */
+static error_t
+parser_init(struct parser *parser, const struct argp *argp,
+        int argc, char **argv, int flags, void *input, const char *name)
+{
+    error_t err;
+    struct group *group;
+
+    err = parser_setup(parser, argp, argc, argv, flags);
+    if (err)
+        return err;
 
     /* Call each parser for the first time, giving it a chance to propagate
         values to child parsers.  */
@@ -513,15 +1226,18 @@ parser_init(struct parser *parser, const struct argp *argp,
         return err;
 
     if (parser->state.flags & ARGP_NO_ERRS) {
-            opterr = 0;
             if (parser->state.flags & ARGP_PARSE_ARGV0)
             /* getopt always skips ARGV[0], so we have to fake it out.  As long
             as OPTERR is 0, then it shouldn't actually try to access it.  */
                 parser->state.argv--, parser->state.argc++;
-    } else
-        opterr = 1; /* Print error messages.  */
+    }
+    /* Getopt would print its messages on stderr, whatever the error stream
+       is; parser_bad_opt prints them instead.  */
+    opterr = 0;
 
-    if (parser->state.argv == argv && argv[0]) {
+    if (name)
+        parser->state.name = name;
+    else if (parser->state.argv == argv && argv[0]) {
         /* There's an argv[0]; use it for messages.  */
 
         char *short_name = strrchr(argv[0], '/');
@@ -532,6 +1248,153 @@ parser_init(struct parser *parser, const struct argp *argp,
     return 0;
 }
 
+/* Return GROUP's option KEY, one with a long name if it has one, to call
+   it by in messages.  */
+static const struct argp_option *
+group_option(const struct group *group, int key)
+{
+    const struct argp_option *opt = group->argp->options, *found = NULL;
+
+    for (; opt && !__option_is_end(opt); opt++)
+        if (opt->key == key && (!found || (!found->name && opt->name)))
+            found = opt;
+    return found;
+}
+
+/* Return a malloced string naming GROUP's options KEYS, COUNT of them, as
+   `--NAME' or `-K', with commas between.  */
+static char *
+constraint_names(const struct group *group, const int *keys, size_t count)
+{
+    size_t len = 1, i;
+    char *names, *p;
+
+    for (i = 0; i < count; i++) {
+        const struct argp_option *opt = group_option(group, keys[i]);
+
+        len += (opt && opt->name ? strlen(opt->name) + 2 : 2) + 4;
+    }
+
+    names = p = malloc(len);
+    if (!names)
+        return NULL;
+    for (i = 0; i < count; i++) {
+        const struct argp_option *opt = group_option(group, keys[i]);
+
+        if (i)
+            p += sprintf(p, ", ");
+        if (opt && opt->name)
+            p += sprintf(p, "`--%s'", opt->name);
+        else
+            p += sprintf(p, "`-%c'", keys[i]);
+    }
+    *p = '\0';
+
+    return names;
+}
+
+/* Report PC, which isn't met.  */
+static void
+constraint_error(struct parser *parser, const struct parser_constraint *pc)
+{
+    const struct argp_constraint *c = pc->constraint;
+    const char *domain = parser->argp->argp_domain;
+    int pair[2];
+    size_t count = 0, n;
+
+    /* Find the two options to blame for a conflict, or the missing one
+        for ARGP_REQUIRES.  */
+    for (n = 0; c->keys[n]; n++) {
+        size_t bit = group_constraint_bit(pc->group, c->keys[n]);
+        int seen = (parser->seen[bit / 64] >> bit % 64) & 1;
+
+        if (c->type == ARGP_REQUIRES ? n == 0 || !seen : seen) {
+            if (count < 2)
+                pair[count] = c->keys[n];
+            count++;
+        }
+    }
+
+    if (count >= 2) {
+        char *first = constraint_names(pc->group, &pair[0], 1);
+        char *second = constraint_names(pc->group, &pair[1], 1);
+
+        if (first && second)
+            __argp_error(&parser->state,
+                    c->type == ARGP_REQUIRES
+                    ? dgettext(domain, "%s requires %s")
+                    : dgettext(domain, "%s and %s can't be used together"),
+                    first, second);
+        free(first);
+        free(second);
+    } else {
+        char *names = constraint_names(pc->group, c->keys, n);
+
+        if (names)
+            __argp_error(&parser->state,
+                    dgettext(domain, "one of %s is required"), names);
+        free(names);
+    }
+}
+
+/* Check PARSER's constraints against the options seen, returning EINVAL if
+   one isn't met.  */
+static error_t
+parser_check_constraints(struct parser *parser)
+{
+    const struct parser_constraint *pc;
+
+    for (pc = parser->constraints; pc < parser->econstraint; pc++) {
+        const uint64_t *seen = parser->seen;
+        unsigned given = 0, all = 1, i;
+        int ok;
+
+        for (i = 0; i < pc->num_terms; i++) {
+            uint64_t hits = seen[pc->terms[i].word] & pc->terms[i].mask;
+
+            /* Only whether none, one or more were given matters.  */
+            given += hits ? (hits & (hits - 1) ? 2 : 1) : 0;
+            all &= hits == pc->terms[i].mask;
+        }
+
+        switch (pc->constraint->type) {
+        case ARGP_CONFLICTS:
+            ok = given < 2;
+            break;
+        case ARGP_REQUIRES:
+            ok = all || !((seen[pc->trigger / 64] >> pc->trigger % 64) & 1);
+            break;
+        case ARGP_AT_LEAST_ONE:
+            ok = given >= 1;
+            break;
+        case ARGP_EXACTLY_ONE:
+            ok = given == 1;
+            break;
+        default:
+            ok = 1;
+        }
+
+        if (!ok) {
+            constraint_error(parser, pc);
+            return EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/* Free PARSER's memory.  */
+static void
+parser_free(struct parser *parser)
+{
+    struct group_accum *accum;
+
+    for (accum = parser->accums; accum < parser->eaccum; accum++)
+        free(accum->args);
+    free(parser->storage);
+    __argp_catalog_free(&parser->catalog);
+}
+
 /* Free any storage consumed by PARSER (but not PARSER itself).  */
 static error_t
 parser_finalize(struct parser *parser,
@@ -543,6 +1406,9 @@ parser_finalize(struct parser *parser,
         /* Suppress errors generated by unparsed arguments.  */
         err = 0;
 
+    if (! err)
+        err = parser_check_constraints(parser);
+
     if (! err) {
         if (parser->state.next == parser->state.argc) {
             /* We successfully parsed all arguments!  Call all the parsers again,
@@ -613,7 +1479,7 @@ parser_finalize(struct parser *parser,
     if (err == EBADKEY)
         err = EINVAL;
 
-    free(parser->storage);
+    parser_free(parser);
 
     return err;
 }
@@ -670,15 +1536,16 @@ parser_parse_arg(struct parser *parser, char *val)
     return err;
 }
 
-/* Call the user parsers to parse the option OPT, with argument VAL, at the
-   current position, returning any error.  */
-static error_t
-parser_parse_opt(struct parser *parser, int opt, char *val)
+/* Return the group in PARSER that the option getopt returned as OPT comes
+   from, or NULL if none, and set *KEY to the option's key and *SLOT to its
+   slot.  */
+static struct group *
+parser_opt_group(struct parser *parser, int opt, int *key,
+        const struct parser_slot **slot)
 {
     /* The group key encoded in the high bits; 0 for short opts or
         group_number + 1 for long opts.  */
     int group_key = opt >> USER_BITS;
-    error_t err = EBADKEY;
 
     if (group_key == 0) {
         /* A short option.  By comparing OPT's position in SHORT_OPTS to the
@@ -687,17 +1554,131 @@ parser_parse_opt(struct parser *parser, int opt, char *val)
         struct group *group;
         char *short_index = strchr(parser->short_opts, opt);
 
-        if (short_index)
-        for (group = parser->groups; group < parser->egroup; group++)
-        if (group->short_end > short_index) {
-            err = group_parse(group, &parser->state, opt, optarg);
-            break;
+        *key = opt;
+        if (short_index) {
+            *slot = &parser->short_slots[short_index - parser->short_opts];
+            for (group = parser->groups; group < parser->egroup; group++)
+            if (group->short_end > short_index)
+                return group;
         }
-    } else
+        return NULL;
+    } else {
         /* A long option.  We use shifts instead of masking for extracting
         the user value in order to preserve the sign.  */
-        err = group_parse(&parser->groups[group_key - 1], &parser->state,
-            (opt << GROUP_BITS) >> GROUP_BITS, optarg);
+        *key = (opt << GROUP_BITS) >> GROUP_BITS;
+        *slot = &parser->long_slots[parser->long_index];
+        return &parser->groups[group_key - 1];
+    }
+}
+
+/* Add VAL to ACCUM's arguments.  */
+static error_t
+accum_add(struct group_accum *accum, char *val)
+{
+    if (accum->count == accum->alloced) {
+        size_t alloced = accum->alloced ? 2 * accum->alloced : 16;
+        char **args;
+
+        if (alloced > SIZE_MAX / sizeof(char *))
+            return ENOMEM;
+        args = realloc(accum->args, alloced * sizeof(char *));
+        if (!args)
+            return ENOMEM;
+        accum->args = args;
+        accum->alloced = alloced;
+    }
+
+    accum->args[accum->count++] = val;
+    return 0;
+}
+
+/* Convert VAL, the argument of GROUP's option KEY, as BINDING says, and
+   store it in GROUP's input, reporting any error.  */
+static error_t
+group_store(struct group *group, struct argp_state *state,
+            const struct argp_binding *binding, int key, char *val)
+{
+    void *value = (char *) group->input + binding->offset;
+    int ambiguous = 0;
+    error_t err;
+
+    if (!val && ((binding->type & ARGP_BIND_LIST)
+                 || (binding->type != ARGP_BIND_BOOL
+                     && binding->type != ARGP_BIND_STRING)))
+        /* A missing optional argument leaves a number or list alone.  */
+        return 0;
+
+    if (binding->type == ARGP_BIND_ENUM) {
+        const struct group_enum *ge = group->enums;
+        int index;
+
+        while (ge->binding != binding)
+            ge++;
+        index = enum_find(ge, val, &ambiguous);
+        if (index >= 0)
+            *(int *) value = binding->values[index].value;
+        err = index >= 0 ? 0 : EINVAL;
+    } else if (binding->type & ARGP_BIND_LIST)
+        err = __argp_convert_list(binding->type & ~ARGP_BIND_LIST,
+                                  binding->delim, val, value);
+    else
+        err = __argp_convert(binding->type, val, value);
+    if (err && err != ENOMEM) {
+        const struct argp_option *found = group_option(group, key);
+
+        if (found && found->name)
+            __argp_error(state, err == ERANGE
+                    ? dgettext(state->root_argp->argp_domain,
+                        "argument `%s' for `--%s' is out of range")
+                    : ambiguous
+                    ? dgettext(state->root_argp->argp_domain,
+                        "ambiguous argument `%s' for `--%s'")
+                    : dgettext(state->root_argp->argp_domain,
+                        "invalid argument `%s' for `--%s'"),
+                    val, found->name);
+        else
+            __argp_error(state, err == ERANGE
+                    ? dgettext(state->root_argp->argp_domain,
+                        "argument `%s' for `-%c' is out of range")
+                    : ambiguous
+                    ? dgettext(state->root_argp->argp_domain,
+                        "ambiguous argument `%s' for `-%c'")
+                    : dgettext(state->root_argp->argp_domain,
+                        "invalid argument `%s' for `-%c'"),
+                    val, key);
+    }
+
+    return err;
+}
+
+/* Call the user parsers to parse the option OPT, with argument VAL, at the
+   current position, returning any error.  Options with a binding are
+   stored, and OPTION_ACCUMULATE ones collected, without calling the
+   parser.  */
+static error_t
+parser_parse_opt(struct parser *parser, int opt, char *val)
+{
+    int group_key = opt >> USER_BITS;
+    int key;
+    const struct parser_slot *slot;
+    struct group *group = parser_opt_group(parser, opt, &key, &slot);
+    error_t err = EBADKEY;
+
+    if (group) {
+        if (group->num_ckeys) {
+            size_t bit = group_constraint_bit(group, key);
+
+            if (bit != (size_t) -1)
+                parser->seen[bit / 64] |= (uint64_t) 1 << bit % 64;
+        }
+
+        if (slot->accum)
+            err = accum_add(slot->accum, val);
+        else if (slot->binding && group->input)
+            err = group_store(group, &parser->state, slot->binding, key, val);
+        else
+            err = group_parse(group, &parser->state, key, val);
+    }
 
     if (err == EBADKEY) {
         /* At least currently, an option not recognized is an error in the
@@ -722,15 +1703,271 @@ parser_parse_opt(struct parser *parser, int opt, char *val)
     return err;
 }
 
-/* Parse the next argument in PARSER (as indicated by PARSER->state.next).
-   Any error from the parsers is returned, and *ARGP_EBADKEY indicates
-   whether a value of EBADKEY is due to an unrecognized argument (which is
-   generally not fatal).  */
+/* "Did you mean" suggestions for unknown long options.  The name given is
+   compared with each of ours by Hyyro's bit-parallel form of Myers' edit
+   distance algorithm, which keeps a column of the distance matrix as two
+   bit vectors of vertical deltas and moves it along one of our names a
+   whole column at a time.  A name is given up as soon as the distance can
+   no longer come back within the bound.  */
+
+/* Names given that are longer than this aren't matched.  */
+#define SUGGEST_MAX_LEN 64
+
+/* The name given, ready to be compared.  */
+struct suggest_pattern
+{
+    /* Bit I of PEQ[C] is set if the name's I'th character is C.  */
+    uint64_t peq[UCHAR_MAX + 1];
+    size_t len;
+
+    /* Names further than this from it aren't suggested.  */
+    unsigned bound;
+};
+
+/* Set up SP for ARG, an unknown long option with its dashes and any
+   `=VALUE'.  Returns 0 if there's nothing to compare.  */
+static int
+suggest_pattern_init(struct suggest_pattern *sp, const char *arg)
+{
+    size_t i;
+
+    arg += strspn(arg, "-");
+    sp->len = strcspn(arg, "=");
+    if (sp->len == 0 || sp->len > SUGGEST_MAX_LEN)
+        return 0;
+
+    memset(sp->peq, 0, sizeof(sp->peq));
+    for (i = 0; i < sp->len; i++)
+        sp->peq[(unsigned char) arg[i]] |= (uint64_t) 1 << i;
+
+    /* A typo or two in a short name, and up to three in a long one.  */
+    sp->bound = (unsigned) (sp->len + 2) / 3;
+    if (sp->bound > 3)
+        sp->bound = 3;
+
+    return 1;
+}
+
+/* Return the edit distance between SP's name and NAME, or anything over
+   BOUND if it's more than that.  */
+static unsigned
+suggest_distance(const struct suggest_pattern *sp, const char *name,
+                 unsigned bound)
+{
+    size_t n = strlen(name), j;
+    uint64_t pv = ~(uint64_t) 0, mv = 0;
+    uint64_t high = (uint64_t) 1 << (sp->len - 1);
+    size_t score = sp->len;
+
+    if (n > sp->len + bound || sp->len > n + bound)
+        return bound + 1;
+
+    for (j = 0; j < n; j++) {
+        uint64_t eq = sp->peq[(unsigned char) name[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+
+        if (ph & high)
+            score++;
+        else if (mh & high)
+            score--;
+
+        /* Each character left can take at most one off.  */
+        if (score > bound + (n - j - 1))
+            return bound + 1;
+
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+
+    return (unsigned) score;
+}
+
+/* Store in NAMES up to MAX of PARSER's long options that ARG, an unknown
+   long option, may have been meant to be, nearest first, and return how
+   many.  */
+static size_t
+parser_suggest(struct parser *parser, const char *arg, const char **names,
+               size_t max)
+{
+    const struct argp_catalog *catalog = &parser->catalog;
+    struct suggest_pattern sp;
+    unsigned *dists, bound;
+    size_t count = 0, i;
+    uint32_t entry;
+
+    if (max == 0 || !suggest_pattern_init(&sp, arg))
+        return 0;
+    dists = malloc(max * sizeof(*dists));
+    if (!dists)
+        return 0;
+
+    bound = sp.bound;
+    for (entry = 0; entry < catalog->count; entry++) {
+        unsigned dist;
+
+        if (!(catalog->flags[entry] & ARGP_CATALOG_LONG)
+            || argp_catalog_hidden(catalog, entry))
+            continue;
+        dist = suggest_distance(&sp, argp_catalog_name(catalog, entry),
+                                bound);
+        if (dist > bound)
+            continue;
+
+        /* Keep the nearest, the earlier of equally near ones first.  */
+        if (count == max)
+            count--;
+        for (i = count; i > 0 && dists[i - 1] > dist; i--) {
+            dists[i] = dists[i - 1];
+            names[i] = names[i - 1];
+        }
+        dists[i] = dist;
+        names[i] = argp_catalog_option(catalog, entry)->name;
+        count++;
+
+        /* Once full, only nearer ones can get in.  */
+        if (count == max) {
+            if (dists[count - 1] == 0)
+                break;
+            bound = dists[count - 1] - 1;
+        }
+    }
+
+    free(dists);
+    return count;
+}
+
+/* Print the message for ARG, an unknown long option, on PARSER's error
+   stream, telling the user which of PARSER's options it may have been meant
+   to be.  */
+static void
+parser_print_unknown(struct parser *parser, const char *arg)
+{
+    struct argp_state *state = &parser->state;
+    const char *domain = parser->argp->argp_domain;
+    const char *names[3];
+    size_t count, i;
+
+    fprintf(state->err_stream,
+            dgettext(domain, "%s: unrecognized option '%s'"),
+            state->name, arg);
+
+    count = parser_suggest(parser, arg, names, 3);
+    if (count > 0) {
+        fputs(dgettext(domain, "; did you mean "), state->err_stream);
+        for (i = 0; i < count; i++)
+            fprintf(state->err_stream, "%s'--%s'",
+                    i == 0 ? "" : i == count - 1 ? dgettext(domain, " or ")
+                                                 : ", ",
+                    names[i]);
+        putc('?', state->err_stream);
+    }
+    putc('\n', state->err_stream);
+}
+
+/* Getopt has returned an error for the option just before PARSER's next
+   argument.  If PARSER is forwarding unknown options and it's one that no
+   parser knows, store it in PARSER->forward and return 0, otherwise return
+   EBADKEY.  Getopt doesn't print messages (see parser_init), so we print
+   them for the errors that stay errors.  */
 static error_t
-parser_parse_next(struct parser *parser, int *arg_ebadkey)
+parser_bad_opt(struct parser *parser)
+{
+    struct argp_state *state = &parser->state;
+    const char *domain = parser->argp->argp_domain;
+    const char *short_opts = parser->short_opts;
+    const char *msg = NULL;
+    int report = !(state->flags & ARGP_NO_ERRS) && state->err_stream;
+    char *arg, *rest;
+
+    if (*short_opts == '-' || *short_opts == '+')
+        short_opts++;
+
+    if (optopt == 0) {
+        /* A long option getopt couldn't match; it's ambiguous if it's the
+        start of any of ours (getopt takes a single match), and unknown
+        otherwise.  */
+        const struct option *long_opt;
+        const char *name;
+        size_t len;
+
+        arg = state->argv[state->next - 1];
+        name = arg + 1 + (arg[1] == '-');
+        len = strcspn(name, "=");
+        for (long_opt = parser->long_opts; long_opt->name; long_opt++)
+            if (strncmp(long_opt->name, name, len) == 0) {
+                msg = N_("%s: option '%.*s' is ambiguous\n");
+                break;
+            }
+        if (!msg && !parser->forward) {
+            if (report)
+                parser_print_unknown(parser, arg);
+            return EBADKEY;
+        }
+    } else if ((optopt >> USER_BITS) != 0) {
+        /* A long option of ours, with an argument missing or left over.  */
+        arg = state->argv[state->next - 1];
+        msg = strchr(arg, '=')
+            ? N_("%s: option '%.*s' doesn't allow an argument\n")
+            : N_("%s: option '%.*s' requires an argument\n");
+    } else if (optopt != ':' && strchr(short_opts, optopt)) {
+        /* A short option of ours, missing its argument.  */
+        if (report)
+            fprintf(state->err_stream,
+                    dgettext (domain,
+                        "%s: option requires an argument -- '%c'\n"),
+                    state->name, optopt);
+        return EBADKEY;
+    } else if (!parser->forward) {
+        /* A short option we don't know.  */
+        if (report)
+            fprintf(state->err_stream,
+                    dgettext (domain, "%s: invalid option -- '%c'\n"),
+                    state->name, optopt);
+        return EBADKEY;
+    } else {
+        /* A short option we don't know, to pass on.  Anything after it in
+        the same argument can only be its own argument, so skip that; but if
+        it came after options we do know, there's no way to pass it on by
+        itself without a copy.  */
+        rest = getopt_skip_rest();
+        state->next = optind;
+        arg = state->argv[state->next - 1];
+        if (rest ? rest != arg + 2 : arg[2] != '\0') {
+            if (report)
+                fprintf(state->err_stream,
+                        dgettext (domain,
+                            "%s: can't pass on option '%c' from '%s'\n"),
+                        state->name, optopt, arg);
+            return EBADKEY;
+        }
+    }
+
+    if (msg) {
+        if (report)
+            fprintf(state->err_stream, dgettext (domain, msg),
+                    state->name, (int) strcspn(arg, "="), arg);
+        return EBADKEY;
+    }
+
+    parser->forward[parser->forward_len++] = arg;
+    parser->forward[parser->forward_len] = NULL;
+    return 0;
+}
+
+/* Find the next argument in PARSER (as indicated by PARSER->state.next),
+   using getopt while it's still useful, and return what it is: KEY_END if
+   there are no more, KEY_ARG for a non-option argument, KEY_BAD for an
+   option getopt found an error in, or else the getopt value of an option.
+   OPTARG is left with the option's argument or the non-option argument.  */
+static int
+parser_next(struct parser *parser)
 {
     int opt;
-    error_t err = 0;
 
     if (parser->state.quoted && parser->state.next < parser->state.quoted)
         /* The next argument pointer has been moved to before the quoted
@@ -745,12 +1982,15 @@ parser_parse_next(struct parser *parser, int *arg_ebadkey)
         optind = parser->state.next;
         /* Distinguish KEY_ERR from a real option.  */
         optopt = KEY_END;
+        parser->long_index = -1;
         if (parser->state.flags & ARGP_LONG_ONLY)
             opt = getopt_long_only (parser->state.argc, parser->state.argv,
-                    parser->short_opts, parser->long_opts, 0);
+                    parser->short_opts, parser->long_opts,
+                    &parser->long_index);
         else
             opt = getopt_long (parser->state.argc, parser->state.argv,
-                    parser->short_opts, parser->long_opts, 0);
+                    parser->short_opts, parser->long_opts,
+                    &parser->long_index);
         /* And see what getopt did.  */
         parser->state.next = optind;
 
@@ -766,38 +2006,167 @@ parser_parse_next(struct parser *parser, int *arg_ebadkey)
                 options, so we definitely shouldn't try to use getopt past
                 here, whatever happens.  */
                 parser->state.quoted = parser->state.next;
-        } else if (opt == KEY_ERR && optopt != KEY_END) {
+        } else if (opt == KEY_ERR && optopt != KEY_END)
             /* KEY_ERR can have the same value as a valid user short
             option, but in the case of a real error, getopt sets OPTOPT
             to the offending character, which can never be KEY_END.  */
-            *arg_ebadkey = 0;
-            return EBADKEY;
-        }
+            return KEY_BAD;
     } else
         opt = KEY_END;
 
     if (opt == KEY_END) {
         /* We're past what getopt considers the options.  */
         if (parser->state.next >= parser->state.argc
-            || (parser->state.flags & ARGP_NO_ARGS)) {
+            || (parser->state.flags & ARGP_NO_ARGS))
             /* Indicate that we're done.  */
-            *arg_ebadkey = 1;
-            return EBADKEY;
-        } else {
-            /* A non-option arg; simulate what getopt might have done.  */
-            opt = KEY_ARG;
-            optarg = parser->state.argv[parser->state.next++];
+            return KEY_END;
+
+        /* A non-option arg; simulate what getopt might have done.  */
+        opt = KEY_ARG;
+        optarg = parser->state.argv[parser->state.next++];
+    }
+
+    return opt;
+}
+
+/* Return the name of PARSER's command nearest to NAME, an unknown one, or
+   NULL if none is near enough.  */
+static const char *
+parser_suggest_command(struct parser *parser, const char *name)
+{
+    const struct argp_command *command = parser->commands;
+    const char *nearest = NULL;
+    struct suggest_pattern sp;
+    unsigned bound;
+
+    if (!suggest_pattern_init(&sp, name))
+        return NULL;
+
+    bound = sp.bound;
+    for (; command->name; command++) {
+        unsigned dist = suggest_distance(&sp, command->name, bound);
+
+        if (dist <= bound) {
+            nearest = command->name;
+            if (dist == 0)
+                break;
+            bound = dist - 1;
         }
     }
 
-    if (opt == KEY_ARG)
+    return nearest;
+}
+
+static error_t parse_named(const struct argp *argp, int argc, char **argv,
+                    unsigned flags, int *end_index, void *input,
+                    char **forward, size_t *forward_count, const char *name);
+
+/* NAME, the first non-option argument, is the command: load its argp, and
+   parse the rest of the arguments with it.  Only now is the command's argp
+   converted, and its parsers called, so commands that aren't given cost
+   nothing.  */
+static error_t
+parser_parse_command(struct parser *parser, char *name)
+{
+    struct argp_state *state = &parser->state;
+    struct group *group = parser->command_group;
+    const char *domain = group->argp->argp_domain;
+    const struct argp_command *command;
+    const struct argp *argp;
+    int index = state->next - 1;
+    size_t forward_count = 0, prog_len, name_len;
+    char *prog;
+    error_t err;
+
+    parser->command_done = 1;
+
+    for (command = parser->commands; command->name; command++)
+        if (strcmp(command->name, name) == 0)
+            break;
+
+    if (!command->name) {
+        const char *nearest = parser_suggest_command(parser, name);
+
+        if (nearest)
+            __argp_error(state, dgettext(domain,
+                        "unknown command `%s'; did you mean `%s'?"),
+                        name, nearest);
+        else
+            __argp_error(state, dgettext(domain, "unknown command `%s'"),
+                        name);
+        return EINVAL;
+    }
+
+    argp = command->argp;
+    if (!argp && command->loader)
+        argp = (*command->loader)(command);
+    if (!argp) {
+        __argp_error(state, dgettext(domain, "can't load command `%s'"), name);
+        return EINVAL;
+    }
+
+    /* Let the parser pick the command's input.  */
+    state->input = group->input;
+    err = group_parse(group, state, ARGP_KEY_COMMAND, name);
+    if (err && err != EBADKEY)
+        return err;
+    group->args_processed++;
+
+    /* The command calls itself `PROGRAM COMMAND' in its messages.  */
+    prog_len = strlen(state->name);
+    name_len = strlen(name);
+    prog = malloc(prog_len + 1 + name_len + 1);
+    if (!prog)
+        return ENOMEM;
+    memcpy(prog, state->name, prog_len);
+    prog[prog_len] = ' ';
+    memcpy(prog + prog_len + 1, name, name_len + 1);
+
+    err = parse_named(argp, state->argc - index, state->argv + index,
+                    state->flags & ~ARGP_PARSE_ARGV0, NULL, state->input,
+                    parser->forward
+                    ? parser->forward + parser->forward_len : NULL,
+                    &forward_count, prog);
+    free(prog);
+
+    parser->forward_len += forward_count;
+    state->next = state->argc;
+    parser->try_getopt = 0;
+
+    return err;
+}
+
+/* Parse the next argument in PARSER (as indicated by PARSER->state.next).
+   Any error from the parsers is returned, and *ARGP_EBADKEY indicates
+   whether a value of EBADKEY is due to an unrecognized argument (which is
+   generally not fatal).  */
+static error_t
+parser_parse_next(struct parser *parser, int *arg_ebadkey)
+{
+    int opt = parser_next(parser);
+    error_t err;
+
+    if (opt == KEY_BAD) {
+        *arg_ebadkey = 0;
+        return parser_bad_opt(parser);
+    }
+
+    if (opt == KEY_END) {
+        *arg_ebadkey = 1;
+        return EBADKEY;
+    }
+
+    if (opt == KEY_ARG && parser->command_group && !parser->command_done)
+        /* The command, which parses the rest.  */
+        err = parser_parse_command(parser, optarg);
+    else if (opt == KEY_ARG)
         /* A non-option argument; try each parser in turn.  */
         err = parser_parse_arg(parser, optarg);
     else
         err = parser_parse_opt(parser, opt, optarg);
 
     if (err == EBADKEY)
-        *arg_ebadkey = (opt == KEY_END || opt == KEY_ARG);
+        *arg_ebadkey = (opt == KEY_ARG);
 
     return err;
 }
@@ -811,6 +2180,57 @@ error_t __argp_parse(const struct argp *__restrict argp,
                     int argc, char **__restrict argv,
                     unsigned flags, int *__restrict end_index,
                     void *__restrict input)
+{
+    return __argp_parse_forward(argp, argc, argv, flags, end_index, input,
+                    NULL, NULL);
+}
+#ifdef weak_alias
+weak_alias(__argp_parse, argp_parse)
+#endif
+
+/* Like __argp_parse, but if FORWARD is non-NULL, store options that no
+   parser knows in it instead of failing, and the number of them in
+   *FORWARD_COUNT.  */
+error_t __argp_parse_forward(const struct argp *__restrict argp,
+                    int argc, char **__restrict argv,
+                    unsigned flags, int *__restrict end_index,
+                    void *__restrict input,
+                    char **__restrict forward,
+                    size_t *__restrict forward_count)
+{
+    return parse_named(argp, argc, argv, flags, end_index, input, forward,
+                    forward_count, NULL);
+}
+#ifdef weak_alias
+weak_alias(__argp_parse_forward, argp_parse_forward)
+#endif
+
+/* Return true if `--complete' is the standard option in ARGP, the tree
+   argp_parse has added the standard options to, and not one of the
+   user's.  */
+static int
+argp_completes(const struct argp *argp)
+{
+    struct argp_catalog catalog;
+    uint32_t entry;
+    int ours;
+
+    if (__argp_catalog_init(&catalog, argp))
+        return 0;
+    entry = __argp_catalog_find(&catalog, "complete", 8);
+    ours = entry != ARGP_CATALOG_NONE
+        && catalog.argps[catalog.group[entry]] == &argp_default_argp;
+    __argp_catalog_free(&catalog);
+
+    return ours;
+}
+
+/* Like __argp_parse_forward, but if NAME isn't NULL, call the program that
+   in messages rather than what ARGV[0] says, as a command's parse does.  */
+static error_t
+parse_named(const struct argp *argp, int argc, char **argv,
+                    unsigned flags, int *end_index, void *input,
+                    char **forward, size_t *forward_count, const char *name)
 {
     error_t err;
     struct parser parser;
@@ -819,6 +2239,11 @@ error_t __argp_parse(const struct argp *__restrict argp,
         to be parsed (which in some cases isn't actually an error).  */
     int arg_ebadkey = 0;
 
+    if (forward)
+        forward[0] = NULL;
+    if (forward_count)
+        *forward_count = 0;
+
     if (! (flags & ARGP_NO_HELP)) {
         /* Add our own options.  */
         struct argp_child *child = alloca(4 * sizeof(struct argp_child));
@@ -840,23 +2265,156 @@ error_t __argp_parse(const struct argp *__restrict argp,
         child->argp = 0;
 
         argp = top_argp;
+
+        if (argc > 1 && strcmp(argv[1], "--complete") == 0
+            && argp_completes(argp)) {
+            /* A shell asking for completions, which mustn't wait for the
+                parsers to start up.  */
+            err = __argp_complete(argp, argc - 2, argv + 2, stdout);
+            if (! (flags & ARGP_NO_EXIT))
+                exit(err ? argp_err_exit_status : 0);
+            if (end_index)
+                *end_index = argc;
+            return err;
+        }
     }
 
     /* Construct a parser for these arguments.  */
-    err = parser_init(&parser, argp, argc, argv, flags, input);
+    err = parser_init(&parser, argp, argc, argv, flags, input, name);
 
     if (! err) {
+        parser.forward = forward;
+
         /* Parse! */
         while (! err)
             err = parser_parse_next(&parser, &arg_ebadkey);
 
+        if (forward_count)
+            *forward_count = parser.forward_len;
+
         err = parser_finalize(&parser, err, arg_ebadkey, end_index);
     }
 
     return err;
 }
+
+/* The state of an argp_iter_begin parse.  */
+struct argp_iter
+{
+    struct parser parser;
+
+    /* The ARGV given to argp_iter_begin, which event indices are into.  */
+    char **argv;
+
+    /* True once the end of ARGV has been reported.  */
+    int done;
+};
+
+/* Start a parse of ARGC & ARGV by ARGP that reports what it finds to the
+   caller, one event at a time, instead of calling the parsers.  */
+struct argp_iter *
+__argp_iter_begin(const struct argp *argp, int argc, char **argv,
+                    unsigned flags)
+{
+    struct argp_iter *iter = malloc(sizeof(*iter));
+
+    if (!iter)
+        return NULL;
+
+    /* Errors are events, and --help is an option like any other.  */
+    flags |= ARGP_NO_ERRS | ARGP_NO_HELP;
+    if (parser_setup(&iter->parser, argp, argc, argv, flags)) {
+        free(iter);
+        return NULL;
+    }
+
+    if (flags & ARGP_PARSE_ARGV0)
+        /* getopt always skips ARGV[0], so fake it out as parser_init does.  */
+        iter->parser.state.argv--, iter->parser.state.argc++;
+
+    iter->argv = argv;
+    iter->done = 0;
+    return iter;
+}
 #ifdef weak_alias
-weak_alias(__argp_parse, argp_parse)
+weak_alias(__argp_iter_begin, argp_iter_begin)
+#endif
+
+/* Find the next option or argument in ITER's parse and describe it in
+   EVENT; returns 0 instead when there are no more.  */
+int
+__argp_iter_next(struct argp_iter *iter, struct argp_event *event)
+{
+    struct parser *parser = &iter->parser;
+    char **argv = parser->state.argv;
+    struct group *group = NULL;
+    const struct parser_slot *slot;
+    int opt, index;
+
+    if (iter->done)
+        return 0;
+
+    /* Getopt is shared with any other parse going on between calls.  */
+    opterr = 0;
+    opt = parser_next(parser);
+
+    if (opt == KEY_END) {
+        iter->done = 1;
+        return 0;
+    }
+
+    if (opt == KEY_ARG) {
+        index = parser->state.next - 1;
+        event->key = ARGP_KEY_ARG;
+        event->arg = optarg;
+    } else {
+        /* The option is in the argument getopt is still part way through,
+        or else the one before OPTIND, unless it took that one as its
+        argument.  */
+        index = getopt_rest() ? optind : optind - 1;
+        if (opt != KEY_BAD) {
+            if (optarg && optarg == argv[index] && !getopt_rest())
+                index--;
+            group = parser_opt_group(parser, opt, &event->key, &slot);
+            event->arg = optarg;
+        }
+        if (!group) {
+            event->key = ARGP_KEY_ERROR;
+            event->arg = argv[index];
+        }
+    }
+
+    event->argp = group ? group->argp : NULL;
+    event->index = index + (int) (argv - iter->argv);
+    return 1;
+}
+#ifdef weak_alias
+weak_alias(__argp_iter_next, argp_iter_next)
+#endif
+
+/* Store in NAMES up to MAX of ITER's long options that ARG may have been
+   meant to be.  */
+size_t
+__argp_iter_suggest(struct argp_iter *iter, const char *arg,
+                    const char **names, size_t max)
+{
+    return parser_suggest(&iter->parser, arg, names, max);
+}
+#ifdef weak_alias
+weak_alias(__argp_iter_suggest, argp_iter_suggest)
+#endif
+
+/* Free ITER, whether or not all its events have been seen.  */
+void
+__argp_iter_end(struct argp_iter *iter)
+{
+    if (iter) {
+        parser_free(&iter->parser);
+        free(iter);
+    }
+}
+#ifdef weak_alias
+weak_alias(__argp_iter_end, argp_iter_end)
 #endif
 
 /* Return the input field for ARGP in the parser corresponding to STATE; used
@@ -879,3 +2437,21 @@ __argp_input(const struct argp *argp, const struct argp_state *state)
 weak_alias(__argp_input, _argp_input)
 #endif
 
+
+/* Return the arguments of the OPTION_ACCUMULATE option KEY of the argp whose
+   parser is being called with STATE, and their number in *COUNT.  */
+char **
+__argp_accumulated(const struct argp_state *state, int key, size_t *count)
+{
+    const struct parser *parser = state ? state->pstate : NULL;
+    const struct group_accum *accum = NULL;
+
+    if (parser && parser->current)
+        accum = group_accum(parser->current, key);
+
+    *count = accum ? accum->count : 0;
+    return *count ? accum->args : NULL;
+}
+#ifdef weak_alias
+weak_alias(__argp_accumulated, argp_accumulated)
+#endif
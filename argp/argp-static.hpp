@@ -0,0 +1,581 @@
+/* Compile-time option tables for C++.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* A C++17 front end for programs whose options are fixed at compile time.
+   The options are declared as a constexpr table of bindings, each storing
+   its option's value in a member of the caller's struct:
+
+     struct config { bool verbose; int jobs; const char *output; };
+
+     inline constexpr auto config_options = win_argp::options(
+         "FILE...", "Frobnicate FILEs.",
+         win_argp::option(&config::verbose, "verbose", 'v', nullptr, 0,
+                          "Say more"),
+         win_argp::option(&config::jobs, "jobs", 'j', "N", 0, "Run N jobs"),
+         win_argp::option(&config::output, "output", 'o', "FILE", 0,
+                          "Write to FILE"));
+
+     config cfg = { false, 1, "-" };
+     int index;
+     error_t err = win_argp::parse<config_options>(argc, argv, 0, &index,
+                                                  &cfg);
+
+   The compiler builds the argp_option array, a perfect hash of the long
+   names and a table of the short ones, so win_argp::parse needs no setup at
+   run time: it looks every option up in O(1), and stores its value through
+   a switch on the option's index that is inlined into the loop.  Anything
+   it doesn't resolve by itself -- abbreviated or unknown options, `--',
+   --help and friends, a bad value, flags other than ARGP_SILENT's -- makes
+   it hand the whole command line to argp_parse instead, with the same
+   bindings, so the results and messages are always argp_parse's.  Bindings
+   only ever assign, so options already stored before that are stored
+   again to the same values.
+
+   win_argp::argp_of<TABLE> is an ordinary struct argp for the same options,
+   whose parser stores through the bindings; it can be a child in a tree of
+   C argps, if the parent passes the struct down in its CHILD_INPUTS.
+
+   Members may be bool (for options without an argument, set to true),
+   integers, floating point numbers, const char * or std::string_view.
+   Numbers are written as for the ARGP_BIND_ types of the same kind.  */
+
+#ifndef ARGP_STATIC_HPP
+#define ARGP_STATIC_HPP
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <argp.h>
+
+namespace win_argp {
+
+/* One option, stored in the MEMBER of a T.  The other fields are those of
+   struct argp_option.  */
+template <typename T, typename M>
+struct binding
+{
+    M T::*member;
+    const char *name;
+    int key;
+    const char *arg;
+    int flags;
+    const char *doc;
+    int group;
+};
+
+/* Bind the option described by the rest of the arguments, as in a struct
+   argp_option, to MEMBER.  ARG must be nullptr exactly when MEMBER is a
+   bool, and KEY must be unique and not 0.  */
+template <typename T, typename M>
+constexpr binding<T, M>
+option(M T::*member, const char *name, int key, const char *arg, int flags,
+       const char *doc, int group = 0) noexcept
+{
+    return { member, name, key, arg, flags, doc, group };
+}
+
+namespace detail {
+
+/* No option.  */
+constexpr std::uint16_t none = 0xffff;
+
+constexpr std::size_t
+pow2_at_least(std::size_t n) noexcept
+{
+    std::size_t p = 1;
+
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+/* FNV-1a, over the LEN bytes at S.  */
+constexpr std::uint64_t
+hash(const char *s, std::size_t len) noexcept
+{
+    std::uint64_t h = 0xcbf29ce484222325ull;
+
+    for (std::size_t i = 0; i < len; i++) {
+        h ^= static_cast<unsigned char>(s[i]);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+/* The bucket of the hash H among COUNT, a power of 2.  */
+constexpr std::size_t
+bucket(std::uint64_t h, std::size_t count) noexcept
+{
+    return static_cast<std::size_t>(h >> 40) & (count - 1);
+}
+
+/* The slot of the hash H, displaced by D, among COUNT, a power of 2.  */
+constexpr std::size_t
+slot(std::uint64_t h, std::uint32_t d, std::size_t count) noexcept
+{
+    h ^= (d + 1ull) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 32;
+    return static_cast<std::size_t>(h) & (count - 1);
+}
+
+/* Whether KEY can be a short option, as for __option_is_short in the "C"
+   locale.  */
+constexpr bool
+is_short(int key) noexcept
+{
+    return key >= 0x20 && key < 0x7f;
+}
+
+template <typename M>
+struct unsupported : std::false_type {};
+
+/* Store ARG, converted, in OUT; return false if it isn't a valid M.  A
+   missing optional argument leaves numbers alone.  Numbers are converted
+   by argp_convert, as 64-bit integers or doubles, so the same way as C
+   bindings and whatever the locale.  */
+template <typename M>
+bool
+convert(char *arg, M &out) noexcept
+{
+    if constexpr (std::is_same_v<M, bool>) {
+        out = true;
+        return true;
+    } else if constexpr (std::is_same_v<M, const char *>) {
+        out = arg;
+        return true;
+    } else if constexpr (std::is_same_v<M, std::string_view>) {
+        out = arg ? std::string_view(arg) : std::string_view();
+        return true;
+    } else if constexpr (std::is_integral_v<M> || std::is_floating_point_v<M>) {
+        /* argp_convert may use strtod, which sets errno.  */
+        int saved_errno = errno;
+        bool ok;
+
+        if (!arg)
+            return true;
+
+        if constexpr (std::is_floating_point_v<M>) {
+            double v;
+
+            ok = !argp_convert(ARGP_BIND_DOUBLE, arg, &v)
+                 && v >= std::numeric_limits<M>::lowest()
+                 && v <= std::numeric_limits<M>::max();
+            if (ok)
+                out = static_cast<M>(v);
+        } else if constexpr (std::is_signed_v<M>) {
+            std::int64_t v;
+
+            ok = !argp_convert(ARGP_BIND_INT64, arg, &v)
+                 && v >= std::numeric_limits<M>::min()
+                 && v <= std::numeric_limits<M>::max();
+            if (ok)
+                out = static_cast<M>(v);
+        } else {
+            std::uint64_t v;
+
+            ok = !argp_convert(ARGP_BIND_UINT64, arg, &v)
+                 && v <= std::numeric_limits<M>::max();
+            if (ok)
+                out = static_cast<M>(v);
+        }
+        errno = saved_errno;
+        return ok;
+    } else
+        static_assert(unsupported<M>::value,
+                      "win_argp bindings can't store this type");
+}
+
+} /* namespace detail */
+
+/* The options of a program, made by win_argp::options: the bindings, the
+   argp_option array for them, and the indexes win_argp::parse looks them up
+   in.  */
+template <typename T, typename... M>
+class table
+{
+public:
+    using values_type = T;
+
+    static constexpr std::size_t size = sizeof...(M);
+    static constexpr std::size_t slot_count = detail::pow2_at_least(2 * size);
+    static constexpr std::size_t bucket_count =
+        detail::pow2_at_least((size + 3) / 4);
+
+    static_assert(size < detail::none, "too many options");
+
+    constexpr table(const char *table_args_doc, const char *table_doc,
+                    binding<T, M>... table_bindings)
+        : bindings(table_bindings...), args_doc(table_args_doc),
+          doc(table_doc)
+    {
+        std::size_t i = 0;
+
+        std::apply([&](const auto &... b) { (add(i++, b), ...); }, bindings);
+        build_hash();
+    }
+
+    /* The index of the option called NAME, or detail::none.  */
+    constexpr std::size_t
+    find(std::string_view name) const noexcept
+    {
+        return find(detail::hash(name.data(), name.size()), name);
+    }
+
+    /* The same, given NAME's hash H.  */
+    constexpr std::size_t
+    find(std::uint64_t h, std::string_view name) const noexcept
+    {
+        std::size_t i = detail::none;
+
+        if (size)
+            i = slots[detail::slot(h, displace[detail::bucket(h, bucket_count)],
+                                   slot_count)];
+        return i != detail::none && names[i] == name ? i : detail::none;
+    }
+
+    /* The index of the option whose short option is KEY, or detail::none.  */
+    constexpr std::size_t
+    find_short(unsigned char key) const noexcept
+    {
+        return shorts[key];
+    }
+
+    std::tuple<binding<T, M>...> bindings;
+
+    /* The options, for argp.  */
+    std::array<struct argp_option, size + 1> options {};
+
+    const char *args_doc;
+    const char *doc;
+
+    /* Each option's long name, its key, and whether it takes an argument:
+        0 for none, 1 for a required one and 2 for an optional one.  */
+    std::array<std::string_view, size> names {};
+    std::array<int, size> keys {};
+    std::array<unsigned char, size> arity {};
+
+    /* The perfect hash of the long names: an option's slot is where the
+        displacement of the bucket its name hashes to puts it.  */
+    std::array<std::uint32_t, bucket_count> displace {};
+    std::array<std::uint16_t, slot_count> slots {};
+
+    /* The option for each short option character.  */
+    std::array<std::uint16_t, 256> shorts {};
+
+private:
+    /* Record B as option I.  Invalid options throw, which stops the table
+        from being a constant expression.  */
+    template <typename B>
+    constexpr void
+    add(std::size_t i, const B &b)
+    {
+        using member_type = std::remove_reference_t<decltype(
+            std::declval<T &>().*b.member)>;
+
+        if (!b.key)
+            throw "win_argp::option: the key can't be 0";
+        if (b.flags & (OPTION_ALIAS | OPTION_DOC))
+            throw "win_argp::option: OPTION_ALIAS and OPTION_DOC can't be bound";
+        if (!b.arg != std::is_same_v<member_type, bool>)
+            throw "win_argp::option: only bool options have no argument";
+
+        for (std::size_t j = 0; j < i; j++)
+            if (keys[j] == b.key)
+                throw "win_argp::option: two options have the same key";
+            else if (b.name && names[j] == b.name)
+                throw "win_argp::option: two options have the same name";
+
+        options[i] = { b.name, b.key, b.arg, b.flags, b.doc, b.group };
+        names[i] = b.name ? std::string_view(b.name) : std::string_view();
+        keys[i] = b.key;
+        arity[i] = !b.arg ? 0 : (b.flags & OPTION_ARG_OPTIONAL) ? 2 : 1;
+
+        if (i == 0)
+            for (auto &s : shorts)
+                s = detail::none;
+        if (detail::is_short(b.key))
+            shorts[static_cast<unsigned char>(b.key)] =
+                static_cast<std::uint16_t>(i);
+    }
+
+    /* Hash and displace: place the buckets of the names, biggest first,
+        each at the first displacement that puts all its names in free
+        slots.  */
+    constexpr void
+    build_hash()
+    {
+        std::array<std::uint64_t, size> h {};
+        std::array<std::size_t, bucket_count> bucket_size {};
+        std::array<std::size_t, size> members {};
+        std::size_t i = 0, b = 0, n = 0, largest = 0;
+
+        for (auto &s : slots)
+            s = detail::none;
+
+        for (i = 0; i < size; i++)
+            if (!names[i].empty()) {
+                h[i] = detail::hash(names[i].data(), names[i].size());
+                b = detail::bucket(h[i], bucket_count);
+                if (++bucket_size[b] > largest)
+                    largest = bucket_size[b];
+            }
+
+        for (; largest; largest--)
+            for (b = 0; b < bucket_count; b++) {
+                if (bucket_size[b] != largest)
+                    continue;
+
+                for (n = 0, i = 0; i < size; i++)
+                    if (!names[i].empty()
+                        && detail::bucket(h[i], bucket_count) == b)
+                        members[n++] = i;
+
+                for (std::uint32_t d = 0;; d++) {
+                    bool fits = true;
+
+                    if (d == 1u << 20)
+                        throw "win_argp::options: no perfect hash found";
+
+                    for (i = 0; i < n && fits; i++) {
+                        std::size_t s = detail::slot(h[members[i]], d,
+                                                     slot_count);
+
+                        fits = slots[s] == detail::none;
+                        for (std::size_t j = 0; j < i && fits; j++)
+                            fits = s != detail::slot(h[members[j]], d,
+                                                     slot_count);
+                    }
+
+                    if (fits) {
+                        displace[b] = d;
+                        for (i = 0; i < n; i++)
+                            slots[detail::slot(h[members[i]], d, slot_count)] =
+                                static_cast<std::uint16_t>(members[i]);
+                        break;
+                    }
+                }
+            }
+    }
+};
+
+/* A table of the options BINDINGS, for a program whose usage and help
+   show ARGS_DOC and DOC, as in struct argp.  */
+template <typename T, typename... M>
+constexpr table<T, M...>
+options(const char *args_doc, const char *doc,
+        binding<T, M>... bindings)
+{
+    return table<T, M...>(args_doc, doc, bindings...);
+}
+
+namespace detail {
+
+template <const auto &Table>
+using values_of = typename std::remove_reference_t<decltype(Table)>::values_type;
+
+/* Store ARG in VALUES through option I of TABLE.  */
+template <const auto &Table, std::size_t... I>
+bool
+store(std::size_t i, char *arg, values_of<Table> &values,
+      std::index_sequence<I...>) noexcept
+{
+    bool ok = false;
+
+    (void) ((i == I
+             && (ok = convert(arg, values.*std::get<I>(Table.bindings).member),
+                 true))
+            || ...);
+    return ok;
+}
+
+template <const auto &Table>
+bool
+store(std::size_t i, char *arg, values_of<Table> &values) noexcept
+{
+    return store<Table>(i, arg, values,
+                        std::make_index_sequence<Table.size>());
+}
+
+/* The index of the option of TABLE with key KEY, or none.  */
+template <const auto &Table, std::size_t... I>
+std::size_t
+find_key(int key, std::index_sequence<I...>) noexcept
+{
+    std::size_t i = none;
+
+    (void) ((key == std::get<I>(Table.bindings).key && (i = I, true)) || ...);
+    return i;
+}
+
+/* Parse ARGC & ARGV into VALUES by TABLE alone, as argp_parse would, and
+   return true; or return false as soon as something needs argp_parse.  */
+template <const auto &Table>
+bool
+parse_fast(int argc, char **argv, unsigned flags, int *arg_index,
+           values_of<Table> &values) noexcept
+{
+    /* The non-options seen so far, which options after them are moved in
+        front of, as getopt permutes them.  */
+    int first_nonopt = argc, i, start;
+
+    if ((flags & ~ARGP_SILENT) || std::getenv("POSIXLY_CORRECT"))
+        return false;
+
+    for (i = 1; i < argc; i++) {
+        char *a = argv[i], *arg = nullptr;
+        std::size_t opt;
+
+        if (a[0] != '-' || a[1] == '\0') {
+            if (first_nonopt == argc)
+                first_nonopt = i;
+            continue;
+        }
+
+        start = i;
+        if (a[1] == '-') {
+            /* A long option, without abbreviations.  */
+            const char *name = a + 2;
+            std::uint64_t h = 0xcbf29ce484222325ull;
+            std::size_t len = 0;
+
+            if (!*name)
+                return false;       /* "--" */
+            for (; name[len] && name[len] != '='; len++) {
+                h ^= static_cast<unsigned char>(name[len]);
+                h *= 0x100000001b3ull;
+            }
+
+            opt = Table.find(h, std::string_view(name, len));
+            if (opt == none)
+                return false;
+            if (name[len] == '=') {
+                if (!Table.arity[opt])
+                    return false;
+                arg = const_cast<char *>(name + len + 1);
+            } else if (Table.arity[opt] == 1) {
+                if (i + 1 == argc)
+                    return false;
+                arg = argv[++i];
+            }
+            if (!store<Table>(opt, arg, values))
+                return false;
+        } else
+            /* A cluster of short options.  */
+            for (char *p = a + 1; *p; p++) {
+                opt = Table.find_short(static_cast<unsigned char>(*p));
+                if (opt == none)
+                    return false;
+                arg = nullptr;
+                if (Table.arity[opt]) {
+                    if (p[1])
+                        arg = p + 1;
+                    else if (Table.arity[opt] == 1) {
+                        if (i + 1 == argc)
+                            return false;
+                        arg = argv[++i];
+                    }
+                }
+                if (!store<Table>(opt, arg, values))
+                    return false;
+                if (arg)
+                    break;
+            }
+
+        if (first_nonopt < start) {
+            /* Move the option, and its argument, in front of the
+                non-options.  */
+            char *unit[2] = { argv[start], argv[i] };
+            int len = i - start + 1, j;
+
+            for (j = start - 1; j >= first_nonopt; j--)
+                argv[j + len] = argv[j];
+            for (j = 0; j < len; j++)
+                argv[first_nonopt + j] = unit[j];
+            first_nonopt += len;
+        }
+    }
+
+    if (first_nonopt < argc && !arg_index)
+        return false;               /* "Too many arguments" */
+    if (arg_index)
+        *arg_index = first_nonopt;
+
+    return true;
+}
+
+} /* namespace detail */
+
+/* An argp parser storing the options of TABLE in the values_type struct
+   that is its input.  */
+template <const auto &Table>
+error_t
+parser(int key, char *arg, struct argp_state *state)
+{
+    auto *values = static_cast<detail::values_of<Table> *>(state->input);
+    std::size_t i = detail::find_key<Table>(
+        key, std::make_index_sequence<Table.size>());
+
+    if (i == detail::none || !values)
+        return ARGP_ERR_UNKNOWN;
+
+    if (!detail::store<Table>(i, arg, *values)) {
+        if (!Table.names[i].empty())
+            argp_error(state, "invalid argument `%s' for `--%s'", arg,
+                       Table.names[i].data());
+        else
+            argp_error(state, "invalid argument `%s' for `-%c'", arg, key);
+        return EINVAL;
+    }
+
+    return 0;
+}
+
+/* The argp for TABLE.  */
+template <const auto &Table>
+inline constexpr struct argp argp_of = {
+    Table.options.data(), &parser<Table>, Table.args_doc, Table.doc,
+    nullptr, nullptr, nullptr
+};
+
+/* Parse ARGC & ARGV by TABLE into VALUES, exactly as argp_parse by
+   argp_of<TABLE> would, with the same FLAGS and ARG_INDEX.  */
+template <const auto &Table>
+error_t
+parse(int argc, char **argv, unsigned flags, int *arg_index,
+      detail::values_of<Table> *values)
+{
+    if (detail::parse_fast<Table>(argc, argv, flags, arg_index, *values))
+        return 0;
+    return argp_parse(&argp_of<Table>, argc, argv, flags, arg_index, values);
+}
+
+} /* namespace win_argp */
+
+#endif /* ARGP_STATIC_HPP */
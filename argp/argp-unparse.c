@@ -0,0 +1,230 @@
+/* Turning option values back into a command line.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <argp.h>
+#include "argp-namefrob.h"
+#include "argp-dag.h"
+
+/* Where argp_unparse is in building the command line.  It goes over the
+   options twice: first with ARGV NULL, just adding up how much room they
+   take, then again to store them.  */
+struct unparse
+{
+    argp_unparse_fn value_fn;
+    void *values, *defaults;
+
+    /* The arguments stored so far (or that would have been), and the bytes
+       their strings take, NULs included.  */
+    size_t argc;
+    size_t size;
+
+    char **argv;
+    char *strings;
+
+    /* The argps whose options have been added, so that one used in more
+       than one place only adds them once.  */
+    struct argp_seen seen;
+};
+
+/* Add an argument to the command line U is building: the LEN bytes at
+   PREFIX, then NAME and `=' if NAME isn't NULL, then VALUE if it isn't
+   NULL.  */
+static void
+unparse_add(struct unparse *u, const char *prefix, size_t len,
+            const char *name, const char *value)
+{
+    size_t name_len = name ? strlen(name) : 0;
+    size_t value_len = value ? strlen(value) : 0;
+    size_t size = len + name_len + (name && value) + value_len + 1;
+
+    if (u->argv) {
+        char *arg = u->strings + u->size;
+
+        memcpy(arg, prefix, len);
+        if (name) {
+            memcpy(arg + len, name, name_len);
+            len += name_len;
+            if (value)
+                arg[len++] = '=';
+        }
+        if (value)
+            memcpy(arg + len, value, value_len);
+        arg[len + value_len] = '\0';
+        u->argv[u->argc] = arg;
+    }
+
+    u->argc++;
+    u->size += size;
+}
+
+/* Return true if the values A and B, either of which may be NULL, are the
+   same.  */
+static int
+unparse_same(const char *a, const char *b)
+{
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+/* Add the arguments that give OPT, of ARGP, its values, using the long
+   option NAME if it isn't NULL and the short option KEY otherwise.  */
+static void
+unparse_option(struct unparse *u, const struct argp *argp,
+               const struct argp_option *opt, const char *name, int key)
+{
+    const char *value, *dvalue;
+    unsigned i;
+    int has;
+
+    if (u->defaults)
+        /* Leave the option out if it's given the same times, with the same
+            values, as by default.  */
+        for (i = 0;; i++) {
+            has = !!(*u->value_fn)(argp, opt, i, &value, u->values);
+            if (has != !!(*u->value_fn)(argp, opt, i, &dvalue, u->defaults)
+                || (has && opt->arg && !unparse_same(value, dvalue)))
+                break;
+            if (!has)
+                return;
+        }
+
+    for (i = 0; (*u->value_fn)(argp, opt, i, &value, u->values); i++) {
+        /* An option's argument goes in the same argument as the option,
+            as it must when the argument is optional.  */
+        if (!opt->arg)
+            value = NULL;
+        else if (!value)
+            value = "";
+
+        if (name)
+            unparse_add(u, "--", 2, name, value);
+        else {
+            char opt_str[2];
+
+            opt_str[0] = '-';
+            opt_str[1] = (char) key;
+            if (value && !*value && !(opt->flags & OPTION_ARG_OPTIONAL)) {
+                /* A bare `-K' would take the next argument as its value,
+                    so an empty one has to go in its own.  */
+                unparse_add(u, opt_str, 2, NULL, NULL);
+                unparse_add(u, "", 0, NULL, NULL);
+            } else
+                unparse_add(u, opt_str, 2, NULL, value);
+        }
+    }
+}
+
+/* Add the arguments for all the options of ARGP and its children.  */
+static void
+unparse_argp(struct unparse *u, const struct argp *argp)
+{
+    const struct argp_option *opt = argp->options, *next;
+    const struct argp_child *child;
+
+    if (argp_seen_add(&u->seen, argp))
+        return;
+
+    if (opt)
+        for (; !__option_is_end(opt); opt = next) {
+            const char *name = opt->name;
+            int key = __option_is_short(opt) ? opt->key : 0;
+
+            /* The option may be known by other names, from the aliases
+                following it; use the first long one, or the first short one
+                if there's no long one.  */
+            for (next = opt + 1;
+                 !__option_is_end(next) && (next->flags & OPTION_ALIAS);
+                 next++) {
+                if (!name)
+                    name = next->name;
+                if (!key && __option_is_short(next))
+                    key = next->key;
+            }
+
+            if (!(opt->flags & OPTION_DOC) && (name || key))
+                unparse_option(u, argp, opt, name, key);
+        }
+
+    for (child = argp->children; child && child->argp; child++)
+        unparse_argp(u, child->argp);
+}
+
+/* Build a command line that gives the options of ARGP the values VALUE_FN
+   reports for VALUES.  See argp.h for details.  */
+char **
+__argp_unparse(const struct argp *argp, argp_unparse_fn value_fn,
+               void *values, void *defaults, const char *name,
+               char *const *args, int *argc)
+{
+    struct unparse u;
+    int pass, quote = 0;
+    char **argv = NULL;
+    size_t i;
+
+    memset(&u, 0, sizeof(u));
+    u.value_fn = value_fn;
+    u.values = values;
+    u.defaults = defaults;
+    argp_seen_init(&u.seen, argp);
+
+    /* If any of ARGS looks like an option, put a "--" before them.  */
+    for (i = 0; args && args[i]; i++)
+        if (args[i][0] == '-' && args[i][1] != '\0')
+            quote = 1;
+
+    for (pass = 0; pass < 2; pass++) {
+        if (pass) {
+            argv = malloc((u.argc + 1) * sizeof(char *) + u.size);
+            if (!argv) {
+                argp_seen_free(&u.seen);
+                errno = ENOMEM;
+                return NULL;
+            }
+            argp_seen_clear(&u.seen);
+            u.argv = argv;
+            u.strings = (char *) (argv + u.argc + 1);
+            u.argc = 0;
+            u.size = 0;
+        }
+
+        if (name)
+            unparse_add(&u, name, strlen(name), NULL, NULL);
+        if (argp)
+            unparse_argp(&u, argp);
+        if (quote)
+            unparse_add(&u, "--", 2, NULL, NULL);
+        for (i = 0; args && args[i]; i++)
+            unparse_add(&u, args[i], strlen(args[i]), NULL, NULL);
+    }
+
+    argp_seen_free(&u.seen);
+    argv[u.argc] = NULL;
+    if (argc)
+        *argc = (int) u.argc;
+
+    return argv;
+}
+#ifdef weak_alias
+weak_alias(__argp_unparse, argp_unparse)
+#endif
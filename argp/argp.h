@@ -129,9 +129,23 @@ struct argp_option
    of option name. */
 #define OPTION_NO_TRANS         0x20
 
+/* Each time this option is given, its argument (or NULL, if it has none) is
+   added to an array instead of being passed to the parser, which can get
+   the array from argp_accumulated once the options are parsed, as when
+   called with ARGP_KEY_END.  This is for options given many times, like
+   `-I DIR'.  */
+#define OPTION_ACCUMULATE   0x40
+
+/* Only valid in the entry that ends an options array, whose ARG then points
+   to a struct argp_extension with more of what its argp does; the entry is
+   best made with ARGP_OPTION_EXTENSION.  Older versions of argp end the
+   array there all the same, and ignore the extension.  */
+#define OPTION_EXTENSION    0x80
+
 struct argp;            /* fwd declare this type */
 struct argp_state;      /* " */
 struct argp_child;      /* " */
+struct argp_command;    /* " */
 
 /* The type of a pointer to an argp parsing function.  */
 typedef error_t (*argp_parser_t)(int __key, char *__arg,
@@ -196,6 +210,119 @@ typedef error_t (*argp_parser_t)(int __key, char *__arg,
 #define ARGP_KEY_SUCCESS    0x1000004
 /* Passed in if an error occurs.  */
 #define ARGP_KEY_ERROR      0x1000005
+/* The first non-option argument, ARG, names one of the COMMANDS of the
+   argp's extension.  STATE->input, which the parser may change, is what the
+   arguments after it are parsed with, by the command's argp.  */
+#define ARGP_KEY_COMMAND    0x1000008
+
+/* The types of value an argp_binding can store, and what it stores them
+   in.  The converters don't depend on the locale, and take no leading or
+   trailing blanks.  */
+
+/* An int, written in decimal, in hex after `0x', or in octal after `0'.  */
+#define ARGP_BIND_INT       1
+/* An int64_t, written the same way.  */
+#define ARGP_BIND_INT64     2
+/* A size_t, written the same way, and optionally followed by one of the
+   suffixes K, M, G, T, P or E for powers of 1024, which may be followed in
+   turn by `B' or `iB'.  */
+#define ARGP_BIND_SIZE      3
+/* A double, with `.' as the decimal point whatever the locale.  */
+#define ARGP_BIND_DOUBLE    4
+/* An int64_t count of nanoseconds, written as a sequence of numbers, which
+   may have fractions, each followed by one of the units ns, us, ms, s, m, h
+   or d, as in `1h30m' or `0.5s'; or as a plain number of seconds.  */
+#define ARGP_BIND_DURATION  5
+/* An int: 1 for an option given without an argument, and otherwise 1 for
+   `yes', `true', `on' or `1', and 0 for `no', `false', `off' or `0', in
+   any case.  */
+#define ARGP_BIND_BOOL      6
+/* A char *, pointing to the argument itself.  */
+#define ARGP_BIND_STRING    7
+/* In lists only, a struct argp_slice of the argument, which unlike
+   ARGP_BIND_STRING leaves the argument as it was.  */
+#define ARGP_BIND_SLICE     8
+/* An int, the VALUE of the entry in the binding's VALUES whose NAME is the
+   argument, or which is the only one starting with it, as long options can
+   be abbreviated.  Names that start the same way and have the same VALUE
+   aren't ambiguous.  */
+#define ARGP_BIND_ENUM      9
+/* A uint64_t, written as for ARGP_BIND_INT but without a `-'.  */
+#define ARGP_BIND_UINT64    10
+
+/* Or'ed with one of the types above: the argument is a list of values of
+   that type, separated by the binding's DELIM, and is stored in a struct
+   argp_list.  The values are converted as they would be alone; an empty
+   argument is an empty list.  An ARGP_BIND_STRING list is split in place,
+   each delimiter in the argument being overwritten by a NUL.  Each time
+   the option is given, its values are added to the end of the list.  */
+#define ARGP_BIND_LIST      0x100
+
+/* A piece of a string that isn't NUL-terminated.  */
+struct argp_slice
+{
+    const char *str;
+    size_t len;
+};
+
+/* The values of an ARGP_BIND_LIST option.  ITEMS is an array of COUNT
+   values of the C type of the list's type, allocated with malloc, which
+   the caller frees with free; the input must hold an empty list, all
+   zeros, before the option is first stored in it.  */
+struct argp_list
+{
+    void *items;
+    size_t count;
+};
+
+/* One of the arguments an ARGP_BIND_ENUM option takes.  */
+struct argp_enum
+{
+    const char *name;
+    int value;
+};
+
+/* An option whose argument argp stores itself, instead of passing it to the
+   parser.  */
+struct argp_binding
+{
+    /* The key of the option, as in its argp_option.  */
+    int key;
+
+    /* One of the ARGP_BIND_ types.  */
+    int type;
+
+    /* Where the value goes, as an offset into the parser's input.  */
+    size_t offset;
+
+    /* For a list, the character between its values, or 0 for `,'.  */
+    int delim;
+
+    /* For ARGP_BIND_ENUM, the arguments it takes, with distinct names, ending
+       with one whose NAME is NULL.  They're listed in the option's help.  */
+    const struct argp_enum *values;
+};
+
+/* The types of argp_constraint.  */
+
+/* At most one of the options may be given.  */
+#define ARGP_CONFLICTS      1
+/* If the first option is given, all the others must be too.  */
+#define ARGP_REQUIRES       2
+/* At least one of the options must be given.  */
+#define ARGP_AT_LEAST_ONE   3
+/* Exactly one of the options must be given.  */
+#define ARGP_EXACTLY_ONE    4
+
+/* A rule on which of an argp's options may be given together.  */
+struct argp_constraint
+{
+    /* One of the types above.  */
+    int type;
+
+    /* The keys of the options, ending with 0.  */
+    const int *keys;
+};
 
 /* An argp structure contains a set of options declarations, a function to
    deal with parsing one, documentation string, a possible vector of child
@@ -235,7 +362,10 @@ struct argp
         conflicts are resolved in favor of this argp, or early argps in the
         CHILDREN list.  This field is useful if you use libraries that supply
         their own argp structure, which you want to use in conjunction with your
-        own.  */
+        own.  The same argp may be used in more than one place in a tree; its
+        parser is then called in each, with the input for that place, but its
+        options, being in conflict with themselves, only go to the first, and
+        are only set up and listed in help once.  */
     const struct argp_child *children;
 
     /* If non-zero, this should be a function to filter the output of help
@@ -256,6 +386,67 @@ struct argp
     const char *argp_domain;
 };
 
+/* A subcommand, such as `commit' in `git commit'.  */
+struct argp_command
+{
+    /* The name it's given by.  */
+    const char *name;
+
+    /* The argp that parses the arguments after the command.  If NULL,
+        LOADER is called for it when the command is given, and returns NULL
+        if it can't be had; it may, for instance, open the module the
+        command lives in.  */
+    const struct argp *argp;
+    const struct argp *(*loader) (const struct argp_command *__command);
+
+    /* A line saying what the command does, for --help.  */
+    const char *doc;
+};
+
+/* What an argp does besides what struct argp holds, which is kept out of it
+   so that its layout stays the same for programs built against older
+   versions of argp.  An argp has one if its options array ends with
+   ARGP_OPTION_EXTENSION (&EXTENSION).  */
+struct argp_extension
+{
+    /* sizeof (struct argp_extension) as the program was built: fields past
+        it are taken to be NULL, so fields may be added at the end.  */
+    size_t size;
+
+    /* If non-NULL, an array of argp_binding structures, terminated by one
+        with a KEY of 0, for options whose arguments argp converts and stores
+        in the input itself: such options never reach PARSER.  An argument
+        that can't be converted is reported by argp_error, and the error is
+        returned from argp_parse.  An optional argument that isn't given
+        leaves a number as it was, stores NULL for a string, and 1 for a
+        bool.  If the input is NULL, the options go to PARSER instead.  */
+    const struct argp_binding *bindings;
+
+    /* If non-NULL, an array of argp_constraint structures, terminated by one
+        with a TYPE of 0, on which of this argp's options can be given
+        together.  They're checked once all the arguments are parsed, before
+        ARGP_KEY_END; one that isn't met is reported by argp_error, and
+        argp_parse returns EINVAL.  */
+    const struct argp_constraint *constraints;
+
+    /* If non-NULL, an array of argp_command structures, terminated by one
+        with a NULL NAME, that the first non-option argument must name one
+        of.  Options after it, and the rest of the arguments, are then
+        parsed by argp_parse with the command's argp, called `PROGRAM NAME'
+        in its messages, once this argp's parser has been called with
+        ARGP_KEY_COMMAND; argp_parse returns what that does.  Only the
+        command given is loaded and set up, so a program with many of them
+        pays only for the one it runs.  Options of this tree must come
+        before the command.  Only the first argp in a tree with COMMANDS
+        has them used.  */
+    const struct argp_command *commands;
+};
+
+/* The entry that ends an options array, giving its argp the struct
+   argp_extension at EXTENSION.  */
+#define ARGP_OPTION_EXTENSION(extension) \
+    { NULL, 0, (const char *) (extension), OPTION_EXTENSION, NULL, 0 }
+
 /* Possible KEY arguments to a help filter function.  */
 #define ARGP_KEY_HELP_PRE_DOC   0x2000001 /* Help text preceding options. */
 #define ARGP_KEY_HELP_POST_DOC  0x2000002 /* Help text following options. */
@@ -402,6 +593,192 @@ error_t __argp_parse(const struct argp *__restrict argp,
                     unsigned flags, int *__restrict arg_index,
                     void *__restrict input);
 
+/* Like argp_parse, but options that no parser in ARGP knows are passed over
+   instead of being errors, and a pointer to each is stored in FORWARD, in
+   the order they appear.  These are elements of ARGV, not copies, so an
+   option's argument goes with it only when it's part of the same element,
+   as in `--name=value' or `-nvalue'; an unknown short option that follows
+   known ones in the same element can't be passed on by itself, and is
+   still an error.  FORWARD must have room for ARGC + 1 pointers, and is
+   terminated by a NULL pointer, so that with a program name stored just
+   before it, it can be handed to execv as it is.  If FORWARD_COUNT is
+   non-NULL, the number of options stored is returned in it.  */
+DLLEXPORT
+error_t argp_parse_forward(const struct argp *__restrict argp,
+                    int argc, char **__restrict argv,
+                    unsigned flags, int *__restrict arg_index,
+                    void *__restrict input,
+                    char **__restrict forward,
+                    size_t *__restrict forward_count);
+DLLEXPORT
+error_t __argp_parse_forward(const struct argp *__restrict argp,
+                    int argc, char **__restrict argv,
+                    unsigned flags, int *__restrict arg_index,
+                    void *__restrict input,
+                    char **__restrict forward,
+                    size_t *__restrict forward_count);
+
+/* A function that tells argp_unparse the values of the options of ARGP.
+   OPT is one that can be given on the command line (never an alias or
+   documentation), and INDEX counts the times it is given, from 0.  If it's
+   given an INDEX'th time, set *VALUE to its argument (or NULL, if it has
+   none) and return non-zero; otherwise return 0.  VALUES is whatever was
+   passed to argp_unparse, for either the values or their defaults.  It may
+   be asked about the same option more than once, and should give the same
+   answers each time.  */
+typedef int (*argp_unparse_fn)(const struct argp *__argp,
+                    const struct argp_option *__opt, unsigned __index,
+                    const char **__value, void *__values);
+
+/* Return a command line that gives the options of ARGP and its children
+   the values VALUE_FN reports for VALUES, in the order the options are
+   declared, each in a single argument: `--NAME=VALUE', or `-KVALUE' if it
+   has no long name (or `-K' and an empty argument, if VALUE is empty and
+   not optional).  It starts with NAME, if that isn't NULL, and ends with
+   the NULL-terminated list ARGS, if that isn't NULL, after a `--' if any of
+   them look like options.  If DEFAULTS isn't NULL, options that VALUE_FN
+   gives the same values for DEFAULTS as for VALUES are left out.  The
+   result is terminated by a NULL pointer, and is a single allocation
+   holding both the pointers and the strings, which the caller frees with
+   free; the number of arguments is returned in *ARGC if ARGC isn't NULL.
+   Returns NULL if there isn't enough memory.  */
+DLLEXPORT
+char **argp_unparse(const struct argp *__argp, argp_unparse_fn __value_fn,
+                    void *__values, void *__defaults, const char *__name,
+                    char *const *__args, int *__argc);
+DLLEXPORT
+char **__argp_unparse(const struct argp *__argp, argp_unparse_fn __value_fn,
+                    void *__values, void *__defaults, const char *__name,
+                    char *const *__args, int *__argc);
+
+/* Write to STREAM, one per line, the ways the last of the ARGC words in
+   ARGV, the one a shell is completing, can be completed as an option of
+   ARGP or its children: `--NAME', with a trailing `=' if the option needs
+   an argument, or `-K' as well if the word is just `-'.  If the word is an
+   argument of an ARGP_BIND_ENUM option, in `--NAME=VALUE', `-KVALUE' or
+   the word after the option, the values it may be completed to are
+   written instead.  Nothing is written for other arguments, for the shell
+   to complete as files, unless the tree has commands and none has been
+   given yet, when the commands that start with it are written; once one
+   has, the rest of the words are completed with its argp alone.  ARGV
+   doesn't include the program name, and the words before the last are only
+   looked at to tell which are options' arguments and which is the command:
+   no parser is called and no help is built.  Hidden options
+   aren't offered.  argp_parse does this for the words after `--complete',
+   when it's the first argument and not an option of ARGP's own, adding the
+   standard options, and then exits; see the scripts in argp/completion.  Returns ENOMEM if there isn't
+   enough memory.  */
+DLLEXPORT
+extern error_t argp_complete(const struct argp *__restrict __argp,
+                    int __argc, char **__restrict __argv,
+                    FILE *__restrict __stream);
+DLLEXPORT
+extern error_t __argp_complete(const struct argp *__restrict __argp,
+                    int __argc, char **__restrict __argv,
+                    FILE *__restrict __stream);
+
+/* What argp_iter_next found next on the command line.  */
+struct argp_event
+{
+    /* The argp, in the tree given to argp_iter_begin, whose option this is,
+        or NULL for a non-option argument or an error.  */
+    const struct argp *argp;
+
+    /* The option's key, ARGP_KEY_ARG for a non-option argument, or
+        ARGP_KEY_ERROR for an option that's unknown or lacks an argument.  */
+    int key;
+
+    /* The option's argument (NULL if it has none), the non-option argument,
+        or the whole argument the error is in.  */
+    char *arg;
+
+    /* The index in ARGV of the argument the option, non-option argument or
+        error is in.  Unless ARGP_IN_ORDER is used, getopt may later move
+        it, to put the non-option arguments after the options.  */
+    int index;
+};
+
+/* A parse that hands back what it finds one event at a time.  */
+struct argp_iter;
+
+/* Start parsing ARGC & ARGV by the options of ARGP, as argp_parse would
+   with FLAGS, but without calling any parsers: each option or non-option
+   argument is instead returned by argp_iter_next, as it's asked for, so
+   the caller can stop at any point with the rest of ARGV unread.  The
+   standard --help and --version options aren't added, and errors are
+   returned as events.  Like argp_parse, this uses getopt, so no other
+   parse may be going on at the same time.  Returns NULL if there isn't
+   enough memory.  */
+DLLEXPORT
+extern struct argp_iter *argp_iter_begin(const struct argp *__argp,
+                    int __argc, char **__argv, unsigned __flags);
+DLLEXPORT
+extern struct argp_iter *__argp_iter_begin(const struct argp *__argp,
+                    int __argc, char **__argv, unsigned __flags);
+
+/* Store the next event of ITER in EVENT and return non-zero, or return 0 if
+   the end of ARGV has been reached.  */
+DLLEXPORT
+extern int argp_iter_next(struct argp_iter *__restrict __iter,
+                    struct argp_event *__restrict __event);
+DLLEXPORT
+extern int __argp_iter_next(struct argp_iter *__restrict __iter,
+                    struct argp_event *__restrict __event);
+
+/* Store in NAMES up to MAX long options of ITER's argp that ARG, the
+   argument of an ARGP_KEY_ERROR event for an unknown long option, may have
+   been a typo for, nearest first, and return how many there are.  ARG may
+   have its dashes and an `=VALUE'.  Names a few edits away from it (by
+   insertions, deletions and substitutions of characters) are suggested;
+   hidden options aren't.  The names belong to ITER's argp.  argp_parse
+   adds the nearest three to its message for such an option.  */
+DLLEXPORT
+extern size_t argp_iter_suggest(struct argp_iter *__iter, const char *__arg,
+                    const char **__names, size_t __max);
+DLLEXPORT
+extern size_t __argp_iter_suggest(struct argp_iter *__iter, const char *__arg,
+                    const char **__names, size_t __max);
+
+/* Free ITER, which may be NULL, at any point in its parse.  */
+DLLEXPORT
+extern void argp_iter_end(struct argp_iter *__iter);
+DLLEXPORT
+extern void __argp_iter_end(struct argp_iter *__iter);
+
+/* Convert ARG as an argp_binding of type TYPE would, and store the result
+   in VALUE, which points to the type's C type.  Returns 0, EINVAL if ARG
+   isn't a valid value, ERANGE if it's out of range, or ENOMEM; VALUE is
+   only changed on success.  ARG may be NULL only for ARGP_BIND_BOOL and
+   ARGP_BIND_STRING.  Lists are converted by argp_convert_list, and
+   ARGP_BIND_ENUM, which needs a binding's VALUES, only by argp_parse.  */
+DLLEXPORT
+extern error_t argp_convert(int __type, const char *__arg, void *__value);
+DLLEXPORT
+extern error_t __argp_convert(int __type, const char *__arg, void *__value);
+
+/* Convert the values in ARG, separated by DELIM (`,' if 0), as an
+   argp_binding of type TYPE | ARGP_BIND_LIST would, and add them to the end
+   of LIST.  Returns 0 or an error as argp_convert does, in which case LIST
+   holds the values it did before.  */
+DLLEXPORT
+extern error_t argp_convert_list(int __type, int __delim, char *__arg,
+                                 struct argp_list *__list);
+DLLEXPORT
+extern error_t __argp_convert_list(int __type, int __delim, char *__arg,
+                                   struct argp_list *__list);
+
+/* Return the arguments of each time the OPTION_ACCUMULATE option KEY was
+   given, in order, and put how many there were in *COUNT; or NULL, with
+   *COUNT 0, if there were none.  KEY is one of the options of the argp whose
+   parser is being called with STATE.  The array is argp's, and is freed
+   when argp_parse returns.  */
+DLLEXPORT
+extern char **argp_accumulated(const struct argp_state *__restrict __state,
+                               int __key, size_t *__restrict __count);
+DLLEXPORT
+extern char **__argp_accumulated(const struct argp_state *__restrict __state,
+                                 int __key, size_t *__restrict __count);
+
 /* Global variables.  */
 
 /* If defined or set by the user program to a non-zero value, then a default
@@ -477,7 +854,8 @@ extern error_t argp_err_exit_status;
    | ARGP_HELP_DOC | ARGP_HELP_BUG_ADDR)
 
 /* Output a usage message for ARGP to STREAM.  FLAGS are from the set
-   ARGP_HELP_*.  */
+   ARGP_HELP_*.  If there isn't enough memory to list the options, nothing
+   is written and errno is set to ENOMEM.  */
 DLLEXPORT
 extern void argp_help(const struct argp *__restrict __argp,
                 FILE *__restrict __stream,
@@ -487,6 +865,111 @@ extern void __argp_help(const struct argp *__restrict __argp,
                 FILE *__restrict __stream, unsigned __flags,
                 char *__name);
 
+/* Like argp_help, but stream the message to STREAM section by section
+   through a fixed-size buffer, so the text is never held in memory as a
+   whole.  The option list is still built and sorted in full before any
+   help that needs it is written, so that part of the memory used grows
+   with the number of options in ARGP.  Output stops early once MAX_BYTES
+   bytes have been written (if MAX_BYTES is non-zero) or STREAM reports an
+   error such as EPIPE.  The text is the same as argp_help's, except that a
+   line with a word wider than the line may be broken in another place:
+   lines are only broken at blanks still in the buffer, and the two buffer
+   the text differently.  Returns the number of bytes written.  */
+DLLEXPORT
+extern size_t argp_help_stream(const struct argp *__restrict __argp,
+                FILE *__restrict __stream,
+                unsigned __flags, char *__restrict __name,
+                size_t __max_bytes);
+DLLEXPORT
+extern size_t __argp_help_stream(const struct argp *__restrict __argp,
+                FILE *__restrict __stream, unsigned __flags,
+                char *__name, size_t __max_bytes);
+
+/* A function that receives help text from argp_help_to_callback, in as many
+   pieces as it takes.  It should consume LEN bytes at DATA and return how
+   many it did; returning fewer than LEN stops the output.  */
+typedef size_t (*argp_help_write_fn)(void *__cookie, const char *__data,
+                    size_t __len);
+
+/* Like argp_help, but render the message into BUF, which is SIZE bytes long,
+   the way snprintf does: at most SIZE - 1 bytes are stored, followed by a
+   '\0'.  Returns the length of the whole message (not counting the '\0'),
+   so a first call with a SIZE of 0 gives the size to allocate.  */
+DLLEXPORT
+extern size_t argp_help_to_buffer(const struct argp *__restrict __argp,
+                char *__restrict __buf, size_t __size,
+                unsigned __flags, char *__restrict __name);
+DLLEXPORT
+extern size_t __argp_help_to_buffer(const struct argp *__restrict __argp,
+                char *__restrict __buf, size_t __size,
+                unsigned __flags, char *__name);
+
+/* Like argp_help, but pass the message to WRITE_FN, called with COOKIE,
+   instead of writing it to a stream.  Returns the number of bytes WRITE_FN
+   consumed.  */
+DLLEXPORT
+extern size_t argp_help_to_callback(const struct argp *__restrict __argp,
+                argp_help_write_fn __write_fn, void *__cookie,
+                unsigned __flags, char *__restrict __name);
+DLLEXPORT
+extern size_t __argp_help_to_callback(const struct argp *__restrict __argp,
+                argp_help_write_fn __write_fn, void *__cookie,
+                unsigned __flags, char *__name);
+
+/* Like argp_help, but write the message to the file descriptor FD in a few
+   large writes, with no stdio buffering in between.  Returns the number of
+   bytes written, which is short if writing to FD failed.  */
+DLLEXPORT
+extern size_t argp_help_to_fd(const struct argp *__restrict __argp,
+                int __fd, unsigned __flags, char *__restrict __name);
+DLLEXPORT
+extern size_t __argp_help_to_fd(const struct argp *__restrict __argp,
+                int __fd, unsigned __flags, char *__name);
+
+/* What help messages are rendered with that only needs working out once:
+   the parsed ARGP_HELP_FMT parameters and the translations of the help
+   strings.  A context is never changed once made, so it may be shared by
+   threads rendering help at the same time.  */
+struct argp_help_context;
+
+/* Return a new help context for ARGP, or NULL if there wasn't enough
+   memory.  ARGP_HELP_FMT is read once, now.  */
+DLLEXPORT
+extern struct argp_help_context *argp_help_context_new(
+                const struct argp *__argp);
+DLLEXPORT
+extern struct argp_help_context *__argp_help_context_new(
+                const struct argp *__argp);
+
+/* Free CTX, which must no longer be in use.  */
+DLLEXPORT
+extern void argp_help_context_free(struct argp_help_context *__ctx);
+DLLEXPORT
+extern void __argp_help_context_free(struct argp_help_context *__ctx);
+
+/* Like argp_help and argp_help_to_buffer, for the argp that CTX was made
+   for, formatted and translated as CTX says.  */
+DLLEXPORT
+extern void argp_help_with_context(
+                const struct argp_help_context *__restrict __ctx,
+                FILE *__restrict __stream,
+                unsigned __flags, char *__restrict __name);
+DLLEXPORT
+extern void __argp_help_with_context(
+                const struct argp_help_context *__restrict __ctx,
+                FILE *__restrict __stream,
+                unsigned __flags, char *__name);
+DLLEXPORT
+extern size_t argp_help_to_buffer_with_context(
+                const struct argp_help_context *__restrict __ctx,
+                char *__restrict __buf, size_t __size,
+                unsigned __flags, char *__restrict __name);
+DLLEXPORT
+extern size_t __argp_help_to_buffer_with_context(
+                const struct argp_help_context *__restrict __ctx,
+                char *__restrict __buf, size_t __size,
+                unsigned __flags, char *__name);
+
 /* The following routines are intended to be called from within an argp
    parsing routine (thus taking an argp_state structure as the first
    argument).  They may or may not print an error message and exit, depending
@@ -506,6 +989,30 @@ extern void __argp_state_help(const struct argp_state *__restrict __state,
                     FILE *__restrict __stream,
                     unsigned int __flags);
 
+/* Like argp_state_help, but render the message into BUF or pass it to
+   WRITE_FN, like argp_help_to_buffer and argp_help_to_callback.  These never
+   exit, whatever FLAGS say.  */
+DLLEXPORT
+extern size_t argp_state_help_to_buffer(
+                    const struct argp_state *__restrict __state,
+                    char *__restrict __buf, size_t __size,
+                    unsigned int __flags);
+DLLEXPORT
+extern size_t __argp_state_help_to_buffer(
+                    const struct argp_state *__restrict __state,
+                    char *__restrict __buf, size_t __size,
+                    unsigned int __flags);
+DLLEXPORT
+extern size_t argp_state_help_to_callback(
+                    const struct argp_state *__restrict __state,
+                    argp_help_write_fn __write_fn, void *__cookie,
+                    unsigned int __flags);
+DLLEXPORT
+extern size_t __argp_state_help_to_callback(
+                    const struct argp_state *__restrict __state,
+                    argp_help_write_fn __write_fn, void *__cookie,
+                    unsigned int __flags);
+
 /* If appropriate, print the printf string FMT and following args, preceded
    by the program name and `:', to stderr, and followed by a `Try ... --help'
    message, then exit (1).  */
@@ -0,0 +1,146 @@
+/* Benchmark for the option catalog of large programs.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+
+/* Usage: argp-catalog-bench [ITERATIONS]
+
+   For programs with a growing number of options, 500 to each child argp,
+   times the three things that go over all of them:
+
+     parse       argp_parse of the last option, which used to look every
+                 long name up in those converted before it
+     help        --help, into a buffer
+     complete    argp_complete of `--option-1'
+
+   and prints milliseconds per call.  */
+
+#include "win-argp-config.h"
+
+#include "bench-common.h"
+
+#define GROUP_OPTIONS 500
+
+static error_t
+accept_parser(int key, char *arg, struct argp_state *state)
+{
+    (void) key;
+    (void) arg;
+    (void) state;
+    return 0;
+}
+
+/* Return a program with COUNT options.  */
+static struct argp *
+make_program(size_t count)
+{
+    struct argp *root = bench_make_argp(count, count / GROUP_OPTIONS, 20);
+    struct argp_child *child;
+
+    for (child = (struct argp_child *) root->children; child->argp; child++)
+        ((struct argp *) child->argp)->parser = accept_parser;
+    root->parser = accept_parser;
+
+    return root;
+}
+
+static double
+time_parse(const struct argp *argp, size_t count, unsigned iterations)
+{
+    char last[32];
+    char *argv[] = { (char *) "bench", last, NULL };
+    double start;
+    unsigned i;
+
+    /* Every third option takes an argument.  */
+    snprintf(last, sizeof last, "--option-%zu%s", count - 1,
+             (count - 1) % 3 ? "" : "=x");
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        if (argp_parse(argp, 2, argv, ARGP_NO_EXIT, NULL, NULL)) {
+            fprintf(stderr, "bench: argp_parse failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+static double
+time_help(const struct argp *argp, unsigned iterations)
+{
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        argp_help_to_buffer(argp, NULL, 0, ARGP_HELP_STD_HELP, "bench");
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+static double
+time_complete(const struct argp *argp, unsigned iterations, FILE *out)
+{
+    char *words[] = { (char *) "--option-1", NULL };
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        if (argp_complete(argp, 1, words, out)) {
+            fprintf(stderr, "bench: argp_complete failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    /* Long options only have room for 127 groups.  */
+    static const size_t counts[] = { 1000, 5000, 10000, 20000 };
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+    FILE *out = tmpfile();
+    size_t i;
+
+    if (!out) {
+        fprintf(stderr, "bench: can't create a temporary file\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%8s %12s %12s %12s\n", "options", "parse ms", "help ms",
+           "complete ms");
+
+    for (i = 0; i < sizeof counts / sizeof counts[0]; i++) {
+        size_t count = counts[i];
+        unsigned iters = iterations ? iterations
+                         : (unsigned) (20000 / count + 2);
+        const struct argp *argp = make_program(count);
+        double parse, help, complete;
+
+        parse = time_parse(argp, count, iters);
+        help = time_help(argp, iters);
+        complete = time_complete(argp, iters, out);
+
+        printf("%8zu %12.3f %12.3f %12.3f\n", count, parse / 1e6,
+               help / 1e6, complete / 1e6);
+    }
+
+    fclose(out);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/* Benchmark for subcommands.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+
+/* Usage: argp-command-bench [ITERATIONS]
+
+   For programs with a growing number of subcommands of 100 options each,
+   times parsing `COMMAND --OPTION' two ways:
+
+     tree        every command's options as a child of the program's argp,
+                 so all of them are converted, and their parsers called, on
+                 every run
+     commands    the commands of the argp's extension, loaded by a loader
+                 when given, so only the one run is set up
+
+   and prints microseconds per parse.  */
+
+#include "win-argp-config.h"
+
+#include "bench-common.h"
+
+#define COMMAND_OPTIONS 100
+
+/* The commands, and the argps their loader finds for them.  */
+static const struct argp_command *bench_commands;
+static const struct argp *const *bench_command_argps;
+static unsigned loads;
+
+static error_t
+accept_parser(int key, char *arg, struct argp_state *state)
+{
+    (void) arg;
+    (void) state;
+    return key == ARGP_KEY_ARG ? ARGP_ERR_UNKNOWN : 0;
+}
+
+static const struct argp *
+load_command(const struct argp_command *command)
+{
+    loads++;
+    return bench_command_argps[command - bench_commands];
+}
+
+static double
+time_parse(const struct argp *argp, int argc, char **argv,
+           unsigned iterations)
+{
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        if (argp_parse(argp, argc, argv, ARGP_SILENT, NULL, NULL)) {
+            fprintf(stderr, "bench: `%s' failed\n", argv[argc - 1]);
+            exit(EXIT_FAILURE);
+        }
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    /* Long options only have room for 127 groups.  */
+    static const size_t counts[] = { 1, 10, 40, 120 };
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+    size_t i;
+
+    printf("%10s %10s %12s %12s\n", "commands", "options", "tree us",
+           "commands us");
+
+    for (i = 0; i < sizeof counts / sizeof counts[0]; i++) {
+        size_t count = counts[i], c, n;
+        unsigned iters = iterations ? iterations
+                         : (unsigned) (20000 / (count * count) + 5);
+        struct argp *tree = bench_make_argp(count * COMMAND_OPTIONS, count, 20);
+        struct argp *lazy = calloc(1, sizeof *lazy);
+        /* Its options are only the end, which gives it its commands.  */
+        struct argp_option *lazy_options = calloc(1, sizeof *lazy_options);
+        struct argp_extension *extension = calloc(1, sizeof *extension);
+        struct argp_command *commands = calloc(count + 1, sizeof *commands);
+        const struct argp **argps = calloc(count, sizeof *argps);
+        char name[32], option[32];
+        char *tree_argv[] = { (char *) "bench", option, NULL };
+        char *lazy_argv[] = { (char *) "bench", name, option, NULL };
+        double tree_ns, lazy_ns;
+
+        /* Each of the tree's children is a command.  */
+        for (c = 0; c < count; c++) {
+            struct argp *child = (struct argp *) tree->children[c].argp;
+            char *command_name = malloc(32);
+
+            child->parser = accept_parser;
+            snprintf(command_name, 32, "command-%zu", c);
+            commands[c].name = command_name;
+            commands[c].loader = load_command;
+            argps[c] = child;
+        }
+        tree->parser = accept_parser;
+        lazy->parser = accept_parser;
+        extension->size = sizeof *extension;
+        extension->commands = commands;
+        lazy_options->arg = (const char *) extension;
+        lazy_options->flags = OPTION_EXTENSION;
+        lazy->options = lazy_options;
+        bench_commands = commands;
+        bench_command_argps = argps;
+
+        /* An option of the last command without an argument.  */
+        c = count - 1;
+        for (n = c * COMMAND_OPTIONS + 1; n % 3 == 0 || n % 5 == 0; n++)
+            ;
+        snprintf(name, sizeof name, "command-%zu", c);
+        snprintf(option, sizeof option, "--option-%zu", n);
+
+        tree_ns = time_parse(tree, 2, tree_argv, iters);
+
+        loads = 0;
+        lazy_ns = time_parse(lazy, 3, lazy_argv, iters);
+        if (loads != iters) {
+            fprintf(stderr, "bench: %u loads\n", loads);
+            return EXIT_FAILURE;
+        }
+
+        printf("%10zu %10zu %12.2f %12.2f\n", count, count * COMMAND_OPTIONS,
+               tree_ns / 1e3, lazy_ns / 1e3);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+/* Benchmark for shell completion against scraping --help.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+
+/* Usage: argp-complete-bench [ITERATIONS]
+
+   For synthetic parsers of growing size, times what a shell's TAB costs:
+
+     prefix      argp_complete of `--option-1', which matches about a tenth
+                 of the options
+     all         argp_complete of `-', which lists every option
+     help        argp_help, which a completion script would otherwise have
+                 to run and scrape
+
+   and prints microseconds per call.  Output goes to the null device.  */
+
+#include "win-argp-config.h"
+
+#include "bench-common.h"
+
+static double
+time_complete(const struct argp *argp, const char *word, FILE *out,
+              unsigned iterations)
+{
+    char *argv[] = { (char *) word, NULL };
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        argp_complete(argp, 1, argv, out);
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+static double
+time_help(const struct argp *argp, FILE *out, unsigned iterations)
+{
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        argp_help(argp, out, ARGP_HELP_STD_HELP, (char *) "bench");
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t sizes[] = { 100, 1000, 10000, 50000 };
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+    FILE *out = fopen(BENCH_NULL_DEVICE, "w");
+    size_t i;
+
+    if (!out) {
+        perror(BENCH_NULL_DEVICE);
+        return EXIT_FAILURE;
+    }
+
+    printf("%10s %12s %12s %12s\n", "options", "prefix us", "all us",
+           "help us");
+
+    for (i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+        size_t noptions = sizes[i];
+        struct argp *argp = bench_make_argp(noptions, 1 + noptions / 100, 20);
+        unsigned iters = iterations ? iterations
+                         : (unsigned) (200000 / noptions + 1);
+
+        printf("%10zu %12.1f %12.1f %12.1f\n", noptions,
+               time_complete(argp, "--option-1", out, iters) / 1e3,
+               time_complete(argp, "-", out, iters) / 1e3,
+               time_help(argp, out, iters) / 1e3);
+    }
+
+    fclose(out);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+/* Benchmark for option constraints.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+
+/* Usage: argp-constraint-bench [ITERATIONS]
+
+   Parses a command line of 16 options for a program with 2000 options
+   and a growing number of constraints between them, all of which hold,
+   and prints microseconds per parse, and the time the constraints add
+   to a parse without any.  */
+
+#include "win-argp-config.h"
+
+#include <stddef.h>
+
+#include "bench-common.h"
+
+#define BENCH_OPTIONS 2000
+
+/* The command line: the first BENCH_GIVEN options that aren't aliases.  */
+#define BENCH_GIVEN 16
+
+static char *bench_argv[BENCH_GIVEN + 2];
+static int given_keys[BENCH_GIVEN];
+
+static error_t
+accept_parser(int key, char *arg, struct argp_state *state)
+{
+    (void) arg;
+    (void) state;
+    return key == ARGP_KEY_ARG ? ARGP_ERR_UNKNOWN : 0;
+}
+
+/* Return the key of option N of bench_make_argp's argp.  */
+static int
+option_key(size_t n)
+{
+    if (n < 52)
+        return n < 26 ? 'a' + (int) n : 'A' + (int) n - 26;
+    return (int) (0x100 + n);
+}
+
+/* Return a random key of an option that isn't an alias and isn't on the
+   command line.  */
+static int
+unused_key(unsigned *seed)
+{
+    size_t n;
+
+    do
+        n = 2 * BENCH_GIVEN + bench_rand(seed) % (BENCH_OPTIONS - 2 * BENCH_GIVEN);
+    while (n % 5 == 0);
+
+    return option_key(n);
+}
+
+/* Return a random key of an option on the command line.  */
+static int
+given_key(unsigned *seed)
+{
+    return given_keys[bench_rand(seed) % BENCH_GIVEN];
+}
+
+/* Fill BENCH_ARGV and GIVEN_KEYS.  */
+static void
+make_command_line(void)
+{
+    int argc = 0;
+    size_t n;
+
+    bench_argv[argc++] = (char *) "bench";
+    for (n = 1; argc <= BENCH_GIVEN; n++)
+        if (n % 5) {
+            char *arg = malloc(32);
+
+            snprintf(arg, 32, "--option-%zu%s", n, n % 3 ? "" : "=1");
+            given_keys[argc - 1] = option_key(n);
+            bench_argv[argc++] = arg;
+        }
+    bench_argv[argc] = NULL;
+}
+
+/* Return COUNT constraints that hold for BENCH_ARGV: every kind in turn,
+   each naming two to five options.  */
+static struct argp_constraint *
+make_constraints(size_t count)
+{
+    struct argp_constraint *constraints = calloc(count + 1,
+                                                 sizeof *constraints);
+    unsigned seed = 45;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        unsigned nkeys = 2 + bench_rand(&seed) % 4, k;
+        int *keys = calloc(nkeys + 1, sizeof *keys);
+
+        for (k = 0; k < nkeys; k++)
+            keys[k] = unused_key(&seed);
+
+        switch (i % 4) {
+        case 0:
+            constraints[i].type = ARGP_CONFLICTS;
+            /* At most one option of a conflict is given.  */
+            if (i % 8 == 0)
+                keys[0] = given_key(&seed);
+            break;
+        case 1:
+            constraints[i].type = ARGP_REQUIRES;
+            /* Given, and so are the options it requires.  */
+            if (i % 8 == 1)
+                for (k = 0; k < nkeys; k++)
+                    keys[k] = given_key(&seed);
+            break;
+        case 2:
+            constraints[i].type = ARGP_AT_LEAST_ONE;
+            keys[nkeys - 1] = given_key(&seed);
+            break;
+        default:
+            constraints[i].type = ARGP_EXACTLY_ONE;
+            keys[bench_rand(&seed) % nkeys] = given_key(&seed);
+            break;
+        }
+        constraints[i].keys = keys;
+    }
+
+    return constraints;
+}
+
+static double
+time_parse(struct argp *argp, unsigned iterations)
+{
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        if (argp_parse(argp, BENCH_GIVEN + 1, bench_argv, 0, NULL, NULL)) {
+            fprintf(stderr, "bench: a constraint didn't hold\n");
+            exit(EXIT_FAILURE);
+        }
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t counts[] = { 0, 100, 1000, 10000, 100000, 1000000 };
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+    struct argp *argp = bench_make_argp(BENCH_OPTIONS, 1, 20);
+    /* The constraints go to the only child, which has the options.  */
+    struct argp *child = (struct argp *) argp->children[0].argp;
+    /* Its options end after its group header and BENCH_OPTIONS options.  */
+    struct argp_option *end =
+        (struct argp_option *) child->options + BENCH_OPTIONS + 1;
+    struct argp_extension extension = { sizeof extension, NULL, NULL, NULL };
+    double none = 0;
+    size_t i;
+
+    child->parser = accept_parser;
+    end->arg = (const char *) &extension;
+    end->flags = OPTION_EXTENSION;
+    make_command_line();
+
+    printf("%12s %12s %12s\n", "constraints", "parse us", "added us");
+
+    for (i = 0; i < sizeof counts / sizeof counts[0]; i++) {
+        double t;
+
+        extension.constraints = counts[i] ? make_constraints(counts[i]) : NULL;
+        t = time_parse(argp, iterations);
+        if (!counts[i])
+            none = t;
+        printf("%12zu %12.1f %12.1f\n", counts[i], t / 1e3, (t - none) / 1e3);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/* Benchmark for child argps shared by many parents.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+
+/* Usage: argp-dag-bench [ITERATIONS]
+
+   For a block of 500 options used under a growing number of parents, as
+   a program might use its logging options in each of its parts, times
+   argp_parse and --help two ways:
+
+     copies      every parent has its own copy of the block, which is what
+                 a shared one used to cost, converted and listed each time
+     shared      every parent has the same block, whose options are only
+                 converted and listed once
+
+   and prints microseconds per call.  */
+
+#include "win-argp-config.h"
+
+#include "bench-common.h"
+
+#define BLOCK_OPTIONS 500
+
+static error_t
+accept_parser(int key, char *arg, struct argp_state *state)
+{
+    (void) key;
+    (void) arg;
+    (void) state;
+    return 0;
+}
+
+/* Return a program with PARENTS parts, each with BLOCKS[I] as its child.  */
+static struct argp *
+make_program(size_t parents, const struct argp **blocks)
+{
+    struct argp *root = calloc(1, sizeof *root);
+    struct argp_child *children = calloc(parents + 1, sizeof *children);
+    size_t i;
+
+    for (i = 0; i < parents; i++) {
+        struct argp *part = calloc(1, sizeof *part);
+        struct argp_child *part_children = calloc(2, sizeof *part_children);
+        char *header = malloc(32);
+
+        snprintf(header, 32, "Part %zu:", i);
+        part_children[0].argp = blocks[i];
+        part_children[0].header = header;
+        part->parser = accept_parser;
+        part->children = part_children;
+        children[i].argp = part;
+    }
+    root->parser = accept_parser;
+    root->children = children;
+
+    return root;
+}
+
+/* Return a block of logging options, and its parser.  */
+static const struct argp *
+make_block(void)
+{
+    struct argp *block = bench_make_argp(BLOCK_OPTIONS, 1, 20);
+    struct argp *options = (struct argp *) block->children[0].argp;
+
+    options->parser = accept_parser;
+    return options;
+}
+
+static double
+time_parse(const struct argp *argp, unsigned iterations)
+{
+    char *argv[] = { (char *) "bench", (char *) "--option-1", NULL };
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        if (argp_parse(argp, 2, argv, ARGP_NO_EXIT, NULL, NULL)) {
+            fprintf(stderr, "bench: argp_parse failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+static double
+time_help(const struct argp *argp, unsigned iterations, size_t *bytes)
+{
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        *bytes = argp_help_to_buffer(argp, NULL, 0, ARGP_HELP_STD_HELP,
+                                     "bench");
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    /* Long options only have room for 127 groups, two for each part.  */
+    static const size_t counts[] = { 1, 10, 30, 60 };
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+    const struct argp *shared = make_block();
+    size_t i;
+
+    printf("%8s %12s %12s %12s %12s %10s %10s\n", "parents",
+           "copies parse", "shared parse", "copies help", "shared help",
+           "copies KB", "shared KB");
+
+    for (i = 0; i < sizeof counts / sizeof counts[0]; i++) {
+        size_t parents = counts[i], c, copies_bytes, shared_bytes;
+        unsigned iters = iterations ? iterations
+                         : (unsigned) (200 / parents + 5);
+        const struct argp **blocks = malloc(parents * sizeof *blocks);
+        struct argp *copies_argp, *shared_argp;
+        double copies_parse, shared_parse, copies_help, shared_help;
+
+        for (c = 0; c < parents; c++)
+            blocks[c] = make_block();
+        copies_argp = make_program(parents, blocks);
+        for (c = 0; c < parents; c++)
+            blocks[c] = shared;
+        shared_argp = make_program(parents, blocks);
+
+        copies_parse = time_parse(copies_argp, iters);
+        shared_parse = time_parse(shared_argp, iters);
+        copies_help = time_help(copies_argp, iters, &copies_bytes);
+        shared_help = time_help(shared_argp, iters, &shared_bytes);
+
+        printf("%8zu %12.1f %12.1f %12.1f %12.1f %10zu %10zu\n", parents,
+               copies_parse / 1e3, shared_parse / 1e3, copies_help / 1e3,
+               shared_help / 1e3, copies_bytes / 1024, shared_bytes / 1024);
+        free(blocks);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,291 @@
+/* Benchmark for the phases of argp help rendering.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* Times every phase of help rendering for synthetic argp trees of growing
+   size, and prints the results as JSON:
+
+     hol_build   argp_hol, turning the argp tree into a HOL
+     hol_sort    hol_sort on the result
+     usage       hol_usage on the sorted HOL
+     help        a complete ARGP_HELP_STD_HELP message, end to end
+     fmtstream   wrapping a single paragraph as long as all the option docs
+
+   Times are nanoseconds per call; the sizes double from --min-options to
+   --max-options, so a time that grows faster than the size shows where
+   behaviour turns quadratic.  The help internals are static, so this file
+   is built together with the argp sources instead of linking the library.  */
+
+#include "../argp-help.c"
+
+#include "bench-common.h"
+
+#define PROG_NAME "bench"
+
+/* Settings from the command line.  */
+struct bench_args
+{
+    struct bench_tree_params tree;
+    size_t min_options;
+    size_t max_options;
+    unsigned iterations;        /* Or 0 to pick a count for each size.  */
+};
+
+static struct argp_option bench_options[] = {
+    { "min-options", 'm', "N", 0, "Smallest tree in the sweep (default 64)", 0 },
+    { "max-options", 'M', "N", 0, "Largest tree in the sweep (default 16384)", 0 },
+    { "options", 'n', "N", 0, "Only measure a tree of N options", 0 },
+    { "depth", 'd', "N", 0, "Levels of child parsers (default 2)", 0 },
+    { "fanout", 'f', "N", 0, "Children of each parser (default 4)", 0 },
+    { "alias-density", 'a', "PCT", 0,
+      "Percentage of options that are aliases (default 20)", 0 },
+    { "doc-length", 'l', "N", 0,
+      "Average length of option docs (default 60)", 0 },
+    { "doc-options", 'D', "PCT", 0,
+      "Percentage of OPTION_DOC entries (default 5)", 0 },
+    { "iterations", 'i', "N", 0,
+      "Repetitions of each measurement (default: by size)", 0 },
+    { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+static error_t
+bench_parse(int key, char *arg, struct argp_state *state)
+{
+    struct bench_args *args = state->input;
+    unsigned long val = arg ? strtoul(arg, NULL, 10) : 0;
+
+    switch (key) {
+    case 'm':
+        args->min_options = val;
+        break;
+    case 'M':
+        args->max_options = val;
+        break;
+    case 'n':
+        args->min_options = args->max_options = val;
+        break;
+    case 'd':
+        args->tree.depth = val;
+        break;
+    case 'f':
+        args->tree.fanout = val;
+        break;
+    case 'a':
+        args->tree.alias_pct = val;
+        break;
+    case 'l':
+        args->tree.doc_len = val;
+        break;
+    case 'D':
+        args->tree.doc_opt_pct = val;
+        break;
+    case 'i':
+        args->iterations = val;
+        break;
+    case ARGP_KEY_END:
+        if (!args->min_options || args->min_options > args->max_options)
+            argp_error(state, "bad option count range");
+        if (args->tree.alias_pct + args->tree.doc_opt_pct > 100)
+            argp_error(state, "alias and doc option percentages exceed 100");
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+
+    return 0;
+}
+
+static struct argp bench_argp = {
+    bench_options, bench_parse, NULL,
+    "Time the phases of argp help rendering on synthetic parsers.",
+    NULL, NULL, NULL
+};
+
+/* An argp_help_write_fn that only counts.  */
+static size_t
+count_write(void *cookie, const char *data, size_t len)
+{
+    (void) data;
+    *(size_t *) cookie += len;
+    return len;
+}
+
+/* Results for one tree size, in nanoseconds per call.  */
+struct bench_result
+{
+    size_t options;
+    double hol_build, hol_sort, usage, help, fmtstream;
+    size_t usage_bytes, help_bytes, fmtstream_bytes;
+};
+
+static void
+measure_hol(const struct argp *argp, unsigned iterations,
+            struct bench_result *res)
+{
+    double build = 0, sort = 0;
+    unsigned i;
+
+    for (i = 0; i < iterations; i++) {
+        double t0 = bench_now_ns(), t1, t2;
+        struct hol *hol = argp_hol(argp);
+
+        t1 = bench_now_ns();
+        hol_set_group(hol, "help", -1);
+        hol_set_group(hol, "version", -1);
+        hol_sort(hol);
+        t2 = bench_now_ns();
+        hol_free(hol);
+
+        build += t1 - t0;
+        sort += t2 - t1;
+    }
+
+    res->hol_build = build / iterations;
+    res->hol_sort = sort / iterations;
+}
+
+static void
+measure_usage(const struct argp *argp, unsigned iterations,
+              struct bench_result *res)
+{
+    struct argp_help_context ctx;
+    struct hol *hol = argp_help_hol(argp);
+    double start;
+    unsigned i;
+
+    help_context_init(&ctx, argp, 0);
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++) {
+        argp_fmtstream_t fs;
+
+        res->usage_bytes = 0;
+        fs = __argp_make_fmtstream_fn(count_write, &res->usage_bytes,
+                                      0, ctx.uparams.rmargin, 0);
+        __argp_fmtstream_set_wmargin(fs, ctx.uparams.usage_indent);
+        __argp_fmtstream_set_lmargin(fs, ctx.uparams.usage_indent);
+        hol_usage(hol, &ctx, fs);
+        __argp_fmtstream_free(fs);
+    }
+    res->usage = (bench_now_ns() - start) / iterations;
+
+    hol_free(hol);
+}
+
+static void
+measure_help(const struct argp *argp, unsigned iterations,
+             struct bench_result *res)
+{
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++) {
+        res->help_bytes = 0;
+        __argp_help_to_callback(argp, count_write, &res->help_bytes,
+                                ARGP_HELP_STD_HELP & ~ARGP_HELP_EXIT_OK,
+                                PROG_NAME);
+    }
+    res->help = (bench_now_ns() - start) / iterations;
+}
+
+/* Wrap one paragraph of LEN bytes the way an option's doc is wrapped.  */
+static void
+measure_fmtstream(size_t len, unsigned iterations, struct bench_result *res)
+{
+    unsigned seed = 1;
+    char *text = bench_make_doc(&seed, len);
+    size_t text_len = strlen(text);
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++) {
+        size_t bytes = 0;
+        argp_fmtstream_t fs = __argp_make_fmtstream_fn(count_write, &bytes,
+                                                       0, RMARGIN, 0);
+
+        __argp_fmtstream_set_lmargin(fs, OPT_DOC_COL);
+        __argp_fmtstream_set_wmargin(fs, OPT_DOC_COL);
+        __argp_fmtstream_write(fs, text, text_len);
+        __argp_fmtstream_free(fs);
+        res->fmtstream_bytes = bytes;
+    }
+    res->fmtstream = (bench_now_ns() - start) / iterations;
+
+    free(text);
+}
+
+static void
+print_result(const struct bench_result *res, int last)
+{
+    printf("    { \"options\": %zu,\n"
+           "      \"hol_build_ns\": %.0f, \"hol_sort_ns\": %.0f,\n"
+           "      \"usage_ns\": %.0f, \"usage_bytes\": %zu,\n"
+           "      \"help_ns\": %.0f, \"help_bytes\": %zu,\n"
+           "      \"help_ns_per_option\": %.1f,\n"
+           "      \"fmtstream_ns\": %.0f, \"fmtstream_bytes\": %zu,\n"
+           "      \"fmtstream_mb_per_s\": %.1f }%s\n",
+           res->options, res->hol_build, res->hol_sort,
+           res->usage, res->usage_bytes,
+           res->help, res->help_bytes, res->help / res->options,
+           res->fmtstream, res->fmtstream_bytes,
+           res->fmtstream ? res->fmtstream_bytes * 1e3 / res->fmtstream : 0.0,
+           last ? "" : ",");
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_args args = {
+        { 0, 2, 4, 20, 60, 5 }, 64, 16384, 0
+    };
+    size_t n;
+
+    argp_parse(&bench_argp, argc, argv, 0, 0, &args);
+
+    printf("{\n"
+           "  \"depth\": %u, \"fanout\": %u, \"alias_pct\": %u,\n"
+           "  \"doc_len\": %zu, \"doc_opt_pct\": %u,\n"
+           "  \"results\": [\n",
+           args.tree.depth, args.tree.fanout, args.tree.alias_pct,
+           args.tree.doc_len, args.tree.doc_opt_pct);
+
+    for (n = args.min_options; n <= args.max_options; n *= 2) {
+        struct bench_result res;
+        struct argp *argp;
+        unsigned iterations = args.iterations ? args.iterations
+                              : (unsigned) (65536 / n + 3);
+
+        memset(&res, 0, sizeof res);
+        res.options = n;
+        args.tree.options = n;
+        argp = bench_make_tree(&args.tree);
+
+        measure_hol(argp, iterations, &res);
+        measure_usage(argp, iterations, &res);
+        measure_help(argp, iterations, &res);
+        measure_fmtstream(n * args.tree.doc_len, iterations, &res);
+
+        print_result(&res, n * 2 > args.max_options);
+        fflush(stdout);
+    }
+
+    printf("  ]\n}\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+/* Benchmark for argp_help_stream.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* Usage: argp-help-stream-bench [OPTIONS [GROUPS [ITERATIONS]]]
+
+   Renders the help of a synthetic parser to the null device in five ways:
+   the classic argp_help, an unbounded argp_help_stream, a stream cut after
+   the first byte (time to first byte), one cut after 4KiB, which is what
+   `prog --help | head' costs, and argp_help_to_fd straight to the file
+   descriptor.  On POSIX systems every mode runs in its own
+   child process so that the reported peak RSS belongs to that mode alone.  */
+
+#include "win-argp-config.h"
+
+#include "bench-common.h"
+
+#define PROG_NAME "bench"
+
+enum bench_mode
+{
+    MODE_HELP,
+    MODE_STREAM,
+    MODE_FIRST_BYTE,
+    MODE_HEAD,
+    MODE_FD,
+    MODE_COUNT
+};
+
+static const char *const mode_names[MODE_COUNT] = {
+    "argp_help",
+    "argp_help_stream",
+    "stream first byte",
+    "stream head 4KiB",
+    "argp_help_to_fd",
+};
+
+static void
+run_mode(enum bench_mode mode, const struct argp *argp, unsigned iterations)
+{
+    FILE *out = fopen(BENCH_NULL_DEVICE, "w");
+    size_t bytes = 0;
+    double start, elapsed;
+    unsigned i;
+
+    if (!out) {
+        perror(BENCH_NULL_DEVICE);
+        exit(EXIT_FAILURE);
+    }
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++) {
+        switch (mode) {
+        case MODE_HELP:
+            argp_help(argp, out, ARGP_HELP_STD_HELP, PROG_NAME);
+            break;
+        case MODE_STREAM:
+            bytes = argp_help_stream(argp, out, ARGP_HELP_STD_HELP,
+                                     PROG_NAME, 0);
+            break;
+        case MODE_FIRST_BYTE:
+            bytes = argp_help_stream(argp, out, ARGP_HELP_STD_HELP,
+                                     PROG_NAME, 1);
+            break;
+        case MODE_HEAD:
+            bytes = argp_help_stream(argp, out, ARGP_HELP_STD_HELP,
+                                     PROG_NAME, 4096);
+            break;
+        case MODE_FD:
+            bytes = argp_help_to_fd(argp, fileno(out), ARGP_HELP_STD_HELP,
+                                    PROG_NAME);
+            break;
+        default:
+            break;
+        }
+    }
+    fflush(out);
+    elapsed = bench_now_ns() - start;
+    fclose(out);
+
+    printf("%-20s %12.1f us/call", mode_names[mode], elapsed / iterations / 1e3);
+    if (mode == MODE_HELP)
+        printf(" %16s", "");
+    else
+        printf(" %10zu bytes", bytes);
+    printf(" %10ld KiB peak RSS\n", bench_peak_rss_kb());
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t noptions = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+    size_t ngroups = argc > 2 ? strtoul(argv[2], NULL, 10) : 20;
+    unsigned iterations = argc > 3 ? strtoul(argv[3], NULL, 10) : 20;
+    struct argp *argp;
+    int mode;
+
+    if (!noptions || !ngroups || !iterations) {
+        fprintf(stderr, "usage: %s [OPTIONS [GROUPS [ITERATIONS]]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    argp = bench_make_argp(noptions, ngroups, 60);
+    printf("%zu options in %zu groups, %u iterations\n",
+           noptions, ngroups, iterations);
+    fflush(stdout);
+
+    for (mode = 0; mode < MODE_COUNT; mode++) {
+#if _WIN32
+        run_mode(mode, argp, iterations);
+#else
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (pid == 0) {
+            run_mode(mode, argp, iterations);
+            _exit(EXIT_SUCCESS);
+        }
+        waitpid(pid, NULL, 0);
+#endif
+    }
+
+    return EXIT_SUCCESS;
+}
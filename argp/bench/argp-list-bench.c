@@ -0,0 +1,195 @@
+/* Benchmark for list options.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* Usage: argp-list-bench [ITERATIONS]
+
+   Parses `--ids=N,N,...' and `--names=NAME,NAME,...' with lists of growing
+   length, up to several megabytes, two ways each:
+
+     strtok      what a parser does by hand: strtok and strtoll into an
+                 array grown by doubling, and strdup for the names, which
+                 strtok would otherwise destroy
+     bind        an ARGP_BIND_INT64 or ARGP_BIND_SLICE list binding
+
+   and prints milliseconds per parse, including argp_parse itself.  */
+
+#include "win-argp-config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bench-common.h"
+
+struct bench_args
+{
+    struct argp_list ids;
+    struct argp_list names;
+};
+
+static struct argp_option bench_options[] = {
+    { "ids", 'i', "N,...", 0, "Use the Ns", 0 },
+    { "names", 'n', "NAME,...", 0, "Use the NAMEs", 0 },
+    { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+/* The hand-written way.  */
+static error_t
+strtok_parser(int key, char *arg, struct argp_state *state)
+{
+    struct bench_args *args = state->input;
+    struct argp_list *list;
+    size_t size, alloced = 0;
+    char *copy, *tok;
+
+    switch (key) {
+    case 'i':
+        list = &args->ids;
+        size = sizeof(int64_t);
+        copy = strdup(arg);
+        break;
+    case 'n':
+        list = &args->names;
+        size = sizeof(char *);
+        /* Keep it, since the names point into it.  */
+        copy = strdup(arg);
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+
+    for (tok = strtok(copy, ","); tok; tok = strtok(NULL, ",")) {
+        if (list->count == alloced) {
+            alloced = alloced ? 2 * alloced : 16;
+            list->items = realloc(list->items, alloced * size);
+        }
+        if (key == 'i')
+            ((int64_t *) list->items)[list->count++] = strtoll(tok, NULL, 0);
+        else
+            ((char **) list->items)[list->count++] = tok;
+    }
+    if (key == 'i')
+        free(copy);
+
+    return 0;
+}
+
+static struct argp strtok_argp = {
+    bench_options, strtok_parser, NULL, NULL, NULL, NULL, NULL
+};
+
+static const struct argp_binding bench_bindings[] = {
+    { 'i', ARGP_BIND_INT64 | ARGP_BIND_LIST,
+      offsetof(struct bench_args, ids), 0 },
+    { 'n', ARGP_BIND_SLICE | ARGP_BIND_LIST,
+      offsetof(struct bench_args, names), 0 },
+    { 0, 0, 0, 0 }
+};
+
+static const struct argp_extension bench_extension = {
+    sizeof(struct argp_extension), bench_bindings, NULL, NULL
+};
+
+/* The same options, bound.  */
+static struct argp_option bind_options[] = {
+    { "ids", 'i', "N,...", 0, "Use the Ns", 0 },
+    { "names", 'n', "NAME,...", 0, "Use the NAMEs", 0 },
+    ARGP_OPTION_EXTENSION(&bench_extension)
+};
+
+static struct argp bind_argp = {
+    bind_options, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+/* Return "--ids=" followed by COUNT numbers, or "--names=" followed by
+   COUNT names, with commas between.  */
+static char *
+make_list(const char *option, size_t count, int names)
+{
+    size_t len = strlen(option), i;
+    char *arg = malloc(len + count * 12 + 1), *p = arg + len;
+    unsigned r = 1;
+
+    memcpy(arg, option, len);
+    for (i = 0; i < count; i++) {
+        r = r * 1103515245 + 12345;
+        if (names)
+            p += sprintf(p, "%sname%u", i ? "," : "", r % 1000);
+        else
+            p += sprintf(p, "%s%u", i ? "," : "", r % 100000000);
+    }
+    *p = '\0';
+
+    return arg;
+}
+
+static double
+time_parse(struct argp *argp, char *arg, size_t count, unsigned iterations)
+{
+    char *argv[] = { (char *) "bench", arg, NULL };
+    double start = bench_now_ns();
+    struct bench_args args;
+    unsigned i;
+
+    for (i = 0; i < iterations; i++) {
+        memset(&args, 0, sizeof args);
+        argp_parse(argp, 2, argv, 0, NULL, &args);
+        if (args.ids.count + args.names.count != count) {
+            fprintf(stderr, "bench: parsed %zu values, not %zu\n",
+                    args.ids.count + args.names.count, count);
+            exit(EXIT_FAILURE);
+        }
+        if (argp == &strtok_argp && args.names.count)
+            free(((char **) args.names.items)[0]);
+        free(args.ids.items);
+        free(args.names.items);
+    }
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t counts[] = { 100, 10000, 100000, 1000000 };
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+    size_t i;
+
+    printf("%10s %10s %12s %12s %12s %12s\n", "values", "bytes",
+           "ids strtok", "ids bind", "names strtok", "names bind");
+
+    for (i = 0; i < sizeof counts / sizeof counts[0]; i++) {
+        size_t count = counts[i];
+        unsigned iters = iterations ? iterations
+                         : (unsigned) (2000000 / count + 1);
+        char *ids = make_list("--ids=", count, 0);
+        char *names = make_list("--names=", count, 1);
+
+        printf("%10zu %10zu %12.3f %12.3f %12.3f %12.3f\n",
+               count, strlen(ids),
+               time_parse(&strtok_argp, ids, count, iters) / 1e6,
+               time_parse(&bind_argp, ids, count, iters) / 1e6,
+               time_parse(&strtok_argp, names, count, iters) / 1e6,
+               time_parse(&bind_argp, names, count, iters) / 1e6);
+        free(ids);
+        free(names);
+    }
+
+    return EXIT_SUCCESS;
+}
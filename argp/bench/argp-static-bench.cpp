@@ -0,0 +1,169 @@
+/* Benchmark for compile-time option tables against argp_parse.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* Usage: argp-static-bench [ITERATIONS]
+
+   Parses the same command line of a program with 16 options three ways:
+
+     c-parser    argp_parse with a hand-written parser, the usual C way
+     argp_of     argp_parse with win_argp::argp_of, the table's own parser
+     static      win_argp::parse, which needs no argp_parse at all
+
+   and prints nanoseconds per parse.  */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "argp-static.hpp"
+
+struct config
+{
+    bool verbose, quiet, dry_run, force, keep, recursive;
+    int jobs, level, retries, port;
+    long timeout;
+    unsigned long limit;
+    double scale, ratio;
+    const char *output, *host;
+};
+
+inline constexpr auto config_options = win_argp::options(
+    "FILE...", "Benchmark program.",
+    win_argp::option(&config::verbose, "verbose", 'v', nullptr, 0, "Say more"),
+    win_argp::option(&config::quiet, "quiet", 'q', nullptr, 0, "Say less"),
+    win_argp::option(&config::dry_run, "dry-run", 'n', nullptr, 0,
+                     "Do nothing"),
+    win_argp::option(&config::force, "force", 'f', nullptr, 0, "Just do it"),
+    win_argp::option(&config::keep, "keep", 'k', nullptr, 0, "Keep going"),
+    win_argp::option(&config::recursive, "recursive", 'r', nullptr, 0,
+                     "Recurse"),
+    win_argp::option(&config::jobs, "jobs", 'j', "N", 0, "Run N jobs"),
+    win_argp::option(&config::level, "level", 'l', "N", 0, "Level N"),
+    win_argp::option(&config::retries, "retries", 'R', "N", 0, "Retry N times"),
+    win_argp::option(&config::port, "port", 'p', "PORT", 0, "Connect to PORT"),
+    win_argp::option(&config::timeout, "timeout", 't', "MS", 0,
+                     "Give up after MS"),
+    win_argp::option(&config::limit, "limit", 'L', "N", 0, "Stop at N"),
+    win_argp::option(&config::scale, "scale", 's', "X", 0, "Scale by X"),
+    win_argp::option(&config::ratio, "ratio", 0x100, "X", 0, "Keep ratio X"),
+    win_argp::option(&config::output, "output", 'o', "FILE", 0,
+                     "Write to FILE"),
+    win_argp::option(&config::host, "host", 'H', "HOST", 0,
+                     "Connect to HOST"));
+
+static error_t
+config_parser(int key, char *arg, struct argp_state *state)
+{
+    struct config *cfg = (struct config *) state->input;
+
+    switch (key) {
+    case 'v': cfg->verbose = true; break;
+    case 'q': cfg->quiet = true; break;
+    case 'n': cfg->dry_run = true; break;
+    case 'f': cfg->force = true; break;
+    case 'k': cfg->keep = true; break;
+    case 'r': cfg->recursive = true; break;
+    case 'j': cfg->jobs = (int) strtol(arg, NULL, 0); break;
+    case 'l': cfg->level = (int) strtol(arg, NULL, 0); break;
+    case 'R': cfg->retries = (int) strtol(arg, NULL, 0); break;
+    case 'p': cfg->port = (int) strtol(arg, NULL, 0); break;
+    case 't': cfg->timeout = strtol(arg, NULL, 0); break;
+    case 'L': cfg->limit = strtoul(arg, NULL, 0); break;
+    case 's': cfg->scale = strtod(arg, NULL); break;
+    case 0x100: cfg->ratio = strtod(arg, NULL); break;
+    case 'o': cfg->output = arg; break;
+    case 'H': cfg->host = arg; break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static struct argp c_argp = {
+    config_options.options.data(), config_parser, "FILE...",
+    "Benchmark program.", NULL, NULL, NULL
+};
+
+static char *bench_argv[] = {
+    (char *) "bench", (char *) "-vk", (char *) "--jobs=8", (char *) "-l",
+    (char *) "3", (char *) "--retries", (char *) "5", (char *) "--port=8080",
+    (char *) "-t1500", (char *) "--limit=100000", (char *) "--scale=1.5",
+    (char *) "--ratio=0.25", (char *) "--output", (char *) "out.txt",
+    (char *) "--host=example.org", (char *) "--dry-run", (char *) "--force",
+    NULL
+};
+
+static const int bench_argc = sizeof bench_argv / sizeof bench_argv[0] - 1;
+
+enum method { C_PARSER, ARGP_OF, STATIC };
+
+/* Monotonic time in nanoseconds.  bench-common.h is C only.  */
+static double
+bench_now_ns()
+{
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double
+time_parse(enum method method, unsigned iterations)
+{
+    double start = bench_now_ns();
+    unsigned i;
+    struct config cfg;
+    int index;
+
+    for (i = 0; i < iterations; i++) {
+        memset(&cfg, 0, sizeof cfg);
+        switch (method) {
+        case C_PARSER:
+            argp_parse(&c_argp, bench_argc, bench_argv, 0, &index, &cfg);
+            break;
+        case ARGP_OF:
+            argp_parse(&win_argp::argp_of<config_options>, bench_argc,
+                       bench_argv, 0, &index, &cfg);
+            break;
+        case STATIC:
+            win_argp::parse<config_options>(bench_argc, bench_argv, 0, &index,
+                                            &cfg);
+            break;
+        }
+        if (cfg.jobs != 8 || cfg.ratio != 0.25 || !cfg.force) {
+            fprintf(stderr, "bench: parse %d went wrong\n", (int) method);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+
+    printf("%14s %14s %14s\n", "c-parser ns", "argp_of ns", "static ns");
+    printf("%14.1f %14.1f %14.1f\n",
+           time_parse(C_PARSER, iterations), time_parse(ARGP_OF, iterations),
+           time_parse(STATIC, iterations));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+/* Benchmark for "did you mean" suggestions.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+
+/* Usage: argp-suggest-bench [MISSES]
+
+   For synthetic parsers of growing size, times the suggestions for an
+   unknown long option two ways:
+
+     naive       the textbook dynamic programming edit distance against
+                 every name, keeping the nearest three
+     suggest     argp_iter_suggest, bit-parallel with an early cutoff
+
+   for two kinds of misses: typos, one to three random edits away from an
+   option's name, and junk, random letters near nothing.  Prints
+   microseconds per miss, and checks that both ways find options equally
+   near.  */
+
+#include "win-argp-config.h"
+
+#include "bench-common.h"
+
+#define SUGGESTIONS 3
+
+/* Add the long names of ARGP and its children to NAMES, counting them in
+   *COUNT.  */
+static void
+collect_names(const struct argp *argp, const char **names, size_t *count)
+{
+    const struct argp_option *opt;
+    const struct argp_child *child;
+
+    for (opt = argp->options; opt && (opt->key || opt->name || opt->doc);
+         opt++)
+        if (opt->name)
+            names[(*count)++] = opt->name;
+    for (child = argp->children; child && child->argp; child++)
+        collect_names(child->argp, names, count);
+}
+
+/* The edit distance between A and B, the textbook way.  ROW has room for
+   strlen(B) + 1 values.  */
+static unsigned
+naive_distance(const char *a, const char *b, unsigned *row)
+{
+    size_t m = strlen(a), n = strlen(b), i, j;
+
+    for (j = 0; j <= n; j++)
+        row[j] = (unsigned) j;
+    for (i = 1; i <= m; i++) {
+        unsigned diag = row[0];
+
+        row[0] = (unsigned) i;
+        for (j = 1; j <= n; j++) {
+            unsigned up = row[j], best = diag + (a[i - 1] != b[j - 1]);
+
+            if (up + 1 < best)
+                best = up + 1;
+            if (row[j - 1] + 1 < best)
+                best = row[j - 1] + 1;
+            diag = up;
+            row[j] = best;
+        }
+    }
+
+    return row[n];
+}
+
+/* Store the distances of the SUGGESTIONS names nearest to ARG, within the
+   bound argp uses, in DISTS, nearest first, and return how many.  */
+static size_t
+naive_suggest(const char *arg, const char **names, size_t count,
+              unsigned *dists)
+{
+    size_t len = strlen(arg), found = 0, i, k;
+    unsigned bound = (unsigned) (len + 2) / 3, row[128];
+
+    if (bound > 3)
+        bound = 3;
+    for (i = 0; i < count; i++) {
+        unsigned dist = naive_distance(arg, names[i], row);
+
+        if (dist > bound)
+            continue;
+        if (found == SUGGESTIONS) {
+            if (dists[found - 1] <= dist)
+                continue;
+            found--;
+        }
+        for (k = found; k > 0 && dists[k - 1] > dist; k--)
+            dists[k] = dists[k - 1];
+        dists[k] = dist;
+        found++;
+    }
+
+    return found;
+}
+
+/* Return a malloced miss: NAME with one to three random edits, or if NAME
+   is NULL, ten random letters.  */
+static char *
+make_miss(const char *name, unsigned *seed)
+{
+    char *miss = malloc(64);
+    size_t len, i;
+    unsigned edits;
+
+    if (!name) {
+        for (i = 0; i < 10; i++)
+            miss[i] = (char) ('a' + bench_rand(seed) % 26);
+        miss[10] = '\0';
+        return miss;
+    }
+
+    strcpy(miss, name);
+    for (edits = 1 + bench_rand(seed) % 3; edits > 0; edits--) {
+        len = strlen(miss);
+        i = bench_rand(seed) % len;
+        switch (bench_rand(seed) % 3) {
+        case 0:
+            miss[i] = (char) ('a' + bench_rand(seed) % 26);
+            break;
+        case 1:
+            memmove(miss + i + 1, miss + i, len - i + 1);
+            miss[i] = (char) ('a' + bench_rand(seed) % 26);
+            break;
+        default:
+            if (len > 1)
+                memmove(miss + i, miss + i + 1, len - i);
+            break;
+        }
+    }
+
+    return miss;
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t sizes[] = { 100, 1000, 10000, 30000 };
+    unsigned misses = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+    char *args[] = { (char *) "bench", NULL };
+    size_t i;
+
+    printf("%10s %6s %12s %12s\n", "options", "miss", "naive us",
+           "suggest us");
+
+    for (i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+        size_t noptions = sizes[i], count = 0, m;
+        /* Long options only have room for 127 groups.  */
+        struct argp *argp = bench_make_argp(noptions, 1 + noptions / 1000, 20);
+        const char **names = malloc(noptions * sizeof(*names));
+        struct argp_iter *iter = argp_iter_begin(argp, 1, args, 0);
+        char **miss = malloc(misses * sizeof(*miss));
+        int junk;
+
+        if (!iter) {
+            fprintf(stderr, "bench: argp_iter_begin failed\n");
+            return EXIT_FAILURE;
+        }
+        collect_names(argp, names, &count);
+
+        for (junk = 0; junk < 2; junk++) {
+            unsigned seed = 47, dists[SUGGESTIONS], row[128];
+            const char *found[SUGGESTIONS];
+            double naive_ns, suggest_ns, start;
+            size_t n, k;
+
+            for (m = 0; m < misses; m++)
+                miss[m] = make_miss(junk ? NULL
+                                    : names[bench_rand(&seed) % count],
+                                    &seed);
+
+            start = bench_now_ns();
+            for (m = 0; m < misses; m++)
+                naive_suggest(miss[m], names, count, dists);
+            naive_ns = bench_now_ns() - start;
+
+            start = bench_now_ns();
+            for (m = 0; m < misses; m++)
+                argp_iter_suggest(iter, miss[m], found, SUGGESTIONS);
+            suggest_ns = bench_now_ns() - start;
+
+            /* The two must agree on how near the suggestions are.  */
+            for (m = 0; m < misses; m++) {
+                n = naive_suggest(miss[m], names, count, dists);
+                if (argp_iter_suggest(iter, miss[m], found, SUGGESTIONS) != n) {
+                    fprintf(stderr, "bench: wrong count for `%s'\n", miss[m]);
+                    return EXIT_FAILURE;
+                }
+                for (k = 0; k < n; k++)
+                    if (naive_distance(miss[m], found[k], row) != dists[k]) {
+                        fprintf(stderr, "bench: `%s' isn't as near `%s'\n",
+                                found[k], miss[m]);
+                        return EXIT_FAILURE;
+                    }
+                free(miss[m]);
+            }
+
+            printf("%10zu %6s %12.2f %12.2f\n", noptions,
+                   junk ? "junk" : "typo", naive_ns / misses / 1e3,
+                   suggest_ns / misses / 1e3);
+        }
+
+        argp_iter_end(iter);
+        free(miss);
+        free(names);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+/* Benchmark for usage line generation.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+/* Usage: argp-usage-bench [ITERATIONS]
+
+   Times the full `Usage:' message (ARGP_HELP_USAGE) and the short one that
+   argp_usage prints on every parse error (ARGP_HELP_STD_USAGE, without the
+   exit) for synthetic parsers of growing size.  The text is rendered into a
+   memory buffer so that no stdio cost is included.  */
+
+#include "win-argp-config.h"
+
+#include "bench-common.h"
+
+#define PROG_NAME "bench"
+
+static double
+time_usage(const struct argp *argp, unsigned flags, char *buf, size_t size,
+           unsigned iterations)
+{
+    double start = bench_now_ns();
+    unsigned i;
+
+    for (i = 0; i < iterations; i++)
+        argp_help_to_buffer(argp, buf, size, flags, PROG_NAME);
+
+    return (bench_now_ns() - start) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t sizes[] = { 10, 100, 1000, 10000, 50000 };
+    unsigned iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+    size_t i;
+
+    printf("%10s %10s %14s %14s\n",
+           "options", "bytes", "usage us", "std-usage us");
+
+    for (i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+        size_t noptions = sizes[i];
+        struct argp *argp = bench_make_argp(noptions, 1 + noptions / 100, 20);
+        unsigned iters = iterations ? iterations
+                         : (unsigned) (200000 / noptions + 1);
+        size_t size = argp_help_to_buffer(argp, NULL, 0, ARGP_HELP_USAGE,
+                                          PROG_NAME) + 1;
+        char *buf = malloc(size);
+        double usage, std_usage;
+
+        usage = time_usage(argp, ARGP_HELP_USAGE, buf, size, iters);
+        std_usage = time_usage(argp, ARGP_HELP_STD_USAGE & ~ARGP_HELP_EXIT_ERR,
+                               buf, size, iters);
+
+        printf("%10zu %10zu %14.1f %14.1f\n",
+               noptions, size - 1, usage / 1e3, std_usage / 1e3);
+        free(buf);
+    }
+
+    return EXIT_SUCCESS;
+}
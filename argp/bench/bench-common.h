@@ -0,0 +1,321 @@
+/* Shared helpers for the argp benchmarks.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+#ifndef __BENCH_COMMON_H
+#define __BENCH_COMMON_H
+
+#include "argp.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if _WIN32
+# include <windows.h>
+# include <psapi.h>
+# define BENCH_NULL_DEVICE "NUL"
+#else
+# include <time.h>
+# include <sys/resource.h>
+# include <sys/wait.h>
+# include <unistd.h>
+# define BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+/* Monotonic time in nanoseconds.  */
+static inline double
+bench_now_ns(void)
+{
+#if _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double) now.QuadPart * 1e9 / (double) freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+#endif
+}
+
+/* Peak resident set size of this process in kilobytes, or 0 if unknown.  */
+static inline long
+bench_peak_rss_kb(void)
+{
+#if _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof pmc))
+        return (long) (pmc.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    struct rusage ru;
+
+    if (getrusage(RUSAGE_SELF, &ru))
+        return 0;
+# ifdef __APPLE__
+    return ru.ru_maxrss / 1024;
+# else
+    return ru.ru_maxrss;
+# endif
+#endif
+}
+
+/* Return P, memory just allocated, or exit if there wasn't enough.  */
+static inline void *
+bench_check_alloc(void *p)
+{
+    if (!p) {
+        fprintf(stderr, "bench: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static inline void *
+bench_malloc(size_t size)
+{
+    return bench_check_alloc(malloc(size));
+}
+
+static inline void *
+bench_calloc(size_t count, size_t size)
+{
+    return bench_check_alloc(calloc(count, size));
+}
+
+/* Return a malloced string made from FORMAT and the arguments after it, as
+   asprintf would.  */
+static inline char *
+bench_format(const char *format, ...)
+{
+    va_list ap;
+    char *str;
+    int len;
+
+    va_start(ap, format);
+    len = vsnprintf(NULL, 0, format, ap);
+    va_end(ap);
+    if (len < 0) {
+        fprintf(stderr, "bench: can't format `%s'\n", format);
+        exit(EXIT_FAILURE);
+    }
+
+    str = bench_malloc((size_t) len + 1);
+    va_start(ap, format);
+    vsnprintf(str, (size_t) len + 1, format, ap);
+    va_end(ap);
+
+    return str;
+}
+
+/* Tiny deterministic generator, so every run builds the same tree.  */
+static inline unsigned
+bench_rand(unsigned *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7fff;
+}
+
+/* Return a malloced sentence of roughly LEN bytes built from WORDS.  */
+static inline char *
+bench_make_doc(unsigned *seed, size_t len)
+{
+    static const char *const words[] = {
+        "the", "option", "value", "selects", "output", "file", "when",
+        "enabled", "with", "default", "mode", "print", "verbose", "messages",
+        "about", "each", "input", "record", "and", "its", "format",
+    };
+    const size_t nwords = sizeof words / sizeof words[0];
+    char *doc = bench_malloc(len + 32);
+    size_t pos = 0;
+
+    while (pos < len) {
+        const char *w = words[bench_rand(seed) % nwords];
+        size_t wlen = strlen(w);
+
+        if (pos)
+            doc[pos++] = ' ';
+        memcpy(doc + pos, w, wlen);
+        pos += wlen;
+    }
+    doc[pos++] = '.';
+    doc[pos] = '\0';
+
+    return doc;
+}
+
+static error_t
+bench_parse_opt(int key, char *arg, struct argp_state *state)
+{
+    (void) key;
+    (void) arg;
+    (void) state;
+    return ARGP_ERR_UNKNOWN;
+}
+
+/* Build a synthetic argp with NOPTIONS options spread over NGROUPS child
+   parsers.  Every third option takes an argument and every fifth one is an
+   alias of its predecessor.  The result lives until the process exits.  */
+static inline struct argp *
+bench_make_argp(size_t noptions, size_t ngroups, size_t doc_len)
+{
+    unsigned seed = 2023;
+    struct argp *root = bench_calloc(1, sizeof *root);
+    struct argp_child *children = bench_calloc(ngroups + 1, sizeof *children);
+    size_t per_group = (noptions + ngroups - 1) / ngroups;
+    size_t g, i, n = 0;
+
+    for (g = 0; g < ngroups; g++) {
+        struct argp *child = bench_calloc(1, sizeof *child);
+        struct argp_option *opts = bench_calloc(per_group + 2, sizeof *opts);
+
+        opts[0].doc = bench_format("Group %zu options:", g + 1);
+        opts[0].group = (int) g + 1;
+
+        for (i = 1; i <= per_group && n < noptions; i++, n++) {
+            opts[i].name = bench_format("option-%zu", n);
+            opts[i].key = (int) (0x100 + n);
+            if (n < 52)
+                opts[i].key = n < 26 ? 'a' + (int) n : 'A' + (int) n - 26;
+            if (n % 3 == 0)
+                opts[i].arg = "VALUE";
+            if (i > 1 && n % 5 == 0) {
+                opts[i].flags = OPTION_ALIAS;
+            } else {
+                opts[i].doc = bench_make_doc(&seed,
+                    doc_len / 2 + bench_rand(&seed) % (doc_len + 1));
+            }
+        }
+
+        child->options = opts;
+        child->parser = bench_parse_opt;
+        children[g].argp = child;
+    }
+
+    root->children = children;
+    root->parser = bench_parse_opt;
+    root->args_doc = "FILE...";
+    root->doc = "Synthetic program used by the argp benchmarks."
+                "\vReport bugs to nobody.";
+
+    return root;
+}
+
+/* Shape of a synthetic argp tree made by bench_make_tree.  */
+struct bench_tree_params
+{
+    size_t options;             /* Options in the whole tree.  */
+    unsigned depth;             /* Levels of children below the root.  */
+    unsigned fanout;            /* Children of every non-leaf argp.  */
+    unsigned alias_pct;         /* Percentage of options that are aliases.  */
+    size_t doc_len;             /* Average length of an option's doc.  */
+    unsigned doc_opt_pct;       /* Percentage of OPTION_DOC entries.  */
+};
+
+/* Make one argp of the tree described by PARAMS, DEPTH levels from the
+   bottom, holding NOPTIONS options.  *N counts options made so far and
+   *SEED drives the generator.  */
+static inline struct argp *
+bench_make_tree_node(const struct bench_tree_params *params, unsigned depth,
+                     size_t noptions, size_t *n, unsigned *seed)
+{
+    struct argp *argp = bench_calloc(1, sizeof *argp);
+    struct argp_option *opts = bench_calloc(noptions + 1, sizeof *opts);
+    size_t i;
+
+    for (i = 0; i < noptions; i++, (*n)++) {
+        unsigned roll = bench_rand(seed) % 100;
+
+        opts[i].doc = bench_make_doc(seed, params->doc_len / 2
+                                     + bench_rand(seed) % (params->doc_len + 1));
+        if (i > 0 && roll < params->doc_opt_pct) {
+            opts[i].name = bench_format("ENTRY-%zu", *n);
+            opts[i].flags = OPTION_DOC;
+            continue;
+        }
+
+        opts[i].name = bench_format("option-%zu", *n);
+        opts[i].key = (int) (0x100 + *n);
+        if (*n < 52)
+            opts[i].key = *n < 26 ? 'a' + (int) *n : 'A' + (int) *n - 26;
+        if (bench_rand(seed) % 3 == 0)
+            opts[i].arg = "VALUE";
+        if (i > 0 && !(opts[i - 1].flags & OPTION_DOC)
+            && roll < params->doc_opt_pct + params->alias_pct) {
+            opts[i].flags = OPTION_ALIAS;
+            opts[i].doc = NULL;
+        }
+    }
+
+    argp->options = opts;
+    argp->parser = bench_parse_opt;
+
+    if (depth > 0 && params->fanout > 0) {
+        struct argp_child *children = bench_calloc(params->fanout + 1,
+                                                   sizeof *children);
+        unsigned c;
+
+        for (c = 0; c < params->fanout; c++) {
+            children[c].header = bench_format("Level %u group %u:", depth,
+                                              c + 1);
+            children[c].group = (int) c + 1;
+            children[c].argp = bench_make_tree_node(params, depth - 1,
+                                                    noptions, n, seed);
+        }
+        argp->children = children;
+    }
+
+    return argp;
+}
+
+/* Build the synthetic argp tree that PARAMS describes: a root with
+   PARAMS->depth levels of PARAMS->fanout children each, the options shared
+   out evenly among them.  The result lives until the process exits.  */
+static inline struct argp *
+bench_make_tree(const struct bench_tree_params *params)
+{
+    unsigned seed = 2023;
+    size_t nodes = 1, level = 1, n = 0;
+    unsigned d;
+    struct argp *root;
+
+    for (d = 0; d < params->depth; d++) {
+        level *= params->fanout;
+        nodes += level;
+    }
+
+    root = bench_make_tree_node(params, params->depth,
+                                (params->options + nodes - 1) / nodes,
+                                &n, &seed);
+    root->args_doc = "FILE...";
+    root->doc = "Synthetic program used by the argp benchmarks."
+                "\vReport bugs to nobody.";
+
+    return root;
+}
+
+#endif /* __BENCH_COMMON_H */
@@ -0,0 +1,60 @@
+# Bash completion for programs that use argp.
+#
+# MIT License
+#
+# Copyright (c) 2023 Konychev Valerii
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Source this file, then register each program with
+#
+#     complete -o default -F _argp_complete PROGRAM
+#
+# On every TAB, the program is run as `PROGRAM --complete WORD...', with the
+# words up to the cursor, and prints the completions of the last one.  When
+# it prints none, -o default lets bash complete file names instead.
+
+_argp_complete()
+{
+    local line cur words
+    local IFS=$' \t\n'
+
+    # Split the line up to the cursor here, so that `--NAME=VALUE' stays one
+    # word whatever COMP_WORDBREAKS holds.
+    line=${COMP_LINE:0:COMP_POINT}
+    read -ra words <<< "$line"
+    if [[ -z $line || $line == *[[:space:]] ]]; then
+        words+=("")
+    fi
+    cur=${words[${#words[@]} - 1]}
+
+    IFS=$'\n'
+    COMPREPLY=($("${words[0]}" --complete "${words[@]:1}" 2>/dev/null))
+
+    # Bash replaces only what follows the last `=' when that's a word break.
+    if [[ $cur == *=* && $COMP_WORDBREAKS == *=* ]]; then
+        COMPREPLY=("${COMPREPLY[@]#"${cur%=*}="}")
+    fi
+
+    # An option that needs an argument is printed with its `=': the value
+    # comes next, without a space.
+    if [[ ${#COMPREPLY[@]} -eq 1 && ${COMPREPLY[0]} == *= ]]; then
+        compopt -o nospace
+    fi
+}
@@ -0,0 +1,948 @@
+/* Differential test for the argp_fmtstream line wrapper.
+   Copyright (C) 1997-2021 Free Software Foundation, Inc.
+   This file is part of the GNU C Library.
+
+   The GNU C Library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   The GNU C Library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with the GNU C Library; if not, see
+   <https://www.gnu.org/licenses/>.  */
+
+/* The fmtstream under test is built into this program, so its internal
+   functions can be used on every platform.  Each random sequence of writes
+   and margin changes is fed both to it and to REF_FMTSTREAM below, which is
+   the wrapper this one replaced, unchanged but for writing to a sink, and
+   the two outputs must be byte-for-byte the same.
+
+   Where the original goes wrong, marked DEFECT: below, the reference gives
+   up and that sequence isn't compared: with no room left in the buffer it
+   wrote margin blanks to the stream ahead of text still in the buffer, it
+   looked at bytes past the end of the text (and before its start, for
+   lines already past the margin), a word running exactly to the end of a
+   line made it overwrite the first byte of the next one, and truncating a
+   line left junk after it if a newline followed, or cut it short of
+   nothing if it was already past the margin.
+   What the stream does instead in those cases is checked against fixed
+   expected output by test_fixed_defects.
+
+   Writes include __argp_fmtstream_printf calls, which the reference does
+   with vsnprintf alone, as the original did.  The same sequences are also
+   written to a MEMORY sink, and a long text to an FD sink, whose output
+   must match what the callback got.  */
+
+#include "../argp-fmtstream.c"
+
+#include <ctype.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REF_INIT_BUF_SIZE 200
+#define REF_PRINTF_SIZE_GUESS 150
+
+/* Where output goes, for both the reference and the stream under test.  */
+struct sink
+{
+    char *data;
+    size_t len, size;
+};
+
+static size_t
+sink_write(void *cookie, const char *data, size_t len)
+{
+    struct sink *sink = cookie;
+
+    if (len == 0)
+        return 0;
+    if (sink->len + len > sink->size) {
+        size_t size = 2 * (sink->len + len);
+        char *data = realloc(sink->data, size);
+
+        if (! data)
+            return 0;
+        sink->data = data;
+        sink->size = size;
+    }
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+
+    return len;
+}
+
+struct ref_fmtstream
+{
+    struct sink *sink;
+
+    size_t lmargin, rmargin;
+    ssize_t wmargin;
+
+    size_t point_offs;
+    ssize_t point_col;
+
+    char *buf;
+    char *p;
+    char *end;
+
+    int defect;                 /* Set once the original has gone wrong.  */
+};
+
+static void
+ref_output(struct ref_fmtstream *fs, const char *data, size_t len)
+{
+    sink_write(fs->sink, data, len);
+}
+
+static void
+ref_output_blanks(struct ref_fmtstream *fs, size_t n)
+{
+    while (n-- > 0)
+        ref_output(fs, " ", 1);
+}
+
+/* Give up on FS where the original goes wrong.  */
+#define REF_DEFECT(fs) do { (fs)->defect = 1; return; } while (0)
+
+/* Return true if there's nothing but blanks from P to the end of FS's text,
+   so that the original's search past them would run off its end.  */
+static int
+ref_blanks_to_end(const struct ref_fmtstream *fs, const char *p)
+{
+    while (p < fs->p && isblank(*p))
+        ++p;
+
+    return p >= fs->p;
+}
+
+static void
+ref_update(struct ref_fmtstream *fs)
+{
+    char *buf, *nl;
+    size_t len;
+
+    if (fs->defect)
+        return;
+
+    /* Scan the buffer for newlines.  */
+    buf = fs->buf + fs->point_offs;
+    while (buf < fs->p) {
+        size_t r;
+
+        if (fs->point_col == 0 && fs->lmargin != 0) {
+        /* We are starting a new line.  Print spaces to the left margin.  */
+            const size_t pad = fs->lmargin;
+
+            /* DEFECT: the blanks would go out ahead of the text before BUF. */
+            if (fs->p + pad >= fs->end && buf > fs->buf)
+                REF_DEFECT(fs);
+
+            if (fs->p + pad < fs->end) {
+                /* We can fit in them in the buffer by moving the
+                buffer text up and filling in the beginning.  */
+                memmove(buf + pad, buf, fs->p - buf);
+                fs->p += pad; /* Compensate for bigger buffer. */
+                memset(buf, ' ', pad); /* Fill in the spaces.  */
+                buf += pad; /* Don't bother searching them.  */
+            } else {
+                /* No buffer space for spaces.  Must flush.  */
+                ref_output_blanks(fs, pad);
+            }
+            fs->point_col = pad;
+        }
+
+        len = fs->p - buf;
+        nl = memchr(buf, '\n', len);
+
+        if (fs->point_col < 0)
+            fs->point_col = 0;
+
+        if (!nl) {
+            /* The buffer ends in a partial line.  */
+
+            if (fs->point_col + len < fs->rmargin) {
+                /* The remaining buffer text is a partial line and fits
+                within the maximum line width.  Advance point for the
+                characters to be written and stop scanning.  */
+                fs->point_col += len;
+                break;
+            } else
+                /* Set the end-of-line pointer for the code below to
+                the end of the buffer.  */
+                nl = fs->p;
+        } else if (fs->point_col + (nl - buf) < (ssize_t) fs->rmargin) {
+            /* The buffer contains a full line that fits within the maximum
+                line width.  Reset point and scan the next line.  */
+            fs->point_col = 0;
+            buf = nl + 1;
+            continue;
+        }
+
+        /* This line is too long.  */
+        r = fs->rmargin - 1;
+
+        if (fs->wmargin < 0) {
+            /* DEFECT: with a newline after the excess, it moves the end of
+                the text up rather than down; and a line already past the
+                margin would keep less than nothing.  */
+            if (nl < fs->p || fs->point_col > (ssize_t) r)
+                REF_DEFECT(fs);
+
+            /* Truncate the line by overwriting the excess with the
+                newline and anything after it in the buffer.  */
+            if (nl < fs->p) {
+                memmove(buf + (r - fs->point_col), nl, fs->p - nl);
+                fs->p -= buf + (r - fs->point_col) - nl;
+                /* Reset point for the next line and start scanning it.  */
+                fs->point_col = 0;
+                buf += r + 1; /* Skip full line plus \n. */
+            } else {
+                /* The buffer ends with a partial line that is beyond the
+                maximum line width.  Advance point for the characters
+                written, and discard those past the max from the buffer.  */
+                fs->point_col += len;
+                fs->p -= fs->point_col - r;
+                break;
+            }
+        } else {
+            /* Do word wrap.  Go to the column just past the maximum line
+                width and scan back for the beginning of the word there.
+                Then insert a line break.  */
+
+            char *p, *nextline;
+            int i;
+
+            p = buf + (r + 1 - fs->point_col);
+
+            /* DEFECT: it looks at the byte past the end of the text, or
+                before the start of a line already past the margin.  */
+            if (p >= fs->p || p < buf - 1)
+                REF_DEFECT(fs);
+
+            while (p >= buf && !isblank(*p))
+                --p;
+            nextline = p + 1; /* This will begin the next line.  */
+
+            if (nextline > buf) {
+                /* Swallow separating blanks.  */
+                if (p >= buf)
+                    do
+                        --p;
+                    while (p >= buf && isblank(*p));
+                nl = p + 1;   /* The newline will replace the first blank. */
+            } else {
+                /* A single word that is greater than the maximum line width.
+                Oh well.  Put it on an overlong line by itself.  */
+                p = buf + (r + 1 - fs->point_col);
+
+                /* DEFECT: a word running right up to the newline starts
+                    the search past it, so the newline is overwritten.  */
+                if (p >= nl)
+                    REF_DEFECT(fs);
+
+                /* Find the end of the long word.  */
+                do
+                    ++p;
+                while (p < nl && !isblank(*p));
+
+                if (p == nl) {
+                    /* It already ends a line.  No fussing required.  */
+                    fs->point_col = 0;
+                    buf = nl + 1;
+                    continue;
+                }
+
+                /* DEFECT: the blanks run to the end of the text, and
+                    the search for the next word past it.  */
+                if (ref_blanks_to_end(fs, p))
+                    REF_DEFECT(fs);
+
+                /* We will move the newline to replace the first blank.  */
+                nl = p;
+                /* Swallow separating blanks.  */
+                do
+                    ++p;
+                while (isblank(*p));
+
+                /* The next line will start here.  */
+                nextline = p;
+            }
+
+            /* Note: There are a bunch of tests below for
+                NEXTLINE == BUF + LEN + 1; this case is where NL happens to fall
+                at the end of the buffer, and NEXTLINE is in fact empty (and so
+                we need not be careful to maintain its contents).  */
+
+            if ((nextline == buf + len + 1
+                ? fs->end - nl < fs->wmargin + 1
+                : nextline - (nl + 1) < fs->wmargin)
+                && fs->p > nextline) {
+                /* The margin needs more blanks than we removed.  */
+                if (fs->end - fs->p > fs->wmargin + 1) {
+                    /* Make some space for them.  */
+                    size_t mv = fs->p - nextline;
+                    memmove(nl + 1 + fs->wmargin, nextline, mv);
+                    nextline = nl + 1 + fs->wmargin;
+                    len = nextline + mv - buf;
+                    *nl++ = '\n';
+                } else {
+                    /* Output the first line so we can use the space.  */
+                    if (nl > fs->buf)
+                        ref_output(fs, fs->buf, nl - fs->buf);
+                    ref_output(fs, "\n", 1);
+
+                    len += buf - fs->buf;
+                    nl = buf = fs->buf;
+                }
+            } else
+                /* We can fit the newline and blanks in before
+                the next word.  */
+                *nl++ = '\n';
+
+            if (nextline - nl >= fs->wmargin
+                || (nextline == buf + len + 1 && fs->end - nextline >= fs->wmargin))
+                /* Add blanks up to the wrap margin column.  */
+                for (i = 0; i < fs->wmargin; ++i)
+                    *nl++ = ' ';
+            else {
+                /* DEFECT: the blanks would go out ahead of the line before
+                    them.  */
+                if (nl > fs->buf)
+                    REF_DEFECT(fs);
+                ref_output_blanks(fs, fs->wmargin);
+            }
+
+            /* Copy the tail of the original buffer into the current buffer
+                position.  */
+            if (nl < nextline)
+                memmove(nl, nextline, buf + len - nextline);
+            len -= nextline - buf;
+
+            /* Continue the scan on the remaining lines in the buffer.  */
+            buf = nl;
+
+            /* Restore bufp to include all the remaining text.  */
+            fs->p = nl + len;
+
+            /* Reset the counter of what has been output this line.  If wmargin
+                is 0, we want to avoid the lmargin getting added, so we set
+                point_col to a magic value of -1 in that case.  */
+            fs->point_col = fs->wmargin ? fs->wmargin : -1;
+        }
+    }
+
+    /* Remember that we've scanned as far as the end of the buffer.  */
+    fs->point_offs = fs->p - fs->buf;
+}
+
+static int
+ref_ensure(struct ref_fmtstream *fs, size_t amount)
+{
+    if ((size_t) (fs->end - fs->p) < amount) {
+        ref_update(fs);
+        ref_output(fs, fs->buf, fs->p - fs->buf);
+        fs->p = fs->buf;
+        fs->point_offs = 0;
+
+        if ((size_t) (fs->end - fs->buf) < amount) {
+            size_t old_size = fs->end - fs->buf;
+            size_t new_size = old_size + amount;
+            char *new_buf = realloc(fs->buf, new_size);
+
+            if (! new_buf)
+                return 0;
+            fs->buf = new_buf;
+            fs->end = new_buf + new_size;
+            fs->p = fs->buf;
+        }
+    }
+
+    return 1;
+}
+
+static void
+ref_write(struct ref_fmtstream *fs, const char *str, size_t len)
+{
+    if (fs->p + len <= fs->end || ref_ensure(fs, len)) {
+        memcpy(fs->p, str, len);
+        fs->p += len;
+    }
+}
+
+static void
+ref_printf(struct ref_fmtstream *fs, const char *fmt, ...)
+{
+    int out;
+    size_t avail;
+    size_t size_guess = REF_PRINTF_SIZE_GUESS;
+
+    do {
+        va_list args;
+
+        if (! ref_ensure(fs, size_guess))
+            return;
+        avail = fs->end - fs->p;
+        va_start(args, fmt);
+        out = vsnprintf(fs->p, avail, fmt, args);
+        va_end(args);
+        if ((size_t) out >= avail)
+            size_guess = out + 1;
+    } while ((size_t) out >= avail);
+
+    fs->p += out;
+}
+
+static void
+ref_sync(struct ref_fmtstream *fs)
+{
+    if ((size_t) (fs->p - fs->buf) > fs->point_offs)
+        ref_update(fs);
+}
+
+static size_t
+ref_point(struct ref_fmtstream *fs)
+{
+    ref_sync(fs);
+    return fs->point_col >= 0 ? fs->point_col : 0;
+}
+
+static void
+ref_flush(struct ref_fmtstream *fs)
+{
+    ref_update(fs);
+    ref_output(fs, fs->buf, fs->p - fs->buf);
+    fs->p = fs->buf;
+    fs->point_offs = 0;
+}
+
+static void
+ref_free(struct ref_fmtstream *fs)
+{
+    ref_flush(fs);
+    free(fs->buf);
+}
+
+int failure_count = 0;
+
+/* How many random sequences the reference got through.  */
+static unsigned compared_count = 0;
+
+static void
+fail(unsigned seed, const char *msg)
+{
+    fprintf(stderr, "seed %u: %s\n", seed, msg);
+    failure_count++;
+}
+
+static unsigned long rand_state;
+
+static unsigned
+rand_below(unsigned n)
+{
+    rand_state = rand_state * 6364136223846793005UL + 1442695040888963407UL;
+    return (unsigned) ((rand_state >> 33) % n);
+}
+
+/* Fill BUF with LEN bytes of text: words of various lengths, some longer
+   than any line, separated by runs of blanks and newlines.  */
+static void
+make_text(char *buf, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        unsigned kind = rand_below(20);
+        size_t n;
+
+        if (kind < 12)
+            n = 1 + rand_below(10);             /* A word.  */
+        else if (kind < 13)
+            n = 20 + rand_below(150);           /* A long word.  */
+        else
+            n = 1 + rand_below(kind < 18 ? 2 : 6);
+
+        for (; n > 0 && i < len; n--, i++)
+            if (kind < 13)
+                buf[i] = 'a' + rand_below(26);
+            else if (kind < 18)
+                buf[i] = ' ';
+            else
+                buf[i] = " \t\n\n"[rand_below(4)];
+    }
+}
+
+/* Format TEXT, which is changed, in one of several ways on FS, MEM and
+   REF: those that __argp_fmtstream_printf does itself, and one it leaves to
+   vsnprintf.  */
+static void
+printf_both(argp_fmtstream_t fs, argp_fmtstream_t mem,
+        struct ref_fmtstream *ref, char *text)
+{
+    int n = (int) rand_below(200000) - 100000;
+    int prec = (int) rand_below(40) - 5;
+    char c = text[0] ? text[0] : 'x';
+
+    switch (rand_below(5)) {
+    case 0:
+        __argp_fmtstream_printf(fs, "%s", text);
+        __argp_fmtstream_printf(mem, "%s", text);
+        ref_printf(ref, "%s", text);
+        break;
+    case 1:
+        __argp_fmtstream_printf(fs, " [-%c %s]", c, text);
+        __argp_fmtstream_printf(mem, " [-%c %s]", c, text);
+        ref_printf(ref, " [-%c %s]", c, text);
+        break;
+    case 2:
+        __argp_fmtstream_printf(fs, "--%.*s=%d%%", prec, text, n);
+        __argp_fmtstream_printf(mem, "--%.*s=%d%%", prec, text, n);
+        ref_printf(ref, "--%.*s=%d%%", prec, text, n);
+        break;
+    case 3:
+        __argp_fmtstream_printf(fs, "%d %d", INT_MIN, n);
+        __argp_fmtstream_printf(mem, "%d %d", INT_MIN, n);
+        ref_printf(ref, "%d %d", INT_MIN, n);
+        break;
+    default:
+        text[strlen(text) / 2] = '\0';
+        __argp_fmtstream_printf(fs, "%8s|%-5d|%s", text, n, text);
+        __argp_fmtstream_printf(mem, "%8s|%-5d|%s", text, n, text);
+        ref_printf(ref, "%8s|%-5d|%s", text, n, text);
+        break;
+    }
+}
+
+/* Run a random sequence of operations on both streams, with margins picked
+   using SEED.  */
+static void
+test_sequence(unsigned seed)
+{
+    static char text[2048];
+    struct sink want = { NULL, 0, 0 }, got = { NULL, 0, 0 };
+    struct ref_fmtstream ref;
+    argp_fmtstream_t fs, mem;
+    char *mem_data;
+    size_t rmargin, lmargin, mem_len;
+    ssize_t wmargin;
+    int ops;
+
+    rand_state = seed;
+
+    rmargin = 2 + rand_below(100);
+    lmargin = rand_below(4) ? 0 : rand_below(rmargin + 5);
+    wmargin = rand_below(8) ? (ssize_t) rand_below(rmargin / 2 + 1) : -1;
+
+    fs = __argp_make_fmtstream_fn(sink_write, &got, lmargin, rmargin, wmargin);
+    mem = __argp_make_fmtstream_mem(lmargin, rmargin, wmargin);
+    ref.sink = &want;
+    ref.lmargin = lmargin;
+    ref.rmargin = rmargin;
+    ref.wmargin = wmargin;
+    ref.point_offs = 0;
+    ref.point_col = 0;
+    ref.buf = malloc(REF_INIT_BUF_SIZE);
+    ref.p = ref.buf;
+    ref.end = ref.buf + REF_INIT_BUF_SIZE;
+    ref.defect = 0;
+
+    if (! fs || ! mem || ! ref.buf) {
+        fail(seed, "out of memory");
+        return;
+    }
+
+    for (ops = 10 + rand_below(100); ops > 0; ops--) {
+        unsigned op = rand_below(20);
+        size_t len, n;
+
+        if (op < 10) {
+            len = rand_below(op < 8 ? 80 : sizeof (text));
+            make_text(text, len);
+            __argp_fmtstream_write(fs, text, len);
+            __argp_fmtstream_write(mem, text, len);
+            ref_write(&ref, text, len);
+        } else if (op < 12) {
+            len = rand_below(300);
+            make_text(text, len);
+            text[len] = '\0';
+            printf_both(fs, mem, &ref, text);
+        } else if (op < 14) {
+            make_text(text, 1);
+            __argp_fmtstream_putc(fs, text[0]);
+            __argp_fmtstream_putc(mem, text[0]);
+            ref_write(&ref, text, 1);
+        } else if (op < 15) {
+            n = rand_below(rmargin);
+            __argp_fmtstream_set_lmargin(fs, n);
+            __argp_fmtstream_set_lmargin(mem, n);
+            ref_sync(&ref);
+            ref.lmargin = n;
+        } else if (op < 16) {
+            n = rand_below(8) ? rand_below(rmargin) : (size_t) -1;
+            __argp_fmtstream_set_wmargin(fs, n);
+            __argp_fmtstream_set_wmargin(mem, n);
+            ref_sync(&ref);
+            ref.wmargin = n;
+        } else if (op < 17) {
+            n = 2 + rand_below(100);
+            __argp_fmtstream_set_rmargin(fs, n);
+            __argp_fmtstream_set_rmargin(mem, n);
+            ref_sync(&ref);
+            ref.rmargin = rmargin = n;
+        } else if (op < 19) {
+            __argp_fmtstream_point(mem);
+            if (__argp_fmtstream_point(fs) != ref_point(&ref) && ! ref.defect)
+                fail(seed, "output columns differ");
+        } else {
+            __argp_fmtstream_flush(fs);
+            __argp_fmtstream_flush(mem);
+            ref_flush(&ref);
+        }
+    }
+
+    __argp_fmtstream_free(fs);
+    ref_free(&ref);
+    mem_data = __argp_fmtstream_take_memory(mem, &mem_len);
+    __argp_fmtstream_free(mem);
+
+    if (! ref.defect)
+        compared_count++;
+
+    if (! ref.defect
+        && (got.len != want.len || memcmp(got.data, want.data, got.len) != 0))
+        fail(seed, "output differs from the reference");
+    else if (! mem_data || mem_len != got.len
+             || memcmp(mem_data, got.data, got.len) != 0)
+        fail(seed, "memory sink output differs");
+
+    free(mem_data);
+
+    free(got.data);
+    free(want.data);
+}
+
+/* argp's help output uses word wrap to a margin with a left margin set for
+   the options' docs; make sure a plain run of that is right on its own.  */
+static void
+test_help_like(void)
+{
+    static const char expect[] =
+        "  -v, --verbose              Simple option\n"
+        "                             without arguments\n";
+    struct sink got = { NULL, 0, 0 };
+    argp_fmtstream_t fs = __argp_make_fmtstream_fn(sink_write, &got, 0, 48, 0);
+
+    if (! fs) {
+        fail(0, "out of memory");
+        return;
+    }
+
+    __argp_fmtstream_puts(fs, "  -v, --verbose");
+    __argp_fmtstream_set_wmargin(fs, 29);
+    __argp_fmtstream_set_lmargin(fs, 29);
+    while (__argp_fmtstream_point(fs) < 29)
+        __argp_fmtstream_putc(fs, ' ');
+    __argp_fmtstream_puts(fs, "Simple option without arguments");
+    __argp_fmtstream_set_lmargin(fs, 0);
+    __argp_fmtstream_putc(fs, '\n');
+    __argp_fmtstream_free(fs);
+
+    if (got.len != sizeof (expect) - 1 || memcmp(got.data, expect, got.len))
+        fail(0, "help-like output is wrong");
+    free(got.data);
+}
+
+/* Sixty lines of "ab", bare and with a left margin of five.  */
+#define AB_5 "ab\nab\nab\nab\nab\n"
+#define AB_60 AB_5 AB_5 AB_5 AB_5 AB_5 AB_5 AB_5 AB_5 AB_5 AB_5 AB_5 AB_5
+#define PAD_AB_5 "     ab\n     ab\n     ab\n     ab\n     ab\n"
+#define PAD_AB_60 PAD_AB_5 PAD_AB_5 PAD_AB_5 PAD_AB_5 PAD_AB_5 PAD_AB_5 \
+                  PAD_AB_5 PAD_AB_5 PAD_AB_5 PAD_AB_5 PAD_AB_5 PAD_AB_5
+
+/* Check the output for the cases where the original wrapper went wrong.
+   FLUSHED is written and flushed first, which left its bytes behind in the
+   original's buffer; then each piece is written and the point asked for,
+   as argp's help does between the parts of an option.  */
+static void
+test_fixed_defects(void)
+{
+    static const struct {
+        size_t lmargin, rmargin;
+        ssize_t wmargin;
+        const char *flushed;
+        const char *pieces[4];
+        const char *expect;
+    } cases[] = {
+        /* A word running exactly to the right margin, with a blank left
+           past it, as for "  -t, --test" with rmargin=30, which came out
+           with the wrap margin's blanks in the middle of a later line.  */
+        { 0, 10, 3, "abc\n     x \n", { "0123456789" },
+          "abc\n     x \n0123456789" },
+        { 0, 30, 6, "  -t, --test\n\n Main options\n",
+          { "  -f, -r, --file=FILE, ", "--input", "=FILE", "\n" },
+          "  -t, --test\n\n Main options\n"
+          "  -f, -r, --file=FILE, --input=FILE\n" },
+        /* A wrap margin past the right one, which made it put out blank
+           lines for ever.  */
+        { 0, 20, 29, "", { "Option with a mandatory argument\n" },
+          "Option with a\n"
+          "                             mandatory\n"
+          "                             argument\n" },
+        /* Left margins for lines that fill the buffer.  */
+        { 5, 80, 0, "", { AB_60 }, PAD_AB_60 },
+        /* A word running exactly to the newline.  */
+        { 0, 10, 2, "", { "abcdefghij\nxy" }, "abcdefghij\nxy" },
+        /* Truncation of lines with a newline after them, which left junk
+           at the end of the text, and of lines already past the margin.  */
+        { 0, 8, -1, "", { "abc", "defghijkl\nxyz\n" }, "abcdefg\nxyz\n" },
+        { 0, 8, -1, "", { "abcdefghijkl", "mn\nxyz\n" }, "abcdefg\nxyz\n" },
+        { 3, 8, -1, "", { "abcdefghijkl\nxyz\n" }, "   abcd\n   xyz\n" },
+    };
+    size_t i, j;
+
+    for (i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        struct sink got = { NULL, 0, 0 };
+        argp_fmtstream_t fs = __argp_make_fmtstream_fn(sink_write, &got,
+            cases[i].lmargin, cases[i].rmargin, cases[i].wmargin);
+
+        if (! fs) {
+            fail(i, "out of memory");
+            return;
+        }
+
+        __argp_fmtstream_puts(fs, cases[i].flushed);
+        __argp_fmtstream_flush(fs);
+        for (j = 0; j < 4 && cases[i].pieces[j]; j++) {
+            __argp_fmtstream_puts(fs, cases[i].pieces[j]);
+            __argp_fmtstream_point(fs);
+        }
+        __argp_fmtstream_free(fs);
+
+        if (got.len != strlen(cases[i].expect)
+            || memcmp(got.data, cases[i].expect, got.len))
+            fail(i, "output where the original went wrong is wrong");
+        free(got.data);
+    }
+}
+
+/* Return what TEXT looks like wrapped with margins RMARGIN and WMARGIN,
+   as a string to be freed, and check its final column against POINT.  */
+static char *
+wrap_text(const char *text, size_t rmargin, ssize_t wmargin, size_t point)
+{
+    argp_fmtstream_t fs = __argp_make_fmtstream_mem(0, rmargin, wmargin);
+    char *out;
+
+    if (! fs)
+        return NULL;
+    __argp_fmtstream_puts(fs, text);
+    if (__argp_fmtstream_point(fs) != point)
+        fail(0, "point isn't counted in columns");
+    out = __argp_fmtstream_take_memory(fs, NULL);
+    __argp_fmtstream_free(fs);
+
+    return out;
+}
+
+/* Feed a line of double-width text through a bounded stream whose buffer
+   is an odd size, so that it has to go in pieces that would end in the
+   middle of a character, and check that it's all measured right.  */
+static void
+test_bounded_width(void)
+{
+    static const char word[] = "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e ";
+    char text[100 * (sizeof (word) - 1) + 1];
+    FILE *fp = tmpfile();
+    argp_fmtstream_t fs;
+    size_t i;
+
+    for (i = 0; i < 100; i++)
+        memcpy(text + i * (sizeof (word) - 1), word, sizeof (word) - 1);
+    text[sizeof (text) - 1] = '\0';
+
+    fs = fp ? __argp_make_bounded_fmtstream(fp, 0, 1000, 0, 257, 0) : NULL;
+    if (! fs) {
+        fail(0, "can't make a bounded stream");
+        return;
+    }
+    __argp_fmtstream_puts(fs, text);
+    if (__argp_fmtstream_point(fs) != 100 * 7)
+        fail(0, "bounded stream measures split characters wrong");
+    __argp_fmtstream_free(fs);
+    if (ftell(fp) != (long) sizeof (text) - 1)
+        fail(0, "bounded stream loses wide text");
+    fclose(fp);
+}
+
+/* Check that text in double-width and combining characters is wrapped and
+   truncated by the columns it takes up rather than by its bytes, and that
+   bytes which aren't UTF-8 still count one column each.  */
+static void
+test_display_width(void)
+{
+    static const struct {
+        const char *text;
+        size_t rmargin;
+        ssize_t wmargin;
+        const char *expect;
+        size_t point;
+    } cases[] = {
+        /* Each word is three 3-byte characters, six columns wide.  */
+        { "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e \xe6\x97\xa5\xe6\x9c\xac"
+          "\xe8\xaa\x9e \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", 10, 0,
+          "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\n\xe6\x97\xa5\xe6\x9c\xac"
+          "\xe8\xaa\x9e\n\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", 6 },
+        { "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe6\x97\xa5\n", 6, -1,
+          "\xe6\x97\xa5\xe6\x9c\xac\n", 0 },
+        { "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", 6, -1,
+          "\xe6\x97\xa5\xe6\x9c\xac", 6 },
+        /* "e" with a combining acute accent, one column.  */
+        { "e\xcc\x81" "e\xcc\x81" "e\xcc\x81" "e\xcc\x81" "e\xcc\x81 ab",
+          9, 2, "e\xcc\x81" "e\xcc\x81" "e\xcc\x81" "e\xcc\x81" "e\xcc\x81"
+          " ab", 8 },
+        { "\xff\xfe\xe6\x97 xyz", 6, 1, "\xff\xfe\xe6\x97\n xyz", 4 },
+    };
+    size_t i;
+
+    if (__argp_fmtstream_width("ab\xe6\x97\xa5\xcc\x81\xff", 8) != 5)
+        fail(0, "width of mixed text is wrong");
+
+    for (i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        char *got = wrap_text(cases[i].text, cases[i].rmargin,
+                              cases[i].wmargin, cases[i].point);
+
+        if (! got || strcmp(got, cases[i].expect))
+            fail(i, "wide text is wrapped wrong");
+        free(got);
+    }
+
+    test_bounded_width();
+}
+
+/* Check each version of the searches for blanks that the CPU can run
+   against a byte at a time, on text of every length up to a few blocks and
+   at every alignment, with blanks and newlines scattered more or less
+   thickly.  */
+static void
+test_scanners(void)
+{
+    static const struct fmtstream_scanners generic = {
+        fmtstream_last_blank_generic, fmtstream_word_end_generic
+    };
+    const struct fmtstream_scanners *versions[3];
+    size_t count = 0, v;
+    char buf[200];
+    unsigned round;
+
+    versions[count++] = &generic;
+#ifdef CPU_SSE2
+    versions[count++] = &fmtstream_sse2_scanners;
+#endif
+#ifdef CPU_AVX2
+    if (cpu_has_avx2())
+        versions[count++] = &fmtstream_avx2_scanners;
+#endif
+
+    rand_state = 7;
+    for (round = 0; round < 20000 && failure_count < 10; round++) {
+        size_t off = rand_below(32), len = rand_below(150), n, from, i;
+        unsigned thin = 2 + rand_below(60);
+        const char *text = buf + off, *end;
+        ssize_t last = -1;
+
+        for (i = 0; i < len; i++)
+            buf[off + i] = rand_below(thin) ? (char) ('a' + rand_below(26))
+                                            : (char) " \t\n"[rand_below(3)];
+        n = rand_below(len + 1);
+        from = rand_below(len + 1);
+
+        for (i = 0; i < n; i++)
+            if (text[i] == ' ' || text[i] == '\t')
+                last = i;
+        for (end = text + from;
+             end < text + len && *end != ' ' && *end != '\t' && *end != '\n';
+             end++)
+            ;
+
+        for (v = 0; v < count; v++) {
+            if (versions[v]->last_blank(text, n) != last)
+                fail(round, "last blank found wrong");
+            if (versions[v]->word_end(text + from, text + len) != end)
+                fail(round, "word end found wrong");
+        }
+    }
+}
+
+/* Write a long text with wide margins to a temporary file through an FD
+   sink, so that it's gathered into several writev calls with margins going
+   straight to the sink, and check it against a MEMORY sink.  */
+static void
+test_fd_sink(void)
+{
+    static char text[3 * FD_SINK_BUF_SIZE];
+    FILE *fp = tmpfile();
+    argp_fmtstream_t fs, mem;
+    char *want, *got;
+    size_t want_len;
+    long got_len;
+
+    fs = fp ? __argp_make_fmtstream_fd(fileno(fp), 40, 79, 40) : NULL;
+    mem = __argp_make_fmtstream_mem(40, 79, 40);
+    if (! fs || ! mem) {
+        fail(0, "can't make FD and MEMORY sinks");
+        return;
+    }
+
+    rand_state = 1;
+    make_text(text, sizeof (text));
+    __argp_fmtstream_write(fs, text, sizeof (text));
+    __argp_fmtstream_write(mem, text, sizeof (text));
+    __argp_fmtstream_free(fs);
+    want = __argp_fmtstream_take_memory(mem, &want_len);
+    __argp_fmtstream_free(mem);
+
+    got_len = ftell(fp);
+    got = malloc(got_len > 0 ? got_len : 1);
+    rewind(fp);
+    if (! want || ! got || got_len < 0 || (size_t) got_len != want_len
+        || fread(got, 1, got_len, fp) != (size_t) got_len
+        || memcmp(got, want, want_len) != 0)
+        fail(0, "FD sink output differs");
+
+    fclose(fp);
+    free(got);
+    free(want);
+}
+
+int
+main(void)
+{
+    unsigned seed;
+
+    test_help_like();
+    test_fixed_defects();
+    test_display_width();
+    test_fd_sink();
+    test_scanners();
+
+    /* Most long sequences run into something the original got wrong, so
+       go on until enough of them have been compared.  */
+    for (seed = 1; compared_count < 2000 && failure_count < 10; seed++) {
+        if (seed > 100000) {
+            fail(0, "too few sequences compared with the reference");
+            break;
+        }
+        test_sequence(seed);
+    }
+
+    if (failure_count)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/* Test for the C++ range over argp parse events.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+#include <cstdio>
+#include <string_view>
+
+#include "argp-iter.hpp"
+
+static struct argp_option options[] = {
+    { "verbose", 'v', nullptr, 0, "Say more", 0 },
+    { "jobs", 'j', "N", 0, "Run N jobs", 0 },
+    { nullptr, 0, nullptr, 0, nullptr, 0 }
+};
+
+static struct argp test_argp = {
+    options, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+static int failure_count;
+
+static void
+fail(const char *msg)
+{
+    std::fprintf(stderr, "%s\n", msg);
+    failure_count++;
+}
+
+int
+main()
+{
+    char *argv[] = {
+        const_cast<char *>("argp-iter-test"), const_cast<char *>("-v"),
+        const_cast<char *>("--jobs=4"), const_cast<char *>("build"),
+        const_cast<char *>("--bogus"), nullptr
+    };
+    win_argp::events events(&test_argp, 5, argv, ARGP_IN_ORDER);
+    std::string_view command;
+    int seen = 0;
+
+    if (!events) {
+        fail("argp_iter_begin failed");
+        return 1;
+    }
+
+    for (const win_argp::event &e : events) {
+        seen++;
+        if (e.key == 'v' && (e.has_arg || e.index != 1))
+            fail("-v reported wrongly");
+        else if (e.key == 'j' && (e.arg != "4" || e.argp != &test_argp))
+            fail("--jobs=4 reported wrongly");
+        else if (e.key == ARGP_KEY_ARG) {
+            /* A subcommand: stop before "--bogus".  */
+            command = e.arg;
+            break;
+        }
+    }
+
+    if (seen != 3 || command != "build")
+        fail("the range didn't stop at the subcommand");
+
+    /* Carrying on finds the rest.  */
+    seen = 0;
+    for (const win_argp::event &e : events)
+        if (++seen != 1 || e.key != ARGP_KEY_ERROR || e.arg != "--bogus")
+            fail("the range didn't carry on where it stopped");
+    if (seen != 1)
+        fail("the range didn't end");
+
+    return failure_count ? 1 : 0;
+}
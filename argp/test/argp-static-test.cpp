@@ -0,0 +1,212 @@
+/* Test for compile-time option tables.
+   Copyright (C) 2023 Konychev Valerii
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.  */
+
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include "argp-static.hpp"
+
+struct config
+{
+    bool verbose;
+    int jobs;
+    unsigned long limit;
+    double scale;
+    const char *output;
+    std::string_view level;
+};
+
+inline constexpr auto config_options = win_argp::options(
+    "FILE...", "Test compile-time option tables.",
+    win_argp::option(&config::verbose, "verbose", 'v', nullptr, 0, "Say more"),
+    win_argp::option(&config::jobs, "jobs", 'j', "N", 0, "Run N jobs"),
+    win_argp::option(&config::limit, "limit", 0x100, "N", 0, "Stop at N"),
+    win_argp::option(&config::scale, "scale", 's', "X", 0, "Scale by X"),
+    win_argp::option(&config::output, "output", 'o', "FILE", 0,
+                     "Write to FILE"),
+    win_argp::option(&config::level, "level", 'l', "L", OPTION_ARG_OPTIONAL,
+                     "Set the level"));
+
+/* Every name and short option is found at compile time.  */
+static_assert(config_options.find("verbose") == 0);
+static_assert(config_options.find("limit") == 2);
+static_assert(config_options.find("level") == 5);
+static_assert(config_options.find("lev") == win_argp::detail::none);
+static_assert(config_options.find("") == win_argp::detail::none);
+static_assert(config_options.find_short('o') == 4);
+static_assert(config_options.find_short('x') == win_argp::detail::none);
+static_assert(config_options.options[2].key == 0x100);
+static_assert(win_argp::argp_of<config_options>.options
+              == config_options.options.data());
+
+static int failure_count;
+
+static void
+fail(const char *msg)
+{
+    std::fprintf(stderr, "%s\n", msg);
+    failure_count++;
+}
+
+static config
+defaults()
+{
+    return { false, 1, 0, 1.0, "-", "none" };
+}
+
+/* Parse ARGS, ARGC of them, into *CFG.  */
+static error_t
+parse(int argc, const char **args, unsigned flags, int *arg_index,
+      config *cfg)
+{
+    static char *argv[16];
+
+    std::memcpy(argv, args, argc * sizeof(char *));
+    argv[argc] = nullptr;
+    *cfg = defaults();
+    return win_argp::parse<config_options>(argc, argv, flags, arg_index, cfg);
+}
+
+/* A C-style parent that has the table's argp as a child.  */
+struct parent_input
+{
+    config cfg;
+    int answer;
+};
+
+static struct argp_option parent_options[] = {
+    { "answer", 'a', "N", 0, "The answer", 0 },
+    { nullptr, 0, nullptr, 0, nullptr, 0 }
+};
+
+static error_t
+parent_parser(int key, char *arg, struct argp_state *state)
+{
+    auto *input = static_cast<parent_input *>(state->input);
+
+    switch (key) {
+    case ARGP_KEY_INIT:
+        state->child_inputs[0] = &input->cfg;
+        break;
+    case 'a':
+        input->answer = std::atoi(arg);
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static const struct argp_child parent_children[] = {
+    { &win_argp::argp_of<config_options>, 0, nullptr, 0 },
+    { nullptr, 0, nullptr, 0 }
+};
+
+static struct argp parent_argp = {
+    parent_options, parent_parser, nullptr, nullptr, parent_children,
+    nullptr, nullptr
+};
+
+int
+main()
+{
+    config cfg;
+    int index;
+
+    {
+        const char *args[] = { "prog", "-vj4", "--limit", "0x10",
+                               "--scale=2.5", "-o", "out", "-lhigh" };
+
+        if (parse(8, args, 0, nullptr, &cfg)
+            || !cfg.verbose || cfg.jobs != 4 || cfg.limit != 16
+            || cfg.scale != 2.5 || std::strcmp(cfg.output, "out")
+            || cfg.level != "high")
+            fail("options weren't stored");
+    }
+
+    {
+        /* Options after the arguments are moved in front of them.  */
+        const char *args[] = { "prog", "a", "-j", "3", "b", "--level", "c" };
+
+        if (parse(7, args, 0, &index, &cfg) || cfg.jobs != 3
+            || cfg.level.data() != nullptr || index != 4)
+            fail("arguments weren't left at the end");
+    }
+
+    {
+        /* An abbreviation goes through argp_parse.  */
+        const char *args[] = { "prog", "-j2", "--verb", "--out=x" };
+
+        if (parse(4, args, 0, nullptr, &cfg) || !cfg.verbose || cfg.jobs != 2
+            || std::strcmp(cfg.output, "x"))
+            fail("an abbreviated option wasn't found");
+    }
+
+    {
+        const char *args[] = { "prog", "--jobs=lots" };
+
+        if (parse(2, args, ARGP_SILENT, nullptr, &cfg) != EINVAL)
+            fail("a bad number was taken");
+    }
+
+    {
+        const char *args[] = { "prog", "--limit=-1" };
+
+        if (parse(2, args, ARGP_SILENT, nullptr, &cfg) != EINVAL)
+            fail("a negative unsigned number was taken");
+    }
+
+    {
+        /* Numbers are read as C bindings read them.  */
+        const char *args[] = { "prog", "--limit=+0x20", "--scale=1e-3" };
+        const char *blank[] = { "prog", "--scale= 2" };
+
+        if (parse(3, args, 0, nullptr, &cfg) || cfg.limit != 32
+            || cfg.scale != 1e-3)
+            fail("numbers weren't read as bindings read them");
+        if (parse(2, blank, ARGP_SILENT, nullptr, &cfg) != EINVAL)
+            fail("a number with a leading blank was taken");
+    }
+
+    {
+        const char *args[] = { "prog", "file" };
+
+        if (parse(2, args, ARGP_SILENT, nullptr, &cfg) != EINVAL)
+            fail("an argument was taken without ARG_INDEX");
+    }
+
+    {
+        /* As a child in a tree of C argps.  */
+        char *argv[] = {
+            const_cast<char *>("prog"), const_cast<char *>("-a42"),
+            const_cast<char *>("--jobs=7"), const_cast<char *>("-v"), nullptr
+        };
+        parent_input input = { defaults(), 0 };
+
+        if (argp_parse(&parent_argp, 4, argv, 0, nullptr, &input)
+            || input.answer != 42 || input.cfg.jobs != 7
+            || !input.cfg.verbose)
+            fail("the table didn't work as a child");
+    }
+
+    return failure_count ? 1 : 0;
+}
@@ -19,6 +19,8 @@
 
 #include "argp.h"
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -66,6 +68,9 @@ group1_parser (int key, char *arg, struct argp_state *state)
     struct test_args *args = state->input;
 
     switch (key) {
+    case ARGP_KEY_INIT:
+        state->child_inputs[0] = state->input;
+        break;
     case 'v':
         args->verbose++;
         break;
@@ -149,6 +154,9 @@ group2_parser (int key, char *arg, struct argp_state *state)
     struct test_args *args = state->input;
 
     switch (key) {
+    case ARGP_KEY_INIT:
+        state->child_inputs[0] = state->input;
+        break;
     case 'O':
         args->opt = 1;
         break;
@@ -436,14 +444,1578 @@ test15 (struct argp *argp)
         fail ("short alias not recognized properly");
 }
 
+/* Read back everything written to the temporary file FP.  */
+static char *
+read_back (FILE *fp, long *len)
+{
+    char *buf;
+
+    *len = ftell (fp);
+    buf = malloc (*len + 1);
+    rewind (fp);
+    if (fread (buf, 1, *len, fp) != (size_t) *len)
+        fail ("short read from temporary file");
+    buf[*len] = '\0';
+    fclose (fp);
+
+    return buf;
+}
+
+static void
+test16 (struct argp *argp)
+{
+    FILE *fp1 = tmpfile ();
+    FILE *fp2 = tmpfile ();
+    char *help, *streamed;
+    long len1, len2;
+    size_t wrote;
+
+    test_number = 16;
+    if (!fp1 || !fp2) {
+        fail ("can't create temporary files");
+        return;
+    }
+
+    argp_help (argp, fp1, ARGP_HELP_STD_HELP, ARGV0);
+    wrote = argp_help_stream (argp, fp2, ARGP_HELP_STD_HELP, ARGV0, 0);
+
+    help = read_back (fp1, &len1);
+    streamed = read_back (fp2, &len2);
+    if ((size_t) len2 != wrote)
+        fail ("argp_help_stream miscounted its output");
+    else if (len1 != len2 || memcmp (help, streamed, len1))
+        fail ("argp_help_stream output differs from argp_help");
+
+    free (help);
+    free (streamed);
+}
+
+static void
+test17 (struct argp *argp)
+{
+    FILE *fp = tmpfile ();
+    char *streamed;
+    long len;
+    size_t wrote;
+
+    test_number = 17;
+    if (!fp) {
+        fail ("can't create temporary file");
+        return;
+    }
+
+    wrote = argp_help_stream (argp, fp, ARGP_HELP_STD_HELP, ARGV0, 10);
+
+    streamed = read_back (fp, &len);
+    if (wrote != 10 || len != 10)
+        fail ("argp_help_stream didn't stop at its byte limit");
+    else if (memcmp (streamed, "Usage: " ARGV0, 10))
+        fail ("argp_help_stream didn't start with the usage line");
+
+    free (streamed);
+}
+
+static void
+test18 (struct argp *argp)
+{
+    FILE *fp = tmpfile ();
+    char *help, *buf;
+    char small[16];
+    long len;
+    size_t size;
+
+    test_number = 18;
+    if (!fp) {
+        fail ("can't create temporary file");
+        return;
+    }
+
+    argp_help (argp, fp, ARGP_HELP_STD_HELP, ARGV0);
+    help = read_back (fp, &len);
+
+    size = argp_help_to_buffer (argp, NULL, 0, ARGP_HELP_STD_HELP, ARGV0);
+    if (size != (size_t) len)
+        fail ("argp_help_to_buffer reported the wrong size");
+
+    buf = malloc (size + 1);
+    if (argp_help_to_buffer (argp, buf, size + 1, ARGP_HELP_STD_HELP, ARGV0)
+        != size || strcmp (buf, help))
+        fail ("argp_help_to_buffer output differs from argp_help");
+
+    if (argp_help_to_buffer (argp, small, sizeof small, ARGP_HELP_STD_HELP,
+                             ARGV0) != size
+        || strlen (small) != sizeof small - 1
+        || memcmp (small, help, sizeof small - 1))
+        fail ("argp_help_to_buffer didn't truncate like snprintf");
+
+    free (buf);
+    free (help);
+}
+
+/* An argp_help_write_fn that takes at most 5 bytes in all.  */
+static size_t
+take_five (void *cookie, const char *data, size_t len)
+{
+    size_t *taken = cookie;
+    size_t n = len < 5 - *taken ? len : 5 - *taken;
+
+    (void) data;
+    *taken += n;
+    return n;
+}
+
+static void
+test19 (struct argp *argp)
+{
+    size_t taken = 0;
+
+    test_number = 19;
+    if (argp_help_to_callback (argp, take_five, &taken, ARGP_HELP_STD_HELP,
+                               ARGV0) != 5 || taken != 5)
+        fail ("argp_help_to_callback didn't stop on a short write");
+}
+
+static void
+test20 (struct argp *argp)
+{
+    struct argp_help_context *ctx = argp_help_context_new (argp);
+    char *help, *buf;
+    size_t size;
+    int i;
+
+    test_number = 20;
+    if (!ctx) {
+        fail ("argp_help_context_new failed");
+        return;
+    }
+
+    size = argp_help_to_buffer (argp, NULL, 0, ARGP_HELP_STD_HELP, ARGV0);
+    help = malloc (size + 1);
+    buf = malloc (size + 1);
+    argp_help_to_buffer (argp, help, size + 1, ARGP_HELP_STD_HELP, ARGV0);
+
+    /* A context can be used over and over.  */
+    for (i = 0; i < 2; i++)
+        if (argp_help_to_buffer_with_context (ctx, buf, size + 1,
+                                              ARGP_HELP_STD_HELP, ARGV0)
+            != size || strcmp (buf, help))
+            fail ("help rendered with a context differs from argp_help");
+
+    argp_help_context_free (ctx);
+    free (buf);
+    free (help);
+}
+
+static void
+test21 (struct argp *argp)
+{
+    FILE *fp1 = tmpfile ();
+    FILE *fp2 = tmpfile ();
+    char *help, *written;
+    long len1, len2;
+    size_t wrote;
+
+    test_number = 21;
+    if (!fp1 || !fp2) {
+        fail ("can't create temporary files");
+        return;
+    }
+
+    argp_help (argp, fp1, ARGP_HELP_STD_HELP, ARGV0);
+    wrote = argp_help_to_fd (argp, fileno (fp2), ARGP_HELP_STD_HELP, ARGV0);
+
+    /* FP2's stdio position doesn't know about the writes to its fd.  */
+    fseek (fp2, 0, SEEK_END);
+    help = read_back (fp1, &len1);
+    written = read_back (fp2, &len2);
+    if ((size_t) len2 != wrote)
+        fail ("argp_help_to_fd miscounted its output");
+    else if (len1 != len2 || memcmp (help, written, len1))
+        fail ("argp_help_to_fd output differs from argp_help");
+
+    if (argp_help_to_fd (argp, -1, ARGP_HELP_STD_HELP, ARGV0) != 0)
+        fail ("argp_help_to_fd wrote to a bad file descriptor");
+
+    free (help);
+    free (written);
+}
+
+static void
+test22 (struct argp *argp)
+{
+    /* Getopt moves "ARG" after the options, so keep what to compare with.  */
+    char *jobs = "--jobs=4", *x = "-x1", *q = "-q";
+    char *argv[] = { ARGV0, jobs, "-v", "ARG", x, "--file", "FILE", q,
+                     "--", "--after", NULL };
+    char *forward[NARGS (argv) + 2];
+    struct test_args test_args;
+    size_t count;
+    int index;
+
+    test_number = 22;
+    init_args (test_args);
+    forward[0] = "child";
+    if (argp_parse_forward (argp, NARGS (argv), argv, ARGP_NO_ERRS, &index,
+                            &test_args, forward + 1, &count))
+        fail ("argp_parse_forward failed");
+    else if (count != 3 || forward[1] != jobs || forward[2] != x
+             || forward[3] != q || forward[4] != NULL)
+        fail ("unknown options not forwarded in order");
+    else if (!test_args.verbose || !test_args.file
+             || strcmp (test_args.file, "FILE"))
+        fail ("known options not processed");
+
+    /* An unknown option can't be split out of a cluster of known ones.  */
+    {
+        char *argv2[] = { ARGV0, "-vx", NULL };
+        if (!argp_parse_forward (argp, NARGS (argv2), argv2,
+                                 ARGP_NO_ERRS | ARGP_NO_EXIT, NULL,
+                                 &test_args, forward, &count))
+            fail ("unknown option in a cluster forwarded");
+    }
+}
+
+/* The argp_unparse_fn for the test options.  */
+static int
+test_value (const struct argp *argp, const struct argp_option *opt,
+            unsigned index, const char **value, void *values)
+{
+    struct test_args *args = values;
+
+    *value = NULL;
+    switch (opt->key) {
+    case 't':
+        return args->test && index == 0;
+    case 'v':
+        return (int) index < args->verbose;
+    case 'f':
+        *value = args->file;
+        return args->file && index == 0;
+    case 'o':
+        *value = args->optional;
+        return args->optional_set && index == 0;
+    case 'C':
+    case 'S':
+        return args->group_1_1_option == opt->key && index == 0;
+    case 'p':
+    case 'l':
+        return args->group_2_1_option == opt->key && index == 0;
+    default:
+        return 0;
+    }
+}
+
+/* Options with and without a long name, for test23's empty values.  */
+struct empty_args
+{
+    const char *name;
+    const char *output;
+};
+
+static struct argp_option empty_options[] = {
+    { "name", 'n', "NAME", 0, "Call it NAME", 0 },
+    { NULL, 'o', "FILE", 0, "Write to FILE", 0 },
+    { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+static error_t
+empty_parser (int key, char *arg, struct argp_state *state)
+{
+    struct empty_args *args = state->input;
+
+    switch (key) {
+    case 'n':
+        args->name = arg;
+        break;
+    case 'o':
+        args->output = arg;
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static struct argp empty_argp = {
+    empty_options, empty_parser, NULL, NULL, NULL, NULL, NULL
+};
+
+static int
+empty_value (const struct argp *argp, const struct argp_option *opt,
+             unsigned index, const char **value, void *values)
+{
+    struct empty_args *args = values;
+
+    (void) argp;
+    *value = opt->key == 'n' ? args->name : args->output;
+    return index == 0;
+}
+
+static void
+test23 (struct argp *argp)
+{
+    static const char *const expected[] = {
+        ARGV0, "--test", "--verbose", "--verbose", "--file=FILE",
+        "--optional=ARG", "--limerick", "--", "a", "-b", NULL
+    };
+    char *args[] = { "a", "-b", NULL };
+    struct test_args values, defaults, parsed;
+    char **argv;
+    int argc, i, index;
+
+    test_number = 23;
+    init_args (values);
+    init_args (defaults);
+    init_args (parsed);
+    values.test = 1;
+    values.verbose = 2;
+    values.file = "FILE";
+    values.optional_set = 1;
+    values.optional = "ARG";
+    values.group_2_1_option = 'l';
+
+    argv = argp_unparse (argp, test_value, &values, NULL, ARGV0, args, &argc);
+    if (!argv) {
+        fail ("argp_unparse failed");
+        return;
+    }
+    for (i = 0; expected[i] && argv[i] && !strcmp (expected[i], argv[i]); i++)
+        ;
+    if (expected[i] || argv[i] || argc != i)
+        fail ("argp_unparse built the wrong command line");
+    else if (argp_parse (argp, argc, argv, 0, &index, &parsed))
+        fail ("argp_unparse output doesn't parse");
+    else if (parsed.test != 1 || parsed.verbose != 2
+             || strcmp (parsed.file, "FILE") || !parsed.optional_set
+             || strcmp (parsed.optional, "ARG")
+             || parsed.group_2_1_option != 'l' || index != argc - 2)
+        fail ("argp_unparse output parses differently");
+    free (argv);
+
+    /* Only what differs from the defaults.  */
+    defaults.verbose = 2;
+    defaults.file = "FILE";
+    defaults.optional_set = 1;
+    argv = argp_unparse (argp, test_value, &values, &defaults, NULL, NULL,
+                         &argc);
+    if (!argv || argc != 3 || strcmp (argv[0], "--test")
+        || strcmp (argv[1], "--optional=ARG")
+        || strcmp (argv[2], "--limerick") || argv[3])
+        fail ("argp_unparse didn't leave out the defaults");
+    free (argv);
+
+    /* An empty value for an option without a long name can't be run
+       together with it.  */
+    {
+        struct empty_args empty = { "x", "" }, parsed_empty = { NULL, NULL };
+
+        argv = argp_unparse (&empty_argp, empty_value, &empty, NULL, ARGV0,
+                             NULL, &argc);
+        if (!argv || argc != 4 || strcmp (argv[1], "--name=x")
+            || strcmp (argv[2], "-o") || strcmp (argv[3], "") || argv[4])
+            fail ("argp_unparse ran an empty value into its option");
+        else if (argp_parse (&empty_argp, argc, argv, 0, NULL, &parsed_empty)
+                 || !parsed_empty.name || strcmp (parsed_empty.name, "x")
+                 || !parsed_empty.output || strcmp (parsed_empty.output, ""))
+            fail ("argp_unparse output with an empty value parses "
+                  "differently");
+        free (argv);
+    }
+}
+
+static void
+test24 (struct argp *argp)
+{
+    char *argv[] = { ARGV0, "-vHx", "--file", "FILE", "-t", "sub", "--zz",
+                     NULL };
+    static const struct { int key; const char *arg; int index; } expected[] = {
+        { 'v', NULL, 1 }, { 'H', "x", 1 }, { 'f', "FILE", 2 }, { 't', NULL, 4 },
+        { ARGP_KEY_ARG, "sub", 5 }
+    };
+    struct argp_iter *iter;
+    struct argp_event event;
+    size_t i;
+
+    test_number = 24;
+    iter = argp_iter_begin (argp, NARGS (argv), argv, ARGP_IN_ORDER);
+    if (!iter) {
+        fail ("argp_iter_begin failed");
+        return;
+    }
+
+    /* Stop at the subcommand, leaving "--zz" unread.  */
+    for (i = 0; i < sizeof expected / sizeof expected[0]; i++)
+        if (!argp_iter_next (iter, &event) || event.key != expected[i].key
+            || event.index != expected[i].index
+            || (expected[i].arg ? !event.arg || strcmp (event.arg,
+                                                        expected[i].arg)
+                                : event.arg != NULL)
+            || (event.key == 'f' && event.argp != &group1_argp)
+            || (event.key == ARGP_KEY_ARG && event.argp != NULL))
+            fail ("argp_iter_next returned the wrong event");
+    argp_iter_end (iter);
+
+    iter = argp_iter_begin (argp, NARGS (argv) - 5, argv + 5, 0);
+    if (!iter || !argp_iter_next (iter, &event)
+        || event.key != ARGP_KEY_ERROR || event.index != 1
+        || strcmp (event.arg, "--zz") || argp_iter_next (iter, &event))
+        fail ("argp_iter_next didn't report an unknown option");
+    argp_iter_end (iter);
+}
+
+/* Options stored by bindings, for test25.  */
+struct bind_args
+{
+    int jobs;
+    int64_t offset;
+    size_t cache;
+    double ratio;
+    int64_t timeout;
+    int color;
+    char *name;
+    int other;
+};
+
+static const struct argp_binding bindings[] = {
+    { 'j', ARGP_BIND_INT, offsetof (struct bind_args, jobs) },
+    { 'O', ARGP_BIND_INT64, offsetof (struct bind_args, offset) },
+    { 'c', ARGP_BIND_SIZE, offsetof (struct bind_args, cache) },
+    { 'r', ARGP_BIND_DOUBLE, offsetof (struct bind_args, ratio) },
+    { 'T', ARGP_BIND_DURATION, offsetof (struct bind_args, timeout) },
+    { 'k', ARGP_BIND_BOOL, offsetof (struct bind_args, color) },
+    { 'n', ARGP_BIND_STRING, offsetof (struct bind_args, name) },
+    { 0, 0, 0 }
+};
+
+static const struct argp_extension bind_extension = {
+    sizeof (struct argp_extension), bindings, NULL, NULL
+};
+
+static struct argp_option bind_options[] = {
+    { "jobs", 'j', "N", 0, "Run N jobs", 0 },
+    { "offset", 'O', "N", 0, "Start at N", 0 },
+    { "cache", 'c', "SIZE", 0, "Cache SIZE bytes", 0 },
+    { "ratio", 'r', "X", 0, "Keep ratio X", 0 },
+    { "timeout", 'T', "TIME", 0, "Give up after TIME", 0 },
+    { "color", 'k', "WHEN", OPTION_ARG_OPTIONAL, "Use colors", 0 },
+    { "name", 'n', "NAME", 0, "Call it NAME", 0 },
+    { "other", 'x', NULL, 0, "Not bound", 0 },
+    ARGP_OPTION_EXTENSION (&bind_extension)
+};
+
+static error_t
+bind_parser (int key, char *arg, struct argp_state *state)
+{
+    struct bind_args *args = state->input;
+
+    switch (key) {
+    case 'x':
+        args->other = 1;
+        break;
+    case 'j': case 'O': case 'c': case 'r': case 'T': case 'k': case 'n':
+        fail ("a bound option reached the parser");
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static struct argp bind_argp = {
+    bind_options, bind_parser, NULL, NULL, NULL, NULL, NULL
+};
+
+/* An extension as a program built before it had BINDINGS would give: the
+   option it doesn't bind goes to the parser.  */
+static const struct argp_extension short_extension = {
+    offsetof (struct argp_extension, bindings), bindings, NULL, NULL
+};
+
+static struct argp_option short_options[] = {
+    { "jobs", 'j', "N", 0, "Run N jobs", 0 },
+    ARGP_OPTION_EXTENSION (&short_extension)
+};
+
+static error_t
+short_parser (int key, char *arg, struct argp_state *state)
+{
+    struct bind_args *args = state->input;
+
+    (void) arg;
+    if (key != 'j')
+        return ARGP_ERR_UNKNOWN;
+    args->other = 1;
+    return 0;
+}
+
+static struct argp short_argp = {
+    short_options, short_parser, NULL, NULL, NULL, NULL, NULL
+};
+
+static void
+test25 (struct argp *argp)
+{
+    char *argv[] = { ARGV0, "-j", "-12", "--offset=0x7fffffffffffffff",
+                     "-c4KiB", "--ratio", "0.125", "--timeout=1h30m0.5s",
+                     "-k", "--name=box", "-x", NULL };
+    char *bad[] = { ARGV0, "--jobs=99999999999", NULL };
+    struct bind_args args;
+    size_t size;
+    uint64_t u64;
+    double d;
+    int64_t ns;
+    int b;
+
+    test_number = 25;
+    (void) argp;
+    memset (&args, 0, sizeof args);
+    if (argp_parse (&bind_argp, NARGS (argv), argv, 0, NULL, &args))
+        fail ("bound options didn't parse");
+    else if (args.jobs != -12 || args.offset != INT64_MAX
+             || args.cache != 4096 || args.ratio != 0.125
+             || args.timeout != INT64_C (5400500000000) || args.color != 1
+             || strcmp (args.name, "box") || !args.other)
+        fail ("bound options stored the wrong values");
+
+    if (argp_parse (&bind_argp, NARGS (bad), bad, ARGP_SILENT, NULL, &args)
+        != ERANGE || args.jobs != -12)
+        fail ("an out of range bound option was taken");
+
+    memset (&args, 0, sizeof args);
+    if (argp_parse (&short_argp, NARGS (bad), bad, 0, NULL, &args)
+        || args.jobs || !args.other)
+        fail ("an extension without bindings bound an option");
+
+    if (argp_convert (ARGP_BIND_SIZE, "3G", &size) || size != (size_t) 3 << 30
+        || argp_convert (ARGP_BIND_SIZE, "-1", &size) != EINVAL
+        || argp_convert (ARGP_BIND_SIZE, "1Q", &size) != EINVAL)
+        fail ("sizes converted wrongly");
+    if (argp_convert (ARGP_BIND_UINT64, "0xffffffffffffffff", &u64)
+        || u64 != UINT64_MAX
+        || argp_convert (ARGP_BIND_UINT64, "-1", &u64) != EINVAL
+        || argp_convert (ARGP_BIND_UINT64, "18446744073709551616", &u64)
+           != ERANGE)
+        fail ("unsigned numbers converted wrongly");
+    if (argp_convert (ARGP_BIND_DOUBLE, "1e-3", &d) || d != 1e-3
+        || argp_convert (ARGP_BIND_DOUBLE, "12345678901234567890.5", &d)
+        || d != 12345678901234567890.5
+        || argp_convert (ARGP_BIND_DOUBLE, " 1", &d) != EINVAL
+        || argp_convert (ARGP_BIND_DOUBLE, "1,5", &d) != EINVAL)
+        fail ("doubles converted wrongly");
+    if (argp_convert (ARGP_BIND_DURATION, "250ms", &ns) || ns != 250000000
+        || argp_convert (ARGP_BIND_DURATION, "2", &ns) || ns != 2000000000
+        || argp_convert (ARGP_BIND_DURATION, "1h30", &ns) != EINVAL
+        || argp_convert (ARGP_BIND_DURATION, "200000d", &ns) != ERANGE)
+        fail ("durations converted wrongly");
+    if (argp_convert (ARGP_BIND_BOOL, "OFF", &b) || b != 0
+        || argp_convert (ARGP_BIND_BOOL, "True", &b) || b != 1
+        || argp_convert (ARGP_BIND_BOOL, "maybe", &b) != EINVAL)
+        fail ("bools converted wrongly");
+}
+
+/* List options, for test26.  */
+struct list_args
+{
+    struct argp_list ids;
+    struct argp_list names;
+    struct argp_list words;
+    struct argp_list ratios;
+};
+
+static const struct argp_binding list_bindings[] = {
+    { 'i', ARGP_BIND_INT64 | ARGP_BIND_LIST, offsetof (struct list_args, ids),
+      0 },
+    { 'n', ARGP_BIND_STRING | ARGP_BIND_LIST,
+      offsetof (struct list_args, names), 0 },
+    { 'w', ARGP_BIND_SLICE | ARGP_BIND_LIST,
+      offsetof (struct list_args, words), ':' },
+    { 'r', ARGP_BIND_DOUBLE | ARGP_BIND_LIST,
+      offsetof (struct list_args, ratios), 0 },
+    { 0, 0, 0, 0 }
+};
+
+static const struct argp_extension list_extension = {
+    sizeof (struct argp_extension), list_bindings, NULL, NULL
+};
+
+static struct argp_option list_options[] = {
+    { "ids", 'i', "N,...", 0, "Use the Ns", 0 },
+    { "names", 'n', "NAME,...", 0, "Call it the NAMEs", 0 },
+    { "words", 'w', "WORD:...", 0, "Say the WORDs", 0 },
+    { "ratios", 'r', "X,...", 0, "Keep the ratios X", 0 },
+    ARGP_OPTION_EXTENSION (&list_extension)
+};
+
+static struct argp list_argp = {
+    list_options, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+static void
+list_free (struct list_args *args)
+{
+    free (args->ids.items);
+    free (args->names.items);
+    free (args->words.items);
+    free (args->ratios.items);
+    memset (args, 0, sizeof *args);
+}
+
+static void
+test26 (struct argp *argp)
+{
+    /* The names are split in place, so they can't be literals.  */
+    char names[] = "a,bc,,d";
+    char *argv[] = { ARGV0, "--ids=1,-2,0x10,077,1234567890123456789",
+                     "-n", names, "--words=x:yz:", "--ratios=0.5,1e3",
+                     "-i", "-9223372036854775808", NULL };
+    char *bad[] = { ARGV0, "--ids=1,2", "--ids=3,x", NULL };
+    char *empty[] = { ARGV0, "--ids=", NULL };
+    struct list_args args;
+    const int64_t *ids;
+    char **strings;
+    const struct argp_slice *words;
+    const double *ratios;
+    struct argp_list list = { NULL, 0 };
+    char sizes[] = "1;2k;3M";
+
+    test_number = 26;
+    (void) argp;
+    memset (&args, 0, sizeof args);
+    if (argp_parse (&list_argp, NARGS (argv), argv, 0, NULL, &args))
+        fail ("list options didn't parse");
+    else {
+        ids = args.ids.items;
+        strings = args.names.items;
+        words = args.words.items;
+        ratios = args.ratios.items;
+        if (args.ids.count != 6 || ids[0] != 1 || ids[1] != -2
+            || ids[2] != 16 || ids[3] != 63
+            || ids[4] != INT64_C (1234567890123456789) || ids[5] != INT64_MIN)
+            fail ("an integer list was stored wrongly");
+        if (args.names.count != 4 || strcmp (strings[0], "a")
+            || strcmp (strings[1], "bc") || strcmp (strings[2], "")
+            || strcmp (strings[3], "d") || strings[1] != names + 2)
+            fail ("a string list wasn't split in place");
+        if (args.words.count != 3 || words[0].len != 1 || words[0].str[0] != 'x'
+            || words[1].len != 2 || memcmp (words[1].str, "yz", 2)
+            || words[2].len != 0)
+            fail ("a slice list was stored wrongly");
+        if (args.ratios.count != 2 || ratios[0] != 0.5 || ratios[1] != 1e3)
+            fail ("a double list was stored wrongly");
+    }
+    list_free (&args);
+
+    if (argp_parse (&list_argp, NARGS (bad), bad, ARGP_SILENT, NULL, &args)
+        != EINVAL || args.ids.count != 2 || ((int64_t *) args.ids.items)[1] != 2)
+        fail ("a bad list value was taken");
+    list_free (&args);
+
+    if (argp_parse (&list_argp, NARGS (empty), empty, 0, NULL, &args)
+        || args.ids.count != 0)
+        fail ("an empty list wasn't empty");
+    list_free (&args);
+
+    if (argp_convert_list (ARGP_BIND_SIZE, ';', sizes, &list)
+        || list.count != 3 || ((size_t *) list.items)[1] != 2048
+        || ((size_t *) list.items)[2] != (size_t) 3 << 20
+        || argp_convert_list (ARGP_BIND_SIZE, 0, "1,-1", &list) != EINVAL
+        || list.count != 3)
+        fail ("argp_convert_list converted sizes wrongly");
+    free (list.items);
+    list.items = NULL;
+    list.count = 0;
+
+    if (argp_convert_list (ARGP_BIND_INT, 0, "-7,2147483647", &list)
+        || list.count != 2 || ((int *) list.items)[0] != -7
+        || argp_convert_list (ARGP_BIND_INT, 0, "1,2147483648", &list)
+           != ERANGE
+        || argp_convert_list (ARGP_BIND_INT, 0, "1,", &list) != EINVAL
+        || argp_convert_list (ARGP_BIND_BOOL | ARGP_BIND_LIST, 0, "1", &list)
+           != EINVAL
+        || list.count != 2)
+        fail ("argp_convert_list converted ints wrongly");
+    free (list.items);
+}
+
+/* Enum options, for test27.  */
+struct enum_args
+{
+    int level;
+    int big;
+};
+
+static const struct argp_enum levels[] = {
+    { "error", 0 }, { "warn", 1 }, { "warning", 1 }, { "info", 2 },
+    { "debug", 3 }, { "dump", 4 }, { "trace", 5 }, { NULL, 0 }
+};
+
+#define BIG_ENUM_SIZE 1000
+
+static char big_names[BIG_ENUM_SIZE][8];
+static struct argp_enum big_enum[BIG_ENUM_SIZE + 1];
+
+static const struct argp_binding enum_bindings[] = {
+    { 'l', ARGP_BIND_ENUM, offsetof (struct enum_args, level), 0, levels },
+    { 'b', ARGP_BIND_ENUM, offsetof (struct enum_args, big), 0, big_enum },
+    { 0, 0, 0, 0, NULL }
+};
+
+static const struct argp_extension enum_extension = {
+    sizeof (struct argp_extension), enum_bindings, NULL, NULL
+};
+
+static struct argp_option enum_options[] = {
+    { "level", 'l', "LEVEL", 0, "Log at LEVEL", 0 },
+    { "big", 'b', "N", 0, NULL, 0 },
+    ARGP_OPTION_EXTENSION (&enum_extension)
+};
+
+static struct argp enum_argp = {
+    enum_options, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+/* Parse `--level=ARG' into *LEVEL.  */
+static error_t
+parse_level (const char *option, const char *arg, int *value)
+{
+    char buf[64];
+    char *argv[] = { ARGV0, buf, NULL };
+    struct enum_args args = { -1, -1 };
+    error_t err;
+
+    if (snprintf (buf, sizeof buf, "--%s=%s", option, arg) >= (int) sizeof buf) {
+        fail ("an enum option is too long to test");
+        return E2BIG;
+    }
+    err = argp_parse (&enum_argp, NARGS (argv), argv, ARGP_SILENT, NULL, &args);
+    *value = *option == 'l' ? args.level : args.big;
+    return err;
+}
+
+static void
+test27 (struct argp *argp)
+{
+    static const struct
+    {
+        const char *arg;
+        int value;
+    } good[] = {
+        { "error", 0 }, { "e", 0 }, { "warn", 1 }, { "war", 1 },
+        { "warni", 1 }, { "warning", 1 }, { "i", 2 }, { "de", 3 },
+        { "debug", 3 }, { "du", 4 }, { "trace", 5 }, { "t", 5 }
+    };
+    static const char *const bad[] = {
+        "", "x", "errors", "Error", "warnings", "infox"
+    };
+    char *help;
+    size_t size;
+    int i, value;
+
+    test_number = 27;
+    (void) argp;
+
+    for (i = 0; i < BIG_ENUM_SIZE; i++) {
+        snprintf (big_names[i], sizeof big_names[i], "v%d", i);
+        big_enum[i].name = big_names[i];
+        big_enum[i].value = i * 2;
+    }
+
+    for (i = 0; i < (int) (sizeof good / sizeof good[0]); i++)
+        if (parse_level ("level", good[i].arg, &value)
+            || value != good[i].value)
+            fail ("an enum value wasn't found");
+    for (i = 0; i < (int) (sizeof bad / sizeof bad[0]); i++)
+        if (parse_level ("level", bad[i], &value) != EINVAL || value != -1)
+            fail ("a bad enum value was taken");
+    if (parse_level ("level", "d", &value) != EINVAL)
+        fail ("an ambiguous enum value was taken");
+
+    for (i = 0; i < BIG_ENUM_SIZE; i++)
+        if (parse_level ("big", big_names[i], &value) || value != i * 2) {
+            fail ("a value of a big enum wasn't found");
+            break;
+        }
+    if (parse_level ("big", "v1000", &value) != EINVAL
+        || parse_level ("big", "v5", &value) || value != 10)
+        fail ("a big enum found the wrong value");
+
+    size = argp_help_to_buffer (&enum_argp, NULL, 0, ARGP_HELP_LONG, ARGV0);
+    help = malloc (size + 1);
+    argp_help_to_buffer (&enum_argp, help, size + 1, ARGP_HELP_LONG, ARGV0);
+    if (!strstr (help, "Log at LEVEL (one of: error, warn,")
+        || !strstr (help, "debug, dump, trace)")
+        || !strstr (help, "(one of: v0, v1, v2,") || !strstr (help, "v999)"))
+        fail ("the values of an enum weren't listed");
+    free (help);
+}
+
+/* Accumulated options, for test28.  */
+struct accum_args
+{
+    size_t includes, verbose, defines;
+    char *last_include;
+    int ok;
+};
+
+static struct argp_option accum_options[] = {
+    { "include", 'I', "DIR", OPTION_ACCUMULATE, "Search DIR", 0 },
+    { "search", 0, NULL, OPTION_ALIAS, NULL, 0 },
+    { "verbose", 'v', NULL, OPTION_ACCUMULATE, "Say more", 0 },
+    { "define", 'D', "K=V", OPTION_ACCUMULATE, "Define K", 0 },
+    { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+static error_t
+accum_parser (int key, char *arg, struct argp_state *state)
+{
+    struct accum_args *args = state->input;
+    char **includes, **verbose;
+    size_t count;
+
+    switch (key) {
+    case 'I': case 'v': case 'D':
+        fail ("an accumulated option reached the parser");
+        break;
+    case ARGP_KEY_END:
+        includes = argp_accumulated (state, 'I', &args->includes);
+        verbose = argp_accumulated (state, 'v', &args->verbose);
+        args->ok = argp_accumulated (state, 'D', &args->defines) == NULL
+                   && argp_accumulated (state, 'x', &count) == NULL
+                   && count == 0 && verbose && !verbose[0];
+        if (args->includes)
+            args->last_include = includes[args->includes - 1];
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static struct argp accum_argp = {
+    accum_options, accum_parser, NULL, NULL, NULL, NULL, NULL
+};
+
+static void
+test28 (struct argp *argp)
+{
+    enum { N = 1000 };
+    char **argv = malloc ((N + 4) * sizeof (char *));
+    struct accum_args args;
+    char (*dirs)[16] = malloc (N * sizeof *dirs);
+    int i;
+
+    test_number = 28;
+    (void) argp;
+    argv[0] = ARGV0;
+    for (i = 0; i < N; i++) {
+        snprintf (dirs[i], sizeof dirs[i], i % 2 ? "-Id%d" : "--search=d%d",
+                  i);
+        argv[i + 1] = dirs[i];
+    }
+    argv[N + 1] = "-vv";
+    argv[N + 2] = "-v";
+    argv[N + 3] = NULL;
+
+    memset (&args, 0, sizeof args);
+    if (argp_parse (&accum_argp, N + 3, argv, 0, NULL, &args)
+        || args.includes != N || args.verbose != 3 || args.defines != 0
+        || !args.ok || strcmp (args.last_include, "d999"))
+        fail ("accumulated options weren't collected");
+
+    free (dirs);
+    free (argv);
+}
+
+/* Constraints, for test29.  */
+static const int ab[] = { 'a', 'b', 0 };
+static const int cde[] = { 'c', 'd', 'e', 0 };
+static const int xy[] = { 'x', 'y', 0 };
+
+static const struct argp_constraint constraints[] = {
+    { ARGP_CONFLICTS, ab },
+    { ARGP_REQUIRES, cde },
+    { ARGP_EXACTLY_ONE, xy },
+    { 0, NULL }
+};
+
+static const struct argp_extension constraint_extension = {
+    sizeof (struct argp_extension), NULL, constraints, NULL
+};
+
+static struct argp_option constraint_options[] = {
+    { NULL, 'a', NULL, 0, "A", 0 },
+    { NULL, 'b', NULL, 0, "B", 0 },
+    { NULL, 'c', NULL, 0, "C", 0 },
+    { NULL, 'd', NULL, 0, "D", 0 },
+    { NULL, 'e', NULL, 0, "E", 0 },
+    { "ex", 'x', NULL, 0, "X", 0 },
+    { "why", 'y', NULL, 0, "Y", 0 },
+    ARGP_OPTION_EXTENSION (&constraint_extension)
+};
+
+#define MANY_OPTIONS 200
+#define MANY_CONFLICTS 70
+
+static char many_names[MANY_OPTIONS][8];
+static struct argp_option many_options[MANY_OPTIONS + 1];
+static int many_pairs[MANY_CONFLICTS][3];
+static struct argp_constraint many_constraints[MANY_CONFLICTS + 1];
+static const struct argp_extension many_extension = {
+    sizeof (struct argp_extension), NULL, many_constraints, NULL
+};
+
+static error_t
+constraint_parser (int key, char *arg, struct argp_state *state)
+{
+    (void) arg;
+    (void) state;
+    return (key >= 'a' && key <= 'y') || key >= 0x100 ? 0 : ARGP_ERR_UNKNOWN;
+}
+
+static struct argp many_argp = {
+    many_options, constraint_parser, NULL, NULL, NULL, NULL, NULL
+};
+
+static const struct argp_child constraint_children[] = {
+    { &many_argp, 0, NULL, 0 },
+    { NULL, 0, NULL, 0 }
+};
+
+static struct argp constraint_argp = {
+    constraint_options, constraint_parser, NULL, NULL, constraint_children,
+    NULL, NULL
+};
+
+/* Parse ARGS, a string of options separated by spaces, with
+   CONSTRAINT_ARGP.  */
+static error_t
+parse_constrained (const char *args)
+{
+    char buf[256], *argv[16], *p;
+    int argc = 0;
+
+    strcpy (buf, args);
+    argv[argc++] = ARGV0;
+    for (p = strtok (buf, " "); p; p = strtok (NULL, " "))
+        argv[argc++] = p;
+    argv[argc] = NULL;
+    return argp_parse (&constraint_argp, argc, argv, ARGP_SILENT, NULL, NULL);
+}
+
+static void
+test29 (struct argp *argp)
+{
+    static const struct
+    {
+        const char *args;
+        error_t err;
+    } cases[] = {
+        { "-x", 0 },
+        { "-x -a", 0 },
+        { "-x -a -b", EINVAL },
+        { "-y -b", 0 },
+        { "-x -c -d -e", 0 },
+        { "-x -c -d", EINVAL },
+        { "-x -d -e", 0 },
+        { "", EINVAL },
+        { "-x -y", EINVAL },
+        { "-x --o5 --o140", 0 },
+        { "-x --o5 --o135", EINVAL },
+        { "-x --o69 --o199", EINVAL },
+        { "-x --o70 --o199", 0 },
+    };
+    int i;
+
+    test_number = 29;
+    (void) argp;
+
+    for (i = 0; i < MANY_OPTIONS; i++) {
+        snprintf (many_names[i], sizeof many_names[i], "o%d", i);
+        many_options[i].name = many_names[i];
+        many_options[i].key = 0x100 + i;
+    }
+    many_options[MANY_OPTIONS].arg = (const char *) &many_extension;
+    many_options[MANY_OPTIONS].flags = OPTION_EXTENSION;
+    /* Keys far enough apart to be in different words of the bitset.  */
+    for (i = 0; i < MANY_CONFLICTS; i++) {
+        many_pairs[i][0] = 0x100 + i;
+        many_pairs[i][1] = 0x100 + i + 130;
+        many_constraints[i].type = ARGP_CONFLICTS;
+        many_constraints[i].keys = many_pairs[i];
+    }
+
+    for (i = 0; i < (int) (sizeof cases / sizeof cases[0]); i++)
+        if (parse_constrained (cases[i].args) != cases[i].err) {
+            fprintf (stderr, "Test 29: `%s'\n", cases[i].args);
+            fail ("a constraint was checked wrongly");
+        }
+}
+
+/* Complete the last of the ARGC words in ARGV for ARGP, and check that
+   EXPECTED is what's written.  */
+static void
+check_complete (const struct argp *argp, int argc, const char *const *argv,
+                const char *expected)
+{
+    FILE *fp = tmpfile ();
+    char *got;
+    long len;
+
+    if (!fp) {
+        fail ("can't create temporary file");
+        return;
+    }
+
+    if (argp_complete (argp, argc, (char **) argv, fp))
+        fail ("argp_complete failed");
+    got = read_back (fp, &len);
+    if (strcmp (got, expected)) {
+        fprintf (stderr, "Test %d: `%s' completed to:\n%s", test_number,
+                 argc ? argv[argc - 1] : "", got);
+        fail ("a word was completed wrongly");
+    }
+    free (got);
+}
+
+/* Count the times the program's own --complete option is given.  */
+static error_t
+own_complete_parser (int key, char *arg, struct argp_state *state)
+{
+    (void) arg;
+    if (key != 'c')
+        return ARGP_ERR_UNKNOWN;
+    ++*(int *) state->input;
+    return 0;
+}
+
+static void
+test30 (struct argp *argp)
+{
+    static const struct
+    {
+        int argc;
+        const char *argv[3];
+        const char *expected;
+    } cases[] = {
+        { 1, { "--le" }, "--level=\n--lev=\n" },
+        { 1, { "--h" }, "" },
+        { 1, { "--" }, "--level=\n--lev=\n--big=\n" },
+        { 1, { "-" }, "-l\n-b\n--level=\n--lev=\n--big=\n" },
+        { 1, { "--level=w" }, "--level=warn\n--level=warning\n" },
+        { 1, { "--lev=du" }, "--lev=dump\n" },
+        { 1, { "-ld" }, "-ldebug\n-ldump\n" },
+        { 2, { "-l", "d" }, "debug\ndump\n" },
+        { 2, { "--level", "" }, "error\nwarn\nwarning\ninfo\ndebug\ndump\ntrace\n" },
+        { 2, { "--level=info", "d" }, "" },
+        { 2, { "--big", "--le" }, "" },
+        { 2, { "--", "--le" }, "" },
+        { 1, { "file" }, "" },
+        { 1, { "-x" }, "" },
+        { 1, { "--x" }, "" },
+        { 0, { NULL }, "" },
+    };
+    static struct argp_option options[] = {
+        { "level", 'l', "LEVEL", 0, "Log at LEVEL", 0 },
+        { "lev", 0, NULL, OPTION_ALIAS, NULL, 0 },
+        { "big", 'b', "N", 0, NULL, 0 },
+        { "hidden", 'h', NULL, OPTION_HIDDEN, NULL, 0 },
+        ARGP_OPTION_EXTENSION (&enum_extension)
+    };
+    static struct argp complete_argp = {
+        options, NULL, NULL, NULL, NULL, NULL, NULL
+    };
+    static struct argp_option own_options[] = {
+        { "complete", 'c', NULL, 0, "Finish the job", 0 },
+        { NULL, 0, NULL, 0, NULL, 0 }
+    };
+    static struct argp own_argp = {
+        own_options, own_complete_parser, NULL, NULL, NULL, NULL, NULL
+    };
+    char *argv[] = { ARGV0, (char *) "--complete", NULL };
+    int i, completes = 0;
+
+    test_number = 30;
+
+    for (i = 0; i < (int) (sizeof cases / sizeof cases[0]); i++)
+        check_complete (&complete_argp, cases[i].argc, cases[i].argv,
+                        cases[i].expected);
+
+    /* A program's own --complete option is left to it.  */
+    if (argp_parse (&own_argp, NARGS (argv), argv, ARGP_NO_EXIT, NULL,
+                    &completes) || completes != 1)
+        fail ("the program's own --complete option wasn't parsed");
+    (void) argp;
+}
+
+/* Check that ITER suggests EXPECTED, a NULL-terminated list, for ARG,
+   asking for up to MAX.  */
+static void
+check_suggest (struct argp_iter *iter, const char *arg, size_t max,
+               const char *const *expected)
+{
+    const char *names[4];
+    size_t count, i;
+
+    count = argp_iter_suggest (iter, arg, names, max);
+    for (i = 0; i < count && expected[i]; i++)
+        if (strcmp (names[i], expected[i]))
+            break;
+    if (i != count || expected[i]) {
+        fprintf (stderr, "Test %d: `%s'\n", test_number, arg);
+        fail ("the wrong options were suggested");
+    }
+}
+
+/* Send the parse's messages to the stream its input points to.  */
+static error_t
+redirect_parser (int key, char *arg, struct argp_state *state)
+{
+    (void) arg;
+    if (key != ARGP_KEY_INIT)
+        return ARGP_ERR_UNKNOWN;
+    state->err_stream = state->input;
+    return 0;
+}
+
+static void
+test31 (struct argp *argp)
+{
+    static struct argp_option options[] = {
+        { "verbose", 'v', NULL, 0, "Say more", 0 },
+        { "version", 'V', NULL, 0, "Say which", 0 },
+        { "level", 'l', "N", 0, "Level N", 0 },
+        { "list", 0x100, NULL, 0, "List them", 0 },
+        { "secret", 0x101, NULL, OPTION_HIDDEN, "Hidden", 0 },
+        { "sekret", 0x102, NULL, 0, NULL, 0 },
+        { "secretly", 0, NULL, OPTION_ALIAS, NULL, 0 },
+        { NULL, 0, NULL, 0, NULL, 0 }
+    };
+    static struct argp suggest_argp = {
+        options, NULL, NULL, NULL, NULL, NULL, NULL
+    };
+    static struct argp redirect_argp = {
+        options, redirect_parser, NULL, NULL, NULL, NULL, NULL
+    };
+    static const char message[] = ARGV0 ": unrecognized option '--verbsoe';"
+        " did you mean '--verbose' or '--version'?\n";
+    static const char *const verbose[] = { "verbose", "version", NULL };
+    static const char *const verbose1[] = { "verbose", NULL };
+    static const char *const level[] = { "level", NULL };
+    static const char *const sekret[] = { "sekret", NULL };
+    static const char *const none[] = { NULL };
+    char *argv[] = { ARGV0, (char *) "--verbsoe", NULL };
+    char long_name[80];
+    struct argp_iter *iter;
+    struct argp_event event;
+    FILE *fp = tmpfile ();
+    char *messages;
+    long len;
+
+    test_number = 31;
+    (void) argp;
+
+    /* The whole message goes to the parser's error stream.  */
+    if (!fp)
+        fail ("can't create temporary file");
+    else {
+        argp_parse (&redirect_argp, NARGS (argv), argv, ARGP_NO_EXIT, NULL,
+                    fp);
+        messages = read_back (fp, &len);
+        if (strncmp (messages, message, strlen (message)))
+            fail ("the unknown option's message was split or wrong");
+        free (messages);
+    }
+
+    iter = argp_iter_begin (&suggest_argp, NARGS (argv), argv, 0);
+    if (!iter) {
+        fail ("argp_iter_begin failed");
+        return;
+    }
+
+    /* Through the error the iterator reports.  */
+    if (!argp_iter_next (iter, &event) || event.key != ARGP_KEY_ERROR)
+        fail ("an unknown option wasn't an error");
+    else
+        check_suggest (iter, event.arg, 4, verbose);
+
+    check_suggest (iter, "verbsoe", 1, verbose1);
+    check_suggest (iter, "--levle=3", 4, level);
+    check_suggest (iter, "--lvel", 4, level);
+    /* Hidden options, and their aliases, aren't suggested.  */
+    check_suggest (iter, "--secre", 4, sekret);
+    check_suggest (iter, "--xyzzy", 4, none);
+    check_suggest (iter, "--", 4, none);
+    check_suggest (iter, "--verbose", 0, none);
+
+    memset (long_name, 'v', sizeof long_name - 1);
+    long_name[sizeof long_name - 1] = '\0';
+    check_suggest (iter, long_name, 4, none);
+
+    argp_iter_end (iter);
+}
+
+struct command_args
+{
+    int verbose, all, level, dry, loads;
+    const char *command, *file;
+    /* What the parse of -a called the program, and its ARGV[0].  */
+    char name[32];
+};
+
+static error_t
+command_parser (int key, char *arg, struct argp_state *state)
+{
+    struct command_args *args = state->input;
+
+    switch (key) {
+    case 'v':
+        args->verbose = 1;
+        break;
+    case 'a':
+        args->all = 1;
+        snprintf (args->name, sizeof args->name, "%s: %s", state->name,
+                  state->argv[0]);
+        break;
+    case 'l':
+        args->level = atoi (arg);
+        break;
+    case 'd':
+        args->dry = 1;
+        break;
+    case ARGP_KEY_COMMAND:
+        args->command = arg;
+        break;
+    case ARGP_KEY_ARG:
+        if (args->file)
+            return ARGP_ERR_UNKNOWN;
+        args->file = arg;
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static struct argp_option build_options[] = {
+    { "all", 'a', NULL, 0, "Build everything", 0 },
+    { "level", 'l', "N", 0, "Optimize at level N", 0 },
+    { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+static struct argp build_argp = {
+    build_options, command_parser, NULL, NULL, NULL, NULL, NULL
+};
+
+static struct argp_option run_options[] = {
+    { "dry", 'd', NULL, 0, "Don't run it", 0 },
+    { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+static struct argp run_argp = {
+    run_options, command_parser, "FILE", NULL, NULL, NULL, NULL
+};
+
+static int command_loads;
+
+static const struct argp *
+load_run (const struct argp_command *command)
+{
+    command_loads++;
+    return strcmp (command->name, "run") == 0 ? &run_argp : NULL;
+}
+
+static void
+test32 (struct argp *argp)
+{
+    static const struct
+    {
+        const char *args;
+        error_t err;
+        struct command_args expected;
+    } cases[] = {
+        { "-v build -a --level 3", 0,
+          { 1, 1, 3, 0, 0, "build", NULL } },
+        { "run --dry prog", 0, { 0, 0, 0, 1, 1, "run", "prog" } },
+        { "-- run prog", 0, { 0, 0, 0, 0, 1, "run", "prog" } },
+        { "-v", 0, { 1, 0, 0, 0, 0, NULL, NULL } },
+        /* Options after the command are its own.  */
+        { "build -v", EINVAL, { 0, 0, 0, 0, 0, "build", NULL } },
+        { "run a b", EINVAL, { 0, 0, 0, 0, 1, "run", "a" } },
+        { "bulid", EINVAL, { 0, 0, 0, 0, 0, NULL, NULL } },
+        { "broken", EINVAL, { 0, 0, 0, 0, 1, NULL, NULL } },
+    };
+    static const struct argp_command commands[] = {
+        { "build", &build_argp, NULL, "Build the program" },
+        { "run", NULL, load_run, "Run it" },
+        { "broken", NULL, load_run, NULL },
+        { NULL, NULL, NULL, NULL }
+    };
+    static const struct argp_extension extension = {
+        sizeof (struct argp_extension), NULL, NULL, commands
+    };
+    static struct argp_option options[] = {
+        { "verbose", 'v', NULL, 0, "Say more", 0 },
+        ARGP_OPTION_EXTENSION (&extension)
+    };
+    static struct argp command_argp = {
+        options, command_parser, "COMMAND [ARG...]", NULL, NULL, NULL, NULL
+    };
+    int i;
+
+    test_number = 32;
+    (void) argp;
+
+    for (i = 0; i < (int) (sizeof cases / sizeof cases[0]); i++) {
+        const struct command_args *e = &cases[i].expected;
+        struct command_args args;
+        char *argv[16], *given[16], buf[256], *word;
+        int argc = 0;
+
+        memset (&args, 0, sizeof args);
+        command_loads = 0;
+        argv[argc++] = ARGV0;
+        strcpy (buf, cases[i].args);
+        for (word = strtok (buf, " "); word; word = strtok (NULL, " "))
+            argv[argc++] = word;
+        argv[argc] = NULL;
+        memcpy (given, argv, (argc + 1) * sizeof (char *));
+
+        if (argp_parse (&command_argp, argc, argv, ARGP_SILENT, NULL, &args)
+                != cases[i].err
+            || memcmp (given, argv, (argc + 1) * sizeof (char *))
+            || (args.all && strcmp (args.name, ARGV0 " build: build"))
+            || args.verbose != e->verbose || args.all != e->all
+            || args.level != e->level || args.dry != e->dry
+            || command_loads != e->loads
+            || (args.command == NULL) != (e->command == NULL)
+            || (args.command && strcmp (args.command, e->command))
+            || (args.file == NULL) != (e->file == NULL)
+            || (args.file && strcmp (args.file, e->file))) {
+            fprintf (stderr, "Test 32: `%s'\n", cases[i].args);
+            fail ("a command was parsed wrongly");
+        }
+    }
+
+    {
+        /* The commands are listed, without being loaded.  */
+        char help[2048];
+
+        command_loads = 0;
+        if (argp_help_to_buffer (&command_argp, help, sizeof help,
+                                 ARGP_HELP_STD_HELP, ARGV0) >= sizeof help
+            || !strstr (help, "\n Commands:\n  build")
+            || !strstr (help, "Build the program\n  run")
+            || !strstr (help, "\n  broken\n")
+            || command_loads != 0)
+            fail ("the commands weren't listed");
+    }
+
+    {
+        const char *words[] = { "b" };
+        const char *run_words[] = { "-v", "run", "--d" };
+        const char *file_words[] = { "run", "x" };
+
+        check_complete (&command_argp, 1, words, "build\nbroken\n");
+        check_complete (&command_argp, 3, run_words, "--dry\n");
+        check_complete (&command_argp, 2, file_words, "");
+    }
+}
+
+struct log_args
+{
+    int level, inits;
+};
+
+static error_t
+log_parser (int key, char *arg, struct argp_state *state)
+{
+    struct log_args *args = state->input;
+
+    switch (key) {
+    case 'L':
+        args->level = atoi (arg);
+        break;
+    case 'Q':
+        args->level = -1;
+        break;
+    case ARGP_KEY_INIT:
+        args->inits++;
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+/* Give the child of a part of the program its input.  */
+static error_t
+part_parser (int key, char *arg, struct argp_state *state)
+{
+    (void) arg;
+    if (key != ARGP_KEY_INIT)
+        return ARGP_ERR_UNKNOWN;
+    state->child_inputs[0] = state->input;
+    return 0;
+}
+
+/* Give the three children of the program its input.  */
+static error_t
+shared_parser (int key, char *arg, struct argp_state *state)
+{
+    int i;
+
+    (void) arg;
+    if (key != ARGP_KEY_INIT)
+        return ARGP_ERR_UNKNOWN;
+    for (i = 0; i < 3; i++)
+        state->child_inputs[i] = state->input;
+    return 0;
+}
+
+static int
+log_value (const struct argp *argp, const struct argp_option *opt,
+           unsigned index, const char **value, void *values)
+{
+    (void) argp;
+    (void) values;
+    *value = "3";
+    return opt->key == 'L' && index == 0;
+}
+
+static void
+test33 (struct argp *argp)
+{
+    static const int log_keys[] = { 'L', 'Q', 0 };
+    static const struct argp_constraint log_constraints[] = {
+        { ARGP_EXACTLY_ONE, log_keys },
+        { 0, NULL }
+    };
+    static const struct argp_extension log_extension = {
+        sizeof (struct argp_extension), NULL, log_constraints, NULL
+    };
+    static struct argp_option log_options[] = {
+        { "log-level", 'L', "N", 0, "Log at level N", 0 },
+        { "quiet", 'Q', NULL, 0, "Don't log", 0 },
+        ARGP_OPTION_EXTENSION (&log_extension)
+    };
+    static struct argp log_argp = {
+        log_options, log_parser, NULL, NULL, NULL, NULL, NULL
+    };
+    /* Two parts of a program with the same logging options.  */
+    static const struct argp_child part_children[] = {
+        { &log_argp, 0, "Logging:", 0 },
+        { NULL, 0, NULL, 0 }
+    };
+    static struct argp part_argp = {
+        NULL, part_parser, NULL, NULL, part_children, NULL, NULL
+    };
+    static const struct argp_child shared_children[] = {
+        { &part_argp, 0, NULL, 0 },
+        { &part_argp, 0, NULL, 0 },
+        { &log_argp, 0, NULL, 0 },
+        { NULL, 0, NULL, 0 }
+    };
+    static struct argp shared_argp = {
+        NULL, shared_parser, NULL, NULL, shared_children, NULL, NULL
+    };
+    struct log_args args;
+    char *argv[] = { ARGV0, (char *) "--log-level=2", NULL };
+    const char *words[] = { "--lo" };
+    char help[1024], **unparsed;
+    int argc;
+
+    test_number = 33;
+    (void) argp;
+
+    /* Every place it's used is initialized, but only the first gets the
+        option, and only its constraint is checked.  */
+    memset (&args, 0, sizeof args);
+    if (argp_parse (&shared_argp, NARGS (argv), argv, ARGP_SILENT, NULL,
+                    &args)
+        || args.level != 2 || args.inits != 3)
+        fail ("a shared child wasn't parsed as it was used");
+
+    if (argp_help_to_buffer (&shared_argp, help, sizeof help,
+                             ARGP_HELP_LONG, ARGV0) >= sizeof help
+        || !strstr (help, "--log-level")
+        || strstr (strstr (help, "--log-level") + 1, "--log-level"))
+        fail ("a shared child's options weren't listed once");
+
+    check_complete (&shared_argp, 1, words, "--log-level=\n");
+
+    unparsed = argp_unparse (&shared_argp, log_value, NULL, NULL, NULL, NULL,
+                             &argc);
+    if (!unparsed || argc != 1 || strcmp (unparsed[0], "--log-level=3"))
+        fail ("a shared child's options weren't unparsed once");
+    free (unparsed);
+}
+
+static void
+test34 (struct argp *argp)
+{
+    /* Two parts of a program that both have a `--color' option.  */
+    static struct argp_option first_options[] = {
+        { "color", 'c', "WHEN", 0, "Color the output WHEN", 0 },
+        { "columns", 0x100, "N", 0, "Use N columns", 0 },
+        { NULL, 0, NULL, 0, NULL, 0 }
+    };
+    static struct argp_option second_options[] = {
+        { "color", 'c', "WHEN", 0, "Color the log WHEN", 0 },
+        { "secret", 's', NULL, OPTION_HIDDEN, NULL, 0 },
+        { NULL, 0, NULL, 0, NULL, 0 }
+    };
+    static struct argp first_argp = {
+        first_options, NULL, NULL, NULL, NULL, NULL, NULL
+    };
+    static struct argp second_argp = {
+        second_options, NULL, NULL, NULL, NULL, NULL, NULL
+    };
+    static const struct argp_child children[] = {
+        { &first_argp, 0, NULL, 0 },
+        { &second_argp, 0, NULL, 0 },
+        { NULL, 0, NULL, 0 }
+    };
+    static struct argp both_argp = {
+        NULL, NULL, NULL, NULL, children, NULL, NULL
+    };
+    static const char *const color[] = { "color", NULL };
+    const char *dash[] = { "-" };
+    const char *colo[] = { "--colo", "-" };
+    const char *cols[] = { "--colu" };
+    char *argv[] = { ARGV0, (char *) "--colr", NULL };
+    struct argp_iter *iter;
+
+    test_number = 34;
+    (void) argp;
+
+    /* Only the first is one getopt knows, so it's only offered once, and
+        doesn't make an abbreviation of it ambiguous.  */
+    check_complete (&both_argp, 1, dash, "-c\n--color=\n--columns=\n");
+    check_complete (&both_argp, 2, colo, "");
+    check_complete (&both_argp, 1, cols, "--columns=\n");
+
+    iter = argp_iter_begin (&both_argp, NARGS (argv), argv, 0);
+    if (!iter) {
+        fail ("argp_iter_begin failed");
+        return;
+    }
+    check_suggest (iter, "--colr", 4, color);
+    check_suggest (iter, "--secrt", 4, color + 1);
+    argp_iter_end (iter);
+}
+
 typedef void (*test_fp) (struct argp *argp);
 
 static test_fp test_fun[] = {
     test1,  test2,  test3,  test4,
     test5,  test6,  test7,  test8,
     test9,  test10, test11, test12,
-    test13, test14, test15,
-    NULL
+    test13, test14, test15, test16,
+    test17, test18, test19, test20,
+    test21, test22, test23, test24,
+    test25, test26, test27, test28,
+    test29, test30, test31, test32,
+    test33, test34, NULL
 };
 
 int
@@ -468,7 +2040,7 @@ main (int argc, char **argv)
     argp_children[2].argp = NULL;
     test_argp.children = argp_children;
 
-    if (argc > 0) {
+    if (argc > 1) {
         struct test_args test_args;
         init_args (test_args);
         return argp_parse (&test_argp, argc, argv, 0, NULL, &test_args);
@@ -65,6 +65,9 @@ int getopt_long(int, char * const *, const char *,
     const struct option *, int *);
 int getopt_long_only(int, char * const *, const char *,
     const struct option *, int *);
+/* extensions: the rest of a cluster of short options, and abandoning it */
+char *getopt_rest(void);
+char *getopt_skip_rest(void);
 #ifndef _GETOPT_DECLARED
 #define _GETOPT_DECLARED
 int getopt(int, char * const [], const char *);
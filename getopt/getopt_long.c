@@ -536,3 +536,34 @@ getopt_long_only(int nargc, char * const *nargv, const char *options,
         FLAG_PERMUTE|FLAG_LONGONLY));
 }
 
+
+/*
+ * getopt_rest --
+ *  Return what is left of the argument of clustered short options that
+ *  getopt is part way through, or NULL if it is between arguments.
+ */
+char *
+getopt_rest(void)
+{
+
+    return (*place ? place : NULL);
+}
+
+/*
+ * getopt_skip_rest --
+ *  Abandon the argument of clustered short options that getopt is part
+ *  way through, moving on to the next one as if it ended after the last
+ *  option returned.  Returns what was left of it, or NULL if getopt was
+ *  between arguments.
+ */
+char *
+getopt_skip_rest(void)
+{
+    char *rest = getopt_rest();
+
+    if (rest) {
+        place = EMSG;
+        ++optind;
+    }
+    return (rest);
+}
@@ -0,0 +1,171 @@
+/***
+ * MIT License
+ *
+ * Copyright (c) 2023 Konychev Valera
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* What the CPU we're built for, and the one we're running on, can do, for
+   the few loops that are worth writing with vector instructions.  SSE2 on
+   x86 and NEON on AArch64 are decided when compiling; AVX2 code is compiled
+   into functions of its own, which must only be called once cpu_has_avx2 has
+   said they can be.  */
+
+#ifndef __CPU_FEATURES_H
+#define __CPU_FEATURES_H
+
+#if defined __x86_64__ || defined __i386__ || defined _M_X64 || defined _M_IX86
+# define CPU_X86 1
+#endif
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+# define CPU_SSE2 1
+# include <emmintrin.h>
+#endif
+
+#if defined CPU_X86 \
+    && (defined _MSC_VER || defined __clang__ \
+        || (defined __GNUC__ && __GNUC__ >= 5))
+# define CPU_AVX2 1
+# include <immintrin.h>
+# ifdef _MSC_VER
+#  define CPU_TARGET_AVX2
+# else
+#  define CPU_TARGET_AVX2 __attribute__ ((__target__ ("avx2")))
+# endif
+#endif
+
+#if defined __aarch64__ || defined _M_ARM64
+# define CPU_NEON 1
+# include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+/* Vector searches of strings read whole aligned blocks, which may go past
+   either end of the string but never into another page.  That is safe, but
+   an address sanitizer can't know it, so such functions are marked with
+   this.  */
+#if defined __has_feature
+# if __has_feature(address_sanitizer)
+#  define CPU_NO_SANITIZE_ADDRESS __attribute__ ((__no_sanitize_address__))
+# endif
+#endif
+#if !defined CPU_NO_SANITIZE_ADDRESS && defined __SANITIZE_ADDRESS__
+# define CPU_NO_SANITIZE_ADDRESS __attribute__ ((__no_sanitize_address__))
+#endif
+#ifndef CPU_NO_SANITIZE_ADDRESS
+# define CPU_NO_SANITIZE_ADDRESS
+#endif
+
+/* Return the index of the lowest bit set in the nonzero MASK.  */
+static inline int
+cpu_ctz(unsigned mask)
+{
+#if defined _MSC_VER
+    unsigned long index;
+
+    _BitScanForward(&index, mask);
+    return (int) index;
+#elif defined __GNUC__
+    return __builtin_ctz(mask);
+#else
+    int index = 0;
+
+    while (!(mask & 1))
+        mask >>= 1, index++;
+    return index;
+#endif
+}
+
+/* Likewise for a 64-bit MASK.  */
+static inline int
+cpu_ctz64(unsigned long long mask)
+{
+#if defined _MSC_VER && (defined _M_X64 || defined _M_ARM64)
+    unsigned long index;
+
+    _BitScanForward64(&index, mask);
+    return (int) index;
+#elif defined __GNUC__
+    return __builtin_ctzll(mask);
+#else
+    return (unsigned) mask ? cpu_ctz((unsigned) mask)
+                           : 32 + cpu_ctz((unsigned) (mask >> 32));
+#endif
+}
+
+/* Return the index of the highest bit set in the nonzero MASK.  */
+static inline int
+cpu_msb(unsigned mask)
+{
+#if defined _MSC_VER
+    unsigned long index;
+
+    _BitScanReverse(&index, mask);
+    return (int) index;
+#elif defined __GNUC__
+    return 31 - __builtin_clz(mask);
+#else
+    int index = 31;
+
+    while (!(mask & 0x80000000u))
+        mask <<= 1, index--;
+    return index;
+#endif
+}
+
+#ifdef CPU_AVX2
+/* Return true if AVX2 instructions can be used, which takes both the CPU
+   having them and the OS saving the registers they use.  This asks the CPU
+   each time, so callers should remember the answer.  */
+static inline int
+cpu_has_avx2(void)
+{
+# ifdef _MSC_VER
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return 0;
+
+    /* OSXSAVE and AVX, then the XMM and YMM state enabled by the OS.  */
+    __cpuid(info, 1);
+    if ((info[2] & (3 << 27)) != (3 << 27) || (_xgetbv(0) & 6) != 6)
+        return 0;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+# else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+# endif
+}
+#else /* CPU_AVX2 */
+static inline int
+cpu_has_avx2(void)
+{
+    return 0;
+}
+#endif /* CPU_AVX2 */
+
+#endif /* __CPU_FEATURES_H */
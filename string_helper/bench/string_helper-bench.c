@@ -0,0 +1,163 @@
+/***
+ * MIT License
+ *
+ * Copyright (c) 2023 Konychev Valera
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Usage: string_helper-bench [MEGABYTES]
+
+   Times each version of strchrnul and strnlen the CPU can run on strings of
+   growing length, looking for a character that isn't there so the whole
+   string is scanned, and prints the rate in bytes per nanosecond next to
+   that of the word-at-a-time versions they replace.  Each length is
+   repeated until about MEGABYTES (default 256) have been scanned.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if _WIN32
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+#include <string_helper.h>
+#include "string_helper-impl.h"
+
+/* Monotonic time in nanoseconds.  */
+static double
+bench_now_ns(void)
+{
+#if _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double) now.QuadPart * 1e9 / (double) freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+#endif
+}
+
+struct version
+{
+    const char *name;
+    char *(*strchrnul)(const char *s, int c_in);
+    size_t (*strnlen)(const char *s, size_t maxlen);
+};
+
+/* Keeps the compiler from dropping calls whose results aren't used.  */
+static volatile size_t sink;
+
+static double
+time_strchrnul(const struct version *v, const char *s, size_t len,
+               size_t repeat)
+{
+    double start = bench_now_ns();
+    size_t i;
+
+    for (i = 0; i < repeat; i++)
+        sink += v->strchrnul(s + (i & 1), '\n') - s;
+
+    return (double) len * repeat / (bench_now_ns() - start);
+}
+
+static double
+time_strnlen(const struct version *v, const char *s, size_t len,
+             size_t repeat)
+{
+    double start = bench_now_ns();
+    size_t i;
+
+    for (i = 0; i < repeat; i++)
+        sink += v->strnlen(s + (i & 1), len + 16);
+
+    return (double) len * repeat / (bench_now_ns() - start);
+}
+
+int main(int argc, char *argv[])
+{
+    static const size_t lengths[] = { 8, 32, 128, 1024, 16384, 262144 };
+    double megabytes = argc > 1 ? strtod(argv[1], NULL) : 256;
+    struct version versions[4];
+    size_t nversions = 0, i, v;
+    char *text;
+
+    versions[nversions].name = "swar";
+    versions[nversions].strchrnul = __strchrnul_swar;
+    versions[nversions++].strnlen = __strnlen_swar;
+#ifdef CPU_SSE2
+    versions[nversions].name = "sse2";
+    versions[nversions].strchrnul = __strchrnul_sse2;
+    versions[nversions++].strnlen = __strnlen_sse2;
+#endif
+#ifdef CPU_AVX2
+    if (cpu_has_avx2()) {
+        versions[nversions].name = "avx2";
+        versions[nversions].strchrnul = __strchrnul_avx2;
+        versions[nversions++].strnlen = __strnlen_avx2;
+    }
+#endif
+#ifdef CPU_NEON
+    versions[nversions].name = "neon";
+    versions[nversions].strchrnul = __strchrnul_neon;
+    versions[nversions++].strnlen = __strnlen_neon;
+#endif
+
+    text = malloc(lengths[sizeof lengths / sizeof lengths[0] - 1] + 2);
+    if (!text)
+        return 1;
+
+    printf("%-10s %-6s %10s %14s %8s\n",
+           "function", "impl", "length", "bytes/ns", "vs swar");
+
+    for (i = 0; i < sizeof lengths / sizeof lengths[0]; i++) {
+        size_t len = lengths[i];
+        size_t repeat = (size_t) (megabytes * 1e6 / len) + 1;
+        double swar_chr = 0, swar_len = 0;
+
+        /* Every other call starts a byte later, so both alignments of the
+           start are seen; the extra byte makes the lengths the same.  */
+        memset(text, 'a', len + 1);
+        text[len + 1] = '\0';
+
+        for (v = 0; v < nversions; v++) {
+            double chr = time_strchrnul(&versions[v], text, len, repeat);
+            double slen = time_strnlen(&versions[v], text, len, repeat);
+
+            if (v == 0)
+                swar_chr = chr, swar_len = slen;
+            printf("%-10s %-6s %10zu %14.2f %7.2fx\n", "strchrnul",
+                   versions[v].name, len, chr, chr / swar_chr);
+            printf("%-10s %-6s %10zu %14.2f %7.2fx\n", "strnlen",
+                   versions[v].name, len, slen, slen / swar_len);
+        }
+    }
+
+    free(text);
+    return 0;
+}
@@ -20,11 +20,15 @@
    License along with the GNU C Library; if not, see
    <http://www.gnu.org/licenses/>.  */
 
+#include <stdint.h>
+
 #include <string_helper.h>
+#include "string_helper-impl.h"
 
-/* Find the first occurrence of C in S or the final NUL byte.  */
-char *
-strchrnul (const char *s, int c_in)
+/* Find the first occurrence of C in S or the final NUL byte, a longword at
+   a time.  */
+CPU_NO_SANITIZE_ADDRESS char *
+__strchrnul_swar (const char *s, int c_in)
 {
     const unsigned char *char_ptr;
     const unsigned long int *longword_ptr;
@@ -152,3 +156,119 @@ strchrnul (const char *s, int c_in)
     return NULL;
 }
 
+/* The vector versions load aligned blocks, starting with the one S is in and
+   ignoring the bytes of it before S, so they never read from a page the
+   string doesn't reach.  */
+
+#ifdef CPU_SSE2
+/* Return a mask of the bytes of BLOCK that are C or NUL.  */
+# define strchrnul_hits_sse2(block, c) \
+    (unsigned) _mm_movemask_epi8(_mm_or_si128(                         \
+        _mm_cmpeq_epi8(block, c), _mm_cmpeq_epi8(block, _mm_setzero_si128())))
+
+CPU_NO_SANITIZE_ADDRESS char *
+__strchrnul_sse2 (const char *s, int c_in)
+{
+    const __m128i c = _mm_set1_epi8((char) c_in);
+    const size_t skip = (uintptr_t) s & 15;
+    const char *p = s - skip;
+    unsigned hits;
+
+    hits = strchrnul_hits_sse2(_mm_load_si128((const __m128i *) p), c);
+    hits = hits >> skip << skip;
+
+    while (!hits) {
+        p += 16;
+        hits = strchrnul_hits_sse2(_mm_load_si128((const __m128i *) p), c);
+    }
+
+    return (char *) p + cpu_ctz(hits);
+}
+#endif /* CPU_SSE2 */
+
+#ifdef CPU_AVX2
+/* Return a mask of the bytes of BLOCK that are C or NUL.  */
+# define strchrnul_hits_avx2(block, c) \
+    (unsigned) _mm256_movemask_epi8(_mm256_or_si256(                   \
+        _mm256_cmpeq_epi8(block, c),                                   \
+        _mm256_cmpeq_epi8(block, _mm256_setzero_si256())))
+
+CPU_NO_SANITIZE_ADDRESS CPU_TARGET_AVX2 char *
+__strchrnul_avx2 (const char *s, int c_in)
+{
+    const __m256i c = _mm256_set1_epi8((char) c_in);
+    const size_t skip = (uintptr_t) s & 31;
+    const char *p = s - skip;
+    unsigned hits;
+
+    hits = strchrnul_hits_avx2(_mm256_load_si256((const __m256i *) p), c);
+    hits = hits >> skip << skip;
+
+    while (!hits) {
+        p += 32;
+        hits = strchrnul_hits_avx2(_mm256_load_si256((const __m256i *) p), c);
+    }
+
+    return (char *) p + cpu_ctz(hits);
+}
+#endif /* CPU_AVX2 */
+
+#ifdef CPU_NEON
+/* Return a mask with four bits for each byte of BLOCK that is C or NUL.
+   NEON has no byte movemask; narrowing the comparison does as well.  */
+static inline unsigned long long
+strchrnul_hits_neon (uint8x16_t block, uint8x16_t c)
+{
+    uint8x16_t hits = vorrq_u8(vceqq_u8(block, c), vceqzq_u8(block));
+
+    return vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+}
+
+CPU_NO_SANITIZE_ADDRESS char *
+__strchrnul_neon (const char *s, int c_in)
+{
+    const uint8x16_t c = vdupq_n_u8((unsigned char) c_in);
+    const size_t skip = (uintptr_t) s & 15;
+    const char *p = s - skip;
+    unsigned long long hits;
+
+    hits = strchrnul_hits_neon(vld1q_u8((const uint8_t *) p), c);
+    hits = hits >> (skip * 4) << (skip * 4);
+
+    while (!hits) {
+        p += 16;
+        hits = strchrnul_hits_neon(vld1q_u8((const uint8_t *) p), c);
+    }
+
+    return (char *) p + cpu_ctz64(hits) / 4;
+}
+#endif /* CPU_NEON */
+
+typedef char *(*strchrnul_fn) (const char *s, int c_in);
+
+/* Find the first occurrence of C in S or the final NUL byte.  */
+char *
+strchrnul (const char *s, int c_in)
+{
+    static volatile strchrnul_fn chosen;
+    strchrnul_fn fn = chosen;
+
+    if (!fn) {
+        /* Threads racing to choose all come to the same answer.  */
+#if defined CPU_AVX2
+        fn = cpu_has_avx2() ? __strchrnul_avx2 : NULL;
+#endif
+#if defined CPU_SSE2
+        if (!fn)
+            fn = __strchrnul_sse2;
+#elif defined CPU_NEON
+        fn = __strchrnul_neon;
+#endif
+        if (!fn)
+            fn = __strchrnul_swar;
+        chosen = fn;
+    }
+
+    return fn(s, c_in);
+}
@@ -0,0 +1,57 @@
+/***
+ * MIT License
+ *
+ * Copyright (c) 2023 Konychev Valera
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* The versions of the string searches for each kind of CPU.  strchrnul and
+   string_helper_strnlen pick the best one the CPU can run the first time
+   they're called; these are declared for the tests and benchmarks, which
+   try them all.  A version may only be called if the CPU has what it needs:
+   the AVX2 ones only when cpu_has_avx2 says so.  */
+
+#ifndef __STRING_HELPER_IMPL_H
+#define __STRING_HELPER_IMPL_H
+
+#include <stddef.h>
+
+#include <cpu-features.h>
+
+/* A word at a time; these work everywhere.  */
+char *__strchrnul_swar(const char *s, int c_in);
+size_t __strnlen_swar(const char *s, size_t maxlen);
+
+#ifdef CPU_SSE2
+char *__strchrnul_sse2(const char *s, int c_in);
+size_t __strnlen_sse2(const char *s, size_t maxlen);
+#endif
+
+#ifdef CPU_AVX2
+char *__strchrnul_avx2(const char *s, int c_in);
+size_t __strnlen_avx2(const char *s, size_t maxlen);
+#endif
+
+#ifdef CPU_NEON
+char *__strchrnul_neon(const char *s, int c_in);
+size_t __strnlen_neon(const char *s, size_t maxlen);
+#endif
+
+#endif /* __STRING_HELPER_IMPL_H */
@@ -44,5 +44,10 @@ char *strndup (const char *s, size_t n);
 
 #endif /* __GLIBC__ */
 
+#include <stddef.h>
+
+/* Like strnlen, with the fastest search the CPU can run.  */
+size_t string_helper_strnlen (const char *s, size_t maxlen);
+
 #endif /* __STRING_HELPER_H */
 
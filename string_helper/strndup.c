@@ -26,7 +26,7 @@
 
 char *strndup(const char *s, size_t n)
 {
-    size_t l = strnlen(s, n);
+    size_t l = string_helper_strnlen(s, n);
     char *new = (char *)malloc(l + 1);
 
     if (new == NULL)
@@ -0,0 +1,179 @@
+/***
+ * MIT License
+ *
+ * Copyright (c) 2023 Konychev Valera
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string_helper.h>
+#include "string_helper-impl.h"
+
+/* Each version reads only whole aligned blocks (or words) that hold at
+   least one byte of the string before its NUL or MAXLEN, so none of them
+   reads from a page the string doesn't reach.  */
+
+CPU_NO_SANITIZE_ADDRESS size_t
+__strnlen_swar(const char *s, size_t maxlen)
+{
+    const size_t ones = (size_t) -1 / 0xff;
+    const size_t high_bits = ones * 0x80;
+    size_t n = 0;
+    size_t word;
+
+    for (; n < maxlen && ((uintptr_t) (s + n) & (sizeof (word) - 1)); n++)
+        if (!s[n])
+            return n;
+
+    for (; maxlen - n >= sizeof (word); n += sizeof (word)) {
+        memcpy(&word, s + n, sizeof (word));
+        /* This is exact for the first zero byte, which is all we want.  */
+        if ((word - ones) & ~word & high_bits)
+            break;
+    }
+
+    for (; n < maxlen; n++)
+        if (!s[n])
+            return n;
+
+    return maxlen;
+}
+
+#ifdef CPU_SSE2
+CPU_NO_SANITIZE_ADDRESS size_t
+__strnlen_sse2(const char *s, size_t maxlen)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const size_t skip = (uintptr_t) s & 15;
+    const char *p = s - skip;
+    unsigned nuls;
+
+    if (maxlen == 0)
+        return 0;
+
+    nuls = _mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_load_si128((const __m128i *) p), zero));
+    nuls = nuls >> skip << skip;
+
+    /* The block at P starts before S + MAXLEN whenever it's loaded.  */
+    while (!nuls) {
+        p += 16;
+        if ((size_t) (p - s) >= maxlen)
+            return maxlen;
+        nuls = _mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_load_si128((const __m128i *) p), zero));
+    }
+
+    p += cpu_ctz(nuls);
+    return (size_t) (p - s) < maxlen ? (size_t) (p - s) : maxlen;
+}
+#endif /* CPU_SSE2 */
+
+#ifdef CPU_AVX2
+CPU_NO_SANITIZE_ADDRESS CPU_TARGET_AVX2 size_t
+__strnlen_avx2(const char *s, size_t maxlen)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const size_t skip = (uintptr_t) s & 31;
+    const char *p = s - skip;
+    unsigned nuls;
+
+    if (maxlen == 0)
+        return 0;
+
+    nuls = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *) p), zero));
+    nuls = nuls >> skip << skip;
+
+    while (!nuls) {
+        p += 32;
+        if ((size_t) (p - s) >= maxlen)
+            return maxlen;
+        nuls = _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *) p), zero));
+    }
+
+    p += cpu_ctz(nuls);
+    return (size_t) (p - s) < maxlen ? (size_t) (p - s) : maxlen;
+}
+#endif /* CPU_AVX2 */
+
+#ifdef CPU_NEON
+/* Return a mask with four bits for each NUL byte of BLOCK.  */
+static inline unsigned long long
+strnlen_nuls_neon(uint8x16_t block)
+{
+    return vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(vceqzq_u8(block)), 4)), 0);
+}
+
+CPU_NO_SANITIZE_ADDRESS size_t
+__strnlen_neon(const char *s, size_t maxlen)
+{
+    const size_t skip = (uintptr_t) s & 15;
+    const char *p = s - skip;
+    unsigned long long nuls;
+
+    if (maxlen == 0)
+        return 0;
+
+    nuls = strnlen_nuls_neon(vld1q_u8((const uint8_t *) p));
+    nuls = nuls >> (skip * 4) << (skip * 4);
+
+    while (!nuls) {
+        p += 16;
+        if ((size_t) (p - s) >= maxlen)
+            return maxlen;
+        nuls = strnlen_nuls_neon(vld1q_u8((const uint8_t *) p));
+    }
+
+    p += cpu_ctz64(nuls) / 4;
+    return (size_t) (p - s) < maxlen ? (size_t) (p - s) : maxlen;
+}
+#endif /* CPU_NEON */
+
+typedef size_t (*strnlen_fn)(const char *s, size_t maxlen);
+
+size_t
+string_helper_strnlen(const char *s, size_t maxlen)
+{
+    static volatile strnlen_fn chosen;
+    strnlen_fn fn = chosen;
+
+    if (!fn) {
+        /* Threads racing to choose all come to the same answer.  */
+#if defined CPU_AVX2
+        fn = cpu_has_avx2() ? __strnlen_avx2 : NULL;
+#endif
+#if defined CPU_SSE2
+        if (!fn)
+            fn = __strnlen_sse2;
+#elif defined CPU_NEON
+        fn = __strnlen_neon;
+#endif
+        if (!fn)
+            fn = __strnlen_swar;
+        chosen = fn;
+    }
+
+    return fn(s, maxlen);
+}
@@ -0,0 +1,207 @@
+/***
+ * MIT License
+ *
+ * Copyright (c) 2023 Konychev Valera
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Checks every version of strchrnul and strnlen that the CPU can run
+   against a byte at a time, for strings at every alignment, and for strings
+   that run right up to a page that can't be read, on either side, so that
+   reading a byte too many crashes.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+#include <string_helper.h>
+#include "string_helper-impl.h"
+
+struct version
+{
+    const char *name;
+    char *(*strchrnul)(const char *s, int c_in);
+    size_t (*strnlen)(const char *s, size_t maxlen);
+};
+
+static struct version versions[5];
+static size_t nversions;
+static int failures;
+
+static void
+fail(const struct version *v, const char *what, size_t len, size_t off)
+{
+    if (failures++ < 10)
+        fprintf(stderr, "%s: %s wrong for length %zu at offset %zu\n",
+                v->name, what, len, off);
+}
+
+static const char *
+ref_strchrnul(const char *s, int c)
+{
+    while (*s && *s != (char) c)
+        s++;
+    return s;
+}
+
+static size_t
+ref_strnlen(const char *s, size_t maxlen)
+{
+    size_t n = 0;
+
+    while (n < maxlen && s[n])
+        n++;
+    return n;
+}
+
+/* Check all versions on the string of LEN bytes at S, which has its NUL at
+   S[LEN] unless NUL_AFTER is false, in which case S + LEN is the end of
+   what can be read.  */
+static void
+check_string(const char *s, size_t len, int nul_after, size_t off)
+{
+    size_t v, k;
+
+    for (v = 0; v < nversions; v++) {
+        const struct version *ver = &versions[v];
+
+        if (nul_after) {
+            /* Look for a character that's there, and one that's not.  */
+            int c = len ? (unsigned char) s[len / 2] : 'x';
+
+            if (ver->strchrnul(s, c) != ref_strchrnul(s, c)
+                || ver->strchrnul(s, 0x7f) != s + len)
+                fail(ver, "strchrnul", len, off);
+            if (ver->strnlen(s, (size_t) -1) != len)
+                fail(ver, "strnlen", len, off);
+        }
+
+        for (k = 0; k <= len; k += 1 + k / 4)
+            if (ver->strnlen(s, k) != ref_strnlen(s, k))
+                fail(ver, "bounded strnlen", k, off);
+    }
+}
+
+/* Return three pages, of which only the middle one can be read, and set
+   *PAGE to their size.  */
+static char *
+guarded_pages(size_t *page)
+{
+    char *mem;
+
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    DWORD old;
+
+    GetSystemInfo(&info);
+    *page = info.dwPageSize;
+    mem = VirtualAlloc(NULL, 3 * *page, MEM_RESERVE | MEM_COMMIT,
+                       PAGE_NOACCESS);
+    if (!mem || !VirtualProtect(mem + *page, *page, PAGE_READWRITE, &old))
+        return NULL;
+#else
+    *page = sysconf(_SC_PAGESIZE);
+    mem = mmap(NULL, 3 * *page, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED
+        || mprotect(mem + *page, *page, PROT_READ | PROT_WRITE))
+        return NULL;
+#endif
+
+    return mem + *page;
+}
+
+static void
+test_page_ends(void)
+{
+    size_t page, len, off;
+    char *mem = guarded_pages(&page);
+
+    if (!mem) {
+        fprintf(stderr, "can't set up guard pages\n");
+        failures++;
+        return;
+    }
+
+    for (len = 0; len < 200; len++) {
+        /* Strings ending at the end of the page, NUL or no NUL.  */
+        char *s = mem + page - len - 1;
+
+        memset(s, 'a' + len % 26, len);
+        s[len] = '\0';
+        check_string(s, len, 1, page - len - 1);
+        memset(mem + page - len, 'b', len);
+        check_string(mem + page - len, len, 0, page - len);
+
+        /* And strings starting at the start of it.  */
+        memset(mem, 'c', len);
+        mem[len] = '\0';
+        check_string(mem, len, 1, 0);
+    }
+
+    for (off = 0; off < 64; off++)
+        for (len = 0; len < 3 * 64; len += 1 + len / 8) {
+            char *s = mem + off;
+            size_t i;
+
+            for (i = 0; i < len; i++)
+                s[i] = 'a' + (i * 7 + off) % 26;
+            s[len] = '\0';
+            check_string(s, len, 1, off);
+        }
+}
+
+int
+main(void)
+{
+    versions[nversions].name = "swar";
+    versions[nversions].strchrnul = __strchrnul_swar;
+    versions[nversions++].strnlen = __strnlen_swar;
+#ifdef CPU_SSE2
+    versions[nversions].name = "sse2";
+    versions[nversions].strchrnul = __strchrnul_sse2;
+    versions[nversions++].strnlen = __strnlen_sse2;
+#endif
+#ifdef CPU_AVX2
+    if (cpu_has_avx2()) {
+        versions[nversions].name = "avx2";
+        versions[nversions].strchrnul = __strchrnul_avx2;
+        versions[nversions++].strnlen = __strnlen_avx2;
+    }
+#endif
+#ifdef CPU_NEON
+    versions[nversions].name = "neon";
+    versions[nversions].strchrnul = __strchrnul_neon;
+    versions[nversions++].strnlen = __strnlen_neon;
+#endif
+    versions[nversions].name = "chosen";
+    versions[nversions].strchrnul = strchrnul;
+    versions[nversions++].strnlen = string_helper_strnlen;
+
+    test_page_ends();
+
+    return failures ? 1 : 0;
+}